@@ -0,0 +1,362 @@
+/**
+ * @file atl_age.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Sample age tracking (acquisition to broker acknowledgement).
+ * @details Each sample batch carries the acquisition time of its oldest sample. Aggregators and uplinks record the
+ *  batch age at every stage it reaches (aggregated, queued, published and acknowledged by broker) into fixed bucket
+ *  histograms, and published MQTT batches wait at a pending table (by msg_id) for MQTT_EVENT_PUBLISHED. Histograms are
+ *  reported as health telemetry and cleared at each report window.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include "sdkconfig.h"
+#include "atl_age.h"
+
+/* Constants */
+static const char *atl_age_stage_names[ATL_AGE_STAGE_MAX] = {
+    "aggregated",
+    "queued",
+    "published",
+    "acked",
+};
+static const uint32_t atl_age_bounds_ms[ATL_AGE_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000, 300000, 900000,
+};
+
+/**
+ * @fn atl_age_stage_str(atl_age_stage_e stage)
+ * @brief Get stage name.
+ * @param[in] stage - Stage
+ * @return const char* - Stage name ("?" if invalid).
+ */
+const char* atl_age_stage_str(atl_age_stage_e stage) {
+    if (stage >= ATL_AGE_STAGE_MAX) {
+        return "?";
+    }
+    return atl_age_stage_names[stage];
+}
+
+/**
+ * @fn atl_age_bucket_ms(uint8_t bucket)
+ * @brief Get upper bound of an histogram bucket.
+ * @param[in] bucket - Bucket index
+ * @return uint32_t - Upper bound (in ms, UINT32_MAX for last bucket).
+ */
+uint32_t atl_age_bucket_ms(uint8_t bucket) {
+    if (bucket >= (ATL_AGE_BUCKETS - 1)) {
+        return UINT32_MAX;
+    }
+    return atl_age_bounds_ms[bucket];
+}
+
+/**
+ * @fn atl_age_percentile(const atl_age_hist_t *hist, uint8_t percent)
+ * @brief Estimate an age percentile (upper bound of bucket reaching it, limited to oldest batch).
+ * @param[in] hist - Age histogram
+ * @param[in] percent - Percentile (1 to 100)
+ * @return uint32_t - Age (in ms, 0 if histogram is empty).
+ */
+uint32_t atl_age_percentile(const atl_age_hist_t *hist, uint8_t percent) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = ((uint64_t)hist->count * percent + 99) / 100;
+    uint32_t acc = 0;
+    for (uint8_t i = 0; i < ATL_AGE_BUCKETS; i++) {
+        acc += hist->bucket[i];
+        if (acc >= rank) {
+            uint32_t bound = atl_age_bucket_ms(i);
+            return (bound < hist->max_ms) ? bound : hist->max_ms;
+        }
+    }
+    return hist->max_ms;
+}
+
+#ifdef CONFIG_ATL_AGE
+
+/**
+ * @typedef atl_age_pending_t
+ * @brief Batch waiting for broker acknowledgement.
+ */
+typedef struct {
+    int         msg_id;         /**< MQTT message identifier (0 if slot is free).*/
+    int64_t     acquired_us;    /**< Acquisition time of oldest sample at batch.*/
+    int64_t     published_us;   /**< Publish time (eviction order).*/
+} atl_age_pending_t;
+
+/* Constants */
+static const char *TAG = "atl-age";
+
+/* Global variables */
+static atl_age_hist_t atl_age_hist[ATL_AGE_STAGE_MAX];
+static atl_age_pending_t atl_age_pending[CONFIG_ATL_AGE_PENDING_MAX];
+static atl_age_status_t atl_age_status;
+static int64_t atl_age_window_start = 0;
+static portMUX_TYPE atl_age_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @fn atl_age_hist_add(atl_age_stage_e stage, int64_t age_us)
+ * @brief Add an age to a stage histogram (lock must be held).
+ * @param[in] stage - Stage
+ * @param[in] age_us - Batch age (in us)
+ */
+static void atl_age_hist_add(atl_age_stage_e stage, int64_t age_us) {
+    atl_age_hist_t *hist = &atl_age_hist[stage];
+    uint32_t age_ms = (age_us > 0) ? (uint32_t)(age_us / 1000) : 0;
+    uint8_t bucket = 0;
+    while ((bucket < (ATL_AGE_BUCKETS - 1)) && (age_ms > atl_age_bounds_ms[bucket])) {
+        bucket++;
+    }
+    hist->bucket[bucket]++;
+    hist->count++;
+    hist->sum_ms += age_ms;
+    if (age_ms > hist->max_ms) {
+        hist->max_ms = age_ms;
+    }
+}
+
+/**
+ * @fn atl_age_pending_find(int msg_id)
+ * @brief Find a pending batch (lock must be held).
+ * @param[in] msg_id - MQTT message identifier
+ * @return atl_age_pending_t* - Pending batch (NULL if not found).
+ */
+static atl_age_pending_t* atl_age_pending_find(int msg_id) {
+    for (uint8_t i = 0; i < CONFIG_ATL_AGE_PENDING_MAX; i++) {
+        if (atl_age_pending[i].msg_id == msg_id) {
+            return &atl_age_pending[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn atl_age_record(atl_age_stage_e stage, int64_t acquired_us)
+ * @brief Record the age of a batch reaching a stage.
+ * @param[in] stage - Stage reached
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch (esp_timer_get_time(), ignored if not positive)
+ */
+void atl_age_record(atl_age_stage_e stage, int64_t acquired_us) {
+    if ((stage >= ATL_AGE_STAGE_MAX) || (acquired_us <= 0)) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_age_lock);
+    atl_age_hist_add(stage, now - acquired_us);
+    portEXIT_CRITICAL(&atl_age_lock);
+}
+
+/**
+ * @fn atl_age_track(int msg_id, int64_t acquired_us)
+ * @brief Wait for broker acknowledgement of a published batch (oldest pending batch is evicted if table is full).
+ * @param[in] msg_id - MQTT message identifier (QoS 1 or 2)
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch
+ */
+void atl_age_track(int msg_id, int64_t acquired_us) {
+    if ((msg_id <= 0) || (acquired_us <= 0)) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    bool evicted = false;
+    portENTER_CRITICAL(&atl_age_lock);
+    atl_age_pending_t *slot = atl_age_pending_find(0);
+    if (slot == NULL) {
+        slot = &atl_age_pending[0];
+        for (uint8_t i = 1; i < CONFIG_ATL_AGE_PENDING_MAX; i++) {
+            if (atl_age_pending[i].published_us < slot->published_us) {
+                slot = &atl_age_pending[i];
+            }
+        }
+        atl_age_status.untracked++;
+        atl_age_status.pending--;
+        evicted = true;
+    }
+    slot->msg_id = msg_id;
+    slot->acquired_us = acquired_us;
+    slot->published_us = now;
+    atl_age_status.pending++;
+    portEXIT_CRITICAL(&atl_age_lock);
+    if (evicted == true) {
+        ESP_LOGW(TAG, "Pending table full, oldest batch no longer tracked");
+    }
+}
+
+/**
+ * @fn atl_age_acked(int msg_id)
+ * @brief Record acknowledgement age of a tracked batch (ignored if message is not tracked).
+ * @param[in] msg_id - MQTT message identifier
+ */
+void atl_age_acked(int msg_id) {
+    if (msg_id <= 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_age_lock);
+    atl_age_pending_t *slot = atl_age_pending_find(msg_id);
+    if (slot != NULL) {
+        atl_age_hist_add(ATL_AGE_ACKED, now - slot->acquired_us);
+        slot->msg_id = 0;
+        atl_age_status.pending--;
+    }
+    portEXIT_CRITICAL(&atl_age_lock);
+}
+
+/**
+ * @fn atl_age_lost(int msg_id)
+ * @brief Count a tracked batch deleted from outbox before acknowledgement (ignored if message is not tracked).
+ * @param[in] msg_id - MQTT message identifier
+ */
+void atl_age_lost(int msg_id) {
+    if (msg_id <= 0) {
+        return;
+    }
+    bool lost = false;
+    portENTER_CRITICAL(&atl_age_lock);
+    atl_age_pending_t *slot = atl_age_pending_find(msg_id);
+    if (slot != NULL) {
+        slot->msg_id = 0;
+        atl_age_status.pending--;
+        atl_age_status.lost++;
+        lost = true;
+    }
+    portEXIT_CRITICAL(&atl_age_lock);
+    if (lost == true) {
+        ESP_LOGW(TAG, "Batch msg_id=%d deleted from outbox before acknowledgement", msg_id);
+    }
+}
+
+/**
+ * @fn atl_age_get(atl_age_stage_e stage, atl_age_hist_t *hist)
+ * @brief Get age histogram of a stage (since last report).
+ * @param[in] stage - Stage
+ * @param[out] hist - Age histogram
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if stage is invalid, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_age_get(atl_age_stage_e stage, atl_age_hist_t *hist) {
+    if (stage >= ATL_AGE_STAGE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&atl_age_lock);
+    memcpy(hist, &atl_age_hist[stage], sizeof(atl_age_hist_t));
+    portEXIT_CRITICAL(&atl_age_lock);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_age_get_status(atl_age_status_t *status)
+ * @brief Get pending batches status (counters since boot).
+ * @param[out] status - Pending batches status
+ */
+void atl_age_get_status(atl_age_status_t *status) {
+    portENTER_CRITICAL(&atl_age_lock);
+    memcpy(status, &atl_age_status, sizeof(atl_age_status_t));
+    portEXIT_CRITICAL(&atl_age_lock);
+}
+
+/**
+ * @fn atl_age_report(cJSON *telemetry)
+ * @brief Add age histograms to a health telemetry object and start a new report window.
+ * @details Keys are flat (ThingsBoard telemetry): "age_window_s", "age_bounds_ms", "age_<stage>_count", and for stages
+ *  with batches "age_<stage>_avg_ms", "age_<stage>_p50_ms", "age_<stage>_p95_ms", "age_<stage>_max_ms" and
+ *  "age_<stage>_hist", plus "age_pending", "age_lost" and "age_untracked".
+ * @param[in,out] telemetry - Telemetry JSON object
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_age_report(cJSON *telemetry) {
+    atl_age_hist_t hist[ATL_AGE_STAGE_MAX];
+    atl_age_status_t status;
+    char key[32];
+    if (telemetry == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Snapshot and start a new window */
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_age_lock);
+    memcpy(hist, atl_age_hist, sizeof(hist));
+    memset(atl_age_hist, 0, sizeof(atl_age_hist));
+    memcpy(&status, &atl_age_status, sizeof(status));
+    int64_t window_start = atl_age_window_start;
+    atl_age_window_start = now;
+    portEXIT_CRITICAL(&atl_age_lock);
+
+    cJSON_AddNumberToObject(telemetry, "age_window_s", (double)((now - window_start) / 1000000));
+    cJSON *bounds = cJSON_AddArrayToObject(telemetry, "age_bounds_ms");
+    for (uint8_t i = 0; (bounds != NULL) && (i < (ATL_AGE_BUCKETS - 1)); i++) {
+        cJSON_AddItemToArray(bounds, cJSON_CreateNumber(atl_age_bounds_ms[i]));
+    }
+    for (uint8_t stage = 0; stage < ATL_AGE_STAGE_MAX; stage++) {
+        const char *name = atl_age_stage_names[stage];
+        snprintf(key, sizeof(key), "age_%s_count", name);
+        cJSON_AddNumberToObject(telemetry, key, hist[stage].count);
+        if (hist[stage].count == 0) {
+            continue;
+        }
+        snprintf(key, sizeof(key), "age_%s_avg_ms", name);
+        cJSON_AddNumberToObject(telemetry, key, (double)(hist[stage].sum_ms / hist[stage].count));
+        snprintf(key, sizeof(key), "age_%s_p50_ms", name);
+        cJSON_AddNumberToObject(telemetry, key, atl_age_percentile(&hist[stage], 50));
+        snprintf(key, sizeof(key), "age_%s_p95_ms", name);
+        cJSON_AddNumberToObject(telemetry, key, atl_age_percentile(&hist[stage], 95));
+        snprintf(key, sizeof(key), "age_%s_max_ms", name);
+        cJSON_AddNumberToObject(telemetry, key, hist[stage].max_ms);
+        snprintf(key, sizeof(key), "age_%s_hist", name);
+        cJSON *buckets = cJSON_AddArrayToObject(telemetry, key);
+        for (uint8_t i = 0; (buckets != NULL) && (i < ATL_AGE_BUCKETS); i++) {
+            cJSON_AddItemToArray(buckets, cJSON_CreateNumber(hist[stage].bucket[i]));
+        }
+    }
+    cJSON_AddNumberToObject(telemetry, "age_pending", status.pending);
+    cJSON_AddNumberToObject(telemetry, "age_lost", status.lost);
+    cJSON_AddNumberToObject(telemetry, "age_untracked", status.untracked);
+    return ESP_OK;
+}
+
+#else
+
+void atl_age_record(atl_age_stage_e stage, int64_t acquired_us) {
+}
+
+void atl_age_track(int msg_id, int64_t acquired_us) {
+}
+
+void atl_age_acked(int msg_id) {
+}
+
+void atl_age_lost(int msg_id) {
+}
+
+esp_err_t atl_age_get(atl_age_stage_e stage, atl_age_hist_t *hist) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void atl_age_get_status(atl_age_status_t *status) {
+    memset(status, 0, sizeof(atl_age_status_t));
+}
+
+/**
+ * @fn atl_age_report(cJSON *telemetry)
+ * @brief Sample age tracking disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_age_report(cJSON *telemetry) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
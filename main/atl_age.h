@@ -0,0 +1,147 @@
+/**
+ * @file atl_age.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Sample age tracking (acquisition to broker acknowledgement) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_AGE_BUCKETS     12      /**< Histogram buckets (last one is unbounded).*/
+
+/**
+ * @enum    atl_age_stage_e
+ * @brief   Stages of a sample batch (age is measured from acquisition of its oldest sample).
+ */
+typedef enum {
+    ATL_AGE_AGGREGATED,     /**< Batch closed by aggregator (encoded).*/
+    ATL_AGE_QUEUED,         /**< Batch handed to uplink queue.*/
+    ATL_AGE_PUBLISHED,      /**< Batch written to network (MQTT publish while connected or LoRaWAN uplink sent).*/
+    ATL_AGE_ACKED,          /**< Batch acknowledged by broker (MQTT_EVENT_PUBLISHED).*/
+    ATL_AGE_STAGE_MAX,
+} atl_age_stage_e;
+
+/**
+ * @typedef atl_age_hist_t
+ * @brief Age histogram of a stage.
+ */
+typedef struct {
+    uint32_t    count;                      /**< Batches recorded.*/
+    uint32_t    max_ms;                     /**< Oldest batch (in ms).*/
+    uint64_t    sum_ms;                     /**< Sum of ages (in ms).*/
+    uint32_t    bucket[ATL_AGE_BUCKETS];    /**< Batches per age bucket (see atl_age_bucket_ms()).*/
+} atl_age_hist_t;
+
+/**
+ * @typedef atl_age_status_t
+ * @brief Batches waiting for broker acknowledgement.
+ */
+typedef struct {
+    uint32_t    pending;    /**< Batches waiting for acknowledgement.*/
+    uint32_t    lost;       /**< Batches deleted from MQTT outbox (expired before acknowledgement).*/
+    uint32_t    untracked;  /**< Batches evicted from pending table (table full).*/
+} atl_age_status_t;
+
+/**
+ * @fn atl_age_stage_str(atl_age_stage_e stage)
+ * @brief Get stage name.
+ * @param[in] stage - Stage
+ * @return const char* - Stage name ("?" if invalid).
+ */
+const char* atl_age_stage_str(atl_age_stage_e stage);
+
+/**
+ * @fn atl_age_bucket_ms(uint8_t bucket)
+ * @brief Get upper bound of an histogram bucket.
+ * @param[in] bucket - Bucket index
+ * @return uint32_t - Upper bound (in ms, UINT32_MAX for last bucket).
+ */
+uint32_t atl_age_bucket_ms(uint8_t bucket);
+
+/**
+ * @fn atl_age_record(atl_age_stage_e stage, int64_t acquired_us)
+ * @brief Record the age of a batch reaching a stage.
+ * @param[in] stage - Stage reached
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch (esp_timer_get_time(), ignored if not positive)
+ */
+void atl_age_record(atl_age_stage_e stage, int64_t acquired_us);
+
+/**
+ * @fn atl_age_track(int msg_id, int64_t acquired_us)
+ * @brief Wait for broker acknowledgement of a published batch (oldest pending batch is evicted if table is full).
+ * @param[in] msg_id - MQTT message identifier (QoS 1 or 2)
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch
+ */
+void atl_age_track(int msg_id, int64_t acquired_us);
+
+/**
+ * @fn atl_age_acked(int msg_id)
+ * @brief Record acknowledgement age of a tracked batch (ignored if message is not tracked).
+ * @param[in] msg_id - MQTT message identifier
+ */
+void atl_age_acked(int msg_id);
+
+/**
+ * @fn atl_age_lost(int msg_id)
+ * @brief Count a tracked batch deleted from outbox before acknowledgement (ignored if message is not tracked).
+ * @param[in] msg_id - MQTT message identifier
+ */
+void atl_age_lost(int msg_id);
+
+/**
+ * @fn atl_age_get(atl_age_stage_e stage, atl_age_hist_t *hist)
+ * @brief Get age histogram of a stage (since last report).
+ * @param[in] stage - Stage
+ * @param[out] hist - Age histogram
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if stage is invalid, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_age_get(atl_age_stage_e stage, atl_age_hist_t *hist);
+
+/**
+ * @fn atl_age_get_status(atl_age_status_t *status)
+ * @brief Get pending batches status (counters since boot).
+ * @param[out] status - Pending batches status
+ */
+void atl_age_get_status(atl_age_status_t *status);
+
+/**
+ * @fn atl_age_percentile(const atl_age_hist_t *hist, uint8_t percent)
+ * @brief Estimate an age percentile (upper bound of bucket reaching it, limited to oldest batch).
+ * @param[in] hist - Age histogram
+ * @param[in] percent - Percentile (1 to 100)
+ * @return uint32_t - Age (in ms, 0 if histogram is empty).
+ */
+uint32_t atl_age_percentile(const atl_age_hist_t *hist, uint8_t percent);
+
+/**
+ * @fn atl_age_report(cJSON *telemetry)
+ * @brief Add age histograms to a health telemetry object and start a new report window.
+ * @details Keys are flat (ThingsBoard telemetry): "age_window_s", "age_bounds_ms", "age_<stage>_count", and for stages
+ *  with batches "age_<stage>_avg_ms", "age_<stage>_p50_ms", "age_<stage>_p95_ms", "age_<stage>_max_ms" and
+ *  "age_<stage>_hist", plus "age_pending", "age_lost" and "age_untracked".
+ * @param[in,out] telemetry - Telemetry JSON object
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_age_report(cJSON *telemetry);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,709 @@
+/**
+ * @file atl_bench.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief On-target micro-benchmarks.
+ * @details Hot paths are measured in place (same flash, cache and heap as production) with the CPU cycle counter.
+ *  Benchmarks run at a task pinned to the application core, so the cycle counter is never read at different cores.
+ *  Inputs are fixed and benchmarks without side effects run one warm-up iteration (cache fill), so results are
+ *  repeatable between builds. Suite results are emitted as JSON (console "bench all" or boot benchmark mode).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <esp_app_desc.h>
+#include <esp_ota_ops.h>
+#include <esp_image_format.h>
+#include <nvs.h>
+#include <mbedtls/sha256.h>
+#include <esp_tls.h>
+#include <esp_crt_bundle.h>
+#include <mqtt_client.h>
+#include <cJSON.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_resolver.h"
+#include "atl_mqtt.h"
+#include "atl_json.h"
+#include "atl_dns.h"
+#include "atl_webserver.h"
+#include "atl_bench.h"
+
+#define ATL_BENCH_SHA_CHUNK     4096    /* SHA-256 chunk (same as firmware chunk default) */
+#define ATL_BENCH_OTA_CHUNK     4096    /* Firmware chunk written to flash */
+#define ATL_BENCH_TLS_PORT      8883    /* MQTT over TLS port (used if broker is not configured with TLS) */
+#define ATL_BENCH_TLS_TIMEOUT   10000   /* TLS handshake timeout (in ms) */
+#define ATL_BENCH_TASK_STACK    8192    /* Benchmark task stack (TLS handshake) */
+
+/**
+ * @typedef atl_bench_ctx_t
+ * @brief Benchmark state (shared by setup, iterations and teardown).
+ */
+typedef struct {
+    uint32_t        iteration;                          /**< Current iteration.*/
+    uint32_t        bytes;                              /**< Bytes processed per iteration.*/
+    uint8_t         *buf;                               /**< Work buffer.*/
+    nvs_handle_t    nvs;                                /**< NVS handle.*/
+    esp_ota_handle_t ota;                               /**< OTA handle.*/
+    char            host[64];                           /**< TLS server address (resolved if cached).*/
+    char            common_name[64];                    /**< TLS server name.*/
+    uint16_t        port;                               /**< TLS server port.*/
+    bool            skip_cn;                            /**< Skip TLS server name check.*/
+} atl_bench_ctx_t;
+
+/**
+ * @typedef atl_bench_case_t
+ * @brief Benchmark definition.
+ */
+typedef struct {
+    const char  *name;                              /**< Benchmark name.*/
+    const char  *help;                              /**< Benchmark description.*/
+    uint32_t    iterations;                         /**< Default iterations.*/
+    bool        warmup;                             /**< Run a warm-up iteration (only if free of side effects).*/
+    esp_err_t   (*setup)(atl_bench_ctx_t *ctx);     /**< Prepare state (not measured, may be NULL).*/
+    esp_err_t   (*run)(atl_bench_ctx_t *ctx);       /**< Measured iteration.*/
+    void        (*teardown)(atl_bench_ctx_t *ctx);  /**< Release state (not measured, may be NULL).*/
+} atl_bench_case_t;
+
+/**
+ * @typedef atl_bench_job_t
+ * @brief Benchmark run handed to benchmark task.
+ */
+typedef struct {
+    const atl_bench_case_t  *bench;     /**< Benchmark.*/
+    uint32_t                iterations; /**< Iterations.*/
+    atl_bench_result_t      *result;    /**< Result.*/
+    esp_err_t               err;        /**< Benchmark error.*/
+    TaskHandle_t            caller;     /**< Task waiting for result.*/
+} atl_bench_job_t;
+
+/* Constants */
+static const char *TAG = "atl-bench";
+
+static const char atl_bench_attr_payload[] =
+    "{\"mqtt_client.mode\":2,\"mqtt_client.broker_address\":\"mqtt.agrotechlab.lages.ifsc.edu.br\","
+    "\"mqtt_client.broker_port\":8883,\"mqtt_client.transport\":2,\"mqtt_client.disable_cn_check\":false,"
+    "\"mqtt_client.user\":\"greenfield-0001\",\"mqtt_client.pass\":\"s3cr3t\\u0021\",\"mqtt_client.qos\":1,"
+    "\"wifi.startup_mode\":2,\"wifi.sta_ssid\":\"AgroTechLab\",\"wifi.sta_pass\":\"greenfield\","
+    "\"ota.behaviour\":1,\"group.id\":\"weather-stations\",\"fw_title\":\"greenfield\",\"fw_version\":\"0.1.0\"}";
+static const char atl_bench_form_payload[] =
+    "mqtt_mode=ATL_MQTT_THIRD&mqtt_srv_addr=mqtt.agrotechlab.lages.ifsc.edu.br&mqtt_srv_port=8883&"
+    "mqtt_transport=MQTT_TRANSPORT_OVER_SSL&mqtt_disable_cn_check=false&mqtt_username=greenfield-0001&"
+    "mqtt_pass=s3cr3t&mqtt_qos=ATL_MQTT_QOS1";
+static const uint8_t atl_bench_dns_query[] = {
+    0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    /* Header (standard query, RD) */
+    17, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+    7, 'g', 's', 't', 'a', 't', 'i', 'c', 3, 'c', 'o', 'm', 0,
+    0x00, 0x01, 0x00, 0x01,                                                     /* Type A, class IN */
+};
+
+/* Global variables */
+static SemaphoreHandle_t atl_bench_mutex = NULL;
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/**
+ * @fn atl_bench_json_run(atl_bench_ctx_t *ctx)
+ * @brief Encode a telemetry message with cJSON.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_json_run(atl_bench_ctx_t *ctx) {
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    cJSON_AddNumberToObject(root, "ts", 1760000000000.0 + ctx->iteration);
+    cJSON_AddNumberToObject(root, "air_temperature", 21.5);
+    cJSON_AddNumberToObject(root, "air_humidity", 63.2);
+    cJSON_AddNumberToObject(root, "atm_pressure", 1013.25);
+    cJSON_AddNumberToObject(root, "wind_speed", 3.4);
+    cJSON_AddNumberToObject(root, "wind_direction", 270);
+    cJSON_AddNumberToObject(root, "rainfall", 0.2);
+    cJSON_AddNumberToObject(root, "solar_radiation", 512);
+    cJSON_AddNumberToObject(root, "soil_moisture", 34.1);
+    char *str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (str == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->bytes = strlen(str);
+    cJSON_free(str);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_config_setup(atl_bench_ctx_t *ctx)
+ * @brief Allocate a configuration sized buffer.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_config_setup(atl_bench_ctx_t *ctx) {
+    ctx->buf = malloc(sizeof(atl_config_t));
+    if (ctx->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->bytes = sizeof(atl_config_t);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_config_snapshot_run(atl_bench_ctx_t *ctx)
+ * @brief Take a configuration snapshot (as every module does before using configuration).
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_config_snapshot_run(atl_bench_ctx_t *ctx) {
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    memcpy(ctx->buf, &atl_config, sizeof(atl_config_t));
+    xSemaphoreGive(atl_config_mutex);
+    return ESP_OK;
+}
+
+#ifdef CONFIG_ATL_BENCH_MODE
+/**
+ * @fn atl_bench_nvs_setup(atl_bench_ctx_t *ctx)
+ * @brief Open NVS and take a configuration snapshot as payload.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_nvs_setup(atl_bench_ctx_t *ctx) {
+    esp_err_t err = atl_bench_config_setup(ctx);
+    if (err == ESP_OK) {
+        err = atl_bench_config_snapshot_run(ctx);
+    }
+    if (err == ESP_OK) {
+        err = nvs_open("nvs", NVS_READWRITE, &ctx->nvs);
+    }
+    return err;
+}
+
+/**
+ * @fn atl_bench_nvs_run(atl_bench_ctx_t *ctx)
+ * @brief Write and commit a configuration sized blob at a scratch key.
+ * @details First word changes at each iteration, otherwise NVS skips writing an unchanged blob.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_nvs_run(atl_bench_ctx_t *ctx) {
+    memcpy(ctx->buf, &ctx->iteration, sizeof(ctx->iteration));
+    esp_err_t err = nvs_set_blob(ctx->nvs, "bench", ctx->buf, ctx->bytes);
+    if (err == ESP_OK) {
+        err = nvs_commit(ctx->nvs);
+    }
+    return err;
+}
+
+/**
+ * @fn atl_bench_nvs_teardown(atl_bench_ctx_t *ctx)
+ * @brief Erase scratch key and close NVS.
+ * @param[in] ctx - Benchmark state
+ */
+static void atl_bench_nvs_teardown(atl_bench_ctx_t *ctx) {
+    nvs_erase_key(ctx->nvs, "bench");
+    nvs_commit(ctx->nvs);
+    nvs_close(ctx->nvs);
+}
+#endif
+
+/**
+ * @typedef atl_bench_attr_t
+ * @brief Attribute benchmark state (production key table dispatched to a scratch configuration).
+ */
+typedef struct {
+    atl_json_dispatch_t dispatch;   /**< Dispatch table of MQTT shared attribute keys.*/
+    atl_config_t        config;     /**< Scratch configuration (setters context, never committed).*/
+    uint32_t            all_mask;   /**< Mask of all keys.*/
+} atl_bench_attr_t;
+
+/**
+ * @fn atl_bench_attr_setup(atl_bench_ctx_t *ctx)
+ * @brief Build the dispatch table of MQTT shared attribute keys (same setters as MQTT client).
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_attr_setup(atl_bench_ctx_t *ctx) {
+    size_t count = 0;
+    const atl_json_key_t *keys = atl_mqtt_get_attr_keys(&count);
+    atl_bench_attr_t *attr = calloc(1, sizeof(atl_bench_attr_t));
+    if (attr == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->buf = (uint8_t *)attr;
+    ctx->bytes = sizeof(atl_bench_attr_payload) - 1;
+    attr->all_mask = (count >= 32) ? UINT32_MAX : ((1UL << count) - 1);
+    return atl_json_dispatch_init(&attr->dispatch, keys, count);
+}
+
+/**
+ * @fn atl_bench_attr_run(atl_bench_ctx_t *ctx)
+ * @brief Parse and dispatch a shared attributes message to the scratch configuration.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_attr_run(atl_bench_ctx_t *ctx) {
+    atl_bench_attr_t *attr = (atl_bench_attr_t *)ctx->buf;
+    uint32_t applied_mask = 0;
+    esp_err_t err = atl_json_dispatch_mask(&attr->dispatch, atl_bench_attr_payload, ctx->bytes, &attr->config, 0, &applied_mask);
+    if ((err == ESP_OK) && (applied_mask != attr->all_mask)) {
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+/**
+ * @fn atl_bench_form_setup(atl_bench_ctx_t *ctx)
+ * @brief Allocate form body buffer.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_form_setup(atl_bench_ctx_t *ctx) {
+    ctx->buf = malloc(sizeof(atl_bench_form_payload));
+    if (ctx->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->bytes = sizeof(atl_bench_form_payload) - 1;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_form_run(atl_bench_ctx_t *ctx)
+ * @brief Parse a MQTT configuration form body with the MQTT configuration POST handler parser.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_form_run(atl_bench_ctx_t *ctx) {
+    atl_mqtt_client_t mqtt_client_config;
+    memcpy(ctx->buf, atl_bench_form_payload, sizeof(atl_bench_form_payload));
+    memset(&mqtt_client_config, 0, sizeof(atl_mqtt_client_t));
+    esp_err_t err = atl_webserver_parse_mqtt_form((char *)ctx->buf, &mqtt_client_config);
+    if ((err == ESP_OK) && (mqtt_client_config.broker_port != 8883)) {
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+/**
+ * @fn atl_bench_dns_setup(atl_bench_ctx_t *ctx)
+ * @brief Allocate query and reply buffers.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_dns_setup(atl_bench_ctx_t *ctx) {
+    ctx->buf = malloc(sizeof(atl_bench_dns_query) + DNS_MAX_LEN);
+    if (ctx->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(ctx->buf, atl_bench_dns_query, sizeof(atl_bench_dns_query));
+    ctx->bytes = sizeof(atl_bench_dns_query);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_dns_run(atl_bench_ctx_t *ctx)
+ * @brief Build the captive portal DNS reply to a type A query.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_dns_run(atl_bench_ctx_t *ctx) {
+    char *reply = (char *)ctx->buf + sizeof(atl_bench_dns_query);
+    return (atl_dns_parse_request((char *)ctx->buf, ctx->bytes, reply, DNS_MAX_LEN) > 0) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @fn atl_bench_sha_setup(atl_bench_ctx_t *ctx)
+ * @brief Allocate SHA-256 input chunk.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_sha_setup(atl_bench_ctx_t *ctx) {
+    ctx->buf = malloc(ATL_BENCH_SHA_CHUNK);
+    if (ctx->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < ATL_BENCH_SHA_CHUNK; i++) {
+        ctx->buf[i] = (uint8_t)i;
+    }
+    ctx->bytes = ATL_BENCH_SHA_CHUNK;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_sha_run(atl_bench_ctx_t *ctx)
+ * @brief Hash a firmware sized chunk with SHA-256.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_sha_run(atl_bench_ctx_t *ctx) {
+    uint8_t digest[32];
+    return (mbedtls_sha256(ctx->buf, ctx->bytes, digest, 0) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+#ifdef CONFIG_ATL_BENCH_MODE
+/**
+ * @fn atl_bench_ota_setup(atl_bench_ctx_t *ctx)
+ * @brief Begin an update at passive OTA partition (erased here, as at firmware download start).
+ * @details Refused if passive partition holds a staged update (next boot partition) or an image marked valid or
+ *  pending verify (rollback image).
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if a firmware download is running or passive partition
+ *  holds an image in use.
+ */
+static esp_err_t atl_bench_ota_setup(atl_bench_ctx_t *ctx) {
+    atl_mqtt_status_t status;
+    esp_ota_img_states_t state;
+    atl_mqtt_get_status(&status);
+    if (status.ota_active == true) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (partition == esp_ota_get_boot_partition()) {
+        ESP_LOGW(TAG, "Passive partition %s holds a staged update, not erased!", partition->label);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((esp_ota_get_state_partition(partition, &state) == ESP_OK) && ((state == ESP_OTA_IMG_VALID) || (state == ESP_OTA_IMG_PENDING_VERIFY))) {
+        ESP_LOGW(TAG, "Passive partition %s holds a %s image, not erased!", partition->label, (state == ESP_OTA_IMG_VALID) ? "valid" : "pending verify");
+        return ESP_ERR_INVALID_STATE;
+    }
+    ctx->buf = malloc(ATL_BENCH_OTA_CHUNK);
+    if (ctx->buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < ATL_BENCH_OTA_CHUNK; i++) {
+        ctx->buf[i] = (uint8_t)i;
+    }
+    ctx->buf[0] = ESP_IMAGE_HEADER_MAGIC;
+    ctx->bytes = ATL_BENCH_OTA_CHUNK;
+    return esp_ota_begin(partition, OTA_SIZE_UNKNOWN, &ctx->ota);
+}
+
+/**
+ * @fn atl_bench_ota_run(atl_bench_ctx_t *ctx)
+ * @brief Write a firmware chunk to flash.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_ota_run(atl_bench_ctx_t *ctx) {
+    return esp_ota_write(ctx->ota, ctx->buf, ctx->bytes);
+}
+
+/**
+ * @fn atl_bench_ota_teardown(atl_bench_ctx_t *ctx)
+ * @brief Abort update (boot partition is not changed).
+ * @param[in] ctx - Benchmark state
+ */
+static void atl_bench_ota_teardown(atl_bench_ctx_t *ctx) {
+    if (ctx->ota != 0) {
+        esp_ota_abort(ctx->ota);
+    }
+}
+#endif
+
+/**
+ * @fn atl_bench_tls_setup(atl_bench_ctx_t *ctx)
+ * @brief Get MQTT broker address (resolved before measuring, so DNS is not part of the handshake).
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if broker is not configured.
+ */
+static esp_err_t atl_bench_tls_setup(atl_bench_ctx_t *ctx) {
+    ctx->port = ATL_BENCH_TLS_PORT;
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        strncpy(ctx->common_name, (const char*)atl_config.mqtt_client.broker_address, sizeof(ctx->common_name) - 1);
+        if (atl_config.mqtt_client.transport == MQTT_TRANSPORT_OVER_SSL) {
+            ctx->port = atl_config.mqtt_client.broker_port;
+        }
+        ctx->skip_cn = atl_config.mqtt_client.disable_cn_check;
+        xSemaphoreGive(atl_config_mutex);
+    }
+    if (strlen(ctx->common_name) == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (atl_resolver_resolve(ctx->common_name, ctx->host, sizeof(ctx->host)) != ESP_OK) {
+        strncpy(ctx->host, ctx->common_name, sizeof(ctx->host) - 1);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_bench_tls_run(atl_bench_ctx_t *ctx)
+ * @brief Open (full handshake) and close a TLS connection to MQTT broker.
+ * @param[in] ctx - Benchmark state
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_bench_tls_run(atl_bench_ctx_t *ctx) {
+    esp_err_t err = ESP_OK;
+    esp_tls_cfg_t cfg = {
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .common_name = ctx->common_name,
+        .skip_common_name = ctx->skip_cn,
+        .timeout_ms = ATL_BENCH_TLS_TIMEOUT,
+    };
+    esp_tls_t *tls = esp_tls_init();
+    if (tls == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (esp_tls_conn_new_sync(ctx->host, strlen(ctx->host), ctx->port, &cfg, tls) != 1) {
+        err = ESP_FAIL;
+    }
+    esp_tls_conn_destroy(tls);
+    return err;
+}
+
+/** Benchmarks available (flash writing benchmarks only at benchmark builds, they change NVS and erase passive OTA partition). */
+static const atl_bench_case_t atl_bench_cases[] = {
+    {"config_snapshot", "Configuration snapshot (mutex and copy)", 1000, true, atl_bench_config_setup, atl_bench_config_snapshot_run, NULL},
+#ifdef CONFIG_ATL_BENCH_MODE
+    {"config_commit", "Configuration sized blob write and commit (NVS scratch key)", 10, false, atl_bench_nvs_setup, atl_bench_nvs_run, atl_bench_nvs_teardown},
+#endif
+    {"attr_parse", "Shared attributes message parse and dispatch", 100, true, atl_bench_attr_setup, atl_bench_attr_run, NULL},
+    {"telemetry_encode", "Telemetry message encode (cJSON)", 100, true, NULL, atl_bench_json_run, NULL},
+    {"form_parse", "Configuration form body parse", 100, true, atl_bench_form_setup, atl_bench_form_run, NULL},
+    {"dns_reply", "Captive portal DNS reply", 1000, true, atl_bench_dns_setup, atl_bench_dns_run, NULL},
+    {"sha256", "SHA-256 of a 4 KB chunk", 100, true, atl_bench_sha_setup, atl_bench_sha_run, NULL},
+#ifdef CONFIG_ATL_BENCH_MODE
+    {"ota_write", "Firmware chunk write (4 KB, passive OTA partition)", 64, false, atl_bench_ota_setup, atl_bench_ota_run, atl_bench_ota_teardown},
+#endif
+    {"tls_handshake", "TLS handshake to MQTT broker", 1, false, atl_bench_tls_setup, atl_bench_tls_run, NULL},
+};
+
+/**
+ * @fn atl_bench_task(void *args)
+ * @brief Run a benchmark and notify caller.
+ * @param[in] args - Benchmark job
+ */
+static void atl_bench_task(void *args) {
+    atl_bench_job_t *job = (atl_bench_job_t *)args;
+    atl_bench_result_t *result = job->result;
+    atl_bench_ctx_t *ctx = calloc(1, sizeof(atl_bench_ctx_t));
+    if (ctx == NULL) {
+        job->err = ESP_ERR_NO_MEM;
+        goto task_end;
+    }
+
+    job->err = (job->bench->setup != NULL) ? job->bench->setup(ctx) : ESP_OK;
+    if ((job->err == ESP_OK) && (job->bench->warmup == true)) {
+        job->err = job->bench->run(ctx);
+    }
+    for (ctx->iteration = 0; (ctx->iteration < job->iterations) && (job->err == ESP_OK); ctx->iteration++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        job->err = job->bench->run(ctx);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if ((result->iterations == 0) || (cycles < result->cycles_min)) {
+            result->cycles_min = cycles;
+        }
+        if (cycles > result->cycles_max) {
+            result->cycles_max = cycles;
+        }
+        result->cycles_total += cycles;
+        result->iterations++;
+    }
+    if (job->bench->teardown != NULL) {
+        job->bench->teardown(ctx);
+    }
+    result->bytes = ctx->bytes;
+    free(ctx->buf);
+    free(ctx);
+
+task_end:
+    xTaskNotifyGive(job->caller);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @fn atl_bench_count(void)
+ * @brief Get the number of benchmarks available.
+ * @return size_t - Number of benchmarks.
+ */
+size_t atl_bench_count(void) {
+    return sizeof(atl_bench_cases) / sizeof(atl_bench_cases[0]);
+}
+
+/**
+ * @fn atl_bench_get_name(size_t index, const char **help)
+ * @brief Get benchmark name and description.
+ * @param[in] index - Benchmark index (less than atl_bench_count())
+ * @param[out] help - Benchmark description (may be NULL)
+ * @return const char* - Benchmark name (NULL if index is invalid).
+ */
+const char* atl_bench_get_name(size_t index, const char **help) {
+    if (index >= atl_bench_count()) {
+        return NULL;
+    }
+    if (help != NULL) {
+        *help = atl_bench_cases[index].help;
+    }
+    return atl_bench_cases[index].name;
+}
+
+/**
+ * @fn atl_bench_run(const char *name, uint32_t iterations, atl_bench_result_t *result)
+ * @brief Run a benchmark at a task pinned to application core (cycle counter is per core).
+ * @param[in] name - Benchmark name
+ * @param[in] iterations - Iterations (0 to use benchmark default)
+ * @param[out] result - Benchmark result
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if benchmark does not exist, otherwise benchmark error.
+ */
+esp_err_t atl_bench_run(const char *name, uint32_t iterations, atl_bench_result_t *result) {
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    atl_bench_job_t job;
+    if (atl_bench_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(result, 0, sizeof(atl_bench_result_t));
+    for (int i = 0; i < atl_bench_count(); i++) {
+        if (strcmp(atl_bench_cases[i].name, name) != 0) {
+            continue;
+        }
+        if (xSemaphoreTake(atl_bench_mutex, portMAX_DELAY) != pdTRUE) {
+            return ESP_FAIL;
+        }
+        result->name = atl_bench_cases[i].name;
+        result->cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+        job.bench = &atl_bench_cases[i];
+        job.iterations = (iterations > 0) ? iterations : atl_bench_cases[i].iterations;
+        job.result = result;
+        job.err = ESP_OK;
+        job.caller = xTaskGetCurrentTaskHandle();
+        if (xTaskCreatePinnedToCore(atl_bench_task, "atl_bench_task", ATL_BENCH_TASK_STACK, &job, 5, NULL, 1) != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+        } else {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            err = job.err;
+        }
+        xSemaphoreGive(atl_bench_mutex);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Benchmark %s failed! Error: %s", name, esp_err_to_name(err));
+        }
+        break;
+    }
+    return err;
+}
+
+/**
+ * @fn atl_bench_run_all_json(uint32_t iterations)
+ * @brief Run all benchmarks and build the results JSON document.
+ * @details Document has firmware and IDF versions, CPU clock and, per benchmark, iterations, min/avg/max cycles, avg
+ *  time, throughput (if benchmark processes bytes) and error name.
+ * @param[in] iterations - Iterations of each benchmark (0 to use benchmark defaults)
+ * @return char* - JSON document (free with cJSON_free(), NULL if out of memory).
+ */
+char* atl_bench_run_all_json(uint32_t iterations) {
+    atl_bench_result_t result;
+    const esp_app_desc_t *app_desc = esp_app_get_description();
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return NULL;
+    }
+    cJSON_AddStringToObject(root, "greenfield_bench", app_desc->version);
+    cJSON_AddStringToObject(root, "idf", app_desc->idf_ver);
+    cJSON_AddNumberToObject(root, "cpu_mhz", esp_rom_get_cpu_ticks_per_us());
+    cJSON *results = cJSON_AddArrayToObject(root, "results");
+    for (int i = 0; (results != NULL) && (i < atl_bench_count()); i++) {
+        esp_err_t err = atl_bench_run(atl_bench_cases[i].name, iterations, &result);
+        cJSON *item = cJSON_CreateObject();
+        if (item == NULL) {
+            break;
+        }
+        cJSON_AddStringToObject(item, "name", atl_bench_cases[i].name);
+        cJSON_AddNumberToObject(item, "iterations", result.iterations);
+        if (result.iterations > 0) {
+            uint32_t avg = result.cycles_total / result.iterations;
+            cJSON_AddNumberToObject(item, "cycles_min", result.cycles_min);
+            cJSON_AddNumberToObject(item, "cycles_avg", avg);
+            cJSON_AddNumberToObject(item, "cycles_max", result.cycles_max);
+            cJSON_AddNumberToObject(item, "us_avg", (double)avg / result.cycles_per_us);
+            if ((result.bytes > 0) && (avg > 0)) {
+                cJSON_AddNumberToObject(item, "bytes", result.bytes);
+                cJSON_AddNumberToObject(item, "bytes_per_s", ((double)result.bytes * result.cycles_per_us * 1000000) / avg);
+            }
+        }
+        cJSON_AddStringToObject(item, "error", esp_err_to_name(err));
+        cJSON_AddItemToArray(results, item);
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+#ifdef CONFIG_ATL_BENCH_MODE
+/**
+ * @fn atl_bench_boot_task(void *args)
+ * @brief Run benchmark suite once (after network connection delay) and print results JSON.
+ * @param[in] args - Not used
+ */
+static void atl_bench_boot_task(void *args) {
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ATL_BENCH_DELAY * 1000));
+    ESP_LOGI(TAG, "Running benchmark suite...");
+    char *json = atl_bench_run_all_json(CONFIG_ATL_BENCH_ITERATIONS);
+    if (json != NULL) {
+        printf("%s\n", json);
+        cJSON_free(json);
+    } else {
+        ESP_LOGE(TAG, "Failed to allocate memory!");
+    }
+    vTaskDelete(NULL);
+}
+#endif
+
+/**
+ * @fn atl_bench_boot_start(void)
+ * @brief Start benchmark suite at boot (benchmark mode).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if benchmark mode is disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_bench_boot_start(void) {
+#ifdef CONFIG_ATL_BENCH_MODE
+    if (xTaskCreatePinnedToCore(atl_bench_boot_task, "atl_bench_boot", 4096, NULL, 5, NULL, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating benchmark task!");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @fn atl_bench_init(void)
+ * @brief Initialize micro-benchmarks (only one benchmark runs at a time).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_bench_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_bench_mutex != NULL) {
+        return ESP_OK;
+    }
+    atl_bench_mutex = xSemaphoreCreateMutex();
+    if (atl_bench_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file atl_bench.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief On-target micro-benchmarks header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef atl_bench_result_t
+ * @brief Micro-benchmark result (CPU cycles per iteration).
+ */
+typedef struct {
+    const char  *name;          /**< Benchmark name.*/
+    uint32_t    iterations;     /**< Iterations measured.*/
+    uint32_t    cycles_min;     /**< Min. cycles of an iteration.*/
+    uint32_t    cycles_max;     /**< Max. cycles of an iteration.*/
+    uint64_t    cycles_total;   /**< Cycles of all iterations.*/
+    uint32_t    cycles_per_us;  /**< CPU cycles per microsecond (to convert cycles to time).*/
+    uint32_t    bytes;          /**< Bytes processed per iteration (0 if not applicable).*/
+} atl_bench_result_t;
+
+/**
+ * @fn atl_bench_init(void)
+ * @brief Initialize micro-benchmarks (only one benchmark runs at a time).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_bench_init(void);
+
+/**
+ * @fn atl_bench_count(void)
+ * @brief Get the number of benchmarks available.
+ * @return size_t - Number of benchmarks.
+ */
+size_t atl_bench_count(void);
+
+/**
+ * @fn atl_bench_get_name(size_t index, const char **help)
+ * @brief Get benchmark name and description.
+ * @param[in] index - Benchmark index (less than atl_bench_count())
+ * @param[out] help - Benchmark description (may be NULL)
+ * @return const char* - Benchmark name (NULL if index is invalid).
+ */
+const char* atl_bench_get_name(size_t index, const char **help);
+
+/**
+ * @fn atl_bench_run(const char *name, uint32_t iterations, atl_bench_result_t *result)
+ * @brief Run a benchmark at a task pinned to application core (cycle counter is per core).
+ * @param[in] name - Benchmark name
+ * @param[in] iterations - Iterations (0 to use benchmark default)
+ * @param[out] result - Benchmark result
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if benchmark does not exist, otherwise benchmark error.
+ */
+esp_err_t atl_bench_run(const char *name, uint32_t iterations, atl_bench_result_t *result);
+
+/**
+ * @fn atl_bench_run_all_json(uint32_t iterations)
+ * @brief Run all benchmarks and build the results JSON document.
+ * @details Document has firmware and IDF versions, CPU clock and, per benchmark, iterations, min/avg/max cycles, avg
+ *  time, throughput (if benchmark processes bytes) and error name.
+ * @param[in] iterations - Iterations of each benchmark (0 to use benchmark defaults)
+ * @return char* - JSON document (free with cJSON_free(), NULL if out of memory).
+ */
+char* atl_bench_run_all_json(uint32_t iterations);
+
+/**
+ * @fn atl_bench_boot_start(void)
+ * @brief Start benchmark suite at boot (benchmark mode).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if benchmark mode is disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_bench_boot_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,7 +4,7 @@
  * @brief Button functions.
  * @version 0.1.0
  * @date 2024-03-08 (created)
- * @date 2024-03-08 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -19,6 +19,10 @@
 #include <freertos/queue.h>
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include "sdkconfig.h"
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+#include <esp_sleep.h>
+#endif
 #include "atl_led.h"
 
 /* Constants */
@@ -36,9 +40,26 @@ TaskHandle_t atl_button_handle = NULL; /**< Button task handle */
 */
 static void IRAM_ATTR button_isr_handler(void *args) {
     uint32_t button_pin = (uint32_t)args;
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+    /* Level interrupt keeps firing until button task arms the opposite level */
+    gpio_intr_disable(button_pin);
+#endif
     xQueueSendFromISR(button_evt_queue, &button_pin, NULL);  
 }
 
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+/**
+ * @fn button_arm(int level)
+ * @brief Arm button interrupt (and light sleep wakeup) at the level opposite to current one.
+ * @details Edge interrupts do not wake the chip up from light sleep, so button changes are caught as level interrupts.
+ * @param [in] level - Current button level
+*/
+static void button_arm(int level) {
+    gpio_wakeup_enable(CONFIG_ATL_BUTTON_GPIO, (level == 0) ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    gpio_intr_enable(CONFIG_ATL_BUTTON_GPIO);
+}
+#endif
+
 /**
  * @fn atl_button_task(void *args)
  * @brief Button task
@@ -52,13 +73,17 @@ static void atl_button_task(void *args) {
 
         /* Check for button event */
         if (xQueueReceive(button_evt_queue, &gpio_pin, portMAX_DELAY)) {
-            if (gpio_get_level(CONFIG_ATL_BUTTON_GPIO) == 0) {
+            int level = gpio_get_level(CONFIG_ATL_BUTTON_GPIO);
+            if (level == 0) {
                 button_pressed = true;
                 atl_led_set_color(255, 69, 0);                
             } else {
                 button_pressed = false;
                 atl_led_set_color(0, 0, 255);
             }             
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+            button_arm(level);
+#endif
         }        
     }    
 }
@@ -74,7 +99,9 @@ void atl_button_init(void) {
     gpio_set_direction(CONFIG_ATL_BUTTON_GPIO, GPIO_MODE_INPUT);
     gpio_pulldown_en(CONFIG_ATL_BUTTON_GPIO);
     gpio_pullup_dis(CONFIG_ATL_BUTTON_GPIO);
+#ifndef CONFIG_ATL_PM_LIGHT_SLEEP
     gpio_set_intr_type(CONFIG_ATL_BUTTON_GPIO, GPIO_INTR_ANYEDGE);
+#endif
     button_evt_queue = xQueueCreate(10, sizeof(uint32_t));
 
     /* Create LED builtin task at CPU 1 */
@@ -83,4 +110,10 @@ void atl_button_init(void) {
     /* Install interruption handler at button event */
     gpio_install_isr_service(0);
     gpio_isr_handler_add(CONFIG_ATL_BUTTON_GPIO, button_isr_handler, (void*)CONFIG_ATL_BUTTON_GPIO);
+
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+    /* Button wakes the chip up from automatic light sleep */
+    button_arm(gpio_get_level(CONFIG_ATL_BUTTON_GPIO));
+    esp_sleep_enable_gpio_wakeup();
+#endif
 }
\ No newline at end of file
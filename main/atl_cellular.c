@@ -0,0 +1,345 @@
+/**
+ * @file atl_cellular.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Cellular (4G) modem backend.
+ * @details The modem runs PPP over UART multiplexed with CMUX (3GPP 27.010): PPP goes through the data channel while
+ *  status queries use the AT channel concurrently, so the link never drops to command mode. Status queries are
+ *  pipelined in a single command line (signal, registration with cell location and operator), one round trip per
+ *  status update. If the modem does not accept CMUX, plain data mode is used and status queries are disabled.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+#include <driver/uart.h>
+#include <esp_modem_api.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_netmgr.h"
+#include "atl_pm.h"
+#include "atl_cellular.h"
+
+#define ATL_CELLULAR_AT_TIMEOUT         1000    /* AT command timeout (in ms) */
+#define ATL_CELLULAR_SYNC_RETRY_DELAY   2000    /* Delay between modem sync attempts (in ms) */
+#define ATL_CELLULAR_STATUS_CMD         "AT+CSQ;+CEREG?;+COPS?\r"   /* Pipelined status query */
+#define ATL_CELLULAR_LINE_MAX           96      /* Max. answer line parsed (longer lines are truncated) */
+
+/* Constants */
+static const char *TAG = "atl-cellular";
+
+/* Global variables */
+static esp_modem_dce_t *atl_cellular_dce = NULL;
+static esp_netif_t *atl_cellular_netif = NULL;
+static SemaphoreHandle_t atl_cellular_mutex = NULL;
+static atl_cellular_status_t atl_cellular_status;
+static int64_t atl_cellular_status_time = 0;        /* Last status query time (in us, 0 if never queried) */
+static char atl_cellular_pin[8];
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/**
+ * @fn atl_cellular_parse_line(const char *line, atl_cellular_status_t *status)
+ * @brief Parse a line of pipelined status query answer.
+ * @details Unsolicited +CEREG (no <n> field, sent at registration changes) and other URCs may arrive between answer
+ *  lines, they are ignored.
+ * @param[in] line - Answer line (without line terminator)
+ * @param[in,out] status - Modem status
+ * @return uint8_t - Answer found at line (ATL_CELLULAR_PARSE_* flag, 0 if none).
+ */
+static uint8_t atl_cellular_parse_line(const char *line, atl_cellular_status_t *status) {
+    int rssi, ber, n, stat, act;
+    unsigned int tac, ci;
+    char oper[sizeof(status->operator_name)];
+
+    /* +CSQ: <rssi>,<ber> (rssi 0..31 = -113..-51 dBm, 99 = unknown) */
+    if (sscanf(line, "+CSQ: %d,%d", &rssi, &ber) == 2) {
+        status->rssi_dbm = ((rssi >= 0) && (rssi <= 31)) ? (-113 + (2 * rssi)) : 0;
+        status->ber = ber;
+        return ATL_CELLULAR_PARSE_CSQ;
+    }
+
+    /* +CEREG: <n>,<stat>[,"<tac>","<ci>",<AcT>] (location fields enabled with AT+CEREG=2, URC has no <n>) */
+    if (strncmp(line, "+CEREG:", 7) == 0) {
+        int fields = sscanf(line, "+CEREG: %d,%d,\"%x\",\"%x\",%d", &n, &stat, &tac, &ci, &act);
+        if (fields < 2) {
+            return 0;
+        }
+        status->reg_stat = stat;
+        status->registered = ((stat == 1) || (stat == 5));
+        if (fields == 5) {
+            status->tac = tac;
+            status->cell_id = ci;
+            status->act = act;
+        } else {
+            status->tac = 0;
+            status->cell_id = 0;
+            status->act = 0;
+        }
+        return ATL_CELLULAR_PARSE_CEREG;
+    }
+
+    /* +COPS: <mode>[,<format>,"<oper>"[,<AcT>]] (no operator if not registered) */
+    if (strncmp(line, "+COPS:", 6) == 0) {
+        const char *quote = strchr(line, '"');
+        if ((quote != NULL) && (sscanf(quote, "\"%23[^\"]\"", oper) == 1)) {
+            snprintf(status->operator_name, sizeof(status->operator_name), "%s", oper);
+        } else {
+            status->operator_name[0] = '\0';
+        }
+        return ATL_CELLULAR_PARSE_COPS;
+    }
+
+    /* Final result codes (an error ends the pipelined command line) */
+    if ((strncmp(line, "+CME ERROR", 10) == 0) || (strcmp(line, "ERROR") == 0)) {
+        return ATL_CELLULAR_PARSE_ERROR;
+    }
+    if (strcmp(line, "OK") == 0) {
+        return ATL_CELLULAR_PARSE_OK;
+    }
+    return 0;
+}
+
+/**
+ * @fn atl_cellular_parse_status(const char *resp, atl_cellular_status_t *status)
+ * @brief Parse the answer of pipelined status query (+CSQ, +CEREG and +COPS lines).
+ * @details Only complete lines are parsed (an answer cut by timeout keeps its last line unparsed). Answers before an
+ *  error are still used, fields without answer are not updated.
+ * @param[in] resp - Modem answer
+ * @param[in,out] status - Modem status
+ * @return uint8_t - Answers found (ATL_CELLULAR_PARSE_* flags).
+ */
+uint8_t atl_cellular_parse_status(const char *resp, atl_cellular_status_t *status) {
+    char line[ATL_CELLULAR_LINE_MAX];
+    uint8_t found = 0;
+    while (*resp != '\0') {
+        size_t len = strcspn(resp, "\r\n");
+        if (resp[len] == '\0') {
+            break;
+        }
+        if (len > 0) {
+            snprintf(line, sizeof(line), "%.*s", (int)len, resp);
+            found |= atl_cellular_parse_line(line, status);
+        }
+        resp += len + 1;
+    }
+    return found;
+}
+
+/**
+ * @fn atl_cellular_query_status(void)
+ * @brief Query modem status through CMUX AT channel (data channel keeps running).
+ */
+static void atl_cellular_query_status(void) {
+    char resp[CONFIG_ESP_MODEM_C_API_STR_MAX];
+    atl_cellular_status_t status;
+
+    /* Answers before an error (or timeout) are still used */
+    memset(resp, 0, sizeof(resp));
+    esp_err_t err = esp_modem_at_raw(atl_cellular_dce, ATL_CELLULAR_STATUS_CMD, resp, "OK", "ERROR", ATL_CELLULAR_AT_TIMEOUT);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Status query failed: %s", esp_err_to_name(err));
+    }
+    if (xSemaphoreTake(atl_cellular_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&status, &atl_cellular_status, sizeof(atl_cellular_status_t));
+        xSemaphoreGive(atl_cellular_mutex);
+    } else {
+        return;
+    }
+    uint8_t found = atl_cellular_parse_status(resp, &status);
+    if ((found & (ATL_CELLULAR_PARSE_CSQ | ATL_CELLULAR_PARSE_CEREG | ATL_CELLULAR_PARSE_COPS)) == 0) {
+        return;
+    }
+    ESP_LOGD(TAG, "rssi=%d dBm, reg=%d, operator=%s, tac=%04X, ci=%08lX", status.rssi_dbm, status.reg_stat,
+             status.operator_name, status.tac, status.cell_id);
+    if (xSemaphoreTake(atl_cellular_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&atl_cellular_status, &status, sizeof(atl_cellular_status_t));
+        atl_cellular_status_time = esp_timer_get_time();
+        xSemaphoreGive(atl_cellular_mutex);
+    }
+}
+
+/**
+ * @fn atl_cellular_task(void *args)
+ * @brief Cellular task (modem bring-up and periodic status query).
+ * @details UART receive does not wake the chip from light sleep, so light sleep is blocked from bring-up for as long
+ *  as the PPP session runs (the modem sends data at any time).
+ * @param[in] args - Not used
+ */
+static void atl_cellular_task(void *args) {
+    char resp[CONFIG_ESP_MODEM_C_API_STR_MAX];
+    bool pin_ok = false;
+    bool cmux = false;
+    atl_pm_acquire(ATL_PM_LOCK_UART);
+
+    /* Wait modem answer (it may be still booting) */
+    while (esp_modem_sync(atl_cellular_dce) != ESP_OK) {
+        ESP_LOGW(TAG, "Modem not answering, retrying...");
+        vTaskDelay(pdMS_TO_TICKS(ATL_CELLULAR_SYNC_RETRY_DELAY));
+    }
+
+    /* Unlock SIM card */
+    if ((esp_modem_read_pin(atl_cellular_dce, &pin_ok) == ESP_OK) && (pin_ok == false)) {
+        if ((atl_cellular_pin[0] == '\0') || (esp_modem_set_pin(atl_cellular_dce, atl_cellular_pin) != ESP_OK)) {
+            ESP_LOGE(TAG, "SIM card locked (check PIN)!");
+            atl_pm_release(ATL_PM_LOCK_UART);
+            vTaskDelete(NULL);
+            return;
+        }
+    }
+
+    /* Report tracking area and cell at registration status */
+    esp_modem_at(atl_cellular_dce, "AT+CEREG=2", resp, ATL_CELLULAR_AT_TIMEOUT);
+
+    /* Start PPP through CMUX data channel (plain data mode if modem does not support CMUX) */
+    if (esp_modem_set_mode(atl_cellular_dce, ESP_MODEM_MODE_CMUX) == ESP_OK) {
+        cmux = true;
+    } else {
+        ESP_LOGW(TAG, "CMUX not supported, using data mode (status queries disabled)!");
+        if (esp_modem_set_mode(atl_cellular_dce, ESP_MODEM_MODE_DATA) != ESP_OK) {
+            ESP_LOGE(TAG, "Fail starting data mode!");
+            atl_pm_release(ATL_PM_LOCK_UART);
+            vTaskDelete(NULL);
+            return;
+        }
+    }
+    if (xSemaphoreTake(atl_cellular_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_cellular_status.started = true;
+        atl_cellular_status.cmux = cmux;
+        xSemaphoreGive(atl_cellular_mutex);
+    }
+    ESP_LOGI(TAG, "Modem started (%s mode)", cmux ? "CMUX" : "data");
+
+    /* Periodic status query (PPP session keeps the UART lock after task ends) */
+    while (cmux == true) {
+        atl_cellular_query_status();
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_ATL_CELLULAR_STATUS_INTERVAL * 1000));
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @fn atl_cellular_init(void)
+ * @brief Initialize cellular modem (PPP over UART with CMUX) and register it as a metered uplink.
+ * @details Modem bring-up runs at cellular task, so this function does not wait for network registration.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_cellular_init(void) {
+    esp_err_t err = ESP_OK;
+    char apn[sizeof(atl_config.cellular.apn) + 1];
+    ESP_LOGI(TAG, "Starting cellular modem");
+
+    /* Get APN and PIN from configuration */
+    memset(apn, 0, sizeof(apn));
+    memset(atl_cellular_pin, 0, sizeof(atl_cellular_pin));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(apn, atl_config.cellular.apn, sizeof(atl_config.cellular.apn));
+        memcpy(atl_cellular_pin, atl_config.cellular.pin, sizeof(atl_cellular_pin) - 1);
+        xSemaphoreGive(atl_config_mutex);
+    } else {
+        ESP_LOGE(TAG, "Fail to get configuration mutex!");
+        return ESP_FAIL;
+    }
+
+    /* Initialize network interface and event loop (also used by WiFi) */
+    err = esp_netif_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail initializing network interface!");
+        goto error_proc;
+    }
+    err = esp_event_loop_create_default();
+    if ((err != ESP_OK) && (err != ESP_ERR_INVALID_STATE)) {
+        ESP_LOGE(TAG, "Fail creating event loop!");
+        goto error_proc;
+    }
+
+    /* Create status mutex */
+    atl_cellular_mutex = xSemaphoreCreateMutex();
+    if (atl_cellular_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    memset(&atl_cellular_status, 0, sizeof(atl_cellular_status_t));
+    atl_cellular_status.ber = 99;
+
+    /* Create PPP network interface */
+    esp_netif_config_t netif_ppp_config = ESP_NETIF_DEFAULT_PPP();
+    atl_cellular_netif = esp_netif_new(&netif_ppp_config);
+    if (atl_cellular_netif == NULL) {
+        ESP_LOGE(TAG, "Fail creating PPP network interface!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+
+    /* Create modem (DTE at UART, generic DCE) */
+    esp_modem_dte_config_t dte_config = ESP_MODEM_DTE_DEFAULT_CONFIG();
+    dte_config.uart_config.port_num = UART_NUM_1;
+    dte_config.uart_config.baud_rate = CONFIG_ATL_CELLULAR_UART_BAUD;
+    dte_config.uart_config.tx_io_num = CONFIG_ATL_CELLULAR_UART_TX;
+    dte_config.uart_config.rx_io_num = CONFIG_ATL_CELLULAR_UART_RX;
+    dte_config.uart_config.rts_io_num = CONFIG_ATL_CELLULAR_UART_RTS;
+    dte_config.uart_config.cts_io_num = CONFIG_ATL_CELLULAR_UART_CTS;
+    dte_config.uart_config.flow_control = ((CONFIG_ATL_CELLULAR_UART_RTS >= 0) && (CONFIG_ATL_CELLULAR_UART_CTS >= 0)) ?
+                                          ESP_MODEM_FLOW_CONTROL_HW : ESP_MODEM_FLOW_CONTROL_NONE;
+    esp_modem_dce_config_t dce_config = ESP_MODEM_DCE_DEFAULT_CONFIG(apn);
+    atl_cellular_dce = esp_modem_new_dev(ESP_MODEM_DCE_GENERIC, &dte_config, &dce_config, atl_cellular_netif);
+    if (atl_cellular_dce == NULL) {
+        ESP_LOGE(TAG, "Fail creating modem!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+
+    /* Register cellular as network manager uplink */
+    atl_netmgr_register(ATL_NETMGR_UPLINK_CELLULAR, atl_cellular_netif, CONFIG_ATL_NETMGR_PRIORITY_CELLULAR, CONFIG_ATL_CELLULAR_METERED);
+
+    /* Start cellular task */
+    if (xTaskCreatePinnedToCore(atl_cellular_task, "atl_cellular_task", 4096, NULL, 5, NULL, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating cellular task!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
+
+/**
+ * @fn atl_cellular_get_status(atl_cellular_status_t *status)
+ * @brief Get cellular modem status.
+ * @param[out] status - Modem status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if cellular backend is not initialized.
+ */
+esp_err_t atl_cellular_get_status(atl_cellular_status_t *status) {
+    if (atl_cellular_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_cellular_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    memcpy(status, &atl_cellular_status, sizeof(atl_cellular_status_t));
+    status->age_ms = (atl_cellular_status_time == 0) ? UINT32_MAX : (uint32_t)((esp_timer_get_time() - atl_cellular_status_time) / 1000);
+    xSemaphoreGive(atl_cellular_mutex);
+    status->ppp_up = esp_netif_is_netif_up(atl_cellular_netif);
+    return ESP_OK;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file atl_cellular.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Cellular (4G) modem backend header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Answers found at pipelined status query (see atl_cellular_parse_status()) */
+#define ATL_CELLULAR_PARSE_CSQ      0x01    /**< Signal quality (+CSQ).*/
+#define ATL_CELLULAR_PARSE_CEREG    0x02    /**< Registration (+CEREG, answer only).*/
+#define ATL_CELLULAR_PARSE_COPS     0x04    /**< Operator (+COPS).*/
+#define ATL_CELLULAR_PARSE_ERROR    0x08    /**< Error (ERROR or +CME ERROR).*/
+#define ATL_CELLULAR_PARSE_OK       0x10    /**< Command line finished (OK).*/
+
+/**
+ * @typedef atl_cellular_status_t
+ * @brief Cellular modem status (from last status query).
+ */
+typedef struct {
+    bool        started;            /**< Modem answered and PPP was requested.*/
+    bool        cmux;               /**< Modem in CMUX mode (status queries available while in data mode).*/
+    bool        ppp_up;             /**< PPP link up.*/
+    bool        registered;         /**< Registered at network (home or roaming).*/
+    uint8_t     reg_stat;           /**< Registration status (+CEREG <stat>).*/
+    int16_t     rssi_dbm;           /**< Signal strength in dBm (0 if unknown).*/
+    uint8_t     ber;                /**< Bit error rate (99 if unknown).*/
+    char        operator_name[24];  /**< Network operator.*/
+    uint16_t    tac;                /**< Tracking area code.*/
+    uint32_t    cell_id;            /**< Cell identity.*/
+    uint8_t     act;                /**< Access technology (7 = LTE).*/
+    uint32_t    age_ms;             /**< Time since last status query (UINT32_MAX if never queried).*/
+} atl_cellular_status_t;
+
+/**
+ * @fn atl_cellular_init(void)
+ * @brief Initialize cellular modem (PPP over UART with CMUX) and register it as a metered uplink.
+ * @details Modem bring-up runs at cellular task, so this function does not wait for network registration.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_cellular_init(void);
+
+/**
+ * @fn atl_cellular_parse_status(const char *resp, atl_cellular_status_t *status)
+ * @brief Parse the answer of pipelined status query (+CSQ, +CEREG and +COPS lines).
+ * @details Only complete lines are parsed (an answer cut by timeout keeps its last line unparsed). Answers before an
+ *  error are still used, fields without answer are not updated. URCs between answer lines are ignored.
+ * @param[in] resp - Modem answer
+ * @param[in,out] status - Modem status
+ * @return uint8_t - Answers found (ATL_CELLULAR_PARSE_* flags).
+ */
+uint8_t atl_cellular_parse_status(const char *resp, atl_cellular_status_t *status);
+
+/**
+ * @fn atl_cellular_get_status(atl_cellular_status_t *status)
+ * @brief Get cellular modem status.
+ * @param[out] status - Modem status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if cellular backend is not initialized.
+ */
+esp_err_t atl_cellular_get_status(atl_cellular_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,7 +4,7 @@
  * @brief Configuration functions.
  * @version 0.1.0
  * @date 2024-03-10 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -22,6 +22,9 @@
 #include <nvs.h>
 #include "sdkconfig.h"
 #include "atl_config.h"
+#include "atl_trace.h"
+#include "atl_stall.h"
+#include "atl_energy.h"
 
 /* Constants */
 static const char *TAG = "atl-config";
@@ -29,6 +32,8 @@ static const char *TAG = "atl-config";
 /* Global variables */
 SemaphoreHandle_t atl_config_mutex;
 atl_config_t atl_config;
+static volatile uint32_t atl_config_generation = 0;    /* Incremented at each configuration commit */
+static int atl_config_stall = -1;                       /* NVS commit latency budget */
 
 /**
  * @fn atl_config_create_default(void)
@@ -68,6 +73,25 @@ static void atl_config_create_default(void) {
     strncpy((char*)&atl_config.mqtt_client.user, (char*)&atl_config.wifi.ap_ssid, sizeof(atl_config.mqtt_client.user));
     strncpy((char*)&atl_config.mqtt_client.pass, (char*)&atl_config.wifi.ap_ssid, sizeof(atl_config.mqtt_client.pass));
     atl_config.mqtt_client.qos = CONFIG_ATL_MQTT_QOS;
+
+    /** Creates default Group configuration **/
+    strncpy((char*)&atl_config.group.id, CONFIG_ATL_MQTT_GROUP_ID, sizeof(atl_config.group.id));
+    atl_config.group.version = 0;
+    atl_config.group.override_mask = 0;
+
+    /** Creates default Cellular configuration **/
+    atl_config.cellular.enabled = false;
+    strncpy((char*)&atl_config.cellular.apn, CONFIG_ATL_CELLULAR_APN, sizeof(atl_config.cellular.apn));
+    memset(atl_config.cellular.pin, 0, sizeof(atl_config.cellular.pin));
+
+    /** Creates default LoRaWAN configuration (DevEUI derived from MAC address) **/
+    char eui[17];
+    atl_config.lora.enabled = false;
+    snprintf(eui, sizeof(eui), "%02X%02X%02XFFFE%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    memcpy(atl_config.lora.dev_eui, eui, sizeof(atl_config.lora.dev_eui));
+    strncpy((char*)&atl_config.lora.join_eui, CONFIG_ATL_LORA_JOIN_EUI, sizeof(atl_config.lora.join_eui));
+    memset(atl_config.lora.app_key, 0, sizeof(atl_config.lora.app_key));
+    atl_config.lora.interval = CONFIG_ATL_LORA_INTERVAL;
 }
 
 /**
@@ -86,6 +110,7 @@ esp_err_t atl_config_init(void) {
         ESP_LOGE(TAG, "Error creating configuration semaphore!");
         return ESP_FAIL;        
     }
+    atl_config_stall = atl_stall_register("nvs_commit", ATL_STALL_FLASH_BUDGET);
 
     /* Open NVS system */
     ESP_LOGI(TAG, "Loading configuration from NVS");
@@ -121,6 +146,24 @@ esp_err_t atl_config_init(void) {
             ESP_LOGE(TAG, "Fail writing new configuration file!");
             goto error_proc;
         } 
+    } else if (file_size < sizeof(atl_config_t)) {
+        
+        /* Configuration file from previous firmware (fields appended since), fill new fields with default values */
+        ESP_LOGW(TAG, "Configuration file outdated (%u bytes)! Updating with default values!", file_size);
+        atl_config_t atl_config_stored;
+        memcpy(&atl_config_stored, &atl_config, file_size);
+        atl_config_create_default();
+        memcpy(&atl_config, &atl_config_stored, file_size);
+        err = nvs_set_blob(nvs_handler, "atl_config", &atl_config, sizeof(atl_config_t));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fail updating configuration file!");
+            goto error_proc;
+        }
+        err = nvs_commit(nvs_handler);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fail writing updated configuration file!");
+            goto error_proc;
+        }
     }
 
     /* Close NVS */
@@ -148,6 +191,8 @@ esp_err_t atl_config_commit_nvs(void) {
     
     /* Open NVS system */    
     if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_trace_begin("nvs_commit");
+        atl_stall_begin(atl_config_stall);
         ESP_LOGD(TAG, "Mounting NVS storage");
         err = nvs_open("nvs", NVS_READWRITE, &nvs_handler);
         if (err != ESP_OK) {
@@ -172,6 +217,10 @@ esp_err_t atl_config_commit_nvs(void) {
         /* Close NVS */
         ESP_LOGD(TAG, "Unmounting NVS storage");
         nvs_close(nvs_handler);
+        atl_config_generation++;
+        atl_energy_flash(atl_energy_current(), 0, sizeof(atl_config_t));
+        atl_stall_end(atl_config_stall);
+        atl_trace_end("nvs_commit");
         xSemaphoreGive(atl_config_mutex);
         return ESP_OK;
     }
@@ -184,6 +233,18 @@ esp_err_t atl_config_commit_nvs(void) {
 error_proc:
     ESP_LOGE(TAG, "Error: %s", esp_err_to_name(err));
     nvs_close(nvs_handler);
+    atl_stall_end(atl_config_stall);
+    atl_trace_end("nvs_commit");
     xSemaphoreGive(atl_config_mutex);
     return err;
 }
+
+/**
+ * @fn atl_config_get_generation(void)
+ * @brief Get configuration generation (incremented at each commit).
+ * @details Used to invalidate data derived from configuration (i.e. rendered webpages).
+ * @return uint32_t - Configuration generation.
+ */
+uint32_t atl_config_get_generation(void) {
+    return atl_config_generation;
+}
@@ -4,7 +4,7 @@
  * @brief Configuration header.
  * @version 0.1.0
  * @date 2024-03-08 (created)
- * @date 2024-03-10 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -88,6 +88,38 @@ typedef struct {
     atl_mqtt_qos_e          qos;                /**< MQTT QoS level.*/
 } atl_mqtt_client_t;
 
+/**
+ * @typedef atl_config_group_t
+ * @brief Group (fleet) configuration structure.
+ */
+typedef struct {
+    uint8_t     id[32];         /**< Group ID (empty if not member of a group).*/
+    uint32_t    version;        /**< Last group configuration version applied.*/
+    uint32_t    override_mask;  /**< Settings overridden by device attributes (bit per attribute key).*/
+} atl_config_group_t;
+
+/**
+ * @typedef atl_config_cellular_t
+ * @brief Cellular (4G) configuration structure.
+ */
+typedef struct {
+    bool        enabled;    /**< Cellular modem enabled.*/
+    uint8_t     apn[64];    /**< Access point name.*/
+    uint8_t     pin[8];     /**< SIM card PIN (empty if not locked).*/
+} atl_config_cellular_t;
+
+/**
+ * @typedef atl_config_lora_t
+ * @brief LoRaWAN configuration structure.
+ */
+typedef struct {
+    bool        enabled;        /**< LoRaWAN uplink enabled.*/
+    uint8_t     dev_eui[16];    /**< Device EUI (hex string, not null terminated if full).*/
+    uint8_t     join_eui[16];   /**< Join EUI (hex string, not null terminated if full).*/
+    uint8_t     app_key[32];    /**< Application key (hex string, not null terminated if full).*/
+    uint16_t    interval;       /**< Uplink interval (in seconds).*/
+} atl_config_lora_t;
+
 /**
  * @typedef atl_config_t
  * @brief Configuration structure.
@@ -98,6 +130,9 @@ typedef struct {
     atl_config_wifi_t       wifi;           /**< WiFi configuration. */
     atl_config_webserver_t  webserver;      /**< Webserver configuration. */
     atl_mqtt_client_t       mqtt_client;    /**< MQTT client configuration. */
+    atl_config_group_t      group;          /**< Group configuration. */
+    atl_config_cellular_t   cellular;       /**< Cellular (4G) configuration. */
+    atl_config_lora_t       lora;           /**< LoRaWAN configuration. */
 } atl_config_t;
 
 /**
@@ -116,6 +151,14 @@ esp_err_t atl_config_init(void);
  */
 esp_err_t atl_config_commit_nvs(void);
 
+/**
+ * @fn atl_config_get_generation(void)
+ * @brief Get configuration generation (incremented at each commit).
+ * @details Used to invalidate data derived from configuration (i.e. rendered webpages).
+ * @return uint32_t - Configuration generation.
+ */
+uint32_t atl_config_get_generation(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,875 @@
+/**
+ * @file atl_console.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Interactive console (serial and TCP).
+ * @details Field debugging and performance triage without reflashing: heap and task stats, metrics, stalls, energy,
+ *  configuration, WiFi scan, MQTT status, span trace and in-place micro-benchmarks. The serial console is an
+ *  esp_console REPL. The TCP console (SoftAP mode) serves the same command table with its own line reader, and
+ *  redirects stdout of its task to the client socket, so commands print the same way at both consoles.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_heap_caps.h>
+#include <esp_console.h>
+#include <lwip/sockets.h>
+#include <mqtt_client.h>
+#include <cJSON.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_wifi.h"
+#include "atl_mqtt.h"
+#include "atl_diag.h"
+#include "atl_bench.h"
+#include "atl_trace.h"
+#include "atl_webserver.h"
+#include "atl_cellular.h"
+#include "atl_console.h"
+
+#define ATL_CONSOLE_LINE_MAX        256     /* Max. command line length */
+#define ATL_CONSOLE_MAX_ARGS        8       /* Max. command arguments */
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+#define ATL_CONSOLE_TASK_STACK      8192    /* Console task stack (webpage command runs a TLS handshake) */
+#else
+#define ATL_CONSOLE_TASK_STACK      6144    /* Console task stack */
+#endif
+#define ATL_CONSOLE_SCAN_RESULTS    20      /* WiFi scan results listed */
+#define ATL_CONSOLE_SCAN_TIMEOUT    10000   /* WiFi scan timeout (in ms) */
+
+/**
+ * @enum    atl_console_field_e
+ * @brief   Configuration field type (config get/set).
+ */
+typedef enum {
+    ATL_CONSOLE_FIELD_STR,              /**< String (null terminated).*/
+    ATL_CONSOLE_FIELD_SECRET,           /**< String never printed.*/
+    ATL_CONSOLE_FIELD_U8,               /**< Unsigned 8 bits.*/
+    ATL_CONSOLE_FIELD_U16,              /**< Unsigned 16 bits.*/
+    ATL_CONSOLE_FIELD_BOOL,             /**< Boolean (true/false).*/
+    ATL_CONSOLE_FIELD_ENUM,             /**< Enum value (number up to max).*/
+    ATL_CONSOLE_FIELD_WIFI_MODE,        /**< atl_wifi_mode_e (by name).*/
+    ATL_CONSOLE_FIELD_MQTT_MODE,        /**< atl_mqtt_mode_e (by name).*/
+    ATL_CONSOLE_FIELD_MQTT_TRANSPORT,   /**< esp_mqtt_transport_t (by name).*/
+} atl_console_field_e;
+
+/**
+ * @typedef atl_console_field_t
+ * @brief Configuration field reachable from console.
+ */
+typedef struct {
+    const char          *name;      /**< Field name (section.key).*/
+    atl_console_field_e type;       /**< Field type.*/
+    size_t              offset;     /**< Offset at atl_config_t.*/
+    size_t              size;       /**< Field size.*/
+    uint32_t            max;        /**< Max. value (ATL_CONSOLE_FIELD_ENUM only).*/
+} atl_console_field_t;
+
+#define ATL_CONSOLE_FIELD(name, type, member, max) { name, type, offsetof(atl_config_t, member), sizeof(((atl_config_t *)0)->member), max }
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/* Constants */
+static const char *TAG = "atl-console";
+#if defined(CONFIG_ATL_CONSOLE_UART) || defined(CONFIG_ATL_CONSOLE_TCP)
+static const char *atl_console_log_level_str[] = {"none", "error", "warn", "info", "debug", "verbose"};
+static const atl_console_field_t atl_console_fields[] = {
+    ATL_CONSOLE_FIELD("wifi.mode", ATL_CONSOLE_FIELD_WIFI_MODE, wifi.mode, 0),
+    ATL_CONSOLE_FIELD("wifi.ap_ssid", ATL_CONSOLE_FIELD_STR, wifi.ap_ssid, 0),
+    ATL_CONSOLE_FIELD("wifi.ap_pass", ATL_CONSOLE_FIELD_SECRET, wifi.ap_pass, 0),
+    ATL_CONSOLE_FIELD("wifi.ap_channel", ATL_CONSOLE_FIELD_U8, wifi.ap_channel, 0),
+    ATL_CONSOLE_FIELD("wifi.ap_max_conn", ATL_CONSOLE_FIELD_U8, wifi.ap_max_conn, 0),
+    ATL_CONSOLE_FIELD("wifi.sta_ssid", ATL_CONSOLE_FIELD_STR, wifi.sta_ssid, 0),
+    ATL_CONSOLE_FIELD("wifi.sta_pass", ATL_CONSOLE_FIELD_SECRET, wifi.sta_pass, 0),
+    ATL_CONSOLE_FIELD("wifi.sta_channel", ATL_CONSOLE_FIELD_U8, wifi.sta_channel, 0),
+    ATL_CONSOLE_FIELD("wifi.sta_max_conn_retry", ATL_CONSOLE_FIELD_U8, wifi.sta_max_conn_retry, 0),
+    ATL_CONSOLE_FIELD("mqtt.mode", ATL_CONSOLE_FIELD_MQTT_MODE, mqtt_client.mode, 0),
+    ATL_CONSOLE_FIELD("mqtt.broker_address", ATL_CONSOLE_FIELD_STR, mqtt_client.broker_address, 0),
+    ATL_CONSOLE_FIELD("mqtt.broker_port", ATL_CONSOLE_FIELD_U16, mqtt_client.broker_port, 0),
+    ATL_CONSOLE_FIELD("mqtt.transport", ATL_CONSOLE_FIELD_MQTT_TRANSPORT, mqtt_client.transport, 0),
+    ATL_CONSOLE_FIELD("mqtt.disable_cn_check", ATL_CONSOLE_FIELD_BOOL, mqtt_client.disable_cn_check, 0),
+    ATL_CONSOLE_FIELD("mqtt.user", ATL_CONSOLE_FIELD_STR, mqtt_client.user, 0),
+    ATL_CONSOLE_FIELD("mqtt.pass", ATL_CONSOLE_FIELD_SECRET, mqtt_client.pass, 0),
+    ATL_CONSOLE_FIELD("mqtt.qos", ATL_CONSOLE_FIELD_ENUM, mqtt_client.qos, ATL_MQTT_QOS2),
+    ATL_CONSOLE_FIELD("cellular.enabled", ATL_CONSOLE_FIELD_BOOL, cellular.enabled, 0),
+    ATL_CONSOLE_FIELD("cellular.apn", ATL_CONSOLE_FIELD_STR, cellular.apn, 0),
+    ATL_CONSOLE_FIELD("cellular.pin", ATL_CONSOLE_FIELD_SECRET, cellular.pin, 0),
+    ATL_CONSOLE_FIELD("lora.enabled", ATL_CONSOLE_FIELD_BOOL, lora.enabled, 0),
+    ATL_CONSOLE_FIELD("lora.interval", ATL_CONSOLE_FIELD_U16, lora.interval, 0),
+};
+
+/**
+ * @fn atl_console_diag_sink(void *ctx, const char *data, size_t len)
+ * @brief Print diagnostics output to console.
+ * @param[in] ctx - Not used
+ * @param[in] data - Data
+ * @param[in] len - Data length
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_console_diag_sink(void *ctx, const char *data, size_t len) {
+    fwrite(data, 1, len, stdout);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_console_diag(const char *member)
+ * @brief Print a diagnostics bundle member.
+ * @param[in] member - Member name
+ * @return int - Command return code.
+ */
+static int atl_console_diag(const char *member) {
+    esp_err_t err = atl_diag_member_write(member, atl_console_diag_sink, NULL);
+    printf("\n");
+    if (err != ESP_OK) {
+        printf("Error: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_heap(int argc, char **argv)
+ * @brief Print heap statistics by capability.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_heap(int argc, char **argv) {
+    static const struct {
+        const char  *name;
+        uint32_t    caps;
+    } regions[] = {
+        {"internal", MALLOC_CAP_INTERNAL},
+        {"dma", MALLOC_CAP_DMA},
+        {"spiram", MALLOC_CAP_SPIRAM},
+    };
+    printf("%-10s %10s %10s %10s %10s\n", "region", "total", "free", "min_free", "largest");
+    for (int i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        printf("%-10s %10u %10u %10u %10u\n", regions[i].name, heap_caps_get_total_size(regions[i].caps),
+            heap_caps_get_free_size(regions[i].caps), heap_caps_get_minimum_free_size(regions[i].caps),
+            heap_caps_get_largest_free_block(regions[i].caps));
+    }
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_tasks(int argc, char **argv)
+ * @brief Print task list.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_tasks(int argc, char **argv) {
+    return atl_console_diag("tasks");
+}
+
+/**
+ * @fn atl_console_cmd_metrics(int argc, char **argv)
+ * @brief Print runtime metrics (same as diagnostics bundle).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_metrics(int argc, char **argv) {
+    return atl_console_diag("metrics");
+}
+
+/**
+ * @fn atl_console_field_find(const char *name)
+ * @brief Find configuration field by name.
+ * @param[in] name - Field name (section.key)
+ * @return const atl_console_field_t* - Field (NULL if not found).
+ */
+static const atl_console_field_t* atl_console_field_find(const char *name) {
+    for (int i = 0; i < sizeof(atl_console_fields) / sizeof(atl_console_fields[0]); i++) {
+        if (strcmp(atl_console_fields[i].name, name) == 0) {
+            return &atl_console_fields[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn atl_console_field_print(const atl_console_field_t *field)
+ * @brief Print a configuration field (caller holds configuration mutex).
+ * @param[in] field - Field
+ */
+static void atl_console_field_print(const atl_console_field_t *field) {
+    const uint8_t *ptr = (const uint8_t *)&atl_config + field->offset;
+    printf("%s = ", field->name);
+    switch (field->type) {
+        case ATL_CONSOLE_FIELD_STR:
+            printf("\"%.*s\"\n", (int)field->size, (const char *)ptr);
+            break;
+        case ATL_CONSOLE_FIELD_SECRET:
+            printf("%s\n", (ptr[0] != '\0') ? "********" : "\"\"");
+            break;
+        case ATL_CONSOLE_FIELD_U8:
+            printf("%u\n", *ptr);
+            break;
+        case ATL_CONSOLE_FIELD_U16:
+            printf("%u\n", *(const uint16_t *)ptr);
+            break;
+        case ATL_CONSOLE_FIELD_BOOL:
+            printf("%s\n", (*(const bool *)ptr == true) ? "true" : "false");
+            break;
+        case ATL_CONSOLE_FIELD_ENUM:
+            printf("%d\n", *(const int *)ptr);
+            break;
+        case ATL_CONSOLE_FIELD_WIFI_MODE:
+            printf("%s\n", atl_wifi_get_mode_str(*(const atl_wifi_mode_e *)ptr));
+            break;
+        case ATL_CONSOLE_FIELD_MQTT_MODE:
+            printf("%s\n", atl_mqtt_get_mode_str(*(const atl_mqtt_mode_e *)ptr));
+            break;
+        case ATL_CONSOLE_FIELD_MQTT_TRANSPORT:
+            printf("%s\n", atl_mqtt_get_transport_str(*(const esp_mqtt_transport_t *)ptr));
+            break;
+    }
+}
+
+/**
+ * @fn atl_console_field_set(const atl_console_field_t *field, char *value)
+ * @brief Set a configuration field (caller holds configuration mutex).
+ * @param[in] field - Field
+ * @param[in] value - New value
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if value is not valid.
+ */
+static esp_err_t atl_console_field_set(const atl_console_field_t *field, char *value) {
+    uint8_t *ptr = (uint8_t *)&atl_config + field->offset;
+    char *end = NULL;
+    unsigned long number = strtoul(value, &end, 10);
+    bool is_number = ((end != value) && (*end == '\0'));
+    switch (field->type) {
+        case ATL_CONSOLE_FIELD_STR:
+        case ATL_CONSOLE_FIELD_SECRET:
+            if (strlen(value) >= field->size) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            memset(ptr, 0, field->size);
+            memcpy(ptr, value, strlen(value));
+            break;
+        case ATL_CONSOLE_FIELD_U8:
+            if ((is_number == false) || (number > UINT8_MAX)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *ptr = number;
+            break;
+        case ATL_CONSOLE_FIELD_U16:
+            if ((is_number == false) || (number > UINT16_MAX)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(uint16_t *)ptr = number;
+            break;
+        case ATL_CONSOLE_FIELD_BOOL:
+            if ((strcmp(value, "true") != 0) && (strcmp(value, "false") != 0)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(bool *)ptr = (strcmp(value, "true") == 0);
+            break;
+        case ATL_CONSOLE_FIELD_ENUM:
+            if ((is_number == false) || (number > field->max)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(int *)ptr = number;
+            break;
+        case ATL_CONSOLE_FIELD_WIFI_MODE:
+            if (atl_wifi_get_mode(value) == 255) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(atl_wifi_mode_e *)ptr = atl_wifi_get_mode(value);
+            break;
+        case ATL_CONSOLE_FIELD_MQTT_MODE:
+            if (atl_mqtt_get_mode(value) == 255) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(atl_mqtt_mode_e *)ptr = atl_mqtt_get_mode(value);
+            break;
+        case ATL_CONSOLE_FIELD_MQTT_TRANSPORT:
+            if (atl_mqtt_get_transport(value) == 255) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *(esp_mqtt_transport_t *)ptr = atl_mqtt_get_transport(value);
+            break;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_console_cmd_stalls(int argc, char **argv)
+ * @brief Print latency budgets (overruns and backtrace of last overrun).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_stalls(int argc, char **argv) {
+    return atl_console_diag("stalls");
+}
+
+/**
+ * @fn atl_console_cmd_energy(int argc, char **argv)
+ * @brief Print energy accounting of current report window (usage and estimated charge per subsystem).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_energy(int argc, char **argv) {
+    return atl_console_diag("energy");
+}
+
+/**
+ * @fn atl_console_cmd_config(int argc, char **argv)
+ * @brief Get, set and commit configuration.
+ * @details Set changes the running configuration only, commit saves it at NVS (most settings apply after restart).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_config(int argc, char **argv) {
+    const atl_console_field_t *field = NULL;
+    esp_err_t err = ESP_OK;
+    if ((argc < 2) || (strcmp(argv[1], "get") == 0)) {
+
+        /* Whole configuration (redacted) */
+        if (argc < 3) {
+            return atl_console_diag("config");
+        }
+        field = atl_console_field_find(argv[2]);
+        if (field == NULL) {
+            printf("Unknown field [%s]. Fields:", argv[2]);
+            for (int i = 0; i < sizeof(atl_console_fields) / sizeof(atl_console_fields[0]); i++) {
+                printf(" %s", atl_console_fields[i].name);
+            }
+            printf("\n");
+            return 1;
+        }
+        if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+            atl_console_field_print(field);
+            xSemaphoreGive(atl_config_mutex);
+        }
+        return 0;
+    } else if ((strcmp(argv[1], "set") == 0) && (argc == 4)) {
+        field = atl_console_field_find(argv[2]);
+        if (field == NULL) {
+            printf("Unknown field [%s]\n", argv[2]);
+            return 1;
+        }
+        if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+            err = atl_console_field_set(field, argv[3]);
+            if (err == ESP_OK) {
+                atl_console_field_print(field);
+            }
+            xSemaphoreGive(atl_config_mutex);
+        }
+        if (err != ESP_OK) {
+            printf("Invalid value for %s\n", field->name);
+            return 1;
+        }
+        printf("Run \"config commit\" to save and \"restart\" to apply\n");
+        return 0;
+    } else if (strcmp(argv[1], "commit") == 0) {
+        err = atl_config_commit_nvs();
+        printf("Configuration commit: %s\n", esp_err_to_name(err));
+        return (err == ESP_OK) ? 0 : 1;
+    }
+    printf("Usage: config [get [<section.key>] | set <section.key> <value> | commit]\n");
+    return 1;
+}
+
+/**
+ * @fn atl_console_cmd_wifi_scan(int argc, char **argv)
+ * @brief Scan WiFi networks and print results.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_wifi_scan(int argc, char **argv) {
+    uint8_t count = 0;
+    uint32_t age_ms = 0;
+    bool scanning = true;
+    esp_err_t err = atl_wifi_scan_start();
+    if (err != ESP_OK) {
+        printf("Scan failed: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    for (int waited = 0; (scanning == true) && (waited < ATL_CONSOLE_SCAN_TIMEOUT); waited += 250) {
+        vTaskDelay(pdMS_TO_TICKS(250));
+        atl_wifi_scan_get(NULL, 0, &count, &age_ms, &scanning);
+    }
+    atl_wifi_scan_result_t *results = calloc(ATL_CONSOLE_SCAN_RESULTS, sizeof(atl_wifi_scan_result_t));
+    if (results == NULL) {
+        printf("Error: %s\n", esp_err_to_name(ESP_ERR_NO_MEM));
+        return 1;
+    }
+    atl_wifi_scan_get(results, ATL_CONSOLE_SCAN_RESULTS, &count, &age_ms, &scanning);
+    printf("%-32s %5s %7s %4s\n", "ssid", "rssi", "channel", "auth");
+    for (int i = 0; i < count; i++) {
+        printf("%-32s %5d %7u %4d\n", results[i].ssid, results[i].rssi, results[i].channel, results[i].authmode);
+    }
+    printf("%u networks (%s)\n", count, (scanning == true) ? "scan still running" : "scan done");
+    free(results);
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_mqtt(int argc, char **argv)
+ * @brief Print MQTT client status.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_mqtt(int argc, char **argv) {
+    atl_mqtt_status_t status;
+    atl_mqtt_get_status(&status);
+    if (status.started == false) {
+        printf("MQTT client not started\n");
+        return 0;
+    }
+    printf("connected: %s\n", (status.connected == true) ? "yes" : "no");
+    printf("connects: %lu\n", (unsigned long)status.connects);
+    printf("disconnects: %lu\n", (unsigned long)status.disconnects);
+    printf("errors: %lu\n", (unsigned long)status.errors);
+    printf("published: %lu\n", (unsigned long)status.published);
+    printf("received: %lu\n", (unsigned long)status.received);
+    printf("outbox_bytes: %d\n", status.outbox_size);
+    printf("keepalive_s: %u\n", status.keepalive);
+    if (status.ota_active == true) {
+        printf("ota: %lu/%lu chunks\n", (unsigned long)status.ota_chunk_done, (unsigned long)status.ota_chunk_count);
+    }
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_cellular(int argc, char **argv)
+ * @brief Cellular modem status, or parse a status query answer (answer lines separated by '|').
+ * @details Parsing starts from an empty status and needs no modem, so captured modem answers can be checked on any board.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_cellular(int argc, char **argv) {
+    atl_cellular_status_t status;
+    memset(&status, 0, sizeof(atl_cellular_status_t));
+    status.ber = 99;
+    if ((argc > 2) && (strcmp(argv[1], "parse") == 0)) {
+        for (char *sep = strchr(argv[2], '|'); sep != NULL; sep = strchr(sep + 1, '|')) {
+            *sep = '\n';
+        }
+        uint8_t found = atl_cellular_parse_status(argv[2], &status);
+        printf("cellular parse: found=%s%s%s%s%s rssi=%d ber=%u reg=%u registered=%s tac=%04X ci=%08lX act=%u operator=\"%s\"\n",
+            (found & ATL_CELLULAR_PARSE_CSQ) ? "csq," : "", (found & ATL_CELLULAR_PARSE_CEREG) ? "cereg," : "",
+            (found & ATL_CELLULAR_PARSE_COPS) ? "cops," : "", (found & ATL_CELLULAR_PARSE_ERROR) ? "error," : "",
+            (found & ATL_CELLULAR_PARSE_OK) ? "ok," : "", status.rssi_dbm, status.ber, status.reg_stat,
+            (status.registered == true) ? "yes" : "no", status.tac, (unsigned long)status.cell_id, status.act, status.operator_name);
+        return 0;
+    } else if (argc > 1) {
+        printf("Usage: cellular [parse <answer>]\n");
+        return 1;
+    }
+    esp_err_t err = atl_cellular_get_status(&status);
+    if (err != ESP_OK) {
+        printf("Error: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    printf("started: %s (%s)\n", (status.started == true) ? "yes" : "no", (status.cmux == true) ? "CMUX" : "data");
+    printf("ppp: %s\n", (status.ppp_up == true) ? "up" : "down");
+    printf("registered: %s (stat %u)\n", (status.registered == true) ? "yes" : "no", status.reg_stat);
+    printf("rssi_dbm: %d\n", status.rssi_dbm);
+    printf("operator: %s\n", status.operator_name);
+    printf("cell: tac %04X, ci %08lX, act %u\n", status.tac, (unsigned long)status.cell_id, status.act);
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_bench(int argc, char **argv)
+ * @brief Run a micro-benchmark, or all benchmarks with JSON output (list benchmarks if none given).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_bench(int argc, char **argv) {
+    atl_bench_result_t result;
+    const char *help = NULL;
+    if (argc < 2) {
+        for (int i = 0; i < atl_bench_count(); i++) {
+            const char *name = atl_bench_get_name(i, &help);
+            printf("%-18s %s\n", name, help);
+        }
+        return 0;
+    }
+    uint32_t iterations = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0;
+
+    /* Whole suite as JSON (machine readable) */
+    if (strcmp(argv[1], "all") == 0) {
+        char *json = atl_bench_run_all_json(iterations);
+        if (json == NULL) {
+            printf("Error: %s\n", esp_err_to_name(ESP_ERR_NO_MEM));
+            return 1;
+        }
+        printf("%s\n", json);
+        cJSON_free(json);
+        return 0;
+    }
+    esp_err_t err = atl_bench_run(argv[1], iterations, &result);
+    if (result.iterations > 0) {
+        uint32_t avg = result.cycles_total / result.iterations;
+        printf("%s: %lu iterations, cycles min/avg/max %lu/%lu/%lu, us min/avg/max %lu/%lu/%lu", result.name,
+            (unsigned long)result.iterations, (unsigned long)result.cycles_min, (unsigned long)avg, (unsigned long)result.cycles_max,
+            (unsigned long)(result.cycles_min / result.cycles_per_us), (unsigned long)(avg / result.cycles_per_us),
+            (unsigned long)(result.cycles_max / result.cycles_per_us));
+        if ((result.bytes > 0) && (avg > 0)) {
+            printf(", %lu KB/s", (unsigned long)(((uint64_t)result.bytes * result.cycles_per_us * 1000000 / avg) / 1024));
+        }
+        printf("\n");
+    }
+    if (err != ESP_OK) {
+        printf("Error: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @fn atl_console_cmd_trace(int argc, char **argv)
+ * @brief Start or stop tracing, or print trace as Chrome trace event JSON (print trace status if none given).
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_trace(int argc, char **argv) {
+    atl_trace_status_t status;
+    esp_err_t err = ESP_OK;
+    if (argc < 2) {
+        atl_trace_get_status(&status);
+        printf("running: %s\n", (status.running == true) ? "yes" : "no");
+        printf("events: %lu/%lu\n", (unsigned long)status.events, (unsigned long)status.capacity);
+        printf("dropped: %lu\n", (unsigned long)status.dropped);
+        return 0;
+    } else if (strcmp(argv[1], "start") == 0) {
+        err = atl_trace_start();
+    } else if (strcmp(argv[1], "stop") == 0) {
+        atl_trace_stop();
+    } else if (strcmp(argv[1], "dump") == 0) {
+        err = atl_trace_export(atl_console_diag_sink, NULL);
+        fflush(stdout);
+    } else {
+        printf("Usage: trace [start|stop|dump]\n");
+        return 1;
+    }
+    if (err != ESP_OK) {
+        printf("Error: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+/**
+ * @fn atl_console_cmd_webpage(int argc, char **argv)
+ * @brief Request a webpage from HTTPS server over loopback and print its status, length and SHA-256.
+ * @details Repeating a page request shows whether a cached page matches the rendered one.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_webpage(int argc, char **argv) {
+    uint8_t sha256[32];
+    size_t len = 0;
+    int status = 0;
+    if (argc < 2) {
+        printf("Usage: webpage <uri>\n");
+        return 1;
+    }
+    esp_err_t err = atl_webserver_fetch(argv[1], &status, &len, sha256);
+    if (err != ESP_OK) {
+        printf("Error: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    printf("webpage %s: status %d, %u bytes, sha256 ", argv[1], status, (unsigned int)len);
+    for (uint8_t i = 0; i < sizeof(sha256); i++) {
+        printf("%02x", sha256[i]);
+    }
+    printf("\n");
+    return 0;
+}
+#endif
+
+/**
+ * @fn atl_console_cmd_log(int argc, char **argv)
+ * @brief Set log level of a tag (or all tags with "*").
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Command return code.
+ */
+static int atl_console_cmd_log(int argc, char **argv) {
+    if (argc == 3) {
+        for (int i = 0; i < sizeof(atl_console_log_level_str) / sizeof(atl_console_log_level_str[0]); i++) {
+            if (strcmp(argv[2], atl_console_log_level_str[i]) == 0) {
+                esp_log_level_set(argv[1], (esp_log_level_t)i);
+                return 0;
+            }
+        }
+    }
+    printf("Usage: log <tag|*> <none|error|warn|info|debug|verbose>\n");
+    return 1;
+}
+
+/**
+ * @fn atl_console_cmd_restart(int argc, char **argv)
+ * @brief Restart device.
+ * @param[in] argc - Arguments count
+ * @param[in] argv - Arguments
+ * @return int - Never returns.
+ */
+static int atl_console_cmd_restart(int argc, char **argv) {
+    printf("Restarting...\n");
+    fflush(stdout);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    esp_restart();
+    return 0;
+}
+
+/** Console commands (shared by serial and TCP consoles). */
+static const esp_console_cmd_t atl_console_cmds[] = {
+    {.command = "heap", .help = "Heap statistics by region", .func = atl_console_cmd_heap},
+    {.command = "tasks", .help = "Task list (state, priority, stack high water mark)", .func = atl_console_cmd_tasks},
+    {.command = "metrics", .help = "Runtime metrics (same as diagnostics bundle)", .func = atl_console_cmd_metrics},
+    {.command = "stalls", .help = "Latency budgets (overruns and backtrace of last overrun)", .func = atl_console_cmd_stalls},
+    {.command = "energy", .help = "Energy accounting per subsystem (usage and estimated mAh of current window)", .func = atl_console_cmd_energy},
+    {.command = "config", .help = "Get, set and commit configuration", .hint = "[get [<section.key>] | set <section.key> <value> | commit]", .func = atl_console_cmd_config},
+    {.command = "wifi_scan", .help = "Scan WiFi networks", .func = atl_console_cmd_wifi_scan},
+    {.command = "mqtt", .help = "MQTT client status", .func = atl_console_cmd_mqtt},
+    {.command = "cellular", .help = "Cellular modem status, or parse a status query answer (lines separated by '|')", .hint = "[parse <answer>]", .func = atl_console_cmd_cellular},
+    {.command = "bench", .help = "Run a micro-benchmark, or all as JSON (list benchmarks if none given)", .hint = "[<name>|all [<iterations>]]", .func = atl_console_cmd_bench},
+    {.command = "trace", .help = "Start, stop or dump span and task trace (Chrome trace event JSON, open at ui.perfetto.dev)", .hint = "[start|stop|dump]", .func = atl_console_cmd_trace},
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+    {.command = "webpage", .help = "Request a webpage over loopback (status, length and SHA-256 of body)", .hint = "<uri>", .func = atl_console_cmd_webpage},
+#endif
+    {.command = "log", .help = "Set log level", .hint = "<tag|*> <none|error|warn|info|debug|verbose>", .func = atl_console_cmd_log},
+    {.command = "restart", .help = "Restart device", .func = atl_console_cmd_restart},
+};
+#endif /* CONFIG_ATL_CONSOLE_UART || CONFIG_ATL_CONSOLE_TCP */
+
+#ifdef CONFIG_ATL_CONSOLE_TCP
+/**
+ * @fn atl_console_tcp_dispatch(char *line)
+ * @brief Run a command line from TCP console (esp_console_run() is not reentrant, so command table is searched here).
+ * @param[in] line - Command line (modified)
+ */
+static void atl_console_tcp_dispatch(char *line) {
+    char *argv[ATL_CONSOLE_MAX_ARGS];
+    int argc = esp_console_split_argv(line, argv, ATL_CONSOLE_MAX_ARGS);
+    if (argc == 0) {
+        return;
+    }
+    if (strcmp(argv[0], "help") == 0) {
+        for (int i = 0; i < sizeof(atl_console_cmds) / sizeof(atl_console_cmds[0]); i++) {
+            printf("%s %s\n  %s\n", atl_console_cmds[i].command, (atl_console_cmds[i].hint != NULL) ? atl_console_cmds[i].hint : "",
+                atl_console_cmds[i].help);
+        }
+        printf("exit\n  Close connection\n");
+        return;
+    }
+    for (int i = 0; i < sizeof(atl_console_cmds) / sizeof(atl_console_cmds[0]); i++) {
+        if (strcmp(argv[0], atl_console_cmds[i].command) == 0) {
+            int ret = atl_console_cmds[i].func(argc, argv);
+            if (ret != 0) {
+                printf("Command returned non-zero error code: 0x%x\n", ret);
+            }
+            return;
+        }
+    }
+    printf("Unrecognized command\n");
+}
+
+/**
+ * @fn atl_console_tcp_session(int sock)
+ * @brief Serve a TCP console client until it disconnects or types "exit".
+ * @details Telnet negotiation (IAC sequences) is ignored, lines end at CR or LF.
+ * @param[in] sock - Client socket (closed at end)
+ */
+static void atl_console_tcp_session(int sock) {
+    char line[ATL_CONSOLE_LINE_MAX];
+    uint8_t rx_buffer[64];
+    size_t len = 0;
+    uint8_t iac_skip = 0;
+    bool line_end = false;
+    FILE *out = fdopen(sock, "w");
+    if (out == NULL) {
+        close(sock);
+        return;
+    }
+
+    /* Task stdout goes to client (newlib streams are per task) */
+    FILE *prev_stdout = stdout;
+    stdout = out;
+    printf("GreenField console. Type \"help\" for commands.\n%s", CONFIG_ATL_CONSOLE_PROMPT);
+    fflush(stdout);
+    while (true) {
+        int n = recv(sock, rx_buffer, sizeof(rx_buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint8_t c = rx_buffer[i];
+            if (iac_skip > 0) {
+                iac_skip--;
+            } else if (c == 0xFF) {
+                iac_skip = 2;
+            } else if ((c == '\r') || (c == '\n') || (c == '\0')) {
+
+                /* CR LF and CR NUL end a single line */
+                if ((line_end == true) && (c != '\r')) {
+                    line_end = false;
+                    continue;
+                }
+                line_end = (c == '\r');
+                line[len] = '\0';
+                len = 0;
+                if ((strcmp(line, "exit") == 0) || (strcmp(line, "quit") == 0)) {
+                    goto session_end;
+                }
+                atl_console_tcp_dispatch(line);
+                printf("%s", CONFIG_ATL_CONSOLE_PROMPT);
+                fflush(stdout);
+            } else if ((c == 0x08) || (c == 0x7F)) {
+                line_end = false;
+                if (len > 0) {
+                    len--;
+                }
+            } else if ((c >= 0x20) && (len < (sizeof(line) - 1))) {
+                line_end = false;
+                line[len++] = c;
+            }
+        }
+    }
+
+session_end:
+    stdout = prev_stdout;
+    fclose(out);
+}
+
+/**
+ * @fn atl_console_tcp_task(void *args)
+ * @brief TCP console server task.
+ * @param[in] args - Not used
+ */
+static void atl_console_tcp_task(void *args) {
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(CONFIG_ATL_CONSOLE_TCP_PORT),
+    };
+    int opt = 1;
+    int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (listen_sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        vTaskDelete(NULL);
+    }
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if ((bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (listen(listen_sock, 1) != 0)) {
+        ESP_LOGE(TAG, "Unable to listen at port %d: errno %d", CONFIG_ATL_CONSOLE_TCP_PORT, errno);
+        close(listen_sock);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI(TAG, "TCP console listening at port %d", CONFIG_ATL_CONSOLE_TCP_PORT);
+
+    /* Serve one client at a time */
+    while (true) {
+        struct sockaddr_in source_addr;
+        socklen_t addr_len = sizeof(source_addr);
+        int sock = accept(listen_sock, (struct sockaddr *)&source_addr, &addr_len);
+        if (sock < 0) {
+            ESP_LOGE(TAG, "Unable to accept connection: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        ESP_LOGI(TAG, "TCP console client connected");
+        atl_console_tcp_session(sock);
+        ESP_LOGI(TAG, "TCP console client disconnected");
+    }
+}
+#endif /* CONFIG_ATL_CONSOLE_TCP */
+
+/**
+ * @fn atl_console_tcp_start(void)
+ * @brief Start the TCP console server (one client at a time, SoftAP mode only).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_console_tcp_start(void) {
+#ifdef CONFIG_ATL_CONSOLE_TCP
+    if (xTaskCreatePinnedToCore(atl_console_tcp_task, "atl_console_tcp", ATL_CONSOLE_TASK_STACK, NULL, 5, NULL, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating TCP console task!");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * @fn atl_console_init(void)
+ * @brief Start the serial console REPL (if enabled at menuconfig).
+ * @details Must be called after configuration initialization.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_console_init(void) {
+    esp_err_t err = ESP_OK;
+#ifdef CONFIG_ATL_CONSOLE_UART
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = CONFIG_ATL_CONSOLE_PROMPT;
+    repl_config.max_cmdline_length = ATL_CONSOLE_LINE_MAX;
+    repl_config.task_stack_size = ATL_CONSOLE_TASK_STACK;
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#elif defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl);
+#else
+    err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+    esp_console_register_help_command();
+    for (int i = 0; i < sizeof(atl_console_cmds) / sizeof(atl_console_cmds[0]); i++) {
+        err = esp_console_cmd_register(&atl_console_cmds[i]);
+        if (err != ESP_OK) {
+            goto error_proc;
+        }
+    }
+    err = esp_console_start_repl(repl);
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+    ESP_LOGI(TAG, "Serial console started (type \"help\" for commands)");
+#endif
+    return err;
+
+#ifdef CONFIG_ATL_CONSOLE_UART
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+#endif
+}
@@ -0,0 +1,42 @@
+/**
+ * @file atl_console.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Interactive console (serial and TCP) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @fn atl_console_init(void)
+ * @brief Start the serial console REPL (if enabled at menuconfig).
+ * @details Must be called after configuration initialization.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_console_init(void);
+
+/**
+ * @fn atl_console_tcp_start(void)
+ * @brief Start the TCP console server (one client at a time, SoftAP mode only).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_console_tcp_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,690 @@
+/**
+ * @file atl_diag.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Diagnostics (log ring and diagnostics bundle).
+ * @details The log ring keeps the last CONFIG_ATL_DIAG_LOG_RING_SIZE bytes of log output (without color codes). The
+ *  bundle is an ustar archive written to a sink through a single 512 bytes block buffer. Tar needs each member size
+ *  before its content, so members are rendered twice: first only counting bytes and then writing them (truncated or
+ *  padded with spaces if the content changed between passes, i.e. new log lines).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_wifi.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <nvs.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_mqtt_keepalive.h"
+#include "atl_netmgr.h"
+#include "atl_wifi.h"
+#include "atl_wifi_link.h"
+#include "atl_netprof.h"
+#include "atl_stall.h"
+#include "atl_age.h"
+#include "atl_energy.h"
+#include "atl_pm.h"
+#include "atl_diag.h"
+
+#define ATL_DIAG_TAR_BLOCK      512     /* Tar block size (also output buffer size) */
+#define ATL_DIAG_LOG_LINE       160     /* Max. log line captured at ring */
+
+/* Constants */
+static const char *TAG = "atl-diag";
+static const char *atl_diag_reset_str[] = {
+    "UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT", "TASK_WDT", "WDT", "DEEPSLEEP", "BROWNOUT", "SDIO",
+    "USB", "JTAG", "EFUSE", "PWR_GLITCH", "CPU_LOCKUP",
+};
+
+/**
+ * @typedef atl_diag_reset_history_t
+ * @brief Reset reasons history (persisted at NVS).
+ */
+typedef struct {
+    uint32_t    boot_count;                         /**< Boots since history creation.*/
+    uint8_t     reason[ATL_DIAG_RESET_HISTORY];     /**< Reset reasons (newest first).*/
+} atl_diag_reset_history_t;
+
+/**
+ * @typedef atl_diag_stream_t
+ * @brief Diagnostics bundle output stream.
+ */
+typedef struct {
+    atl_diag_sink_t sink;                       /**< Output function.*/
+    void            *ctx;                       /**< Output function context.*/
+    esp_err_t       err;                        /**< First output error (output stops).*/
+    bool            counting;                   /**< Counting member size (nothing is output).*/
+    size_t          member_len;                 /**< Current member bytes written (or counted).*/
+    size_t          member_size;                /**< Current member size at tar header.*/
+    uint32_t        log_end;                    /**< Log ring position at bundle start.*/
+    size_t          len;                        /**< Bytes at block buffer.*/
+    char            buf[ATL_DIAG_TAR_BLOCK];    /**< Block buffer.*/
+} atl_diag_stream_t;
+
+/* Global variables */
+static char atl_diag_log_ring[CONFIG_ATL_DIAG_LOG_RING_SIZE];
+static uint32_t atl_diag_log_total = 0;             /* Bytes ever written at ring (ring index = total % size) */
+static portMUX_TYPE atl_diag_log_lock = portMUX_INITIALIZER_UNLOCKED;
+static vprintf_like_t atl_diag_log_prev = NULL;
+static char atl_diag_log_line[ATL_DIAG_LOG_LINE];   /* Log line being captured (guarded by line mutex) */
+static StaticSemaphore_t atl_diag_log_line_mutex_buf;
+static SemaphoreHandle_t atl_diag_log_line_mutex = NULL;
+static atl_diag_reset_history_t atl_diag_reset_history;
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/**
+ * @fn atl_diag_log_vprintf(const char *fmt, va_list args)
+ * @brief Log output hook, copy the message to log ring and forward it to previous output (UART).
+ * @details Message is formatted at a static line buffer (no extra stack at the logging task). Messages logged from
+ *  ISR or with scheduler stopped are only forwarded.
+ * @param[in] fmt - Message format
+ * @param[in] args - Message arguments
+ * @return int - Previous output result.
+ */
+static int atl_diag_log_vprintf(const char *fmt, va_list args) {
+    if ((atl_diag_log_line_mutex == NULL) || (xPortInIsrContext() == pdTRUE) ||
+        (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) ||
+        (xSemaphoreTake(atl_diag_log_line_mutex, portMAX_DELAY) != pdTRUE)) {
+        return atl_diag_log_prev(fmt, args);
+    }
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(atl_diag_log_line, sizeof(atl_diag_log_line), fmt, copy);
+    va_end(copy);
+    if (len > 0) {
+        if (len >= sizeof(atl_diag_log_line)) {
+            len = sizeof(atl_diag_log_line) - 1;
+            atl_diag_log_line[len - 1] = '\n';
+        }
+        portENTER_CRITICAL(&atl_diag_log_lock);
+        for (int i = 0; i < len; i++) {
+            /* Skip color codes (ESC[...m) */
+            if (atl_diag_log_line[i] == '\033') {
+                while ((i < len) && (atl_diag_log_line[i] != 'm')) {
+                    i++;
+                }
+                continue;
+            }
+            atl_diag_log_ring[atl_diag_log_total % CONFIG_ATL_DIAG_LOG_RING_SIZE] = atl_diag_log_line[i];
+            atl_diag_log_total++;
+        }
+        portEXIT_CRITICAL(&atl_diag_log_lock);
+    }
+    xSemaphoreGive(atl_diag_log_line_mutex);
+    return atl_diag_log_prev(fmt, args);
+}
+
+/**
+ * @fn atl_diag_log_read(uint32_t *pos, uint32_t end, char *buf, size_t len)
+ * @brief Read log ring from a position (bytes already overwritten are skipped).
+ * @param[in,out] pos - Read position
+ * @param[in] end - End position
+ * @param[out] buf - Output buffer
+ * @param[in] len - Output buffer size
+ * @return size_t - Bytes read (0 at end).
+ */
+static size_t atl_diag_log_read(uint32_t *pos, uint32_t end, char *buf, size_t len) {
+    size_t n = 0;
+    portENTER_CRITICAL(&atl_diag_log_lock);
+    if ((atl_diag_log_total - *pos) > CONFIG_ATL_DIAG_LOG_RING_SIZE) {
+        *pos = atl_diag_log_total - CONFIG_ATL_DIAG_LOG_RING_SIZE;
+    }
+    while ((n < len) && ((int32_t)(end - *pos) > 0)) {
+        buf[n++] = atl_diag_log_ring[*pos % CONFIG_ATL_DIAG_LOG_RING_SIZE];
+        (*pos)++;
+    }
+    portEXIT_CRITICAL(&atl_diag_log_lock);
+    return n;
+}
+
+/**
+ * @fn atl_diag_flush(atl_diag_stream_t *s)
+ * @brief Send block buffer to sink.
+ * @param[in] s - Output stream
+ */
+static void atl_diag_flush(atl_diag_stream_t *s) {
+    if ((s->len > 0) && (s->err == ESP_OK)) {
+        s->err = s->sink(s->ctx, s->buf, s->len);
+    }
+    s->len = 0;
+}
+
+/**
+ * @fn atl_diag_raw_write(atl_diag_stream_t *s, const char *data, size_t len)
+ * @brief Write bytes to block buffer (flushed at each full block).
+ * @param[in] s - Output stream
+ * @param[in] data - Data (NULL to write zeros)
+ * @param[in] len - Data length
+ */
+static void atl_diag_raw_write(atl_diag_stream_t *s, const char *data, size_t len) {
+    while ((len > 0) && (s->err == ESP_OK)) {
+        size_t n = ATL_DIAG_TAR_BLOCK - s->len;
+        if (n > len) {
+            n = len;
+        }
+        if (data != NULL) {
+            memcpy(&s->buf[s->len], data, n);
+            data += n;
+        } else {
+            memset(&s->buf[s->len], 0, n);
+        }
+        s->len += n;
+        len -= n;
+        if (s->len == ATL_DIAG_TAR_BLOCK) {
+            atl_diag_flush(s);
+        }
+    }
+}
+
+/**
+ * @fn atl_diag_write(atl_diag_stream_t *s, const char *data, size_t len)
+ * @brief Write member content (counted only at first pass, truncated to member size at second pass).
+ * @param[in] s - Output stream
+ * @param[in] data - Data
+ * @param[in] len - Data length
+ */
+static void atl_diag_write(atl_diag_stream_t *s, const char *data, size_t len) {
+    if (s->counting == false) {
+        if (s->member_len + len > s->member_size) {
+            len = s->member_size - s->member_len;
+        }
+        atl_diag_raw_write(s, data, len);
+    }
+    s->member_len += len;
+}
+
+/**
+ * @fn atl_diag_printf(atl_diag_stream_t *s, const char *fmt, ...)
+ * @brief Write formatted member content (max. 127 chars per call).
+ * @param[in] s - Output stream
+ * @param[in] fmt - Format
+ */
+static void atl_diag_printf(atl_diag_stream_t *s, const char *fmt, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len > 0) {
+        atl_diag_write(s, line, (len < sizeof(line)) ? len : (sizeof(line) - 1));
+    }
+}
+
+/**
+ * @fn atl_diag_json_str(atl_diag_stream_t *s, const char *key, const uint8_t *str, size_t max_len, bool last)
+ * @brief Write a JSON string member (escaped, string not need to be null terminated up to max_len).
+ * @param[in] s - Output stream
+ * @param[in] key - Member key
+ * @param[in] str - String value
+ * @param[in] max_len - String buffer size
+ * @param[in] last - Last member of object (no comma)
+ */
+static void atl_diag_json_str(atl_diag_stream_t *s, const char *key, const uint8_t *str, size_t max_len, bool last) {
+    atl_diag_printf(s, "    \"%s\": \"", key);
+    for (size_t i = 0; (i < max_len) && (str[i] != '\0'); i++) {
+        if ((str[i] == '"') || (str[i] == '\\')) {
+            atl_diag_printf(s, "\\%c", str[i]);
+        } else if (str[i] < 0x20) {
+            atl_diag_printf(s, "\\u%04x", str[i]);
+        } else {
+            atl_diag_write(s, (const char*)&str[i], 1);
+        }
+    }
+    atl_diag_printf(s, "\"%s\n", last ? "" : ",");
+}
+
+/**
+ * @fn atl_diag_member_config(atl_diag_stream_t *s)
+ * @brief Render configuration (passwords redacted).
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_config(atl_diag_stream_t *s) {
+    static const uint8_t redacted[] = "********";
+    atl_config_t config;
+    memset(&config, 0, sizeof(atl_config_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&config, &atl_config, sizeof(atl_config_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    atl_diag_printf(s, "{\n  \"generation\": %lu,\n", (unsigned long)atl_config_get_generation());
+    atl_diag_printf(s, "  \"system\": {\n    \"led_behaviour\": \"%s\"\n  },\n", atl_led_get_behaviour_str(config.system.led_behaviour));
+    atl_diag_printf(s, "  \"ota\": {\n    \"behaviour\": \"%s\"\n  },\n", atl_ota_get_behaviour_str(config.ota.behaviour));
+    atl_diag_printf(s, "  \"wifi\": {\n    \"mode\": \"%s\",\n", atl_wifi_get_mode_str(config.wifi.mode));
+    atl_diag_json_str(s, "ap_ssid", config.wifi.ap_ssid, sizeof(config.wifi.ap_ssid), false);
+    atl_diag_json_str(s, "ap_pass", (config.wifi.ap_pass[0] != '\0') ? redacted : config.wifi.ap_pass, sizeof(redacted), false);
+    atl_diag_printf(s, "    \"ap_channel\": %u,\n    \"ap_max_conn\": %u,\n", config.wifi.ap_channel, config.wifi.ap_max_conn);
+    atl_diag_json_str(s, "sta_ssid", config.wifi.sta_ssid, sizeof(config.wifi.sta_ssid), false);
+    atl_diag_json_str(s, "sta_pass", (config.wifi.sta_pass[0] != '\0') ? redacted : config.wifi.sta_pass, sizeof(redacted), false);
+    atl_diag_printf(s, "    \"sta_channel\": %u,\n    \"sta_max_conn_retry\": %u\n  },\n", config.wifi.sta_channel, config.wifi.sta_max_conn_retry);
+    atl_diag_printf(s, "  \"webserver\": {\n");
+    atl_diag_json_str(s, "username", config.webserver.username, sizeof(config.webserver.username), false);
+    atl_diag_json_str(s, "password", (config.webserver.password[0] != '\0') ? redacted : config.webserver.password, sizeof(redacted), true);
+    atl_diag_printf(s, "  },\n  \"mqtt_client\": {\n    \"mode\": \"%s\",\n", atl_mqtt_get_mode_str(config.mqtt_client.mode));
+    atl_diag_json_str(s, "broker_address", config.mqtt_client.broker_address, sizeof(config.mqtt_client.broker_address), false);
+    atl_diag_printf(s, "    \"broker_port\": %u,\n    \"transport\": \"%s\",\n", config.mqtt_client.broker_port, atl_mqtt_get_transport_str(config.mqtt_client.transport));
+    atl_diag_printf(s, "    \"disable_cn_check\": %s,\n", config.mqtt_client.disable_cn_check ? "true" : "false");
+    atl_diag_json_str(s, "user", config.mqtt_client.user, sizeof(config.mqtt_client.user), false);
+    atl_diag_json_str(s, "pass", (config.mqtt_client.pass[0] != '\0') ? redacted : config.mqtt_client.pass, sizeof(redacted), false);
+    atl_diag_printf(s, "    \"qos\": %d\n  },\n  \"group\": {\n", config.mqtt_client.qos);
+    atl_diag_json_str(s, "id", config.group.id, sizeof(config.group.id), false);
+    atl_diag_printf(s, "    \"version\": %lu,\n    \"override_mask\": \"0x%08lx\"\n  }\n}\n", (unsigned long)config.group.version, (unsigned long)config.group.override_mask);
+}
+
+/**
+ * @fn atl_diag_member_metrics(atl_diag_stream_t *s)
+ * @brief Render metrics snapshot.
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_metrics(atl_diag_stream_t *s) {
+    wifi_mode_t mode = WIFI_MODE_NULL;
+    wifi_ap_record_t ap_info;
+    atl_wifi_link_t link;
+    atl_netprof_stats_t netprof;
+    atl_age_hist_t age;
+    atl_age_status_t age_status;
+    atl_pm_lock_info_t pm_lock;
+    atl_wifi_window_t window;
+    atl_diag_printf(s, "uptime_s: %lu\n", (unsigned long)(esp_timer_get_time() / 1000000));
+    atl_diag_printf(s, "heap_free: %lu\n", (unsigned long)esp_get_free_heap_size());
+    atl_diag_printf(s, "heap_min_free: %lu\n", (unsigned long)esp_get_minimum_free_heap_size());
+    atl_diag_printf(s, "heap_internal_free: %u\n", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    atl_diag_printf(s, "heap_internal_largest_block: %u\n", heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    atl_diag_printf(s, "heap_spiram_free: %u\n", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    atl_diag_printf(s, "tasks: %u\n", uxTaskGetNumberOfTasks());
+    atl_diag_printf(s, "config_generation: %lu\n", (unsigned long)atl_config_get_generation());
+    atl_diag_printf(s, "uplink: %s%s\n", atl_netmgr_get_active_str(), atl_netmgr_is_metered() ? " (metered)" : "");
+    atl_netprof_get_stats(&netprof);
+    atl_diag_printf(s, "net_profile: %s (tcp_wnd %lu, tcp_snd_buf %lu, tcp_mss %lu)\n", atl_netprof_get_str(netprof.profile),
+        (unsigned long)netprof.tcp_wnd, (unsigned long)netprof.tcp_snd_buf, (unsigned long)netprof.tcp_mss);
+    atl_diag_printf(s, "net_bulk_last: %lu bytes in %lu ms (%lu transfers)\n", (unsigned long)netprof.last_bytes,
+        (unsigned long)netprof.last_ms, (unsigned long)netprof.bulk_count);
+    if ((esp_wifi_get_mode(&mode) == ESP_OK) && ((mode == WIFI_MODE_STA) || (mode == WIFI_MODE_APSTA)) &&
+        (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK)) {
+        atl_diag_printf(s, "wifi_bssid: "MACSTR"\n", MAC2STR(ap_info.bssid));
+        atl_diag_printf(s, "wifi_channel: %u\n", ap_info.primary);
+        atl_diag_printf(s, "wifi_rssi: %d\n", ap_info.rssi);
+        if (atl_wifi_link_get(&link) == ESP_OK) {
+            atl_diag_printf(s, "wifi_rssi_avg: %d\n", link.rssi_avg);
+            atl_diag_printf(s, "wifi_tx_power: %d\n", link.tx_power);
+            atl_diag_printf(s, "wifi_phy: %s (negotiated %d, ap_lr %d)\n", atl_wifi_link_get_phy_str(link.phy), link.phy_mode, link.ap_lr);
+            atl_diag_printf(s, "wifi_link_losses: %lu\n", (unsigned long)link.link_losses);
+        }
+        atl_diag_printf(s, "mqtt_keepalive_s: %u\n", atl_mqtt_keepalive_get());
+    } else {
+        atl_diag_printf(s, "wifi_mode: %d\n", mode);
+    }
+    atl_diag_printf(s, "log_ring_size: %u\n", CONFIG_ATL_DIAG_LOG_RING_SIZE);
+    atl_diag_printf(s, "log_ring_total: %lu\n", (unsigned long)atl_diag_log_total);
+    atl_diag_printf(s, "stall_overruns: %lu\n", (unsigned long)atl_stall_get_overruns());
+    for (uint8_t stage = 0; atl_age_get(stage, &age) == ESP_OK; stage++) {
+        atl_diag_printf(s, "sample_age_%s: %lu batches, p95 %lu ms, max %lu ms\n", atl_age_stage_str(stage),
+            (unsigned long)age.count, (unsigned long)atl_age_percentile(&age, 95), (unsigned long)age.max_ms);
+    }
+    atl_age_get_status(&age_status);
+    atl_diag_printf(s, "sample_age_pending: %lu (lost %lu, untracked %lu)\n", (unsigned long)age_status.pending,
+        (unsigned long)age_status.lost, (unsigned long)age_status.untracked);
+    for (uint8_t lock = 0; atl_pm_get(lock, &pm_lock) == ESP_OK; lock++) {
+        atl_diag_printf(s, "pm_lock_%s: held %lu, acquired %lu\n", atl_pm_lock_str(lock), (unsigned long)pm_lock.held,
+            (unsigned long)pm_lock.acquired);
+    }
+    if (atl_wifi_window_get(&window) == ESP_OK) {
+        atl_diag_printf(s, "wifi_window: %s, windows %lu (missed %lu), last %lu ms\n", window.open ? "open" : "radio off",
+            (unsigned long)window.windows, (unsigned long)window.missed, (unsigned long)window.last_ms);
+    }
+}
+
+/**
+ * @fn atl_diag_member_energy(atl_diag_stream_t *s)
+ * @brief Render energy accounting of current report window (usage and estimated charge per subsystem).
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_energy(atl_diag_stream_t *s) {
+    atl_energy_t energy;
+    if (atl_energy_get(&energy) != ESP_OK) {
+        atl_diag_printf(s, "energy accounting disabled\n");
+        return;
+    }
+    atl_diag_printf(s, "window_s: %lu\n", (unsigned long)energy.window_s);
+    atl_diag_printf(s, "radio_on_ms: %lu\n", (unsigned long)energy.radio_on_ms);
+    atl_diag_printf(s, "cpu_active_ms: %lu\n", (unsigned long)energy.cpu_active_ms);
+    atl_diag_printf(s, "cpu_idle_ms: %lu\n", (unsigned long)energy.cpu_idle_ms);
+    atl_diag_printf(s, "total_mah: %.3f\n", energy.total_mah);
+    atl_diag_printf(s, "%-10s %-10s %-10s %-10s %-10s %-12s %s\n", "subsystem", "mah", "cpu_ms", "tx_bytes", "erases",
+                    "writes", "write_bytes");
+    for (uint8_t sub = 0; sub < ATL_ENERGY_SUB_MAX; sub++) {
+        atl_energy_usage_t *usage = &energy.sub[sub];
+        atl_diag_printf(s, "%-10s %-10.3f %-10lu %-10lu %-10lu %-12lu %lu\n", atl_energy_sub_str(sub), usage->mah,
+                        (unsigned long)usage->cpu_ms, (unsigned long)usage->tx_bytes, (unsigned long)usage->flash_erases,
+                        (unsigned long)usage->flash_writes, (unsigned long)usage->flash_write_bytes);
+    }
+}
+
+/**
+ * @fn atl_diag_member_stalls(atl_diag_stream_t *s)
+ * @brief Render latency budgets (overruns and backtrace of last overrun).
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_stalls(atl_diag_stream_t *s) {
+    atl_stall_info_t info;
+    atl_diag_printf(s, "%-24s %-9s %-8s %-8s %-8s %s\n", "name", "budget_ms", "runs", "overruns", "max_ms", "last_overrun");
+    for (size_t i = 0; atl_stall_get(i, &info) == ESP_OK; i++) {
+        atl_diag_printf(s, "%-24s %-9lu %-8lu %-8lu %-8lu", info.name, (unsigned long)info.budget_ms, (unsigned long)info.runs,
+                        (unsigned long)info.overruns, (unsigned long)info.max_ms);
+        if (info.overruns > 0) {
+            atl_diag_printf(s, " %lu ms at %s (state %c) backtrace:", (unsigned long)info.last_overrun_ms, info.last_task, info.last_state);
+            for (int j = 0; (j < ATL_STALL_BACKTRACE_DEPTH) && (info.backtrace[j] != 0); j++) {
+                atl_diag_printf(s, " 0x%08lx", (unsigned long)info.backtrace[j]);
+            }
+        }
+        atl_diag_printf(s, "\n");
+    }
+}
+
+/**
+ * @fn atl_diag_member_tasks(atl_diag_stream_t *s)
+ * @brief Render task list.
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_tasks(atl_diag_stream_t *s) {
+#ifdef CONFIG_FREERTOS_USE_TRACE_FACILITY
+    static const char state_str[] = {'X', 'R', 'B', 'S', 'D', '?'};
+    UBaseType_t count = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *tasks = calloc(count, sizeof(TaskStatus_t));
+    if (tasks == NULL) {
+        atl_diag_printf(s, "No memory to list %u tasks\n", count);
+        return;
+    }
+    count = uxTaskGetSystemState(tasks, count, NULL);
+    atl_diag_printf(s, "%-16s %-5s %-4s %-4s %s\n", "name", "state", "prio", "base", "stack_min_free");
+    for (UBaseType_t i = 0; i < count; i++) {
+        atl_diag_printf(s, "%-16s %-5c %-4u %-4u %lu\n", tasks[i].pcTaskName,
+                        state_str[(tasks[i].eCurrentState <= eInvalid) ? tasks[i].eCurrentState : eInvalid],
+                        tasks[i].uxCurrentPriority, tasks[i].uxBasePriority, (unsigned long)tasks[i].usStackHighWaterMark);
+    }
+    free(tasks);
+#else
+    atl_diag_printf(s, "tasks: %u (enable CONFIG_FREERTOS_USE_TRACE_FACILITY for task list)\n", uxTaskGetNumberOfTasks());
+#endif
+}
+
+/**
+ * @fn atl_diag_reset_str_get(uint8_t reason)
+ * @brief Get reset reason name.
+ * @param[in] reason - Reset reason (esp_reset_reason_t)
+ * @return const char* - Reset reason name.
+ */
+static const char* atl_diag_reset_str_get(uint8_t reason) {
+    if (reason < (sizeof(atl_diag_reset_str) / sizeof(atl_diag_reset_str[0]))) {
+        return atl_diag_reset_str[reason];
+    }
+    return "?";
+}
+
+/**
+ * @fn atl_diag_member_reset(atl_diag_stream_t *s)
+ * @brief Render reset reasons (current and history).
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_reset(atl_diag_stream_t *s) {
+    atl_diag_printf(s, "current: %s\n", atl_diag_reset_str_get(esp_reset_reason()));
+    atl_diag_printf(s, "boot_count: %lu\n", (unsigned long)atl_diag_reset_history.boot_count);
+    for (uint8_t i = 0; (i < ATL_DIAG_RESET_HISTORY) && (i < atl_diag_reset_history.boot_count); i++) {
+        atl_diag_printf(s, "boot[-%u]: %s\n", i, atl_diag_reset_str_get(atl_diag_reset_history.reason[i]));
+    }
+}
+
+/**
+ * @fn atl_diag_member_partitions(atl_diag_stream_t *s)
+ * @brief Render partition table and application info.
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_partitions(atl_diag_stream_t *s) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *boot = esp_ota_get_boot_partition();
+    esp_app_desc_t app_info;
+    if ((running != NULL) && (esp_ota_get_partition_description(running, &app_info) == ESP_OK)) {
+        atl_diag_printf(s, "firmware: %s %s\n", app_info.project_name, app_info.version);
+        atl_diag_printf(s, "build: %s %s (IDF %s)\n", app_info.date, app_info.time, app_info.idf_ver);
+    }
+    atl_diag_printf(s, "running: %s\nboot: %s\n\n", (running != NULL) ? running->label : "?", (boot != NULL) ? boot->label : "?");
+    atl_diag_printf(s, "%-16s %-4s %-7s %-10s %-10s %s\n", "label", "type", "subtype", "address", "size", "ota_state");
+    esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, NULL);
+    while (it != NULL) {
+        const esp_partition_t *partition = esp_partition_get(it);
+        esp_ota_img_states_t ota_state;
+        int state = -1;
+        if (esp_ota_get_state_partition(partition, &ota_state) == ESP_OK) {
+            state = ota_state;
+        }
+        atl_diag_printf(s, "%-16s %-4d 0x%02x    0x%08lx 0x%08lx %d\n", partition->label, partition->type, partition->subtype,
+                        (unsigned long)partition->address, (unsigned long)partition->size, state);
+        it = esp_partition_next(it);
+    }
+    esp_partition_iterator_release(it);
+}
+
+/**
+ * @fn atl_diag_member_log(atl_diag_stream_t *s)
+ * @brief Render log ring (up to bundle start).
+ * @param[in] s - Output stream
+ */
+static void atl_diag_member_log(atl_diag_stream_t *s) {
+    char buf[64];
+    size_t n;
+    uint32_t pos = (s->log_end > CONFIG_ATL_DIAG_LOG_RING_SIZE) ? (s->log_end - CONFIG_ATL_DIAG_LOG_RING_SIZE) : 0;
+    while ((n = atl_diag_log_read(&pos, s->log_end, buf, sizeof(buf))) > 0) {
+        atl_diag_write(s, buf, n);
+    }
+}
+
+/**
+ * @fn atl_diag_member(atl_diag_stream_t *s, const char *name, void (*render)(atl_diag_stream_t *s))
+ * @brief Write a tar member (header, content and padding).
+ * @param[in] s - Output stream
+ * @param[in] name - Member file name
+ * @param[in] render - Member render function
+ */
+static void atl_diag_member(atl_diag_stream_t *s, const char *name, void (*render)(atl_diag_stream_t *s)) {
+    unsigned int checksum = 0;
+
+    /* First pass, get member size */
+    s->counting = true;
+    s->member_len = 0;
+    render(s);
+    s->member_size = s->member_len;
+    s->counting = false;
+
+    /* Tar header (buffer is always at a block boundary here) */
+    memset(s->buf, 0, ATL_DIAG_TAR_BLOCK);
+    snprintf(&s->buf[0], 100, "greenfield_diag/%s", name);
+    memcpy(&s->buf[100], "0000644", 8);
+    memcpy(&s->buf[108], "0000000", 8);
+    memcpy(&s->buf[116], "0000000", 8);
+    snprintf(&s->buf[124], 12, "%011o", (unsigned int)s->member_size);
+    snprintf(&s->buf[136], 12, "%011lo", (unsigned long)time(NULL));
+    memset(&s->buf[148], ' ', 8);
+    s->buf[156] = '0';
+    memcpy(&s->buf[257], "ustar", 6);
+    memcpy(&s->buf[263], "00", 2);
+    for (int i = 0; i < ATL_DIAG_TAR_BLOCK; i++) {
+        checksum += (uint8_t)s->buf[i];
+    }
+    snprintf(&s->buf[148], 8, "%06o", checksum);
+    s->len = ATL_DIAG_TAR_BLOCK;
+    atl_diag_flush(s);
+
+    /* Second pass, write content (padded if shorter than first pass) */
+    s->member_len = 0;
+    render(s);
+    while (s->member_len < s->member_size) {
+        atl_diag_write(s, " ", 1);
+    }
+    if ((s->member_size % ATL_DIAG_TAR_BLOCK) != 0) {
+        atl_diag_raw_write(s, NULL, ATL_DIAG_TAR_BLOCK - (s->member_size % ATL_DIAG_TAR_BLOCK));
+    }
+}
+
+/** Bundle members (in archive order). */
+static const struct {
+    const char *name;
+    void (*render)(atl_diag_stream_t *s);
+} atl_diag_members[] = {
+    {"config.json", atl_diag_member_config},
+    {"metrics.txt", atl_diag_member_metrics},
+    {"tasks.txt", atl_diag_member_tasks},
+    {"stalls.txt", atl_diag_member_stalls},
+    {"energy.txt", atl_diag_member_energy},
+    {"reset.txt", atl_diag_member_reset},
+    {"partitions.txt", atl_diag_member_partitions},
+    {"log.txt", atl_diag_member_log},
+};
+
+/**
+ * @fn atl_diag_stream_new(atl_diag_sink_t sink, void *ctx)
+ * @brief Allocate an output stream (log ring is read up to current position).
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return atl_diag_stream_t* - Output stream (NULL if out of memory).
+ */
+static atl_diag_stream_t* atl_diag_stream_new(atl_diag_sink_t sink, void *ctx) {
+    atl_diag_stream_t *s = calloc(1, sizeof(atl_diag_stream_t));
+    if (s == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory!");
+        return NULL;
+    }
+    s->sink = sink;
+    s->ctx = ctx;
+    s->err = ESP_OK;
+    portENTER_CRITICAL(&atl_diag_log_lock);
+    s->log_end = atl_diag_log_total;
+    portEXIT_CRITICAL(&atl_diag_log_lock);
+    return s;
+}
+
+/**
+ * @fn atl_diag_bundle_write(atl_diag_sink_t sink, void *ctx)
+ * @brief Write the diagnostics bundle (tar archive) incrementally to sink.
+ * @details Archive has redacted configuration, metrics, task list, reset reasons, partitions and the log ring. It is
+ *  produced with a fixed 512 bytes buffer, each member is rendered twice (size and content).
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, otherwise sink error.
+ */
+esp_err_t atl_diag_bundle_write(atl_diag_sink_t sink, void *ctx) {
+    esp_err_t err;
+    atl_diag_stream_t *s = atl_diag_stream_new(sink, ctx);
+    if (s == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < sizeof(atl_diag_members) / sizeof(atl_diag_members[0]); i++) {
+        atl_diag_member(s, atl_diag_members[i].name, atl_diag_members[i].render);
+    }
+
+    /* End of archive (two zero blocks) */
+    atl_diag_raw_write(s, NULL, 2 * ATL_DIAG_TAR_BLOCK);
+    atl_diag_flush(s);
+    err = s->err;
+    free(s);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Diagnostics bundle aborted! Error: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * @fn atl_diag_member_write(const char *name, atl_diag_sink_t sink, void *ctx)
+ * @brief Write a single bundle member as plain text (no tar header nor padding) to sink.
+ * @param[in] name - Member name, with or without extension (i.e. "metrics" or "metrics.txt")
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if member does not exist, otherwise sink error.
+ */
+esp_err_t atl_diag_member_write(const char *name, atl_diag_sink_t sink, void *ctx) {
+    esp_err_t err;
+    size_t name_len = strlen(name);
+    for (int i = 0; i < sizeof(atl_diag_members) / sizeof(atl_diag_members[0]); i++) {
+        const char *member = atl_diag_members[i].name;
+        if ((strncmp(member, name, name_len) != 0) || ((member[name_len] != '\0') && (member[name_len] != '.'))) {
+            continue;
+        }
+        atl_diag_stream_t *s = atl_diag_stream_new(sink, ctx);
+        if (s == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        s->member_size = SIZE_MAX;
+        atl_diag_members[i].render(s);
+        atl_diag_flush(s);
+        err = s->err;
+        free(s);
+        return err;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @fn atl_diag_init(void)
+ * @brief Start capturing log messages at RAM ring and record current reset reason at NVS history.
+ * @details Must be called after NVS initialization.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_diag_init(void) {
+    esp_err_t err = ESP_OK;
+    nvs_handle_t nvs_handler;
+    size_t file_size = sizeof(atl_diag_reset_history_t);
+
+    /* Capture log output */
+    if (atl_diag_log_prev == NULL) {
+        atl_diag_log_line_mutex = xSemaphoreCreateMutexStatic(&atl_diag_log_line_mutex_buf);
+        atl_diag_log_prev = esp_log_set_vprintf(atl_diag_log_vprintf);
+    }
+
+    /* Push current reset reason to history */
+    memset(&atl_diag_reset_history, 0, sizeof(atl_diag_reset_history_t));
+    err = nvs_open("nvs", NVS_READWRITE, &nvs_handler);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail mounting NVS storage");
+        return err;
+    }
+    if ((nvs_get_blob(nvs_handler, "reset_hist", &atl_diag_reset_history, &file_size) != ESP_OK) ||
+        (file_size != sizeof(atl_diag_reset_history_t))) {
+        memset(&atl_diag_reset_history, 0, sizeof(atl_diag_reset_history_t));
+    }
+    memmove(&atl_diag_reset_history.reason[1], &atl_diag_reset_history.reason[0], ATL_DIAG_RESET_HISTORY - 1);
+    atl_diag_reset_history.reason[0] = esp_reset_reason();
+    atl_diag_reset_history.boot_count++;
+    err = nvs_set_blob(nvs_handler, "reset_hist", &atl_diag_reset_history, sizeof(atl_diag_reset_history_t));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handler);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail writing reset history! Error: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs_handler);
+    ESP_LOGI(TAG, "Boot %lu, reset reason: %s", (unsigned long)atl_diag_reset_history.boot_count, atl_diag_reset_str_get(atl_diag_reset_history.reason[0]));
+    return err;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file atl_diag.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Diagnostics (log ring and diagnostics bundle) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_DIAG_RESET_HISTORY      8       /**< Reset reasons kept at NVS.*/
+
+/**
+ * @typedef atl_diag_sink_t
+ * @brief Diagnostics bundle output (i.e. HTTP chunk sender). Return other than ESP_OK aborts the bundle.
+ */
+typedef esp_err_t (*atl_diag_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @fn atl_diag_init(void)
+ * @brief Start capturing log messages at RAM ring and record current reset reason at NVS history.
+ * @details Must be called after NVS initialization.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_diag_init(void);
+
+/**
+ * @fn atl_diag_bundle_write(atl_diag_sink_t sink, void *ctx)
+ * @brief Write the diagnostics bundle (tar archive) incrementally to sink.
+ * @details Archive has redacted configuration, metrics, task list, reset reasons, partitions and the log ring. It is
+ *  produced with a fixed 512 bytes buffer, each member is rendered twice (size and content).
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, otherwise sink error.
+ */
+esp_err_t atl_diag_bundle_write(atl_diag_sink_t sink, void *ctx);
+
+/**
+ * @fn atl_diag_member_write(const char *name, atl_diag_sink_t sink, void *ctx)
+ * @brief Write a single bundle member as plain text (no tar header nor padding) to sink.
+ * @param[in] name - Member name, with or without extension (i.e. "metrics" or "metrics.txt")
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if member does not exist, otherwise sink error.
+ */
+esp_err_t atl_diag_member_write(const char *name, atl_diag_sink_t sink, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
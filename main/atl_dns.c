@@ -4,7 +4,7 @@
  * @brief DNS function.
  * @version 0.1.0
  * @date 2024-03-11 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -71,15 +71,16 @@ static char *parse_dns_name(char *raw_name, char *parsed_name, size_t parsed_nam
 }
 
 /**
- * @fn parse_dns_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len)
+ * @fn atl_dns_parse_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len)
  * @brief Parse DNS name and reply with softAP IP
  * @details Parses the DNS request and prepares a DNS response with the IP of the softAP
  * @param[in] req - request
  * @param[in] req_len - request length
  * @param[out] dns_reply - DNS reply
  * @param[out] dns_reply_max_len - maximum size of DNS reply
+ * @return int - Reply length (0 if not a standard query, -1 if fail).
 */
-static int parse_dns_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len) {
+int atl_dns_parse_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len) {
     if (req_len > dns_reply_max_len) {
         return -1;
     }
@@ -136,7 +137,7 @@ static int parse_dns_request(char *req, size_t req_len, char *dns_reply, size_t
             answer->class = htons(qd_class);
             answer->ttl = htonl(ANS_TTL_SEC);
 
-            esp_netif_ip_info_t ip_info;
+            esp_netif_ip_info_t ip_info = {0};
             esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_AP_DEF"), &ip_info);
             ESP_LOGD(TAG, "Answer with PTR offset: 0x%" PRIX16 " and IP 0x%" PRIX32, ntohs(answer->ptr_offset), ip_info.ip.addr);
 
@@ -208,7 +209,7 @@ static void atl_dns_server_task(void *pvParameters) {
                 rx_buffer[len] = 0;
 
                 char reply[DNS_MAX_LEN];
-                int reply_len = parse_dns_request(rx_buffer, len, reply, DNS_MAX_LEN);
+                int reply_len = atl_dns_parse_request(rx_buffer, len, reply, DNS_MAX_LEN);
 
                 ESP_LOGD(TAG, "Received %d bytes from %s | DNS reply with len: %d", len, addr_str, reply_len);
                 if (reply_len <= 0) {
@@ -4,7 +4,7 @@
  * @brief DNS header.
  * @version 0.1.0
  * @date 2024-03-11 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -16,6 +16,9 @@
  */
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -62,6 +65,17 @@ typedef struct __attribute__((__packed__)) {
     uint32_t ip_addr;
 } dns_answer_t;
 
+/**
+ * @fn atl_dns_parse_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len)
+ * @brief Parse DNS name and reply with softAP IP
+ * @param[in] req - request
+ * @param[in] req_len - request length
+ * @param[out] dns_reply - DNS reply
+ * @param[out] dns_reply_max_len - maximum size of DNS reply
+ * @return int - Reply length (0 if not a standard query, -1 if fail).
+ */
+int atl_dns_parse_request(char *req, size_t req_len, char *dns_reply, size_t dns_reply_max_len);
+
 /**
  * @fn atl_dns_server_init(void)
  * @brief Initialize DNS capture server.
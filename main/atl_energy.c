@@ -0,0 +1,372 @@
+/**
+ * @file atl_energy.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Energy accounting per subsystem (radio-on, CPU-active, TX and flash).
+ * @details CPU activity is sampled at the tick hook of each core: a tick is active when the core is not running its
+ *  idle task, and it is attributed to the subsystem whose section is open at the running task. Idle time is the
+ *  remainder of the window, so ticks suppressed by tickless idle (light sleep) are counted as idle. WiFi radio-on
+ *  time, bytes sent and flash erases/writes are accounted by their callers. A power model (menuconfig) converts the
+ *  usage to estimated charge, reported as telemetry at each report window.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_freertos_hooks.h>
+#include <cJSON.h>
+#include "sdkconfig.h"
+#include "atl_energy.h"
+
+/* Constants */
+static const char *atl_energy_sub_names[ATL_ENERGY_SUB_MAX] = {
+    "ota",
+    "portal",
+    "sampling",
+    "mqtt",
+    "system",
+};
+
+/**
+ * @fn atl_energy_sub_str(atl_energy_sub_e sub)
+ * @brief Get subsystem name.
+ * @param[in] sub - Subsystem
+ * @return const char* - Subsystem name ("?" if invalid).
+ */
+const char* atl_energy_sub_str(atl_energy_sub_e sub) {
+    if (sub >= ATL_ENERGY_SUB_MAX) {
+        return "?";
+    }
+    return atl_energy_sub_names[sub];
+}
+
+#ifdef CONFIG_ATL_ENERGY
+
+/**
+ * @typedef atl_energy_acc_t
+ * @brief Usage counters of a subsystem (current window).
+ */
+typedef struct {
+    uint32_t    ticks;              /**< Active ticks attributed to subsystem.*/
+    uint32_t    tx_bytes;           /**< Bytes sent.*/
+    uint32_t    flash_erases;       /**< Flash sectors erased.*/
+    uint32_t    flash_writes;       /**< Flash write operations.*/
+    uint32_t    flash_write_bytes;  /**< Bytes written to flash.*/
+} atl_energy_acc_t;
+
+/* Constants */
+static const char *TAG = "atl-energy";
+
+/* Global variables */
+static atl_energy_acc_t atl_energy_acc[ATL_ENERGY_SUB_MAX];
+static uint32_t atl_energy_active_ticks = 0;
+static TaskHandle_t atl_energy_task[ATL_ENERGY_SYSTEM];         /* Task with an open section (per subsystem) */
+static TaskHandle_t atl_energy_idle[portNUM_PROCESSORS];        /* Idle task of each core */
+static int64_t atl_energy_window_start = 0;
+static int64_t atl_energy_radio_since = 0;                      /* Radio start time (0 if off) */
+static int64_t atl_energy_radio_us = 0;                         /* Radio-on time of window (closed periods) */
+static bool atl_energy_started = false;
+static portMUX_TYPE atl_energy_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @fn atl_energy_tick_hook(void)
+ * @brief Tick hook, sample core activity and attribute it to the subsystem of the running task.
+ * @details Called from tick interrupt, so it is kept at IRAM (flash cache may be disabled by a flash write).
+ */
+static void IRAM_ATTR atl_energy_tick_hook(void) {
+    BaseType_t core = xPortGetCoreID();
+    TaskHandle_t task = xTaskGetCurrentTaskHandleForCore(core);
+    if (task == atl_energy_idle[core]) {
+        return;
+    }
+    uint8_t sub = 0;
+    while ((sub < ATL_ENERGY_SYSTEM) && (atl_energy_task[sub] != task)) {
+        sub++;
+    }
+    portENTER_CRITICAL_ISR(&atl_energy_lock);
+    atl_energy_active_ticks++;
+    atl_energy_acc[sub].ticks++;
+    portEXIT_CRITICAL_ISR(&atl_energy_lock);
+}
+
+/**
+ * @fn atl_energy_snapshot(atl_energy_t *energy, bool reset)
+ * @brief Get usage of current window and convert it to estimated charge.
+ * @param[out] energy - Energy accounting
+ * @param[in] reset - Start a new window
+ */
+static void atl_energy_snapshot(atl_energy_t *energy, bool reset) {
+    atl_energy_acc_t acc[ATL_ENERGY_SUB_MAX];
+    memset(energy, 0, sizeof(atl_energy_t));
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_energy_lock);
+    memcpy(acc, atl_energy_acc, sizeof(acc));
+    uint32_t active_ticks = atl_energy_active_ticks;
+    int64_t window_us = now - atl_energy_window_start;
+    int64_t radio_us = atl_energy_radio_us + ((atl_energy_radio_since > 0) ? (now - atl_energy_radio_since) : 0);
+    if (reset == true) {
+        memset(atl_energy_acc, 0, sizeof(atl_energy_acc));
+        atl_energy_active_ticks = 0;
+        atl_energy_window_start = now;
+        atl_energy_radio_us = 0;
+        if (atl_energy_radio_since > 0) {
+            atl_energy_radio_since = now;
+        }
+    }
+    portEXIT_CRITICAL(&atl_energy_lock);
+
+    /* Usage */
+    uint64_t window_ms = window_us / 1000;
+    uint64_t active_ms = ((uint64_t)active_ticks * 1000) / configTICK_RATE_HZ;
+    energy->window_s = window_us / 1000000;
+    energy->radio_on_ms = radio_us / 1000;
+    energy->cpu_active_ms = active_ms;
+    energy->cpu_idle_ms = ((window_ms * portNUM_PROCESSORS) > active_ms) ? ((window_ms * portNUM_PROCESSORS) - active_ms) : 0;
+
+    /* Power model (charge in uAs) */
+    for (uint8_t sub = 0; sub < ATL_ENERGY_SUB_MAX; sub++) {
+        atl_energy_usage_t *usage = &energy->sub[sub];
+        usage->cpu_ms = ((uint64_t)acc[sub].ticks * 1000) / configTICK_RATE_HZ;
+        usage->tx_bytes = acc[sub].tx_bytes;
+        usage->flash_erases = acc[sub].flash_erases;
+        usage->flash_writes = acc[sub].flash_writes;
+        usage->flash_write_bytes = acc[sub].flash_write_bytes;
+        double uas = ((double)usage->cpu_ms * CONFIG_ATL_ENERGY_CPU_ACTIVE_UA / 1000.0) +
+                     ((double)usage->tx_bytes * CONFIG_ATL_ENERGY_TX_UAS_PER_KB / 1024.0) +
+                     ((double)usage->flash_erases * CONFIG_ATL_ENERGY_FLASH_ERASE_UAS) +
+                     ((double)usage->flash_write_bytes * CONFIG_ATL_ENERGY_FLASH_WRITE_UAS_PER_KB / 1024.0);
+        if (sub == ATL_ENERGY_SYSTEM) {
+            uas += ((double)window_ms * CONFIG_ATL_ENERGY_IDLE_UA / 1000.0) +
+                   ((double)energy->radio_on_ms * CONFIG_ATL_ENERGY_RADIO_ON_UA / 1000.0);
+        }
+        usage->mah = uas / 3600000.0;
+        energy->total_mah += usage->mah;
+    }
+}
+
+/**
+ * @fn atl_energy_init(void)
+ * @brief Initialize energy accounting (CPU activity sampling at tick hook).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_energy_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_energy_started == true) {
+        return ESP_OK;
+    }
+    atl_energy_window_start = esp_timer_get_time();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        atl_energy_idle[core] = xTaskGetIdleTaskHandleForCore(core);
+        err = esp_register_freertos_tick_hook_for_cpu(atl_energy_tick_hook, core);
+        if (err != ESP_OK) {
+            goto error_proc;
+        }
+    }
+    atl_energy_started = true;
+    ESP_LOGI(TAG, "Energy accounting started (report every %d s)", CONFIG_ATL_ENERGY_REPORT_INTERVAL);
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
+
+/**
+ * @fn atl_energy_begin(atl_energy_sub_e sub)
+ * @brief Begin a section of a subsystem at calling task (CPU ticks of the task are attributed to it).
+ * @details A subsystem section is open at one task at a time (last begin wins).
+ * @param[in] sub - Subsystem
+ */
+void atl_energy_begin(atl_energy_sub_e sub) {
+    if (sub >= ATL_ENERGY_SYSTEM) {
+        return;
+    }
+    atl_energy_task[sub] = xTaskGetCurrentTaskHandle();
+}
+
+/**
+ * @fn atl_energy_end(atl_energy_sub_e sub)
+ * @brief End a section of a subsystem (ignored if it was not begun by calling task).
+ * @param[in] sub - Subsystem
+ */
+void atl_energy_end(atl_energy_sub_e sub) {
+    if (sub >= ATL_ENERGY_SYSTEM) {
+        return;
+    }
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&atl_energy_lock);
+    if (atl_energy_task[sub] == task) {
+        atl_energy_task[sub] = NULL;
+    }
+    portEXIT_CRITICAL(&atl_energy_lock);
+}
+
+/**
+ * @fn atl_energy_current(void)
+ * @brief Get the subsystem of the section open at calling task.
+ * @return atl_energy_sub_e - Subsystem (ATL_ENERGY_SYSTEM if none).
+ */
+atl_energy_sub_e atl_energy_current(void) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    uint8_t sub = 0;
+    while ((sub < ATL_ENERGY_SYSTEM) && (atl_energy_task[sub] != task)) {
+        sub++;
+    }
+    return sub;
+}
+
+/**
+ * @fn atl_energy_tx(atl_energy_sub_e sub, size_t bytes)
+ * @brief Account bytes sent by a subsystem.
+ * @param[in] sub - Subsystem
+ * @param[in] bytes - Bytes sent
+ */
+void atl_energy_tx(atl_energy_sub_e sub, size_t bytes) {
+    if (sub >= ATL_ENERGY_SUB_MAX) {
+        return;
+    }
+    portENTER_CRITICAL(&atl_energy_lock);
+    atl_energy_acc[sub].tx_bytes += bytes;
+    portEXIT_CRITICAL(&atl_energy_lock);
+}
+
+/**
+ * @fn atl_energy_flash(atl_energy_sub_e sub, uint32_t erases, size_t write_bytes)
+ * @brief Account a flash operation of a subsystem.
+ * @param[in] sub - Subsystem
+ * @param[in] erases - Sectors erased
+ * @param[in] write_bytes - Bytes written (a write operation is counted if not zero)
+ */
+void atl_energy_flash(atl_energy_sub_e sub, uint32_t erases, size_t write_bytes) {
+    if (sub >= ATL_ENERGY_SUB_MAX) {
+        return;
+    }
+    portENTER_CRITICAL(&atl_energy_lock);
+    atl_energy_acc[sub].flash_erases += erases;
+    if (write_bytes > 0) {
+        atl_energy_acc[sub].flash_writes++;
+        atl_energy_acc[sub].flash_write_bytes += write_bytes;
+    }
+    portEXIT_CRITICAL(&atl_energy_lock);
+}
+
+/**
+ * @fn atl_energy_radio(bool on)
+ * @brief Account WiFi radio state change (call after esp_wifi_start() and esp_wifi_stop()).
+ * @param[in] on - Radio started
+ */
+void atl_energy_radio(bool on) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_energy_lock);
+    if ((on == true) && (atl_energy_radio_since == 0)) {
+        atl_energy_radio_since = now;
+    } else if ((on == false) && (atl_energy_radio_since > 0)) {
+        atl_energy_radio_us += now - atl_energy_radio_since;
+        atl_energy_radio_since = 0;
+    }
+    portEXIT_CRITICAL(&atl_energy_lock);
+}
+
+/**
+ * @fn atl_energy_get(atl_energy_t *energy)
+ * @brief Get energy accounting of current report window.
+ * @param[out] energy - Energy accounting
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_energy_get(atl_energy_t *energy) {
+    atl_energy_snapshot(energy, false);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_energy_report(cJSON *telemetry)
+ * @brief Add energy accounting to a telemetry object and start a new report window.
+ * @details Keys are flat (ThingsBoard telemetry): "energy_window_s", "energy_radio_on_s", "energy_cpu_active_pct",
+ *  "energy_total_mah" and, per subsystem, "energy_<sub>_mah", "energy_<sub>_cpu_ms", "energy_<sub>_tx_bytes",
+ *  "energy_<sub>_flash_erases" and "energy_<sub>_flash_writes".
+ * @param[in,out] telemetry - Telemetry JSON object
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_energy_report(cJSON *telemetry) {
+    atl_energy_t energy;
+    char key[40];
+    if (telemetry == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    atl_energy_snapshot(&energy, true);
+    uint64_t cpu_ms = (uint64_t)energy.cpu_active_ms + energy.cpu_idle_ms;
+    cJSON_AddNumberToObject(telemetry, "energy_window_s", energy.window_s);
+    cJSON_AddNumberToObject(telemetry, "energy_radio_on_s", energy.radio_on_ms / 1000);
+    cJSON_AddNumberToObject(telemetry, "energy_cpu_active_pct", (cpu_ms > 0) ? ((double)energy.cpu_active_ms * 100.0 / cpu_ms) : 0.0);
+    cJSON_AddNumberToObject(telemetry, "energy_total_mah", energy.total_mah);
+    for (uint8_t sub = 0; sub < ATL_ENERGY_SUB_MAX; sub++) {
+        const char *name = atl_energy_sub_names[sub];
+        snprintf(key, sizeof(key), "energy_%s_mah", name);
+        cJSON_AddNumberToObject(telemetry, key, energy.sub[sub].mah);
+        snprintf(key, sizeof(key), "energy_%s_cpu_ms", name);
+        cJSON_AddNumberToObject(telemetry, key, energy.sub[sub].cpu_ms);
+        snprintf(key, sizeof(key), "energy_%s_tx_bytes", name);
+        cJSON_AddNumberToObject(telemetry, key, energy.sub[sub].tx_bytes);
+        snprintf(key, sizeof(key), "energy_%s_flash_erases", name);
+        cJSON_AddNumberToObject(telemetry, key, energy.sub[sub].flash_erases);
+        snprintf(key, sizeof(key), "energy_%s_flash_writes", name);
+        cJSON_AddNumberToObject(telemetry, key, energy.sub[sub].flash_writes);
+    }
+    return ESP_OK;
+}
+
+#else
+
+/**
+ * @fn atl_energy_init(void)
+ * @brief Energy accounting disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_energy_init(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void atl_energy_begin(atl_energy_sub_e sub) {
+}
+
+void atl_energy_end(atl_energy_sub_e sub) {
+}
+
+atl_energy_sub_e atl_energy_current(void) {
+    return ATL_ENERGY_SYSTEM;
+}
+
+void atl_energy_tx(atl_energy_sub_e sub, size_t bytes) {
+}
+
+void atl_energy_flash(atl_energy_sub_e sub, uint32_t erases, size_t write_bytes) {
+}
+
+void atl_energy_radio(bool on) {
+}
+
+esp_err_t atl_energy_get(atl_energy_t *energy) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t atl_energy_report(cJSON *telemetry) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file atl_energy.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Energy accounting per subsystem (radio-on, CPU-active, TX and flash) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <cJSON.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum    atl_energy_sub_e
+ * @brief   Subsystems energy is attributed to (a tick inside nested sections goes to the first one listed).
+ */
+typedef enum {
+    ATL_ENERGY_OTA,         /**< Firmware download and partition writes.*/
+    ATL_ENERGY_PORTAL,      /**< Web portal and REST API handlers.*/
+    ATL_ENERGY_SAMPLING,    /**< Sample aggregation and uplink of sample batches.*/
+    ATL_ENERGY_MQTT,        /**< MQTT session (events, attributes and reports).*/
+    ATL_ENERGY_SYSTEM,      /**< Unattributed (idle baseline, radio-on and other tasks).*/
+    ATL_ENERGY_SUB_MAX,
+} atl_energy_sub_e;
+
+/**
+ * @typedef atl_energy_usage_t
+ * @brief Resource usage and estimated charge of a subsystem.
+ */
+typedef struct {
+    uint32_t    cpu_ms;             /**< CPU active time (in core-ms, sampled at tick).*/
+    uint32_t    tx_bytes;           /**< Bytes sent by the subsystem (application payload).*/
+    uint32_t    flash_erases;       /**< Flash sectors erased.*/
+    uint32_t    flash_writes;       /**< Flash write operations.*/
+    uint32_t    flash_write_bytes;  /**< Bytes written to flash.*/
+    float       mah;                /**< Estimated charge (in mAh, from power model).*/
+} atl_energy_usage_t;
+
+/**
+ * @typedef atl_energy_t
+ * @brief Energy accounting of current report window.
+ */
+typedef struct {
+    uint32_t            window_s;                   /**< Report window length (in seconds).*/
+    uint32_t            radio_on_ms;                /**< WiFi radio-on time (started, modem sleep included).*/
+    uint32_t            cpu_active_ms;              /**< CPU active time of all cores (in core-ms).*/
+    uint32_t            cpu_idle_ms;                /**< CPU idle time of all cores (in core-ms).*/
+    float               total_mah;                  /**< Estimated charge of all subsystems (in mAh).*/
+    atl_energy_usage_t  sub[ATL_ENERGY_SUB_MAX];    /**< Usage per subsystem (system has idle baseline and radio-on).*/
+} atl_energy_t;
+
+/**
+ * @fn atl_energy_init(void)
+ * @brief Initialize energy accounting (CPU activity sampling at tick hook).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_energy_init(void);
+
+/**
+ * @fn atl_energy_sub_str(atl_energy_sub_e sub)
+ * @brief Get subsystem name.
+ * @param[in] sub - Subsystem
+ * @return const char* - Subsystem name ("?" if invalid).
+ */
+const char* atl_energy_sub_str(atl_energy_sub_e sub);
+
+/**
+ * @fn atl_energy_begin(atl_energy_sub_e sub)
+ * @brief Begin a section of a subsystem at calling task (CPU ticks of the task are attributed to it).
+ * @details A subsystem section is open at one task at a time (last begin wins).
+ * @param[in] sub - Subsystem
+ */
+void atl_energy_begin(atl_energy_sub_e sub);
+
+/**
+ * @fn atl_energy_end(atl_energy_sub_e sub)
+ * @brief End a section of a subsystem (ignored if it was not begun by calling task).
+ * @param[in] sub - Subsystem
+ */
+void atl_energy_end(atl_energy_sub_e sub);
+
+/**
+ * @fn atl_energy_current(void)
+ * @brief Get the subsystem of the section open at calling task.
+ * @return atl_energy_sub_e - Subsystem (ATL_ENERGY_SYSTEM if none).
+ */
+atl_energy_sub_e atl_energy_current(void);
+
+/**
+ * @fn atl_energy_tx(atl_energy_sub_e sub, size_t bytes)
+ * @brief Account bytes sent by a subsystem.
+ * @param[in] sub - Subsystem
+ * @param[in] bytes - Bytes sent
+ */
+void atl_energy_tx(atl_energy_sub_e sub, size_t bytes);
+
+/**
+ * @fn atl_energy_flash(atl_energy_sub_e sub, uint32_t erases, size_t write_bytes)
+ * @brief Account a flash operation of a subsystem.
+ * @param[in] sub - Subsystem
+ * @param[in] erases - Sectors erased
+ * @param[in] write_bytes - Bytes written (a write operation is counted if not zero)
+ */
+void atl_energy_flash(atl_energy_sub_e sub, uint32_t erases, size_t write_bytes);
+
+/**
+ * @fn atl_energy_radio(bool on)
+ * @brief Account WiFi radio state change (call after esp_wifi_start() and esp_wifi_stop()).
+ * @param[in] on - Radio started
+ */
+void atl_energy_radio(bool on);
+
+/**
+ * @fn atl_energy_get(atl_energy_t *energy)
+ * @brief Get energy accounting of current report window.
+ * @param[out] energy - Energy accounting
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_energy_get(atl_energy_t *energy);
+
+/**
+ * @fn atl_energy_report(cJSON *telemetry)
+ * @brief Add energy accounting to a telemetry object and start a new report window.
+ * @details Keys are flat (ThingsBoard telemetry): "energy_window_s", "energy_radio_on_s", "energy_cpu_active_pct",
+ *  "energy_total_mah" and, per subsystem, "energy_<sub>_mah", "energy_<sub>_cpu_ms", "energy_<sub>_tx_bytes",
+ *  "energy_<sub>_flash_erases" and "energy_<sub>_flash_writes".
+ * @param[in,out] telemetry - Telemetry JSON object
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_energy_report(cJSON *telemetry);
+
+#ifdef __cplusplus
+}
+#endif
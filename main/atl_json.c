@@ -0,0 +1,465 @@
+/**
+ * @file atl_json.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Streaming JSON decoder functions.
+ * @details Single pass tokenizer (SAX style) that reports each value to a callback, without building a DOM and
+ *  without heap allocation. Used to decode inbound attribute messages with a key to setter hash table.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include "atl_json.h"
+
+/* Constants */
+static const char *TAG = "atl-json";       /**< Module identification.*/
+
+/**
+ * @typedef atl_json_parser_t
+ * @brief Tokenizer state.
+ */
+typedef struct {
+    const char      *pos;   /**< Current position.*/
+    const char      *end;   /**< End of message.*/
+    atl_json_cb_t   cb;     /**< Value callback.*/
+    void            *arg;   /**< Callback argument.*/
+} atl_json_parser_t;
+
+/**
+ * @typedef atl_json_dispatch_ctx_t
+ * @brief Key dispatch context (atl_json_dispatch).
+ */
+typedef struct {
+    const atl_json_dispatch_t   *dispatch;      /**< Dispatch table.*/
+    void                        *ctx;           /**< Setter context.*/
+    uint32_t                    skip_mask;      /**< Keys not dispatched (bit per key index).*/
+    uint32_t                    applied_mask;   /**< Keys successfully set (bit per key index).*/
+} atl_json_dispatch_ctx_t;
+
+/**
+ * @fn atl_json_skip_ws(atl_json_parser_t *parser)
+ * @brief Skip white spaces.
+ * @param[in,out] parser - Tokenizer state
+ */
+static void atl_json_skip_ws(atl_json_parser_t *parser) {
+    while ((parser->pos < parser->end) && ((*parser->pos == ' ') || (*parser->pos == '\t') || (*parser->pos == '\n') || (*parser->pos == '\r'))) {
+        parser->pos++;
+    }
+}
+
+/**
+ * @fn atl_json_parse_string(atl_json_parser_t *parser, const char **str, int *str_len)
+ * @brief Parse a string token (escapes are kept, see atl_json_strcpy).
+ * @param[in,out] parser - Tokenizer state (at opening quote)
+ * @param[out] str - String start
+ * @param[out] str_len - String length
+ * @return esp_err_t - If ERR_OK success, otherwise malformed.
+ */
+static esp_err_t atl_json_parse_string(atl_json_parser_t *parser, const char **str, int *str_len) {
+    parser->pos++;
+    *str = parser->pos;
+    while (parser->pos < parser->end) {
+        if (*parser->pos == '\\') {
+            parser->pos += 2;
+        } else if (*parser->pos == '"') {
+            *str_len = parser->pos - *str;
+            parser->pos++;
+            return ESP_OK;
+        } else if ((unsigned char)*parser->pos < 0x20) {
+            return ESP_ERR_INVALID_ARG;
+        } else {
+            parser->pos++;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+/**
+ * @fn atl_json_parse_literal(atl_json_parser_t *parser, const char *literal)
+ * @brief Parse a literal token (true, false or null).
+ * @param[in,out] parser - Tokenizer state
+ * @param[in] literal - Expected literal
+ * @return esp_err_t - If ERR_OK success, otherwise malformed.
+ */
+static esp_err_t atl_json_parse_literal(atl_json_parser_t *parser, const char *literal) {
+    size_t len = strlen(literal);
+    if (((parser->end - parser->pos) < (int)len) || (strncmp(parser->pos, literal, len) != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    parser->pos += len;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_parse_number(atl_json_parser_t *parser, double *number)
+ * @brief Parse a number token.
+ * @param[in,out] parser - Tokenizer state
+ * @param[out] number - Number value
+ * @return esp_err_t - If ERR_OK success, otherwise malformed.
+ */
+static esp_err_t atl_json_parse_number(atl_json_parser_t *parser, double *number) {
+    char buffer[32];
+    int len = 0;
+    while ((parser->pos + len < parser->end) && (strchr("0123456789+-.eE", parser->pos[len]) != NULL) && (parser->pos[len] != '\0')) {
+        len++;
+    }
+    if ((len == 0) || (len >= sizeof(buffer))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(buffer, parser->pos, len);
+    buffer[len] = '\0';
+    char *number_end = NULL;
+    *number = strtod(buffer, &number_end);
+    if (number_end != &buffer[len]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    parser->pos += len;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_parse_value(atl_json_parser_t *parser, const char *key, int key_len, uint8_t depth)
+ * @brief Parse a value (recursively for objects and arrays) and report it to callback.
+ * @param[in,out] parser - Tokenizer state
+ * @param[in] key - Value key (NULL for array elements and root)
+ * @param[in] key_len - Value key length
+ * @param[in] depth - Value nesting level (0 for root)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_json_parse_value(atl_json_parser_t *parser, const char *key, int key_len, uint8_t depth) {
+    esp_err_t err;
+    atl_json_value_t value = {};
+
+    atl_json_skip_ws(parser);
+    if (parser->pos >= parser->end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (depth > ATL_JSON_MAX_DEPTH) {
+        ESP_LOGW(TAG, "Maximum nesting level exceeded!");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch (*parser->pos) {
+        case '{':
+        case '[': {
+            bool is_object = (*parser->pos == '{');
+            char close = is_object ? '}' : ']';
+            value.type = is_object ? ATL_JSON_OBJECT : ATL_JSON_ARRAY;
+            if ((parser->cb != NULL) && ((err = parser->cb(key, key_len, depth, &value, parser->arg)) != ESP_OK)) {
+                return err;
+            }
+            parser->pos++;
+            atl_json_skip_ws(parser);
+            if ((parser->pos < parser->end) && (*parser->pos == close)) {
+                parser->pos++;
+                return ESP_OK;
+            }
+            while (parser->pos < parser->end) {
+                const char *member_key = NULL;
+                int member_key_len = 0;
+                if (is_object) {
+                    atl_json_skip_ws(parser);
+                    if ((parser->pos >= parser->end) || (*parser->pos != '"') ||
+                        (atl_json_parse_string(parser, &member_key, &member_key_len) != ESP_OK)) {
+                        return ESP_ERR_INVALID_ARG;
+                    }
+                    atl_json_skip_ws(parser);
+                    if ((parser->pos >= parser->end) || (*parser->pos != ':')) {
+                        return ESP_ERR_INVALID_ARG;
+                    }
+                    parser->pos++;
+                }
+                err = atl_json_parse_value(parser, member_key, member_key_len, depth + 1);
+                if (err != ESP_OK) {
+                    return err;
+                }
+                atl_json_skip_ws(parser);
+                if (parser->pos >= parser->end) {
+                    break;
+                } else if (*parser->pos == ',') {
+                    parser->pos++;
+                } else if (*parser->pos == close) {
+                    parser->pos++;
+                    return ESP_OK;
+                } else {
+                    break;
+                }
+            }
+            return ESP_ERR_INVALID_ARG;
+        }
+        case '"':
+            value.type = ATL_JSON_STRING;
+            err = atl_json_parse_string(parser, &value.str, &value.str_len);
+            break;
+        case 't':
+            value.type = ATL_JSON_TRUE;
+            err = atl_json_parse_literal(parser, "true");
+            break;
+        case 'f':
+            value.type = ATL_JSON_FALSE;
+            err = atl_json_parse_literal(parser, "false");
+            break;
+        case 'n':
+            value.type = ATL_JSON_NULL;
+            err = atl_json_parse_literal(parser, "null");
+            break;
+        default:
+            value.type = ATL_JSON_NUMBER;
+            err = atl_json_parse_number(parser, &value.number);
+            break;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (parser->cb != NULL) {
+        return parser->cb(key, key_len, depth, &value, parser->arg);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_parse(const char *data, int data_len, atl_json_cb_t cb, void *arg)
+ * @brief Walk a JSON message once, calling cb for each value (no heap allocation).
+ * @param[in] data - JSON message (not need to be null terminated)
+ * @param[in] data_len - JSON message length
+ * @param[in] cb - Value callback
+ * @param[in] arg - Callback argument
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if malformed, otherwise callback error.
+ */
+esp_err_t atl_json_parse(const char *data, int data_len, atl_json_cb_t cb, void *arg) {
+    if ((data == NULL) || (data_len <= 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    atl_json_parser_t parser = {
+        .pos = data,
+        .end = data + data_len,
+        .cb = cb,
+        .arg = arg,
+    };
+    esp_err_t err = atl_json_parse_value(&parser, NULL, 0, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* Only white spaces (or null terminator) are allowed after root value */
+    atl_json_skip_ws(&parser);
+    if ((parser.pos < parser.end) && (*parser.pos != '\0')) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_strcpy(char *dst, size_t dst_size, const atl_json_value_t *value)
+ * @brief Copy (unescaping) a JSON string value to a null terminated buffer.
+ * @param[out] dst - Destination buffer
+ * @param[in] dst_size - Destination buffer size
+ * @param[in] value - JSON string value
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if not a string, ESP_ERR_INVALID_SIZE if truncated.
+ */
+esp_err_t atl_json_strcpy(char *dst, size_t dst_size, const atl_json_value_t *value) {
+    if ((value->type != ATL_JSON_STRING) || (dst_size == 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t out = 0;
+    for (int i = 0; i < value->str_len; i++) {
+        char c = value->str[i];
+        char utf8[3];
+        uint8_t utf8_len = 1;
+        if ((c == '\\') && (i + 1 < value->str_len)) {
+            c = value->str[++i];
+            switch (c) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                    if (i + 4 < value->str_len) {
+                        char hex[5] = {value->str[i + 1], value->str[i + 2], value->str[i + 3], value->str[i + 4], '\0'};
+                        uint16_t code = (uint16_t)strtoul(hex, NULL, 16);
+                        i += 4;
+                        if (code < 0x80) {
+                            c = (char)code;
+                        } else if (code < 0x800) {
+                            utf8[0] = (char)(0xC0 | (code >> 6));
+                            utf8[1] = (char)(0x80 | (code & 0x3F));
+                            utf8_len = 2;
+                        } else if ((code >= 0xD800) && (code <= 0xDFFF)) {
+                            c = '?';    /* Surrogate pairs are not supported */
+                        } else {
+                            utf8[0] = (char)(0xE0 | (code >> 12));
+                            utf8[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+                            utf8[2] = (char)(0x80 | (code & 0x3F));
+                            utf8_len = 3;
+                        }
+                    }
+                    break;
+                default:    /* \" \\ \/ */
+                    break;
+            }
+        }
+        if (utf8_len == 1) {
+            utf8[0] = c;
+        }
+        if (out + utf8_len >= dst_size) {
+            dst[out] = '\0';
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(&dst[out], utf8, utf8_len);
+        out += utf8_len;
+    }
+    dst[out] = '\0';
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_hash(const char *key, int key_len)
+ * @brief Hash a key (FNV-1a 32 bits).
+ * @param[in] key - Key (not need to be null terminated)
+ * @param[in] key_len - Key length
+ * @return uint32_t - Key hash.
+ */
+uint32_t atl_json_hash(const char *key, int key_len) {
+    uint32_t hash = 2166136261UL;
+    for (int i = 0; i < key_len; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * @fn atl_json_dispatch_init(atl_json_dispatch_t *dispatch, const atl_json_key_t *keys, uint8_t count)
+ * @brief Build the key dispatch hash table.
+ * @param[out] dispatch - Dispatch table
+ * @param[in] keys - Key table
+ * @param[in] count - Key table size
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if too many keys.
+ */
+esp_err_t atl_json_dispatch_init(atl_json_dispatch_t *dispatch, const atl_json_key_t *keys, uint8_t count) {
+    if (count >= ATL_JSON_DISPATCH_BUCKETS) {
+        ESP_LOGE(TAG, "Too many keys (%d - max. %d)!", count, ATL_JSON_DISPATCH_BUCKETS - 1);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(dispatch, 0, sizeof(atl_json_dispatch_t));
+    dispatch->keys = keys;
+    dispatch->count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t bucket = atl_json_hash(keys[i].key, strlen(keys[i].key)) & (ATL_JSON_DISPATCH_BUCKETS - 1);
+        while (dispatch->buckets[bucket] != 0) {
+            bucket = (bucket + 1) & (ATL_JSON_DISPATCH_BUCKETS - 1);
+        }
+        dispatch->buckets[bucket] = i + 1;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_dispatch_find(const atl_json_dispatch_t *dispatch, const char *key, int key_len)
+ * @brief Find a key at dispatch table.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] key - Key (not need to be null terminated)
+ * @param[in] key_len - Key length
+ * @return int - Key index if found, otherwise -1.
+ */
+int atl_json_dispatch_find(const atl_json_dispatch_t *dispatch, const char *key, int key_len) {
+    uint32_t bucket = atl_json_hash(key, key_len) & (ATL_JSON_DISPATCH_BUCKETS - 1);
+    while (dispatch->buckets[bucket] != 0) {
+        const atl_json_key_t *entry = &dispatch->keys[dispatch->buckets[bucket] - 1];
+        if ((strncmp(entry->key, key, key_len) == 0) && (entry->key[key_len] == '\0')) {
+            return dispatch->buckets[bucket] - 1;
+        }
+        bucket = (bucket + 1) & (ATL_JSON_DISPATCH_BUCKETS - 1);
+    }
+    return -1;
+}
+
+/**
+ * @fn atl_json_dispatch_cb(const char *key, int key_len, uint8_t depth, const atl_json_value_t *value, void *arg)
+ * @brief Tokenizer callback of atl_json_dispatch (calls setter of top level keys).
+ * @param[in] key - Value key
+ * @param[in] key_len - Value key length
+ * @param[in] depth - Value nesting level
+ * @param[in] value - Value
+ * @param[in] arg - Dispatch context
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_json_dispatch_cb(const char *key, int key_len, uint8_t depth, const atl_json_value_t *value, void *arg) {
+    atl_json_dispatch_ctx_t *dispatch_ctx = (atl_json_dispatch_ctx_t*)arg;
+
+    /* Root value must be an object */
+    if (depth == 0) {
+        return (value->type == ATL_JSON_OBJECT) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    /* Only top level keys are dispatched */
+    if ((depth != 1) || (key == NULL)) {
+        return ESP_OK;
+    }
+    int index = atl_json_dispatch_find(dispatch_ctx->dispatch, key, key_len);
+    if (index < 0) {
+        ESP_LOGD(TAG, "Unknown key [%.*s]", key_len, key);
+        return ESP_OK;
+    }
+    if ((index < 32) && ((dispatch_ctx->skip_mask & (1UL << index)) != 0)) {
+        ESP_LOGD(TAG, "Skipped key [%.*s]", key_len, key);
+        return ESP_OK;
+    }
+    if (dispatch_ctx->dispatch->keys[index].setter(dispatch_ctx->ctx, value) != ESP_OK) {
+        ESP_LOGW(TAG, "Invalid value of [%.*s]", key_len, key);
+    } else if (index < 32) {
+        dispatch_ctx->applied_mask |= (1UL << index);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_json_dispatch(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx)
+ * @brief Parse a JSON object and call the setter of each known top level key.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in] ctx - Setter context
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_json_dispatch(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx) {
+    return atl_json_dispatch_mask(dispatch, data, data_len, ctx, 0, NULL);
+}
+
+/**
+ * @fn atl_json_dispatch_mask(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx, uint32_t skip_mask, uint32_t *applied_mask)
+ * @brief Parse a JSON object and call the setter of each known top level key not masked.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in] ctx - Setter context
+ * @param[in] skip_mask - Keys not dispatched (bit per key index)
+ * @param[out] applied_mask - Keys successfully set (bit per key index, may be NULL)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_json_dispatch_mask(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx, uint32_t skip_mask, uint32_t *applied_mask) {
+    esp_err_t err;
+    atl_json_dispatch_ctx_t dispatch_ctx = {
+        .dispatch = dispatch,
+        .ctx = ctx,
+        .skip_mask = skip_mask,
+        .applied_mask = 0,
+    };
+    err = atl_json_parse(data, data_len, atl_json_dispatch_cb, &dispatch_ctx);
+    if (applied_mask != NULL) {
+        *applied_mask = (err == ESP_OK) ? dispatch_ctx.applied_mask : 0;
+    }
+    return err;
+}
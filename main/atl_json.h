@@ -0,0 +1,165 @@
+/**
+ * @file atl_json.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Streaming JSON decoder header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_JSON_MAX_DEPTH          8       /**< Max. nesting level of objects/arrays.*/
+#define ATL_JSON_DISPATCH_BUCKETS   64      /**< Key dispatch hash table size (power of 2, > number of keys).*/
+
+/**
+ * @typedef atl_json_type_e
+ * @brief JSON value type.
+ */
+typedef enum {
+    ATL_JSON_NULL,
+    ATL_JSON_FALSE,
+    ATL_JSON_TRUE,
+    ATL_JSON_NUMBER,
+    ATL_JSON_STRING,
+    ATL_JSON_OBJECT,
+    ATL_JSON_ARRAY,
+} atl_json_type_e;
+
+/**
+ * @typedef atl_json_value_t
+ * @brief JSON value (strings point into the payload, still escaped).
+ */
+typedef struct {
+    atl_json_type_e type;       /**< Value type.*/
+    const char      *str;       /**< String value (not null terminated).*/
+    int             str_len;    /**< String value length.*/
+    double          number;     /**< Number value.*/
+} atl_json_value_t;
+
+/**
+ * @typedef atl_json_cb_t
+ * @brief Tokenizer callback, called for each value (objects and arrays before their members).
+ * @details Key is NULL for array elements and for the root value. Return other than ESP_OK stops the parser.
+ */
+typedef esp_err_t (*atl_json_cb_t)(const char *key, int key_len, uint8_t depth, const atl_json_value_t *value, void *arg);
+
+/**
+ * @typedef atl_json_setter_t
+ * @brief Key setter, called with the value of a dispatched key.
+ */
+typedef esp_err_t (*atl_json_setter_t)(void *ctx, const atl_json_value_t *value);
+
+/**
+ * @typedef atl_json_key_t
+ * @brief Dispatched key.
+ */
+typedef struct {
+    const char          *key;       /**< Key name.*/
+    atl_json_setter_t   setter;     /**< Key setter.*/
+} atl_json_key_t;
+
+/**
+ * @typedef atl_json_dispatch_t
+ * @brief Key dispatch table (FNV-1a hash, open addressing).
+ */
+typedef struct {
+    const atl_json_key_t    *keys;                              /**< Key table.*/
+    uint8_t                 count;                              /**< Key table size.*/
+    uint8_t                 buckets[ATL_JSON_DISPATCH_BUCKETS]; /**< Key index + 1 (0 is empty).*/
+} atl_json_dispatch_t;
+
+/**
+ * @fn atl_json_parse(const char *data, int data_len, atl_json_cb_t cb, void *arg)
+ * @brief Walk a JSON message once, calling cb for each value (no heap allocation).
+ * @param[in] data - JSON message (not need to be null terminated)
+ * @param[in] data_len - JSON message length
+ * @param[in] cb - Value callback
+ * @param[in] arg - Callback argument
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if malformed, otherwise callback error.
+ */
+esp_err_t atl_json_parse(const char *data, int data_len, atl_json_cb_t cb, void *arg);
+
+/**
+ * @fn atl_json_strcpy(char *dst, size_t dst_size, const atl_json_value_t *value)
+ * @brief Copy (unescaping) a JSON string value to a null terminated buffer.
+ * @param[out] dst - Destination buffer
+ * @param[in] dst_size - Destination buffer size
+ * @param[in] value - JSON string value
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if not a string, ESP_ERR_INVALID_SIZE if truncated.
+ */
+esp_err_t atl_json_strcpy(char *dst, size_t dst_size, const atl_json_value_t *value);
+
+/**
+ * @fn atl_json_hash(const char *key, int key_len)
+ * @brief Hash a key (FNV-1a 32 bits).
+ * @param[in] key - Key (not need to be null terminated)
+ * @param[in] key_len - Key length
+ * @return uint32_t - Key hash.
+ */
+uint32_t atl_json_hash(const char *key, int key_len);
+
+/**
+ * @fn atl_json_dispatch_init(atl_json_dispatch_t *dispatch, const atl_json_key_t *keys, uint8_t count)
+ * @brief Build the key dispatch hash table.
+ * @param[out] dispatch - Dispatch table
+ * @param[in] keys - Key table
+ * @param[in] count - Key table size
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if too many keys.
+ */
+esp_err_t atl_json_dispatch_init(atl_json_dispatch_t *dispatch, const atl_json_key_t *keys, uint8_t count);
+
+/**
+ * @fn atl_json_dispatch_find(const atl_json_dispatch_t *dispatch, const char *key, int key_len)
+ * @brief Find a key at dispatch table.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] key - Key (not need to be null terminated)
+ * @param[in] key_len - Key length
+ * @return int - Key index if found, otherwise -1.
+ */
+int atl_json_dispatch_find(const atl_json_dispatch_t *dispatch, const char *key, int key_len);
+
+/**
+ * @fn atl_json_dispatch(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx)
+ * @brief Parse a JSON object and call the setter of each known top level key.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in] ctx - Setter context
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_json_dispatch(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx);
+
+/**
+ * @fn atl_json_dispatch_mask(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx, uint32_t skip_mask, uint32_t *applied_mask)
+ * @brief Parse a JSON object and call the setter of each known top level key not masked.
+ * @details Masks have a bit per key index, only the first 32 keys of the table can be masked and reported.
+ * @param[in] dispatch - Dispatch table
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in] ctx - Setter context
+ * @param[in] skip_mask - Keys not dispatched (bit per key index)
+ * @param[out] applied_mask - Keys successfully set (bit per key index, may be NULL)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_json_dispatch_mask(const atl_json_dispatch_t *dispatch, const char *data, int data_len, void *ctx, uint32_t skip_mask, uint32_t *applied_mask);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,7 +4,7 @@
  * @brief LED functions.
  * @version 0.1.0
  * @date 2024-03-08 (created)
- * @date 2024-03-18 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -21,6 +21,7 @@
 #include <freertos/semphr.h>
 #include <esp_log.h>
 #include <led_strip.h>
+#include "sdkconfig.h"
 #include "atl_led.h"
 #include "atl_storage.h"
 
@@ -34,10 +35,26 @@ const char *atl_led_behaviour_str[] = {
     "ATL_LED_ENABLED_FULL",
 };
 
+/* LED strip general configuration, according to your led board design */
+static const led_strip_config_t led_strip_config = {
+    .strip_gpio_num = CONFIG_ATL_LED_BUILTIN_GPIO,  // The GPIO that connected to the LED strip's data line
+    .max_leds = 1,                                  // The number of LEDs in the strip,
+    .led_pixel_format = LED_PIXEL_FORMAT_GRB,       // Pixel format of your LED strip
+    .led_model = LED_MODEL_WS2812,                  // LED strip model
+    .flags.invert_out = false,                      // whether to invert the output signal
+};
+
+/* LED strip backend configuration: RMT */
+static const led_strip_rmt_config_t led_rmt_config = {
+    .clk_src = RMT_CLK_SRC_DEFAULT,        // different clock source can lead to different power consumption
+    .resolution_hz = LED_STRIP_RMT_RES_HZ, // RMT counter clock frequency
+    .flags.with_dma = false,               // DMA feature is available on ESP target like ESP32-S3
+};
+
 /* Global variables */
 static SemaphoreHandle_t led_mutex; /**< LED builtin mutex */
 static bool led_builtin_state = false; /**< LED builtin enabled */
-static led_strip_handle_t led_strip; /**< LED builtin handle */
+static led_strip_handle_t led_strip = NULL; /**< LED builtin handle */
 static atl_led_rgb_color_t atl_led_color = {0, 0, 255}; /**< LED builtin color */
 TaskHandle_t atl_led_handle = NULL; /**< LED builtin task handle */
 static uint8_t button_count = 0; /**< Button pressed count */
@@ -69,10 +86,17 @@ static void atl_led_task(void *args) {
             vTaskDelay(pdMS_TO_TICKS(250));
 
         } else {
-
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+            /* No heartbeat with automatic light sleep (LED only shows state changes) */
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (button_pressed == false) {
+                atl_led_builtin_show();
+                continue;
+            }
+#else
             /* Toogle period */
             vTaskDelay(pdMS_TO_TICKS(CONFIG_ATL_LED_BUILTIN_PERIOD));
-
+#endif
         }
 
         /* Toogle led builtin */
@@ -80,6 +104,20 @@ static void atl_led_task(void *args) {
     }    
 }
 
+/**
+ * @fn atl_led_strip_open(void)
+ * @brief Get LED strip ready to be refreshed (RMT channel is created if needed).
+ * @details Strip is kept for the whole runtime: each refresh enables the RMT channel only while transmitting, so it
+ *  does not hold the PM lock of the channel between refreshes.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+*/
+static esp_err_t atl_led_strip_open(void) {
+    if (led_strip != NULL) {
+        return ESP_OK;
+    }
+    return led_strip_new_rmt_device(&led_strip_config, &led_rmt_config, &led_strip);
+}
+
 /**
  * @brief Get the led behaviour string object
  * @param behaviour 
@@ -120,24 +158,8 @@ void atl_led_builtin_init(void) {
         ESP_LOGW(TAG, "Could not create mutex!");
     }
 
-    /* LED strip general initialization, according to your led board design */
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = CONFIG_ATL_LED_BUILTIN_GPIO, // The GPIO that connected to the LED strip's data line
-        .max_leds = 1,                                  // The number of LEDs in the strip,
-        .led_pixel_format = LED_PIXEL_FORMAT_GRB,       // Pixel format of your LED strip
-        .led_model = LED_MODEL_WS2812,                  // LED strip model
-        .flags.invert_out = false,                      // whether to invert the output signal
-    };
-
-    /* LED strip backend configuration: RMT */
-    led_strip_rmt_config_t rmt_config = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,        // different clock source can lead to different power consumption
-        .resolution_hz = LED_STRIP_RMT_RES_HZ, // RMT counter clock frequency
-        .flags.with_dma = false,               // DMA feature is available on ESP target like ESP32-S3
-    };         
-
     /* Initialize LED builtin */
-    err = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
+    err = atl_led_strip_open();
     if (err == ESP_OK) {
 
         ESP_LOGI(TAG, "Created LED strip object with RMT backend");
@@ -164,21 +186,25 @@ void atl_led_builtin_toogle(void) {
         ESP_LOGW(TAG, "Timeout taking mutex!");
     }
     
-    /* If the addressable LED is enabled */
-    if (led_builtin_state == false) {
+    /* Get LED strip */
+    if (ESP_ERROR_CHECK_WITHOUT_ABORT(atl_led_strip_open()) == ESP_OK) {
 
-        /* Set the LED on */
-        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_set_pixel(led_strip, 0, atl_led_color.red, atl_led_color.green, atl_led_color.blue));
+        /* If the addressable LED is enabled */
+        if (led_builtin_state == false) {
 
-    } else {
+            /* Set the LED on */
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_set_pixel(led_strip, 0, atl_led_color.red, atl_led_color.green, atl_led_color.blue));
 
-        /* Set all LED off */
-        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
+        } else {
+
+            /* Set all LED off */
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
+        }
+        
+        /* Refresh the strip to send data */
+        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
     }
     
-    /* Refresh the strip to send data */
-    ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
-    
     /* Give semaphore */
     if (!xSemaphoreGive(led_mutex)) {
         ESP_LOGW(TAG, "Fail giving mutex!");
@@ -204,37 +230,64 @@ void atl_led_builtin_blink(uint8_t times, uint16_t interval, uint8_t red, uint8_
         ESP_LOGW(TAG, "Timeout taking mutex!");
     }
  
-    /* Set all LED off to clear all pixels */
-    ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
-    ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
+    /* Get LED strip (kept during the whole blink sequence) */
+    if (ESP_ERROR_CHECK_WITHOUT_ABORT(atl_led_strip_open()) == ESP_OK) {
 
-    /* Blink looping */    
-    for (uint8_t i = 0; i < times; i++) {
-        
-        /* Set the LED on */
-        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_set_pixel(led_strip, 0, red, green, blue));
+        /* Set all LED off to clear all pixels */
+        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
         ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
 
-        /* Wait ON interval */
-        vTaskDelay(pdMS_TO_TICKS(200));
+        /* Blink looping */    
+        for (uint8_t i = 0; i < times; i++) {
+            
+            /* Set the LED on */
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_set_pixel(led_strip, 0, red, green, blue));
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
 
-        /* Set all LED off */
-        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
-        ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
+            /* Wait ON interval */
+            vTaskDelay(pdMS_TO_TICKS(200));
+
+            /* Set all LED off */
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
+            ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
+
+            /* Wait OFF interval */
+            vTaskDelay(pdMS_TO_TICKS(interval));
+        }
+    }
+
+    /* Give semaphore */
+    if (!xSemaphoreGive(led_mutex)) {
+        ESP_LOGW(TAG, "Fail giving mutex!");
+    }
+}
+
+/**
+ * @fn atl_led_builtin_show(void)
+ * @brief Show current color with a single blink (LED is left off)
+*/
+void atl_led_builtin_show(void) {
+    atl_led_rgb_color_t color;
 
-        /* Wait OFF interval */
-        vTaskDelay(pdMS_TO_TICKS(interval));
+    /* Take semaphore */
+    if (!xSemaphoreTake(led_mutex, pdMS_TO_TICKS(led_mutex_timeout))) {
+        ESP_LOGW(TAG, "Timeout taking mutex!");
     }
+    color = atl_led_color;
+    led_builtin_state = false;
 
     /* Give semaphore */
     if (!xSemaphoreGive(led_mutex)) {
         ESP_LOGW(TAG, "Fail giving mutex!");
     }
+
+    atl_led_builtin_blink(1, 0, color.red, color.green, color.blue);
 }
 
 /**
  * @fn atl_led_set_color(uint8_t red, uint8_t green, uint8_t blue)
  * @brief Set led builtin color
+ * @details With automatic light sleep the new color is shown at once by a single blink.
  * @param [in] red red value (0..255)
  * @param [in] green green value (0..255)
  * @param [in] blue blue value (0..255)
@@ -255,6 +308,13 @@ void atl_led_set_color(uint8_t red, uint8_t green, uint8_t blue) {
     if (!xSemaphoreGive(led_mutex)) {
         ESP_LOGW(TAG, "Fail giving mutex!");
     }
+
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+    /* Show new state (there is no heartbeat) */
+    if (atl_led_handle != NULL) {
+        xTaskNotifyGive(atl_led_handle);
+    }
+#endif
 }
 
 /**
@@ -269,7 +329,7 @@ void atl_led_set_enabled(bool status) {
     }
 
     led_builtin_state = status;
-    if (status == false) {
+    if ((status == false) && (ESP_ERROR_CHECK_WITHOUT_ABORT(atl_led_strip_open()) == ESP_OK)) {
         /* Power off led strip */
         ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_clear(led_strip));
         ESP_ERROR_CHECK_WITHOUT_ABORT(led_strip_refresh(led_strip));
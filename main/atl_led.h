@@ -4,7 +4,7 @@
  * @brief LED header.
  * @version 0.1.0
  * @date 2024-03-08 (created)
- * @date 2024-03-18 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -82,6 +82,12 @@ void atl_led_builtin_toogle(void);
 */
 void atl_led_builtin_blink(uint8_t times, uint16_t interval, uint8_t red, uint8_t green, uint8_t blue);
 
+/**
+ * @fn atl_led_builtin_show(void)
+ * @brief Show current color with a single blink (LED is left off)
+*/
+void atl_led_builtin_show(void);
+
 /**
  * @fn atl_led_set_color(uint8_t red, uint8_t green, uint8_t blue)
  * @brief Set led builtin color
@@ -0,0 +1,484 @@
+/**
+ * @file atl_lora.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief LoRaWAN uplink (weather channels aggregation and uplink scheduler).
+ * @details Samples are aggregated between uplinks and sent with the bit-packed codec. The scheduler follows the data
+ *  rate chosen by the network server (ADR): the full schema is sent when it fits the payload limit and dwell time of
+ *  the current data rate, otherwise the compact one. After each uplink the next one waits the uplink interval or the
+ *  duty-cycle off-time (whichever is longer), and uplinks are deferred when the daily airtime budget is exhausted
+ *  (samples keep being aggregated meanwhile).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_lora_radio.h"
+#include "atl_lora_codec.h"
+#include "atl_lora.h"
+#include "atl_age.h"
+#include "atl_energy.h"
+
+#define ATL_LORA_MAC_OVERHEAD       13          /* MHDR + FHDR (without options) + FPort + MIC */
+#define ATL_LORA_JOIN_BACKOFF_MIN   15          /* First join retry delay (in seconds) */
+#define ATL_LORA_JOIN_BACKOFF_MAX   3600        /* Max. join retry delay (in seconds) */
+#define ATL_LORA_INTERVAL_MIN       60          /* Min. uplink interval set by downlink (in seconds) */
+#define ATL_LORA_DAY_US             (24LL * 3600 * 1000000)
+#define ATL_LORA_DEG_TO_RAD         0.017453293f
+
+/**
+ * @typedef atl_lora_dr_t
+ * @brief Data rate parameters (regional parameters).
+ */
+typedef struct {
+    uint8_t     sf;             /**< Spreading factor.*/
+    uint16_t    bw_khz;         /**< Bandwidth (in kHz).*/
+    uint8_t     max_payload;    /**< Max. application payload (without FOpts).*/
+} atl_lora_dr_t;
+
+/**
+ * @enum    atl_lora_agg_e
+ * @brief   Channel aggregation.
+ */
+typedef enum {
+    ATL_LORA_AGG_AVG,
+    ATL_LORA_AGG_MAX,
+    ATL_LORA_AGG_SUM,
+    ATL_LORA_AGG_VECTOR,
+    ATL_LORA_AGG_LAST,
+} atl_lora_agg_e;
+
+/**
+ * @typedef atl_lora_acc_t
+ * @brief Channel accumulator.
+ */
+typedef struct {
+    float       sum;            /**< Sum of samples (or sine sum of vector channels).*/
+    float       sum_cos;        /**< Cosine sum (vector channels).*/
+    float       max;            /**< Max. sample.*/
+    float       last;           /**< Last sample.*/
+    uint16_t    count;          /**< Samples since last uplink.*/
+} atl_lora_acc_t;
+
+/* Constants */
+static const char *TAG = "atl-lora";
+#if defined(CONFIG_ATL_LORA_REGION_EU868)
+static const atl_lora_dr_t atl_lora_dr_table[] = {
+    {12, 125, 51}, {11, 125, 51}, {10, 125, 51}, {9, 125, 115}, {8, 125, 222}, {7, 125, 222}, {7, 250, 222},
+};
+#elif defined(CONFIG_ATL_LORA_REGION_US915)
+static const atl_lora_dr_t atl_lora_dr_table[] = {
+    {10, 125, 11}, {9, 125, 53}, {8, 125, 125}, {7, 125, 242}, {8, 500, 242},
+};
+#else
+static const atl_lora_dr_t atl_lora_dr_table[] = {
+    {12, 125, 51}, {11, 125, 51}, {10, 125, 51}, {9, 125, 115}, {8, 125, 242}, {7, 125, 242}, {8, 500, 242},
+};
+#endif
+static const atl_lora_agg_e atl_lora_channel_agg[ATL_LORA_CH_MAX] = {
+    ATL_LORA_AGG_AVG,       /* Temperature */
+    ATL_LORA_AGG_AVG,       /* Humidity */
+    ATL_LORA_AGG_AVG,       /* Pressure */
+    ATL_LORA_AGG_AVG,       /* Wind speed */
+    ATL_LORA_AGG_MAX,       /* Wind gust */
+    ATL_LORA_AGG_VECTOR,    /* Wind direction */
+    ATL_LORA_AGG_SUM,       /* Rain */
+    ATL_LORA_AGG_AVG,       /* Solar radiation */
+    ATL_LORA_AGG_LAST,      /* Battery */
+};
+static const atl_lora_codec_field_t atl_lora_weather_fields[] = {
+    {ATL_LORA_CH_TEMPERATURE,   -40.0f, 0.1f,  11},     /* -40.0 to 164.6 °C */
+    {ATL_LORA_CH_HUMIDITY,      0.0f,   0.5f,  8},      /* 0 to 127 % */
+    {ATL_LORA_CH_PRESSURE,      800.0f, 0.1f,  12},     /* 800.0 to 1209.4 hPa */
+    {ATL_LORA_CH_WIND_SPEED,    0.0f,   0.1f,  10},     /* 0 to 102.2 m/s */
+    {ATL_LORA_CH_WIND_GUST,     0.0f,   0.1f,  10},     /* 0 to 102.2 m/s */
+    {ATL_LORA_CH_WIND_DIR,      0.0f,   2.0f,  8},      /* 0 to 508 degrees */
+    {ATL_LORA_CH_RAIN,          0.0f,   0.2f,  11},     /* 0 to 409.2 mm */
+    {ATL_LORA_CH_SOLAR,         0.0f,   4.0f,  9},      /* 0 to 2040 W/m² */
+    {ATL_LORA_CH_BATTERY,       2.5f,   0.01f, 8},      /* 2.50 to 5.04 V */
+};
+static const atl_lora_codec_field_t atl_lora_weather_min_fields[] = {
+    {ATL_LORA_CH_TEMPERATURE,   -40.0f, 0.1f,  11},
+    {ATL_LORA_CH_HUMIDITY,      0.0f,   0.5f,  8},
+    {ATL_LORA_CH_RAIN,          0.0f,   0.2f,  11},
+    {ATL_LORA_CH_BATTERY,       2.5f,   0.01f, 8},
+};
+static const atl_lora_codec_schema_t atl_lora_schemas[] = {
+    {ATL_LORA_PORT_WEATHER, sizeof(atl_lora_weather_fields) / sizeof(atl_lora_codec_field_t), atl_lora_weather_fields},            /* 11 bytes */
+    {ATL_LORA_PORT_WEATHER_MIN, sizeof(atl_lora_weather_min_fields) / sizeof(atl_lora_codec_field_t), atl_lora_weather_min_fields}, /* 5 bytes */
+};
+#ifdef CONFIG_ATL_LORA_RADIO_SIM
+static const atl_lora_radio_t *atl_lora_radio = &atl_lora_radio_sim;
+#else
+static const atl_lora_radio_t *atl_lora_radio = &atl_lora_radio_at;
+#endif
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/* Global variables */
+static SemaphoreHandle_t atl_lora_mutex = NULL;
+static atl_lora_acc_t atl_lora_acc[ATL_LORA_CH_MAX];
+static atl_lora_status_t atl_lora_status;
+static int64_t atl_lora_day_start = 0;
+static int64_t atl_lora_acquired_us = 0;   /* Acquisition of oldest sample since last uplink (0 if none) */
+static uint32_t atl_lora_interval = 0;      /* Uplink interval (in seconds) */
+static char atl_lora_dev_eui[sizeof(atl_config.lora.dev_eui) + 1];
+static char atl_lora_join_eui[sizeof(atl_config.lora.join_eui) + 1];
+static char atl_lora_app_key[sizeof(atl_config.lora.app_key) + 1];
+
+/**
+ * @fn atl_lora_airtime_ms(uint8_t dr, size_t len)
+ * @brief Compute uplink airtime (explicit header, CRC on, coding rate 4/5, 8 symbols preamble).
+ * @param[in] dr - Data rate
+ * @param[in] len - Application payload length
+ * @return uint32_t - Airtime (in ms).
+ */
+static uint32_t atl_lora_airtime_ms(uint8_t dr, size_t len) {
+    const atl_lora_dr_t *rate = &atl_lora_dr_table[dr];
+    uint32_t tsym_us = ((1UL << rate->sf) * 1000UL) / rate->bw_khz;
+    int32_t de = ((rate->sf >= 11) && (rate->bw_khz == 125)) ? 1 : 0;
+    int32_t num = (8 * (int32_t)(len + ATL_LORA_MAC_OVERHEAD)) - (4 * rate->sf) + 28 + 16;
+    int32_t den = 4 * (rate->sf - (2 * de));
+    int32_t payload_sym = 8;
+    if (num > 0) {
+        payload_sym += ((num + den - 1) / den) * 5;
+    }
+    return (((tsym_us * 49) / 4) + (payload_sym * tsym_us) + 999) / 1000;
+}
+
+/**
+ * @fn atl_lora_aggregate(float *values)
+ * @brief Get aggregated channel values since last uplink (NAN if channel has no samples).
+ * @param[out] values - Channel values
+ */
+static void atl_lora_aggregate(float *values) {
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    for (uint8_t ch = 0; ch < ATL_LORA_CH_MAX; ch++) {
+        atl_lora_acc_t *acc = &atl_lora_acc[ch];
+        if (acc->count == 0) {
+            values[ch] = NAN;
+            continue;
+        }
+        switch (atl_lora_channel_agg[ch]) {
+            case ATL_LORA_AGG_AVG:
+                values[ch] = acc->sum / acc->count;
+                break;
+            case ATL_LORA_AGG_MAX:
+                values[ch] = acc->max;
+                break;
+            case ATL_LORA_AGG_SUM:
+                values[ch] = acc->sum;
+                break;
+            case ATL_LORA_AGG_VECTOR:
+                values[ch] = atan2f(acc->sum, acc->sum_cos) / ATL_LORA_DEG_TO_RAD;
+                if (values[ch] < 0.0f) {
+                    values[ch] += 360.0f;
+                }
+                break;
+            default:
+                values[ch] = acc->last;
+                break;
+        }
+    }
+    xSemaphoreGive(atl_lora_mutex);
+}
+
+/**
+ * @fn atl_lora_clear(void)
+ * @brief Clear channel accumulators (after a successful uplink).
+ */
+static void atl_lora_clear(void) {
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) == pdTRUE) {
+        memset(atl_lora_acc, 0, sizeof(atl_lora_acc));
+        atl_lora_acquired_us = 0;
+        xSemaphoreGive(atl_lora_mutex);
+    }
+}
+
+/**
+ * @fn atl_lora_downlink(const atl_lora_downlink_t *downlink)
+ * @brief Process a downlink (configuration port: 0x01 + uplink interval in seconds, big endian).
+ * @param[in] downlink - Downlink received
+ */
+static void atl_lora_downlink(const atl_lora_downlink_t *downlink) {
+    if ((downlink->port != ATL_LORA_PORT_CONFIG) || (downlink->len < 3) || (downlink->data[0] != 0x01)) {
+        if (downlink->port != 0) {
+            ESP_LOGW(TAG, "Unknown downlink (port %d, %d bytes)", downlink->port, downlink->len);
+        }
+        return;
+    }
+    uint16_t interval = (downlink->data[1] << 8) | downlink->data[2];
+    if (interval < ATL_LORA_INTERVAL_MIN) {
+        interval = ATL_LORA_INTERVAL_MIN;
+    }
+    ESP_LOGI(TAG, "Uplink interval set to %d s by downlink", interval);
+    atl_lora_interval = interval;
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_config.lora.interval = interval;
+        xSemaphoreGive(atl_config_mutex);
+        atl_config_commit_nvs();
+    }
+}
+
+/**
+ * @fn atl_lora_uplink(void)
+ * @brief Send aggregated channels with the largest schema allowed by current data rate.
+ * @return uint32_t - Duty-cycle off-time after the uplink (in seconds).
+ */
+static uint32_t atl_lora_uplink(void) {
+    float values[ATL_LORA_CH_MAX];
+    uint8_t payload[16];
+    size_t len = 0;
+    atl_lora_link_t link = {0};
+    atl_lora_downlink_t downlink;
+    const atl_lora_codec_schema_t *schema = NULL;
+    uint32_t airtime = 0;
+
+    /* Link parameters set by ADR */
+    if (atl_lora_radio->get_link(&link) != ESP_OK) {
+        link.dr = 0;
+    }
+    if (link.dr >= (sizeof(atl_lora_dr_table) / sizeof(atl_lora_dr_t))) {
+        link.dr = 0;
+    }
+    if (link.max_payload == 0) {
+        link.max_payload = atl_lora_dr_table[link.dr].max_payload;
+    }
+
+    /* Largest schema allowed by payload limit and dwell time */
+    for (uint8_t i = 0; i < (sizeof(atl_lora_schemas) / sizeof(atl_lora_codec_schema_t)); i++) {
+        size_t size = atl_lora_codec_size(&atl_lora_schemas[i]);
+        schema = &atl_lora_schemas[i];
+        airtime = atl_lora_airtime_ms(link.dr, size);
+        if ((size <= link.max_payload) && ((CONFIG_ATL_LORA_MAX_DWELL_TIME == 0) || (airtime <= CONFIG_ATL_LORA_MAX_DWELL_TIME))) {
+            break;
+        }
+    }
+
+    /* Daily airtime budget */
+    bool deferred = false;
+    int64_t acquired_us = 0;
+    int64_t now = esp_timer_get_time();
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) == pdTRUE) {
+        acquired_us = atl_lora_acquired_us;
+        if ((now - atl_lora_day_start) >= ATL_LORA_DAY_US) {
+            atl_lora_day_start = now;
+            atl_lora_status.airtime_day_ms = 0;
+        }
+        if ((CONFIG_ATL_LORA_DAILY_AIRTIME > 0) && ((atl_lora_status.airtime_day_ms + airtime) > (CONFIG_ATL_LORA_DAILY_AIRTIME * 1000UL))) {
+            atl_lora_status.deferred++;
+            deferred = true;
+        }
+        xSemaphoreGive(atl_lora_mutex);
+    }
+    if (deferred == true) {
+        ESP_LOGW(TAG, "Daily airtime budget exhausted, uplink deferred");
+        return 0;
+    }
+
+    /* Encode and send */
+    atl_lora_aggregate(values);
+    atl_lora_codec_encode(schema, values, payload, sizeof(payload), &len);
+    atl_age_record(ATL_AGE_AGGREGATED, acquired_us);
+    memset(&downlink, 0, sizeof(downlink));
+    esp_err_t err = atl_lora_radio->send(schema->port, payload, len, &downlink);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Uplink failed: %s", esp_err_to_name(err));
+        return 0;
+    }
+    atl_lora_clear();
+    atl_age_record(ATL_AGE_PUBLISHED, acquired_us);
+    atl_energy_tx(ATL_ENERGY_SAMPLING, len);
+    ESP_LOGI(TAG, "Uplink port %d, %d bytes, DR%d (SF%d), airtime %lu ms", schema->port, len, link.dr,
+             atl_lora_dr_table[link.dr].sf, airtime);
+
+    /* Update status */
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_lora_status.dr = link.dr;
+        atl_lora_status.last_port = schema->port;
+        atl_lora_status.last_len = len;
+        atl_lora_status.last_airtime_ms = airtime;
+        atl_lora_status.airtime_day_ms += airtime;
+        atl_lora_status.uplinks++;
+        if (downlink.rssi != 0) {
+            atl_lora_status.rssi = downlink.rssi;
+            atl_lora_status.snr = downlink.snr;
+        }
+        xSemaphoreGive(atl_lora_mutex);
+    }
+    atl_lora_downlink(&downlink);
+
+    /* Off-time = airtime * (1 / duty-cycle - 1) */
+#if CONFIG_ATL_LORA_DUTY_CYCLE > 0
+    return ((airtime * (1000UL - CONFIG_ATL_LORA_DUTY_CYCLE)) / CONFIG_ATL_LORA_DUTY_CYCLE + 999) / 1000;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @fn atl_lora_task(void *args)
+ * @brief LoRa task (join and uplink scheduler).
+ * @param[in] args - Not used
+ */
+static void atl_lora_task(void *args) {
+    atl_lora_keys_t keys = {
+        .dev_eui = atl_lora_dev_eui,
+        .join_eui = atl_lora_join_eui,
+        .app_key = atl_lora_app_key,
+    };
+    uint32_t backoff = ATL_LORA_JOIN_BACKOFF_MIN;
+
+    /* Initialize radio */
+    if (atl_lora_radio->init() != ESP_OK) {
+        ESP_LOGE(TAG, "Fail initializing radio %s!", atl_lora_radio->name);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    /* Join network (join requests are also subject to duty-cycle, retries back off) */
+    while (atl_lora_radio->join(&keys) != ESP_OK) {
+        ESP_LOGW(TAG, "Join failed, retrying in %lu s", backoff);
+        vTaskDelay(pdMS_TO_TICKS(backoff * 1000));
+        backoff = (backoff * 2 > ATL_LORA_JOIN_BACKOFF_MAX) ? ATL_LORA_JOIN_BACKOFF_MAX : backoff * 2;
+    }
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_lora_status.joined = true;
+        xSemaphoreGive(atl_lora_mutex);
+    }
+    ESP_LOGI(TAG, "Joined network (DevEUI %s)", atl_lora_dev_eui);
+
+    /* Uplink scheduler */
+    while (true) {
+        atl_energy_begin(ATL_ENERGY_SAMPLING);
+        uint32_t off_time = atl_lora_uplink();
+        atl_energy_end(ATL_ENERGY_SAMPLING);
+        uint32_t wait = (off_time > atl_lora_interval) ? off_time : atl_lora_interval;
+        vTaskDelay(pdMS_TO_TICKS(wait * 1000));
+    }
+}
+
+/**
+ * @fn atl_lora_init(void)
+ * @brief Initialize LoRaWAN uplink (radio, join and uplink scheduler task).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_lora_init(void) {
+    esp_err_t err = ESP_OK;
+    ESP_LOGI(TAG, "Starting LoRaWAN uplink (%s radio)", atl_lora_radio->name);
+
+    /* Get credentials and interval from configuration */
+    memset(atl_lora_dev_eui, 0, sizeof(atl_lora_dev_eui));
+    memset(atl_lora_join_eui, 0, sizeof(atl_lora_join_eui));
+    memset(atl_lora_app_key, 0, sizeof(atl_lora_app_key));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(atl_lora_dev_eui, atl_config.lora.dev_eui, sizeof(atl_config.lora.dev_eui));
+        memcpy(atl_lora_join_eui, atl_config.lora.join_eui, sizeof(atl_config.lora.join_eui));
+        memcpy(atl_lora_app_key, atl_config.lora.app_key, sizeof(atl_config.lora.app_key));
+        atl_lora_interval = atl_config.lora.interval;
+        xSemaphoreGive(atl_config_mutex);
+    } else {
+        ESP_LOGE(TAG, "Fail to get configuration mutex!");
+        return ESP_FAIL;
+    }
+
+    if (atl_lora_interval < ATL_LORA_INTERVAL_MIN) {
+        atl_lora_interval = ATL_LORA_INTERVAL_MIN;
+    }
+
+    /* Create accumulators mutex */
+    atl_lora_mutex = xSemaphoreCreateMutex();
+    if (atl_lora_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    memset(atl_lora_acc, 0, sizeof(atl_lora_acc));
+    memset(&atl_lora_status, 0, sizeof(atl_lora_status_t));
+    atl_lora_status.radio = atl_lora_radio->name;
+
+    /* Start LoRa task */
+    if (xTaskCreatePinnedToCore(atl_lora_task, "atl_lora_task", 4096, NULL, 5, NULL, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating LoRa task!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
+
+/**
+ * @fn atl_lora_put(atl_lora_channel_e channel, float value)
+ * @brief Add a sample to a weather channel (aggregated until next uplink).
+ * @param[in] channel - Weather channel
+ * @param[in] value - Sample value
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if channel is invalid.
+ */
+esp_err_t atl_lora_put(atl_lora_channel_e channel, float value) {
+    if ((channel >= ATL_LORA_CH_MAX) || isnan(value)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (atl_lora_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    atl_lora_acc_t *acc = &atl_lora_acc[channel];
+    if (atl_lora_channel_agg[channel] == ATL_LORA_AGG_VECTOR) {
+        acc->sum += sinf(value * ATL_LORA_DEG_TO_RAD);
+        acc->sum_cos += cosf(value * ATL_LORA_DEG_TO_RAD);
+    } else {
+        acc->sum += value;
+    }
+    if ((acc->count == 0) || (value > acc->max)) {
+        acc->max = value;
+    }
+    acc->last = value;
+    acc->count++;
+    if (atl_lora_acquired_us == 0) {
+        atl_lora_acquired_us = esp_timer_get_time();
+    }
+    xSemaphoreGive(atl_lora_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_lora_get_status(atl_lora_status_t *status)
+ * @brief Get LoRaWAN uplink status.
+ * @param[out] status - Uplink status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if LoRaWAN uplink is not initialized.
+ */
+esp_err_t atl_lora_get_status(atl_lora_status_t *status) {
+    if (atl_lora_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_lora_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    memcpy(status, &atl_lora_status, sizeof(atl_lora_status_t));
+    xSemaphoreGive(atl_lora_mutex);
+    return ESP_OK;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file atl_lora.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief LoRaWAN uplink header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_LORA_PORT_CONFIG        1       /**< Downlink port of configuration commands.*/
+#define ATL_LORA_PORT_WEATHER       10      /**< Uplink port of full weather schema.*/
+#define ATL_LORA_PORT_WEATHER_MIN   11      /**< Uplink port of compact weather schema (slow data rates).*/
+
+/**
+ * @enum    atl_lora_channel_e
+ * @brief   Weather channels aggregated between uplinks.
+ */
+typedef enum {
+    ATL_LORA_CH_TEMPERATURE,        /**< Air temperature (°C, average).*/
+    ATL_LORA_CH_HUMIDITY,           /**< Relative humidity (%, average).*/
+    ATL_LORA_CH_PRESSURE,           /**< Barometric pressure (hPa, average).*/
+    ATL_LORA_CH_WIND_SPEED,         /**< Wind speed (m/s, average).*/
+    ATL_LORA_CH_WIND_GUST,          /**< Wind gust (m/s, maximum).*/
+    ATL_LORA_CH_WIND_DIR,           /**< Wind direction (degrees, vector average).*/
+    ATL_LORA_CH_RAIN,               /**< Rain (mm, sum).*/
+    ATL_LORA_CH_SOLAR,              /**< Solar radiation (W/m², average).*/
+    ATL_LORA_CH_BATTERY,            /**< Battery voltage (V, last).*/
+    ATL_LORA_CH_MAX,
+} atl_lora_channel_e;
+
+/**
+ * @typedef atl_lora_status_t
+ * @brief LoRaWAN uplink status.
+ */
+typedef struct {
+    const char  *radio;             /**< Radio name.*/
+    bool        joined;             /**< Device joined the network.*/
+    uint8_t     dr;                 /**< Data rate of last uplink.*/
+    uint8_t     last_port;          /**< Port of last uplink.*/
+    uint8_t     last_len;           /**< Payload length of last uplink.*/
+    uint32_t    last_airtime_ms;    /**< Airtime of last uplink.*/
+    uint32_t    airtime_day_ms;     /**< Airtime used at current day.*/
+    uint32_t    uplinks;            /**< Uplinks sent.*/
+    uint32_t    deferred;           /**< Uplinks deferred by airtime budget.*/
+    int16_t     rssi;               /**< RSSI of last downlink (0 if none).*/
+    int8_t      snr;                /**< SNR of last downlink.*/
+} atl_lora_status_t;
+
+/**
+ * @fn atl_lora_init(void)
+ * @brief Initialize LoRaWAN uplink (radio, join and uplink scheduler task).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_lora_init(void);
+
+/**
+ * @fn atl_lora_put(atl_lora_channel_e channel, float value)
+ * @brief Add a sample to a weather channel (aggregated until next uplink).
+ * @param[in] channel - Weather channel
+ * @param[in] value - Sample value
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if channel is invalid.
+ */
+esp_err_t atl_lora_put(atl_lora_channel_e channel, float value);
+
+/**
+ * @fn atl_lora_get_status(atl_lora_status_t *status)
+ * @brief Get LoRaWAN uplink status.
+ * @param[out] status - Uplink status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if LoRaWAN uplink is not initialized.
+ */
+esp_err_t atl_lora_get_status(atl_lora_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
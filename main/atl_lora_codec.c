@@ -0,0 +1,117 @@
+/**
+ * @file atl_lora_codec.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Bit-packed LoRaWAN payload codec.
+ * @details Each field is quantized to its resolution and packed with the minimum width, so a full weather sample fits
+ *  in 11 bytes (the payload limit of the slowest data rates). Field layout is fixed by the schema, the network
+ *  server decoder uses the same tables.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <math.h>
+#include "atl_lora_codec.h"
+
+/**
+ * @fn atl_lora_codec_na(uint8_t bits)
+ * @brief Get the not available marker of a field (all bits set).
+ * @param[in] bits - Field width
+ * @return uint32_t - Not available marker.
+ */
+static uint32_t atl_lora_codec_na(uint8_t bits) {
+    return (bits >= 32) ? UINT32_MAX : ((1UL << bits) - 1);
+}
+
+/**
+ * @fn atl_lora_codec_size(const atl_lora_codec_schema_t *schema)
+ * @brief Get the payload size of a schema.
+ * @param[in] schema - Payload schema
+ * @return size_t - Payload size (in bytes).
+ */
+size_t atl_lora_codec_size(const atl_lora_codec_schema_t *schema) {
+    size_t bits = 0;
+    for (uint8_t i = 0; i < schema->field_count; i++) {
+        bits += schema->fields[i].bits;
+    }
+    return (bits + 7) / 8;
+}
+
+/**
+ * @fn atl_lora_codec_encode(const atl_lora_codec_schema_t *schema, const float *values, uint8_t *buf, size_t buf_size, size_t *len)
+ * @brief Encode channel values (out of range values are clamped, NAN is encoded as not available).
+ * @param[in] schema - Payload schema
+ * @param[in] values - Channel values
+ * @param[out] buf - Payload buffer
+ * @param[in] buf_size - Payload buffer size
+ * @param[out] len - Payload length
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if buffer is too small.
+ */
+esp_err_t atl_lora_codec_encode(const atl_lora_codec_schema_t *schema, const float *values, uint8_t *buf, size_t buf_size, size_t *len) {
+    size_t size = atl_lora_codec_size(schema);
+    size_t pos = 0;
+    if (size > buf_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(buf, 0, size);
+    for (uint8_t i = 0; i < schema->field_count; i++) {
+        const atl_lora_codec_field_t *field = &schema->fields[i];
+        uint32_t na = atl_lora_codec_na(field->bits);
+        uint32_t raw = na;
+
+        /* Quantize value (highest raw value is reserved to not available) */
+        float value = values[field->channel];
+        if (!isnan(value)) {
+            float q = roundf((value - field->min) / field->step);
+            if (q <= 0.0f) {
+                raw = 0;
+            } else if (q >= (float)(na - 1)) {
+                raw = na - 1;
+            } else {
+                raw = (uint32_t)q;
+            }
+        }
+
+        /* Append field bits (MSB first) */
+        for (int8_t bit = field->bits - 1; bit >= 0; bit--, pos++) {
+            if (raw & (1UL << bit)) {
+                buf[pos / 8] |= 0x80 >> (pos % 8);
+            }
+        }
+    }
+    *len = size;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_lora_codec_decode(const atl_lora_codec_schema_t *schema, const uint8_t *buf, size_t len, float *values)
+ * @brief Decode a payload (channels not available are set to NAN, channels out of schema are not changed).
+ * @param[in] schema - Payload schema
+ * @param[in] buf - Payload
+ * @param[in] len - Payload length
+ * @param[out] values - Channel values
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if payload is too short.
+ */
+esp_err_t atl_lora_codec_decode(const atl_lora_codec_schema_t *schema, const uint8_t *buf, size_t len, float *values) {
+    size_t pos = 0;
+    if (len < atl_lora_codec_size(schema)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (uint8_t i = 0; i < schema->field_count; i++) {
+        const atl_lora_codec_field_t *field = &schema->fields[i];
+        uint32_t raw = 0;
+        for (uint8_t bit = 0; bit < field->bits; bit++, pos++) {
+            raw = (raw << 1) | ((buf[pos / 8] >> (7 - (pos % 8))) & 0x01);
+        }
+        values[field->channel] = (raw == atl_lora_codec_na(field->bits)) ? NAN : (field->min + (raw * field->step));
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file atl_lora_codec.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Bit-packed LoRaWAN payload codec header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef atl_lora_codec_field_t
+ * @brief Payload field (value = min + raw * step, raw with all bits set means not available).
+ */
+typedef struct {
+    uint8_t     channel;    /**< Source channel (index at values array).*/
+    float       min;        /**< Minimum value.*/
+    float       step;       /**< Resolution.*/
+    uint8_t     bits;       /**< Field width (1 to 32 bits).*/
+} atl_lora_codec_field_t;
+
+/**
+ * @typedef atl_lora_codec_schema_t
+ * @brief Payload schema (fields packed MSB first, without padding between them).
+ * @details Schema is identified by the LoRaWAN port, so the payload has no header.
+ */
+typedef struct {
+    uint8_t                         port;           /**< LoRaWAN port of the schema.*/
+    uint8_t                         field_count;    /**< Number of fields.*/
+    const atl_lora_codec_field_t    *fields;        /**< Fields (in payload order).*/
+} atl_lora_codec_schema_t;
+
+/**
+ * @fn atl_lora_codec_size(const atl_lora_codec_schema_t *schema)
+ * @brief Get the payload size of a schema.
+ * @param[in] schema - Payload schema
+ * @return size_t - Payload size (in bytes).
+ */
+size_t atl_lora_codec_size(const atl_lora_codec_schema_t *schema);
+
+/**
+ * @fn atl_lora_codec_encode(const atl_lora_codec_schema_t *schema, const float *values, uint8_t *buf, size_t buf_size, size_t *len)
+ * @brief Encode channel values (out of range values are clamped, NAN is encoded as not available).
+ * @param[in] schema - Payload schema
+ * @param[in] values - Channel values
+ * @param[out] buf - Payload buffer
+ * @param[in] buf_size - Payload buffer size
+ * @param[out] len - Payload length
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if buffer is too small.
+ */
+esp_err_t atl_lora_codec_encode(const atl_lora_codec_schema_t *schema, const float *values, uint8_t *buf, size_t buf_size, size_t *len);
+
+/**
+ * @fn atl_lora_codec_decode(const atl_lora_codec_schema_t *schema, const uint8_t *buf, size_t len, float *values)
+ * @brief Decode a payload (channels not available are set to NAN, channels out of schema are not changed).
+ * @param[in] schema - Payload schema
+ * @param[in] buf - Payload
+ * @param[in] len - Payload length
+ * @param[out] values - Channel values
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_SIZE if payload is too short.
+ */
+esp_err_t atl_lora_codec_decode(const atl_lora_codec_schema_t *schema, const uint8_t *buf, size_t len, float *values);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file atl_lora_radio.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief LoRaWAN radio abstraction header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_LORA_MAX_DOWNLINK       32      /**< Max. downlink payload kept.*/
+
+/**
+ * @typedef atl_lora_keys_t
+ * @brief OTAA join credentials (hex strings).
+ */
+typedef struct {
+    const char  *dev_eui;       /**< Device EUI.*/
+    const char  *join_eui;      /**< Join (application) EUI.*/
+    const char  *app_key;       /**< Application key.*/
+} atl_lora_keys_t;
+
+/**
+ * @typedef atl_lora_link_t
+ * @brief Radio link parameters (managed by network server through ADR).
+ */
+typedef struct {
+    uint8_t     dr;             /**< Current data rate.*/
+    uint8_t     max_payload;    /**< Max. application payload at current data rate (0 if unknown, region table is used).*/
+    int8_t      tx_power;       /**< TX power in dBm (0 if unknown).*/
+} atl_lora_link_t;
+
+/**
+ * @typedef atl_lora_downlink_t
+ * @brief Downlink received at class A receive windows.
+ */
+typedef struct {
+    uint8_t     port;                           /**< Downlink port (0 if there is no application downlink).*/
+    uint8_t     len;                            /**< Downlink payload length.*/
+    uint8_t     data[ATL_LORA_MAX_DOWNLINK];    /**< Downlink payload.*/
+    int16_t     rssi;                           /**< Downlink RSSI (0 if nothing was received).*/
+    int8_t      snr;                            /**< Downlink SNR.*/
+} atl_lora_downlink_t;
+
+/**
+ * @typedef atl_lora_radio_t
+ * @brief LoRaWAN radio operations (class A device, MAC commands handled by radio).
+ * @details Operations are blocking and called only from LoRa task.
+ */
+typedef struct {
+    const char  *name;                                                  /**< Radio name.*/
+    esp_err_t   (*init)(void);                                          /**< Initialize radio.*/
+    esp_err_t   (*join)(const atl_lora_keys_t *keys);                   /**< OTAA join (ADR enabled).*/
+    esp_err_t   (*send)(uint8_t port, const uint8_t *data, size_t len, atl_lora_downlink_t *downlink);  /**< Unconfirmed uplink and receive windows.*/
+    esp_err_t   (*get_link)(atl_lora_link_t *link);                     /**< Get current link parameters.*/
+} atl_lora_radio_t;
+
+/** AT command module radio (RHF76-052 / LoRa-E5 command set). */
+extern const atl_lora_radio_t atl_lora_radio_at;
+
+/** Simulated radio (no hardware, frames are logged). */
+extern const atl_lora_radio_t atl_lora_radio_sim;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,318 @@
+/**
+ * @file atl_lora_radio_at.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief LoRaWAN radio for AT command modules (RHF76-052 / LoRa-E5 command set).
+ * @details The module runs the LoRaWAN MAC (join, ADR, receive windows), this driver only sends commands and parses
+ *  the answers. Each command waits for its final line ("+<CMD>: Done" for long commands).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <driver/uart.h>
+#include "sdkconfig.h"
+#include "atl_lora_radio.h"
+#include "atl_pm.h"
+
+#ifdef CONFIG_ATL_LORA_RADIO_AT
+
+#define ATL_LORA_AT_UART            UART_NUM_2
+#define ATL_LORA_AT_LINE_LEN        128         /* Max. answer line */
+#define ATL_LORA_AT_CMD_TIMEOUT     1000        /* Short command timeout (in ms) */
+#define ATL_LORA_AT_JOIN_TIMEOUT    20000       /* Join timeout (in ms) */
+#define ATL_LORA_AT_SEND_TIMEOUT    15000       /* Uplink and receive windows timeout (in ms) */
+
+/* Constants */
+static const char *TAG = "atl-lora-at";
+#if defined(CONFIG_ATL_LORA_REGION_EU868)
+static const char *atl_lora_at_region = "EU868";
+#elif defined(CONFIG_ATL_LORA_REGION_US915)
+static const char *atl_lora_at_region = "US915HYBRID";
+#else
+static const char *atl_lora_at_region = "AU915";
+#endif
+
+/**
+ * @typedef atl_lora_at_line_cb_t
+ * @brief Answer line callback.
+ */
+typedef void (*atl_lora_at_line_cb_t)(const char *line, void *arg);
+
+/**
+ * @fn atl_lora_at_read_line(char *line, size_t size, int64_t deadline)
+ * @brief Read an answer line (without line terminators).
+ * @param[out] line - Line buffer
+ * @param[in] size - Line buffer size
+ * @param[in] deadline - Read deadline (esp_timer time in us)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_TIMEOUT if deadline was reached.
+ */
+static esp_err_t atl_lora_at_read_line(char *line, size_t size, int64_t deadline) {
+    size_t len = 0;
+    while (esp_timer_get_time() < deadline) {
+        uint8_t c;
+        int64_t remaining_ms = (deadline - esp_timer_get_time()) / 1000;
+        if (uart_read_bytes(ATL_LORA_AT_UART, &c, 1, pdMS_TO_TICKS(remaining_ms > 0 ? remaining_ms : 1)) != 1) {
+            continue;
+        }
+        if ((c == '\r') || (c == '\n')) {
+            if (len > 0) {
+                line[len] = '\0';
+                return ESP_OK;
+            }
+        } else if (len < (size - 1)) {
+            line[len++] = c;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @fn atl_lora_at_cmd(const char *cmd, const char *done, uint32_t timeout_ms, atl_lora_at_line_cb_t cb, void *arg)
+ * @brief Send a command and wait its final line.
+ * @details UART receive does not wake the chip from light sleep, so light sleep is blocked until the final line.
+ * @param[in] cmd - Command (without line terminator)
+ * @param[in] done - Text of the final line
+ * @param[in] timeout_ms - Timeout (in ms)
+ * @param[in] cb - Callback called for each answer line (may be NULL)
+ * @param[in] arg - Callback argument
+ * @return esp_err_t - If ERR_OK success, ESP_FAIL if module answered an error, ESP_ERR_TIMEOUT on timeout.
+ */
+static esp_err_t atl_lora_at_cmd(const char *cmd, const char *done, uint32_t timeout_ms, atl_lora_at_line_cb_t cb, void *arg) {
+    char line[ATL_LORA_AT_LINE_LEN];
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    int64_t deadline = esp_timer_get_time() + (timeout_ms * 1000LL);
+    atl_pm_acquire(ATL_PM_LOCK_UART);
+    uart_flush_input(ATL_LORA_AT_UART);
+    uart_write_bytes(ATL_LORA_AT_UART, cmd, strlen(cmd));
+    uart_write_bytes(ATL_LORA_AT_UART, "\r\n", 2);
+    while (atl_lora_at_read_line(line, sizeof(line), deadline) == ESP_OK) {
+        ESP_LOGD(TAG, "%s", line);
+        if (cb != NULL) {
+            cb(line, arg);
+        }
+        if (strstr(line, "ERROR") != NULL) {
+            ESP_LOGW(TAG, "%s: %s", cmd, line);
+            err = ESP_FAIL;
+            break;
+        }
+        if (strstr(line, done) != NULL) {
+            err = ESP_OK;
+            break;
+        }
+    }
+    atl_pm_release(ATL_PM_LOCK_UART);
+    if (err == ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "%s: timeout", cmd);
+    }
+    return err;
+}
+
+/**
+ * @fn atl_lora_at_join_line(const char *line, void *arg)
+ * @brief Join answer line callback.
+ * @param[in] line - Answer line
+ * @param[out] arg - Joined flag
+ */
+static void atl_lora_at_join_line(const char *line, void *arg) {
+    if ((strstr(line, "Network joined") != NULL) || (strstr(line, "Joined already") != NULL)) {
+        *(bool *)arg = true;
+    }
+}
+
+/**
+ * @fn atl_lora_at_send_line(const char *line, void *arg)
+ * @brief Uplink answer line callback (downlink data and receive window metrics).
+ * @param[in] line - Answer line
+ * @param[out] arg - Downlink
+ */
+static void atl_lora_at_send_line(const char *line, void *arg) {
+    atl_lora_downlink_t *downlink = (atl_lora_downlink_t *)arg;
+    const char *field;
+    int port;
+    float snr;
+    int rssi;
+
+    /* +MSGHEX: RXWIN1, RSSI -106, SNR 4.0 */
+    field = strstr(line, "RSSI");
+    if ((field != NULL) && (sscanf(field, "RSSI %d, SNR %f", &rssi, &snr) == 2)) {
+        downlink->rssi = rssi;
+        downlink->snr = (int8_t)snr;
+    }
+
+    /* +MSGHEX: PORT: 1; RX: "0100B4" */
+    field = strstr(line, "PORT:");
+    if ((field != NULL) && (sscanf(field, "PORT: %d", &port) == 1)) {
+        downlink->port = port;
+        downlink->len = 0;
+        field = strstr(field, "RX: \"");
+        if (field != NULL) {
+            field += 5;
+            while ((field[0] != '"') && (field[0] != '\0') && (field[1] != '\0') && (downlink->len < ATL_LORA_MAX_DOWNLINK)) {
+                char byte[3] = {field[0], field[1], '\0'};
+                downlink->data[downlink->len++] = strtoul(byte, NULL, 16);
+                field += 2;
+            }
+        }
+    }
+}
+
+/**
+ * @fn atl_lora_at_dr_line(const char *line, void *arg)
+ * @brief Data rate answer line callback (+DR: DR2 or +DR: AU915 DR2 SF10 BW125K).
+ * @param[in] line - Answer line
+ * @param[out] arg - Link parameters
+ */
+static void atl_lora_at_dr_line(const char *line, void *arg) {
+    atl_lora_link_t *link = (atl_lora_link_t *)arg;
+    for (const char *p = line + 1; (p = strstr(p, "DR")) != NULL; p += 2) {
+        if ((p[2] >= '0') && (p[2] <= '9')) {
+            link->dr = atoi(&p[2]);
+            return;
+        }
+    }
+}
+
+/**
+ * @fn atl_lora_at_len_line(const char *line, void *arg)
+ * @brief Max. payload answer line callback (+LW: LEN, 51).
+ * @param[in] line - Answer line
+ * @param[out] arg - Link parameters
+ */
+static void atl_lora_at_len_line(const char *line, void *arg) {
+    atl_lora_link_t *link = (atl_lora_link_t *)arg;
+    int len;
+    const char *field = strstr(line, "LEN,");
+    if ((field != NULL) && (sscanf(field, "LEN, %d", &len) == 1)) {
+        link->max_payload = len;
+    }
+}
+
+/**
+ * @fn atl_lora_at_power_line(const char *line, void *arg)
+ * @brief TX power answer line callback (+POWER: 14).
+ * @param[in] line - Answer line
+ * @param[out] arg - Link parameters
+ */
+static void atl_lora_at_power_line(const char *line, void *arg) {
+    atl_lora_link_t *link = (atl_lora_link_t *)arg;
+    int power;
+    if (sscanf(line, "+POWER: %d", &power) == 1) {
+        link->tx_power = power;
+    }
+}
+
+/**
+ * @fn atl_lora_at_init(void)
+ * @brief Initialize module UART and check module answer.
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_lora_at_init(void) {
+    esp_err_t err;
+    uart_config_t uart_config = {
+        .baud_rate = CONFIG_ATL_LORA_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    err = uart_driver_install(ATL_LORA_AT_UART, 512, 0, 0, NULL, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail installing UART driver!");
+        return err;
+    }
+    uart_param_config(ATL_LORA_AT_UART, &uart_config);
+    uart_set_pin(ATL_LORA_AT_UART, CONFIG_ATL_LORA_UART_TX, CONFIG_ATL_LORA_UART_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    return atl_lora_at_cmd("AT", "+AT: OK", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+}
+
+/**
+ * @fn atl_lora_at_join(const atl_lora_keys_t *keys)
+ * @brief Configure class A OTAA with ADR and join the network.
+ * @param[in] keys - Join credentials
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_lora_at_join(const atl_lora_keys_t *keys) {
+    char cmd[64];
+    bool joined = false;
+    snprintf(cmd, sizeof(cmd), "AT+DR=%s", atl_lora_at_region);
+    atl_lora_at_cmd(cmd, "+DR:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    atl_lora_at_cmd("AT+MODE=LWOTAA", "+MODE:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    atl_lora_at_cmd("AT+CLASS=A", "+CLASS:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    atl_lora_at_cmd("AT+ADR=ON", "+ADR:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    snprintf(cmd, sizeof(cmd), "AT+ID=DevEui,\"%s\"", keys->dev_eui);
+    atl_lora_at_cmd(cmd, "+ID:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    snprintf(cmd, sizeof(cmd), "AT+ID=AppEui,\"%s\"", keys->join_eui);
+    atl_lora_at_cmd(cmd, "+ID:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    snprintf(cmd, sizeof(cmd), "AT+KEY=APPKEY,\"%s\"", keys->app_key);
+    atl_lora_at_cmd(cmd, "+KEY:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL);
+    if (atl_lora_at_cmd("AT+JOIN", "+JOIN: Done", ATL_LORA_AT_JOIN_TIMEOUT, atl_lora_at_join_line, &joined) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return (joined == true) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @fn atl_lora_at_send(uint8_t port, const uint8_t *data, size_t len, atl_lora_downlink_t *downlink)
+ * @brief Send an unconfirmed uplink and wait receive windows.
+ * @param[in] port - LoRaWAN port
+ * @param[in] data - Payload
+ * @param[in] len - Payload length
+ * @param[out] downlink - Downlink received (port 0 if none)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_lora_at_send(uint8_t port, const uint8_t *data, size_t len, atl_lora_downlink_t *downlink) {
+    char cmd[16 + (2 * 242)];
+    snprintf(cmd, sizeof(cmd), "AT+PORT=%d", port);
+    if (atl_lora_at_cmd(cmd, "+PORT:", ATL_LORA_AT_CMD_TIMEOUT, NULL, NULL) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    size_t pos = snprintf(cmd, sizeof(cmd), "AT+MSGHEX=\"");
+    for (size_t i = 0; (i < len) && (pos < (sizeof(cmd) - 4)); i++) {
+        pos += snprintf(&cmd[pos], sizeof(cmd) - pos, "%02X", data[i]);
+    }
+    snprintf(&cmd[pos], sizeof(cmd) - pos, "\"");
+    return atl_lora_at_cmd(cmd, "+MSGHEX: Done", ATL_LORA_AT_SEND_TIMEOUT, atl_lora_at_send_line, downlink);
+}
+
+/**
+ * @fn atl_lora_at_get_link(atl_lora_link_t *link)
+ * @brief Get data rate, max. payload and TX power set by ADR.
+ * @param[out] link - Link parameters
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_lora_at_get_link(atl_lora_link_t *link) {
+    esp_err_t err = atl_lora_at_cmd("AT+DR", "+DR:", ATL_LORA_AT_CMD_TIMEOUT, atl_lora_at_dr_line, link);
+    if (err != ESP_OK) {
+        return err;
+    }
+    atl_lora_at_cmd("AT+LW=LEN", "+LW:", ATL_LORA_AT_CMD_TIMEOUT, atl_lora_at_len_line, link);
+    atl_lora_at_cmd("AT+POWER", "+POWER:", ATL_LORA_AT_CMD_TIMEOUT, atl_lora_at_power_line, link);
+    return ESP_OK;
+}
+
+/** AT command module radio (RHF76-052 / LoRa-E5 command set). */
+const atl_lora_radio_t atl_lora_radio_at = {
+    .name = "at",
+    .init = atl_lora_at_init,
+    .join = atl_lora_at_join,
+    .send = atl_lora_at_send,
+    .get_link = atl_lora_at_get_link,
+};
+
+#endif /* CONFIG_ATL_LORA_RADIO_AT */
@@ -0,0 +1,108 @@
+/**
+ * @file atl_lora_radio_sim.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Simulated LoRaWAN radio (no hardware).
+ * @details Uplinks are logged as hex and take the time of class A receive windows. ADR is simulated by stepping the
+ *  data rate up from DR0 after each few uplinks, so the scheduler schema and airtime choices can be checked without
+ *  a gateway.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include "sdkconfig.h"
+#include "atl_lora_radio.h"
+
+#ifdef CONFIG_ATL_LORA_RADIO_SIM
+
+#define ATL_LORA_SIM_RX_WINDOWS     2000    /* RX1 and RX2 windows (in ms) */
+#define ATL_LORA_SIM_ADR_UPLINKS    3       /* Uplinks between simulated ADR steps */
+#define ATL_LORA_SIM_MAX_DR         3       /* Max. data rate reached by simulated ADR (valid at all regions) */
+
+/* Constants */
+static const char *TAG = "atl-lora-sim";
+
+/* Global variables */
+static uint8_t atl_lora_sim_dr = 0;
+static uint32_t atl_lora_sim_uplinks = 0;
+
+/**
+ * @fn atl_lora_sim_init(void)
+ * @brief Initialize simulated radio.
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_lora_sim_init(void) {
+    atl_lora_sim_dr = 0;
+    atl_lora_sim_uplinks = 0;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_lora_sim_join(const atl_lora_keys_t *keys)
+ * @brief Simulate an OTAA join (always accepted after join windows).
+ * @param[in] keys - Join credentials
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_lora_sim_join(const atl_lora_keys_t *keys) {
+    ESP_LOGI(TAG, "Join request (DevEUI %s, JoinEUI %s)", keys->dev_eui, keys->join_eui);
+    vTaskDelay(pdMS_TO_TICKS(ATL_LORA_SIM_RX_WINDOWS * 3));
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_lora_sim_send(uint8_t port, const uint8_t *data, size_t len, atl_lora_downlink_t *downlink)
+ * @brief Log an uplink and wait receive windows (no downlink).
+ * @param[in] port - LoRaWAN port
+ * @param[in] data - Payload
+ * @param[in] len - Payload length
+ * @param[out] downlink - Downlink received (always port 0)
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_lora_sim_send(uint8_t port, const uint8_t *data, size_t len, atl_lora_downlink_t *downlink) {
+    ESP_LOGI(TAG, "Uplink port %d DR%d:", port, atl_lora_sim_dr);
+    ESP_LOG_BUFFER_HEX(TAG, data, len);
+    vTaskDelay(pdMS_TO_TICKS(ATL_LORA_SIM_RX_WINDOWS));
+    memset(downlink, 0, sizeof(atl_lora_downlink_t));
+    if ((++atl_lora_sim_uplinks % ATL_LORA_SIM_ADR_UPLINKS) == 0) {
+        if (atl_lora_sim_dr < ATL_LORA_SIM_MAX_DR) {
+            atl_lora_sim_dr++;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_lora_sim_get_link(atl_lora_link_t *link)
+ * @brief Get simulated link parameters.
+ * @param[out] link - Link parameters (max. payload from region table)
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_lora_sim_get_link(atl_lora_link_t *link) {
+    link->dr = atl_lora_sim_dr;
+    link->max_payload = 0;
+    link->tx_power = 14;
+    return ESP_OK;
+}
+
+/** Simulated radio (no hardware, frames are logged). */
+const atl_lora_radio_t atl_lora_radio_sim = {
+    .name = "sim",
+    .init = atl_lora_sim_init,
+    .join = atl_lora_sim_join,
+    .send = atl_lora_sim_send,
+    .get_link = atl_lora_sim_get_link,
+};
+
+#endif /* CONFIG_ATL_LORA_RADIO_SIM */
@@ -4,7 +4,7 @@
  * @brief Main function file.
  * @version 0.1.0
  * @date 2024-02-26 (created)
- * @date 2024-03-10 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -28,6 +28,18 @@
 #include "atl_dns.h"
 #include "atl_webserver.h"
 #include "atl_mqtt.h"
+#include "atl_resolver.h"
+#include "atl_diag.h"
+#include "atl_trace.h"
+#include "atl_stall.h"
+#include "atl_energy.h"
+#include "atl_pm.h"
+#include "atl_netmgr.h"
+#include "atl_cellular.h"
+#include "atl_lora.h"
+#include "atl_netprof.h"
+#include "atl_bench.h"
+#include "atl_console.h"
 
 /* Constants */
 static const char *TAG = "atl-main";
@@ -48,10 +60,37 @@ void app_main(void) {
 
     /* Storage initialization */
     atl_storage_init();
+
+    /* Diagnostics initialization (log ring and reset history) */
+    atl_diag_init();
+
+    /* Span and task tracing (if enabled at menuconfig) */
+    atl_trace_init();
+
+    /* Stall detector (latency budgets of tasks and handlers) */
+    atl_stall_init();
+
+    /* Energy accounting per subsystem (if enabled at menuconfig) */
+    atl_energy_init();
+
+    /* Dynamic frequency scaling and automatic light sleep (if enabled at menuconfig) */
+    atl_pm_init();
     
     /* Cofiguration initialization (load configuration from NVS or create new default config) */
     atl_config_init();
 
+    /* Network tuning profile (bulk transfer accounting) */
+    atl_netprof_init();
+
+    /* Interactive console (available even if network never comes up) */
+    atl_bench_init();
+    atl_console_init();
+
+    /* Initialize LoRaWAN uplink (independent of WiFi mode) */
+    if (atl_config.lora.enabled == true) {
+        atl_lora_init();
+    }
+
     /* Check the WiFi startup mode defined by configuration file */
     if (atl_config.wifi.mode != ATL_WIFI_DISABLED) {
         
@@ -61,14 +100,28 @@ void app_main(void) {
             /* Initialize WiFi in AP mode */
             atl_wifi_init_softap();
 
+            /* Initialize TCP console (if enabled at menuconfig) */
+            atl_console_tcp_start();
+
             /* Initialize name server (DNS) */
             // atl_dns_server_init();
 
         } else if (atl_config.wifi.mode == ATL_WIFI_STA_MODE) {
             
+            /* Initialize network manager (uplinks are registered by their drivers) */
+            atl_netmgr_init();
+
+            /* Initialize cellular modem (before WiFi, which waits for connection) */
+            if (atl_config.cellular.enabled == true) {
+                atl_cellular_init();
+            }
+
             /* Initialize WiFi in STA mode */
             atl_wifi_init_sta();
 
+            /* Initialize name resolver cache (used by MQTT client) */
+            atl_resolver_init();
+
             /* Initialize MQTT client */
             atl_mqtt_init();
         }
@@ -79,4 +132,7 @@ void app_main(void) {
 
     /* Update serial interface output */
     ESP_LOGI(TAG, "Initialization finished!");
+
+    /* Benchmark suite (benchmark build only) */
+    atl_bench_boot_start();
 }
@@ -4,7 +4,7 @@
  * @brief MQTT function.
  * @version 0.1.0
  * @date 2024-03-13 (created)
- * @date 2024-03-14 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -15,15 +15,33 @@
  * and limitations under the License.
  */
 #include <math.h>
+#include <errno.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <esp_log.h>
 #include <esp_err.h>
 #include <esp_mac.h>
 #include <esp_ota_ops.h>
+#include <esp_timer.h>
 #include <esp_image_format.h>
 #include <mqtt_client.h>
+#include <esp_tls_errors.h>
 #include <cJSON.h>
 #include "atl_config.h"
 #include "atl_mqtt.h"
+#include "atl_mqtt_request.h"
+#include "atl_json.h"
+#include "atl_mqtt_keepalive.h"
+#include "atl_resolver.h"
+#include "atl_netmgr.h"
+#include "atl_netprof.h"
+#include "atl_trace.h"
+#include "atl_stall.h"
+#include "atl_age.h"
+#include "atl_energy.h"
+#include "atl_pm.h"
+#include "atl_wifi.h"
 
 /* Constants */
 static const char *TAG = "atl-mqtt";
@@ -57,6 +75,24 @@ static esp_mqtt5_user_property_item_t atl_user_property_arr[] = {
 
 #define USE_PROPERTY_ARR_SIZE (sizeof(atl_user_property_arr) / sizeof(esp_mqtt5_user_property_item_t))
 
+/* Largest packet accepted from broker (firmware chunk or JSON message plus topic/properties overhead) */
+#define ATL_MQTT_MAX_PACKET_SIZE (MAX(CONFIG_ATL_OTA_CHUNK_SIZE, CONFIG_ATL_MQTT_RX_BUFFER_SIZE) + 512)
+
+/* Firmware chunk request retries (timeout) before abort the download */
+#define ATL_MQTT_OTA_MAX_RETRIES 3
+
+/* Firmware write alignment (encrypted flash is written in 16-byte blocks) */
+#define ATL_MQTT_OTA_WRITE_ALIGN 16
+
+/* Max. group configuration topic length */
+#define ATL_MQTT_GROUP_TOPIC_LEN 96
+
+/* MQTT_USER_EVENT kinds (custom event msg_id, outstanding request expiration dispatches 0) */
+#define ATL_MQTT_USER_EVENT_TELEMETRY   1
+#define ATL_MQTT_USER_EVENT_HEALTH      2
+#define ATL_MQTT_USER_EVENT_ENERGY      3
+#define ATL_MQTT_USER_EVENT_KEEPALIVE   4
+
 static esp_mqtt5_publish_property_config_t publish_property = {
     .payload_format_indicator = 1,
     .message_expiry_interval = 1000,
@@ -75,6 +111,103 @@ static esp_mqtt5_subscribe_property_config_t subscribe_property = {
     //.share_name = "group1",
 };
 
+/**
+ * @typedef atl_mqtt_rx_topic_e
+ * @brief Inbound MQTT message class (by topic).
+ */
+typedef enum {
+    ATL_MQTT_RX_NONE,
+    ATL_MQTT_RX_ATTRIBUTES,
+    ATL_MQTT_RX_ATTRIBUTES_RESPONSE,
+    ATL_MQTT_RX_FW_CHUNK,
+    ATL_MQTT_RX_GROUP_CONFIG,
+    ATL_MQTT_RX_UNKNOWN,
+} atl_mqtt_rx_topic_e;
+
+/**
+ * @typedef atl_mqtt_rx_t
+ * @brief Inbound MQTT message (reassembled from MQTT_EVENT_DATA fragments).
+ */
+typedef struct {
+    atl_mqtt_rx_topic_e topic;                                      /**< Message class.*/
+    int                 request_id;                                 /**< Outstanding request answered (responses only).*/
+    int                 msg_id;                                     /**< Message packet id (only sent at first fragment).*/
+    bool                dup;                                        /**< Message redelivery flag (only sent at first fragment).*/
+    int                 total_len;                                  /**< Message total length.*/
+    int                 received;                                   /**< Bytes received so far.*/
+    bool                discard;                                    /**< Discard remaining fragments.*/
+    char                buffer[CONFIG_ATL_MQTT_RX_BUFFER_SIZE + 1]; /**< JSON reassembly buffer.*/
+} atl_mqtt_rx_t;
+
+/**
+ * @typedef atl_mqtt_ota_t
+ * @brief Firmware download (OTA over MQTT) state.
+ */
+typedef struct {
+    bool                    active;             /**< Firmware download in progress.*/
+    uint32_t                fw_size;            /**< Firmware size.*/
+    uint32_t                chunk_size;         /**< Firmware chunk size.*/
+    uint32_t                chunk_count;        /**< Total of firmware chunks.*/
+    uint32_t                chunk_next;         /**< Next firmware chunk to be requested.*/
+    uint32_t                chunk_done;         /**< Firmware chunks written.*/
+    uint8_t                 chunk_inflight;     /**< Firmware chunks requested and not answered yet.*/
+    uint8_t                 pipeline_depth;     /**< Max. firmware chunks in flight (from TCP window and free heap).*/
+    int64_t                 start_time;         /**< Download start time (in us).*/
+    uint8_t                 retries;            /**< Consecutive chunk request timeouts.*/
+    uint8_t                 *chunk_written;     /**< Bitmap of firmware chunks written (duplicate suppression).*/
+    uint8_t                 carry[ATL_MQTT_OTA_WRITE_ALIGN];    /**< Fragment tail waiting for an aligned write.*/
+    uint8_t                 carry_len;          /**< Bytes at carry buffer.*/
+    const esp_partition_t   *update_partition;  /**< Partition receiving new firmware.*/
+    esp_ota_handle_t        update_handle;      /**< OTA handle.*/
+} atl_mqtt_ota_t;
+
+/**
+ * @typedef atl_mqtt_rx_seen_t
+ * @brief Inbound QoS1/2 message already processed (duplicate suppression).
+ */
+typedef struct {
+    int         msg_id;     /**< Message packet id.*/
+    uint32_t    hash;       /**< Message content hash.*/
+} atl_mqtt_rx_seen_t;
+
+#define ATL_MQTT_RX_SEEN_SIZE 8     /**< Processed messages remembered for duplicate suppression.*/
+
+/**
+ * @typedef atl_mqtt_batch_t
+ * @brief Sample batch waiting to be published by MQTT task.
+ */
+typedef struct {
+    char        *payload;       /**< Telemetry JSON (freed after publish).*/
+    int64_t     acquired_us;    /**< Acquisition time of oldest sample at batch.*/
+} atl_mqtt_batch_t;
+
+static int msg_id = 0;
+static atl_mqtt_rx_seen_t atl_mqtt_rx_seen[ATL_MQTT_RX_SEEN_SIZE];
+static uint8_t atl_mqtt_rx_seen_next = 0;
+static atl_mqtt_rx_t atl_mqtt_rx;
+static atl_mqtt_ota_t atl_mqtt_ota;
+static atl_mqtt_client_t mqtt_client_config;    /* Local copy of MQTT client configuration (referenced by mqtt5_cfg) */
+static esp_mqtt_client_config_t mqtt5_cfg;      /* MQTT client configuration (re-applied before each connection) */
+static char atl_mqtt_broker_ip[ATL_RESOLVER_IP_STR_LEN];   /* Broker address resolved from cache */
+static char atl_mqtt_group_topic[ATL_MQTT_GROUP_TOPIC_LEN]; /* Group configuration topic (empty if not member of a group) */
+static atl_mqtt_status_t atl_mqtt_status;      /* Session counters (updated by MQTT task only) */
+static int atl_mqtt_stall_event = -1;           /* Event handler latency budget */
+static int atl_mqtt_stall_ota = -1;             /* Firmware fragment write latency budget */
+static QueueHandle_t atl_mqtt_batch_queue = NULL;  /* Sample batches handed to MQTT task */
+static bool atl_mqtt_tls_locked = false;        /* TLS handshake PM lock held */
+static esp_timer_handle_t atl_mqtt_keepalive_timer = NULL; /* Keepalive confirm period (one-shot, armed while connected) */
+static int atl_mqtt_transport_errno = -1;       /* Transport errno of the current connection (-1 if no transport error) */
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+static uint32_t atl_mqtt_window_deferred = 0;   /* User event kinds deferred until next publish window (bit mask) */
+#endif
+#ifdef CONFIG_ATL_AGE
+static esp_timer_handle_t atl_mqtt_health_timer = NULL;    /* Sample age report period */
+#endif
+#ifdef CONFIG_ATL_ENERGY
+static esp_timer_handle_t atl_mqtt_energy_timer = NULL;    /* Energy report period */
+#endif
+
+
 /**
  * @brief Get the MQTT mode enum
  * @param mode_str 
@@ -109,6 +242,1121 @@ esp_mqtt_transport_t atl_mqtt_get_transport(char* transport_str) {
     return 255;
 }
 
+/**
+ * @fn atl_mqtt_publish_fw_state(esp_mqtt_client_handle_t client, const char *fw_state)
+ * @brief Publish firmware update state to ThingsBoard.
+ * @param[in] client - MQTT client handle
+ * @param[in] fw_state - Firmware state (DOWNLOADING, DOWNLOADED, VERIFIED, UPDATING, UPDATED or FAILED)
+ */
+static void atl_mqtt_publish_fw_state(esp_mqtt_client_handle_t client, const char *fw_state) {
+    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
+    esp_mqtt5_client_set_publish_property(client, &publish_property);
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "fw_state", fw_state);
+    char *payload = cJSON_PrintUnformatted(response);
+    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", payload, 0, 1, 0);
+    atl_energy_tx(ATL_ENERGY_MQTT, strlen(payload));
+    esp_mqtt5_client_delete_user_property(publish_property.user_property);
+    publish_property.user_property = NULL;
+    ESP_LOGI(TAG, "Sent firmware state [%s] to [v1/devices/me/telemetry], msg_id=%d", fw_state, msg_id);
+    cJSON_Delete(response);
+    free(payload);
+}
+
+/**
+ * @fn atl_mqtt_publish_batches(esp_mqtt_client_handle_t client)
+ * @brief Publish sample batches queued by atl_mqtt_publish_telemetry() (QoS 1, tracked until broker acknowledgement).
+ * @details Runs at MQTT task, so the msg_id is tracked before its MQTT_EVENT_PUBLISHED can be processed. Batches
+ *  published while disconnected are kept at outbox and only their acknowledgement age is recorded.
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_publish_batches(esp_mqtt_client_handle_t client) {
+    atl_mqtt_batch_t batch;
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+    /* Outbox would expire them before next window, keep batches queued until connected */
+    if (atl_mqtt_status.connected == false) {
+        return;
+    }
+#endif
+    while (xQueueReceive(atl_mqtt_batch_queue, &batch, 0) == pdTRUE) {
+        int batch_msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", batch.payload, 0, 1, 0);
+        if (batch_msg_id < 0) {
+            ESP_LOGW(TAG, "Fail to publish sample batch (outbox full)!");
+        } else {
+            if (atl_mqtt_status.connected == true) {
+                atl_age_record(ATL_AGE_PUBLISHED, batch.acquired_us);
+            }
+            atl_age_track(batch_msg_id, batch.acquired_us);
+            atl_energy_tx(ATL_ENERGY_SAMPLING, strlen(batch.payload));
+            atl_mqtt_status.batches++;
+            ESP_LOGD(TAG, "Sent sample batch to [v1/devices/me/telemetry], msg_id=%d", batch_msg_id);
+        }
+        free(batch.payload);
+    }
+}
+
+/**
+ * @fn atl_mqtt_publish_report(esp_mqtt_client_handle_t client, esp_err_t (*report)(cJSON *telemetry), const char *name)
+ * @brief Publish a periodic report as telemetry (the report starts a new window).
+ * @details Report is skipped while disconnected, so the next one covers the whole window.
+ * @param[in] client - MQTT client handle
+ * @param[in] report - Report function (atl_age_report() or atl_energy_report())
+ * @param[in] name - Report name (log only)
+ */
+static void atl_mqtt_publish_report(esp_mqtt_client_handle_t client, esp_err_t (*report)(cJSON *telemetry), const char *name) {
+    if (atl_mqtt_status.connected == false) {
+        return;
+    }
+    cJSON *telemetry = cJSON_CreateObject();
+    if (report(telemetry) == ESP_OK) {
+        char *payload = cJSON_PrintUnformatted(telemetry);
+        if (payload != NULL) {
+            msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", payload, 0, 1, 0);
+            atl_energy_tx(ATL_ENERGY_MQTT, strlen(payload));
+            ESP_LOGI(TAG, "Sent %s report to [v1/devices/me/telemetry], msg_id=%d", name, msg_id);
+            free(payload);
+        }
+    }
+    cJSON_Delete(telemetry);
+}
+
+/**
+ * @fn atl_mqtt_dispatch_user_event(int kind)
+ * @brief Signal MQTT task (MQTT_USER_EVENT).
+ * @param[in] kind - User event kind (ATL_MQTT_USER_EVENT_TELEMETRY, ATL_MQTT_USER_EVENT_HEALTH, ATL_MQTT_USER_EVENT_ENERGY
+ *  or ATL_MQTT_USER_EVENT_KEEPALIVE)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_mqtt_dispatch_user_event(int kind) {
+    esp_mqtt_event_t event = {
+        .event_id = MQTT_USER_EVENT,
+        .client = client,
+        .msg_id = kind,
+    };
+    return esp_mqtt_dispatch_custom_event(client, &event);
+}
+
+/**
+ * @fn atl_mqtt_tls_lock(bool lock)
+ * @brief Hold maximum CPU frequency during TLS handshake (from MQTT_EVENT_BEFORE_CONNECT to connection result).
+ * @param[in] lock - Acquire (only if transport is SSL or WSS) or release PM lock
+ */
+static void atl_mqtt_tls_lock(bool lock) {
+    if (lock == atl_mqtt_tls_locked) {
+        return;
+    }
+    if (lock == false) {
+        atl_pm_release(ATL_PM_LOCK_TLS);
+        atl_mqtt_tls_locked = false;
+    } else if ((mqtt5_cfg.broker.address.transport == MQTT_TRANSPORT_OVER_SSL) ||
+               (mqtt5_cfg.broker.address.transport == MQTT_TRANSPORT_OVER_WSS)) {
+        atl_pm_acquire(ATL_PM_LOCK_TLS);
+        atl_mqtt_tls_locked = true;
+    }
+}
+
+/**
+ * @fn atl_mqtt_keepalive_timer_cb(void *arg)
+ * @brief Keepalive confirm period elapsed (keepalive is confirmed by MQTT task).
+ * @param[in] arg - Not used
+ */
+static void atl_mqtt_keepalive_timer_cb(void *arg) {
+    atl_mqtt_dispatch_user_event(ATL_MQTT_USER_EVENT_KEEPALIVE);
+}
+
+/**
+ * @fn atl_mqtt_keepalive_arm(bool connected)
+ * @brief Arm keepalive confirm timer at connection or stop it at disconnection.
+ * @param[in] connected - Connection established (arm) or lost/closed (stop)
+ */
+static void atl_mqtt_keepalive_arm(bool connected) {
+    if (atl_mqtt_keepalive_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = atl_mqtt_keepalive_timer_cb,
+            .name = "atl_mqtt_keepalive",
+        };
+        if (esp_timer_create(&timer_args, &atl_mqtt_keepalive_timer) != ESP_OK) {
+            ESP_LOGW(TAG, "Fail to create keepalive timer!");
+            return;
+        }
+    }
+    esp_timer_stop(atl_mqtt_keepalive_timer);
+    if (connected == true) {
+        esp_timer_start_once(atl_mqtt_keepalive_timer, atl_mqtt_keepalive_get_confirm_period() * 1000000ULL);
+    }
+}
+
+/**
+ * @fn atl_mqtt_keepalive_idle_drop(void)
+ * @brief Check if a disconnection has an idle cause (NAT/idle timeout).
+ * @details Idle timeouts show up as a PINGRESP timeout (no transport error) or a connection reset/timeout while the
+ *  uplink is still up. Uplink loss and connections closed by the broker (FIN) are not idle drops.
+ * @return bool - True if idle drop.
+ */
+static bool atl_mqtt_keepalive_idle_drop(void) {
+    if (atl_netmgr_is_up() == false) {
+        return false;
+    }
+    return (atl_mqtt_transport_errno < 0) || (atl_mqtt_transport_errno == ECONNRESET) ||
+           (atl_mqtt_transport_errno == ETIMEDOUT) || (atl_mqtt_transport_errno == ECONNABORTED) ||
+           (atl_mqtt_transport_errno == EPIPE);
+}
+
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+/**
+ * @fn atl_mqtt_window_cb(bool open)
+ * @brief WiFi publish window callback (called from WiFi window task, so client may be stopped).
+ * @param[in] open - Window connected (start client) or closing (stop client)
+ */
+static void atl_mqtt_window_cb(bool open) {
+    if (open == true) {
+        esp_mqtt_client_start(client);
+        return;
+    }
+
+    /* Closed on purpose, connection lifetime says nothing about network idle timeout */
+    atl_mqtt_keepalive_closed();
+    atl_mqtt_keepalive_arm(false);
+    esp_mqtt_client_stop(client);
+    atl_mqtt_tls_lock(false);
+    atl_mqtt_status.connected = false;
+    atl_netmgr_set_session(false);
+}
+
+/**
+ * @fn atl_mqtt_window_defer(int kind)
+ * @brief Defer a report to next publish window if broker is not connected.
+ * @param[in] kind - User event kind of the report
+ * @return bool - True if deferred.
+ */
+static bool atl_mqtt_window_defer(int kind) {
+    if (atl_mqtt_status.connected == true) {
+        return false;
+    }
+    atl_mqtt_window_deferred |= (1UL << kind);
+    return true;
+}
+
+/**
+ * @fn atl_mqtt_window_resume(esp_mqtt_client_handle_t client)
+ * @brief Publish sample batches and deferred reports at publish window connection.
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_window_resume(esp_mqtt_client_handle_t client) {
+    atl_mqtt_publish_batches(client);
+    for (int kind = ATL_MQTT_USER_EVENT_TELEMETRY; kind <= ATL_MQTT_USER_EVENT_ENERGY; kind++) {
+        if ((atl_mqtt_window_deferred & (1UL << kind)) != 0) {
+            atl_mqtt_dispatch_user_event(kind);
+        }
+    }
+    atl_mqtt_window_deferred = 0;
+}
+
+/**
+ * @fn atl_mqtt_window_update(esp_mqtt_client_handle_t client)
+ * @brief Signal WiFi publish window if there is traffic pending (queued batches, outbox or deferred reports).
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_window_update(esp_mqtt_client_handle_t client) {
+    bool busy = (atl_mqtt_status.connected == false) || (atl_mqtt_window_deferred != 0) || (atl_mqtt_ota.active == true) ||
+                (uxQueueMessagesWaiting(atl_mqtt_batch_queue) > 0) || (esp_mqtt_client_get_outbox_size(client) > 0);
+    atl_wifi_window_set_busy(busy);
+}
+#endif
+
+#if defined(CONFIG_ATL_AGE) || defined(CONFIG_ATL_ENERGY)
+/**
+ * @fn atl_mqtt_report_timer_cb(void *arg)
+ * @brief Report period elapsed (report is published by MQTT task).
+ * @param[in] arg - User event kind of the report
+ */
+static void atl_mqtt_report_timer_cb(void *arg) {
+    atl_mqtt_dispatch_user_event((int)(intptr_t)arg);
+}
+
+/**
+ * @fn atl_mqtt_report_timer_start(esp_timer_handle_t *timer, int kind, uint32_t interval_s)
+ * @brief Start a periodic report timer (if not started yet).
+ * @param[in,out] timer - Timer handle
+ * @param[in] kind - User event kind of the report
+ * @param[in] interval_s - Report interval (in seconds)
+ */
+static void atl_mqtt_report_timer_start(esp_timer_handle_t *timer, int kind, uint32_t interval_s) {
+    if (*timer != NULL) {
+        return;
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = atl_mqtt_report_timer_cb,
+        .arg = (void*)(intptr_t)kind,
+        .name = "atl_mqtt_report",
+    };
+    if ((esp_timer_create(&timer_args, timer) != ESP_OK) ||
+        (esp_timer_start_periodic(*timer, interval_s * 1000000ULL) != ESP_OK)) {
+        ESP_LOGW(TAG, "Fail to start report timer (kind %d)!", kind);
+    }
+}
+#endif
+
+/* Forward declarations */
+static void atl_mqtt_ota_abort(esp_mqtt_client_handle_t client, bool notify);
+static void atl_mqtt_ota_chunk_cb(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg);
+
+/**
+ * @fn atl_mqtt_ota_request_chunk(esp_mqtt_client_handle_t client, uint32_t chunk)
+ * @brief Request a firmware chunk from ThingsBoard.
+ * @param[in] client - MQTT client handle
+ * @param[in] chunk - Firmware chunk index
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_mqtt_ota_request_chunk(esp_mqtt_client_handle_t client, uint32_t chunk) {
+    char fw_topic_suffix[20] = {};
+    char fw_chunk_size[12] = {};
+    sprintf(fw_topic_suffix, "/chunk/%lu", chunk);
+    sprintf(fw_chunk_size, "%lu", atl_mqtt_ota.chunk_size);
+    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
+    int chunk_request_id = atl_mqtt_request_send(client, &publish_property, "v2/fw/request", "v2/fw/response", fw_topic_suffix,
+        fw_chunk_size, 0, 1, 0, atl_mqtt_ota_chunk_cb, (void*)(uintptr_t)chunk);
+    esp_mqtt5_client_delete_user_property(publish_property.user_property);
+    publish_property.user_property = NULL;
+    if (chunk_request_id < 0) {
+        return ESP_FAIL;
+    }
+    atl_mqtt_ota.chunk_inflight++;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_mqtt_ota_fill_pipeline(esp_mqtt_client_handle_t client)
+ * @brief Keep up to pipeline depth firmware chunk requests in flight.
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_ota_fill_pipeline(esp_mqtt_client_handle_t client) {
+    while ((atl_mqtt_ota.chunk_inflight < atl_mqtt_ota.pipeline_depth) && (atl_mqtt_ota.chunk_next < atl_mqtt_ota.chunk_count)) {
+        if (atl_mqtt_ota_request_chunk(client, atl_mqtt_ota.chunk_next) != ESP_OK) {
+            if (atl_mqtt_ota.chunk_inflight == 0) {
+                atl_mqtt_ota_abort(client, true);
+            }
+            break;
+        }
+        atl_mqtt_ota.chunk_next++;
+    }
+}
+
+/**
+ * @fn atl_mqtt_ota_abort(esp_mqtt_client_handle_t client, bool notify)
+ * @brief Abort the firmware download in progress.
+ * @param[in] client - MQTT client handle
+ * @param[in] notify - Notify ThingsBoard (FAILED state)
+ */
+static void atl_mqtt_ota_abort(esp_mqtt_client_handle_t client, bool notify) {
+    if (atl_mqtt_ota.active == false) {
+        return;
+    }
+    atl_mqtt_ota.active = false;
+    atl_wifi_window_hold(false);
+    atl_pm_release(ATL_PM_LOCK_OTA);
+    esp_ota_abort(atl_mqtt_ota.update_handle);
+    free(atl_mqtt_ota.chunk_written);
+    atl_mqtt_ota.chunk_written = NULL;
+    atl_netprof_bulk_end(atl_mqtt_ota.chunk_done * atl_mqtt_ota.chunk_size, (esp_timer_get_time() - atl_mqtt_ota.start_time) / 1000);
+    ESP_LOGE(TAG, "Firmware download aborted (%lu/%lu chunks written)!", atl_mqtt_ota.chunk_done, atl_mqtt_ota.chunk_count);
+    if (notify == true) {
+        atl_mqtt_publish_fw_state(client, "FAILED");
+    }
+}
+
+/**
+ * @fn atl_mqtt_ota_begin(esp_mqtt_client_handle_t client)
+ * @brief Prepare the next OTA partition to receive a new firmware.
+ * @param[in] client - MQTT client handle
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_mqtt_ota_begin(esp_mqtt_client_handle_t client) {
+    esp_err_t err;
+
+    /* Check if boot configured partition is the same of running partition */
+    const esp_partition_t *boot_partition = esp_ota_get_boot_partition();
+    const esp_partition_t *running_partition = esp_ota_get_running_partition();
+    if ((boot_partition != NULL) && (running_partition != NULL)) {
+        if (boot_partition != running_partition) {
+            ESP_LOGW(TAG, "Configured OTA boot partition at offset 0x%08lx, but running from offset 0x%08lx",
+                boot_partition->address, running_partition->address);
+            ESP_LOGW(TAG, "This can happen if either the OTA boot data or preferred boot image become corrupted somehow!");
+        }
+    } else {
+        ESP_LOGE(TAG, "Fail getting boot/running partition!");
+    }
+
+    /* Get pointer to next partition to write new firmware */
+    atl_mqtt_ota.update_partition = esp_ota_get_next_update_partition(NULL);
+    if (atl_mqtt_ota.update_partition == NULL) {
+        ESP_LOGE(TAG, "Fail getting update partition!");
+        atl_mqtt_publish_fw_state(client, "FAILED");
+        return ESP_FAIL;
+    }
+
+    /* Erase whole new partition, so chunks may be written out of order (maximum CPU frequency until download ends) */
+    atl_pm_acquire(ATL_PM_LOCK_OTA);
+    atl_energy_begin(ATL_ENERGY_OTA);
+    err = esp_ota_begin(atl_mqtt_ota.update_partition, OTA_SIZE_UNKNOWN, &atl_mqtt_ota.update_handle);
+    atl_energy_end(ATL_ENERGY_OTA);
+    atl_energy_flash(ATL_ENERGY_OTA, atl_mqtt_ota.update_partition->size / atl_mqtt_ota.update_partition->erase_size, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "OTA begin failed! Error: (%d) %s", err, esp_err_to_name(err));
+        atl_pm_release(ATL_PM_LOCK_OTA);
+        esp_ota_abort(atl_mqtt_ota.update_handle);
+        atl_mqtt_publish_fw_state(client, "FAILED");
+        return err;
+    }
+
+    /* Track written chunks, so redelivered chunks are not written again */
+    atl_mqtt_ota.chunk_written = calloc((atl_mqtt_ota.chunk_count + 7) / 8, sizeof(uint8_t));
+    if (atl_mqtt_ota.chunk_written == NULL) {
+        ESP_LOGE(TAG, "Fail allocating chunk bitmap!");
+        atl_pm_release(ATL_PM_LOCK_OTA);
+        esp_ota_abort(atl_mqtt_ota.update_handle);
+        atl_mqtt_publish_fw_state(client, "FAILED");
+        return ESP_ERR_NO_MEM;
+    }
+    atl_mqtt_ota.active = true;
+    atl_wifi_window_hold(true);
+    atl_mqtt_ota.start_time = esp_timer_get_time();
+    atl_netprof_bulk_begin();
+    ESP_LOGI(TAG, "OTA begin succeeded!");
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_mqtt_ota_finish(esp_mqtt_client_handle_t client)
+ * @brief Finalize the firmware download, verify the new image and update the boot partition.
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_ota_finish(esp_mqtt_client_handle_t client) {
+    esp_err_t err;
+    atl_mqtt_ota.active = false;
+    atl_wifi_window_hold(false);
+    free(atl_mqtt_ota.chunk_written);
+    atl_mqtt_ota.chunk_written = NULL;
+    atl_netprof_bulk_end(atl_mqtt_ota.fw_size, (esp_timer_get_time() - atl_mqtt_ota.start_time) / 1000);
+
+    /* Set device to DOWNLOADED state */
+    atl_mqtt_publish_fw_state(client, "DOWNLOADED");
+
+    /* Finalize partition write and verify checksum of new firmware */
+    err = esp_ota_end(atl_mqtt_ota.update_handle);
+    atl_pm_release(ATL_PM_LOCK_OTA);
+    if (err != ESP_OK) {
+        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
+            ESP_LOGE(TAG, "Image validation failed, image is corrupted!");
+        } else {
+            ESP_LOGE(TAG, "OTA end failed! Error: (%d) %s", err, esp_err_to_name(err));
+        }
+        atl_mqtt_publish_fw_state(client, "FAILED");
+        return;
+    }
+
+    /* Get new partition and verify checksum of firmware writed at new partition */
+    esp_app_desc_t new_app_info;
+    err = esp_ota_get_partition_description(atl_mqtt_ota.update_partition, &new_app_info);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail getting update app info! Error: (%d) %s", err, esp_err_to_name(err));
+        return;
+    }
+    uint8_t sha_256[32] = { 0 };  /* 32 bytes for SHA-256 digest length */
+    err = esp_partition_get_sha256(atl_mqtt_ota.update_partition, sha_256);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail getting update SHA-256! Error: (%d) %s", err, esp_err_to_name(err));
+        return;
+    }
+    char hash_print[32 * 2 + 1];
+    memset(&hash_print, 0, sizeof(hash_print));
+    for (uint8_t i = 0; i < 32; ++i) {
+        sprintf(&hash_print[i * 2], "%02x", sha_256[i]);
+    }
+    ESP_LOGI(TAG, "New firmware (%s at 0x%08lx - SHA256: %s)", atl_mqtt_ota.update_partition->label, atl_mqtt_ota.update_partition->address, hash_print);
+
+    /* If SHA256 checked, notify ThingsBoard that firmware was VERIFIED */
+    atl_mqtt_publish_fw_state(client, "VERIFIED");
+
+    /* Notify ThingsBoard that GreenField will apply new firmware */
+    atl_mqtt_publish_fw_state(client, "UPDATING");
+
+    /* Update boot partition in bootloader */
+    err = esp_ota_set_boot_partition(atl_mqtt_ota.update_partition);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "OTA set boot partition failed! Error: (%d) %s", err, esp_err_to_name(err));
+        atl_mqtt_publish_fw_state(client, "FAILED");
+    } else {
+        /* Restart GreenField */
+        ESP_LOGW(TAG, "Rebooting GreenField!");
+        esp_restart();
+    }
+}
+
+/**
+ * @fn atl_mqtt_ota_write(const uint8_t *data, int data_len, uint32_t position, bool last_fragment)
+ * @brief Write a chunk fragment on next partition in ATL_MQTT_OTA_WRITE_ALIGN blocks.
+ * @details The aligned part of the fragment is written straight from the MQTT buffer. The unaligned tail is kept at
+ *  carry buffer and completed by next fragment. At last fragment of a chunk the tail is padded with 0xFF (only the
+ *  last chunk of the image may have a tail, chunk size is aligned).
+ * @param[in] data - Fragment data
+ * @param[in] data_len - Fragment length
+ * @param[in] position - Fragment position at firmware image
+ * @param[in] last_fragment - Last fragment of the chunk
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_mqtt_ota_write(const uint8_t *data, int data_len, uint32_t position, bool last_fragment) {
+    esp_err_t err = ESP_OK;
+
+    /* Complete the tail of previous fragment */
+    if (atl_mqtt_ota.carry_len > 0) {
+        int len = MIN(ATL_MQTT_OTA_WRITE_ALIGN - atl_mqtt_ota.carry_len, data_len);
+        memcpy(&atl_mqtt_ota.carry[atl_mqtt_ota.carry_len], data, len);
+        atl_mqtt_ota.carry_len += len;
+        position += len;
+        data += len;
+        data_len -= len;
+        if (atl_mqtt_ota.carry_len == ATL_MQTT_OTA_WRITE_ALIGN) {
+            err = esp_ota_write_with_offset(atl_mqtt_ota.update_handle, atl_mqtt_ota.carry, ATL_MQTT_OTA_WRITE_ALIGN, position - ATL_MQTT_OTA_WRITE_ALIGN);
+            atl_mqtt_ota.carry_len = 0;
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+
+    /* Write the aligned part without copy */
+    int aligned_len = data_len & ~(ATL_MQTT_OTA_WRITE_ALIGN - 1);
+    if (aligned_len > 0) {
+        err = esp_ota_write_with_offset(atl_mqtt_ota.update_handle, data, aligned_len, position);
+        if (err != ESP_OK) {
+            return err;
+        }
+        position += aligned_len;
+        data += aligned_len;
+        data_len -= aligned_len;
+    }
+
+    /* Keep the tail for next fragment */
+    if (data_len > 0) {
+        memcpy(&atl_mqtt_ota.carry[atl_mqtt_ota.carry_len], data, data_len);
+        atl_mqtt_ota.carry_len += data_len;
+    }
+
+    /* Pad and write the tail of the last chunk */
+    if ((last_fragment == true) && (atl_mqtt_ota.carry_len > 0)) {
+        uint8_t len = atl_mqtt_ota.carry_len;
+        memset(&atl_mqtt_ota.carry[len], 0xFF, ATL_MQTT_OTA_WRITE_ALIGN - len);
+        err = esp_ota_write_with_offset(atl_mqtt_ota.update_handle, atl_mqtt_ota.carry, ATL_MQTT_OTA_WRITE_ALIGN, position + data_len - len);
+        atl_mqtt_ota.carry_len = 0;
+    }
+    return err;
+}
+
+/**
+ * @fn atl_mqtt_ota_chunk_cb(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg)
+ * @brief Firmware chunk request callback.
+ * @details Each fragment is written from the MQTT buffer to its position at the OTA partition (see atl_mqtt_ota_write()),
+ *  so pipelined chunks may be answered in any order. A timed out chunk is requested again (up to ATL_MQTT_OTA_MAX_RETRIES).
+ * @param[in] client - MQTT client handle
+ * @param[in] status - Request status
+ * @param[in] data - Fragment data
+ * @param[in] data_len - Fragment length
+ * @param[in] offset - Fragment offset at chunk
+ * @param[in] total_len - Chunk length
+ * @param[in] arg - Firmware chunk index
+ */
+static void atl_mqtt_ota_chunk_cb(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg) {
+    uint32_t chunk = (uint32_t)(uintptr_t)arg;
+    bool last_fragment = ((offset + data_len) >= total_len);
+    esp_err_t err;
+
+    /* Request finished (answered, timed out or cancelled) */
+    if ((status != ATL_MQTT_REQUEST_RESPONSE) || (last_fragment == true)) {
+        if (atl_mqtt_ota.chunk_inflight > 0) {
+            atl_mqtt_ota.chunk_inflight--;
+        }
+    }
+
+    /* Drop answers of an aborted download */
+    if (atl_mqtt_ota.active == false) {
+        return;
+    }
+
+    /* Chunk request timed out, request it again */
+    if (status == ATL_MQTT_REQUEST_TIMEOUT) {
+        if (++atl_mqtt_ota.retries > ATL_MQTT_OTA_MAX_RETRIES) {
+            atl_mqtt_ota_abort(client, true);
+        } else if (atl_mqtt_ota_request_chunk(client, chunk) != ESP_OK) {
+            atl_mqtt_ota_abort(client, true);
+        }
+        return;
+    } else if (status == ATL_MQTT_REQUEST_CANCELLED) {
+        atl_mqtt_ota_abort(client, false);
+        return;
+    }
+
+    /* Drop a redelivered chunk before any flash work */
+    if (atl_mqtt_ota.chunk_written[chunk / 8] & (1 << (chunk % 8))) {
+        if (last_fragment == true) {
+            ESP_LOGW(TAG, "Chunk %lu already written, discarding duplicate!", chunk + 1);
+        }
+        return;
+    }
+
+    /* Check chunk size (last chunk may be smaller) */
+    uint32_t chunk_offset = chunk * atl_mqtt_ota.chunk_size;
+    uint32_t chunk_len = MIN(atl_mqtt_ota.chunk_size, atl_mqtt_ota.fw_size - chunk_offset);
+    if (total_len != chunk_len) {
+        ESP_LOGE(TAG, "Invalid chunk %lu size (%d bytes - expected %lu bytes)!", chunk + 1, total_len, chunk_len);
+        atl_mqtt_ota_abort(client, true);
+        return;
+    }
+
+    /* Write the fragment at its position on next partition (fragments of a chunk arrive in order) */
+    if (offset == 0) {
+        atl_mqtt_ota.carry_len = 0;
+    }
+    atl_trace_begin("ota_write");
+    atl_stall_begin(atl_mqtt_stall_ota);
+    atl_energy_begin(ATL_ENERGY_OTA);
+    err = atl_mqtt_ota_write((const uint8_t*)data, data_len, chunk_offset + offset, last_fragment);
+    atl_energy_end(ATL_ENERGY_OTA);
+    atl_energy_flash(ATL_ENERGY_OTA, 0, data_len);
+    atl_stall_end(atl_mqtt_stall_ota);
+    atl_trace_end("ota_write");
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail writing chunk %lu/%lu! Error: (%d) %s", chunk + 1, atl_mqtt_ota.chunk_count, err, esp_err_to_name(err));
+        atl_mqtt_ota_abort(client, true);
+        return;
+    }
+    if (last_fragment == false) {
+        return;
+    }
+    atl_mqtt_ota.chunk_written[chunk / 8] |= (1 << (chunk % 8));
+    atl_mqtt_ota.chunk_done++;
+    atl_mqtt_ota.retries = 0;
+    ESP_LOGI(TAG, "Chunk %lu/%lu received! (Size: %d bytes - %lu/%lu written)", chunk + 1, atl_mqtt_ota.chunk_count, total_len, atl_mqtt_ota.chunk_done, atl_mqtt_ota.chunk_count);
+
+    /* If all new firmware chunks was received, update status and partition boot order */
+    if (atl_mqtt_ota.chunk_done >= atl_mqtt_ota.chunk_count) {
+        atl_trace_begin("ota_finish");
+        atl_mqtt_ota_finish(client);
+        atl_trace_end("ota_finish");
+    }
+
+    /* Otherwise keep the pipeline full */
+    else {
+        atl_mqtt_ota_fill_pipeline(client);
+    }
+}
+
+/**
+ * @fn atl_mqtt_attr_get_enum(const atl_json_value_t *value, int max, int *enum_value)
+ * @brief Get an enumeration attribute value (integer number between 0 and max).
+ * @param[in] value - JSON value
+ * @param[in] max - Maximum enumeration value
+ * @param[out] enum_value - Enumeration value
+ * @return esp_err_t - If ERR_OK success, otherwise invalid value.
+ */
+static esp_err_t atl_mqtt_attr_get_enum(const atl_json_value_t *value, int max, int *enum_value) {
+    if ((value->type != ATL_JSON_NUMBER) || (value->number < 0) || (value->number > max) || (value->number != (int)value->number)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *enum_value = (int)value->number;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_mqtt_attr_set_str(uint8_t *dst, size_t dst_size, const atl_json_value_t *value)
+ * @brief Set a string attribute (unchanged if value does not fit).
+ * @param[out] dst - Configuration field
+ * @param[in] dst_size - Configuration field size
+ * @param[in] value - JSON value
+ * @return esp_err_t - If ERR_OK success, otherwise invalid value.
+ */
+static esp_err_t atl_mqtt_attr_set_str(uint8_t *dst, size_t dst_size, const atl_json_value_t *value) {
+    char str[65];
+    esp_err_t err = atl_json_strcpy(str, MIN(sizeof(str), dst_size), value);
+    if (err == ESP_OK) {
+        memset(dst, 0, dst_size);
+        memcpy(dst, str, strlen(str));
+    }
+    return err;
+}
+
+/* Attribute setters (ctx is the local copy of configuration) */
+static esp_err_t atl_mqtt_attr_mqtt_mode(void *ctx, const atl_json_value_t *value) {
+    int mode;
+    esp_err_t err = atl_mqtt_attr_get_enum(value, ATL_MQTT_THIRD, &mode);
+    if (err == ESP_OK) {
+        ((atl_config_t*)ctx)->mqtt_client.mode = mode;
+    }
+    return err;
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_broker_address(void *ctx, const atl_json_value_t *value) {
+    return atl_mqtt_attr_set_str(((atl_config_t*)ctx)->mqtt_client.broker_address, sizeof(((atl_config_t*)ctx)->mqtt_client.broker_address), value);
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_broker_port(void *ctx, const atl_json_value_t *value) {
+    if ((value->type != ATL_JSON_NUMBER) || (value->number < 1) || (value->number > 65535)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ((atl_config_t*)ctx)->mqtt_client.broker_port = (uint16_t)value->number;
+    return ESP_OK;
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_transport(void *ctx, const atl_json_value_t *value) {
+    int transport;
+    esp_err_t err = atl_mqtt_attr_get_enum(value, MQTT_TRANSPORT_OVER_SSL, &transport);
+    if ((err == ESP_OK) && (transport >= MQTT_TRANSPORT_OVER_TCP)) {
+        ((atl_config_t*)ctx)->mqtt_client.transport = transport;
+        return ESP_OK;
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_disable_cn_check(void *ctx, const atl_json_value_t *value) {
+    if ((value->type != ATL_JSON_TRUE) && (value->type != ATL_JSON_FALSE)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ((atl_config_t*)ctx)->mqtt_client.disable_cn_check = (value->type == ATL_JSON_TRUE);
+    return ESP_OK;
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_user(void *ctx, const atl_json_value_t *value) {
+    return atl_mqtt_attr_set_str(((atl_config_t*)ctx)->mqtt_client.user, sizeof(((atl_config_t*)ctx)->mqtt_client.user), value);
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_pass(void *ctx, const atl_json_value_t *value) {
+    return atl_mqtt_attr_set_str(((atl_config_t*)ctx)->mqtt_client.pass, sizeof(((atl_config_t*)ctx)->mqtt_client.pass), value);
+}
+
+static esp_err_t atl_mqtt_attr_mqtt_qos(void *ctx, const atl_json_value_t *value) {
+    int qos;
+    esp_err_t err = atl_mqtt_attr_get_enum(value, ATL_MQTT_QOS2, &qos);
+    if (err == ESP_OK) {
+        ((atl_config_t*)ctx)->mqtt_client.qos = qos;
+    }
+    return err;
+}
+
+static esp_err_t atl_mqtt_attr_wifi_mode(void *ctx, const atl_json_value_t *value) {
+    int mode;
+    esp_err_t err = atl_mqtt_attr_get_enum(value, ATL_WIFI_STA_MODE, &mode);
+    if (err == ESP_OK) {
+        ((atl_config_t*)ctx)->wifi.mode = mode;
+    }
+    return err;
+}
+
+static esp_err_t atl_mqtt_attr_wifi_sta_ssid(void *ctx, const atl_json_value_t *value) {
+    return atl_mqtt_attr_set_str(((atl_config_t*)ctx)->wifi.sta_ssid, sizeof(((atl_config_t*)ctx)->wifi.sta_ssid), value);
+}
+
+static esp_err_t atl_mqtt_attr_wifi_sta_pass(void *ctx, const atl_json_value_t *value) {
+    return atl_mqtt_attr_set_str(((atl_config_t*)ctx)->wifi.sta_pass, sizeof(((atl_config_t*)ctx)->wifi.sta_pass), value);
+}
+
+static esp_err_t atl_mqtt_attr_ota_behaviour(void *ctx, const atl_json_value_t *value) {
+    int behaviour;
+    esp_err_t err = atl_mqtt_attr_get_enum(value, ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT, &behaviour);
+    if (err == ESP_OK) {
+        ((atl_config_t*)ctx)->ota.behaviour = behaviour;
+    }
+    return err;
+}
+
+static esp_err_t atl_mqtt_attr_group_id(void *ctx, const atl_json_value_t *value) {
+    atl_config_group_t *group = &((atl_config_t*)ctx)->group;
+    uint8_t id[sizeof(group->id)];
+    memcpy(id, group->id, sizeof(id));
+    esp_err_t err = atl_mqtt_attr_set_str(group->id, sizeof(group->id), value);
+    if ((err == ESP_OK) && (memcmp(id, group->id, sizeof(id)) != 0)) {
+        group->version = 0;
+    }
+    return err;
+}
+
+/**
+ * @brief Shared attributes accepted from server (key to setter).
+ */
+static const atl_json_key_t atl_mqtt_attr_keys[] = {
+    {"mqtt_client.mode",                atl_mqtt_attr_mqtt_mode},
+    {"mqtt_client.broker_address",      atl_mqtt_attr_mqtt_broker_address},
+    {"mqtt_client.broker_port",         atl_mqtt_attr_mqtt_broker_port},
+    {"mqtt_client.transport",           atl_mqtt_attr_mqtt_transport},
+    {"mqtt_client.disable_cn_check",    atl_mqtt_attr_mqtt_disable_cn_check},
+    {"mqtt_client.user",                atl_mqtt_attr_mqtt_user},
+    {"mqtt_client.pass",                atl_mqtt_attr_mqtt_pass},
+    {"mqtt_client.qos",                 atl_mqtt_attr_mqtt_qos},
+    {"wifi.startup_mode",               atl_mqtt_attr_wifi_mode},
+    {"wifi.sta_ssid",                   atl_mqtt_attr_wifi_sta_ssid},
+    {"wifi.sta_pass",                   atl_mqtt_attr_wifi_sta_pass},
+    {"ota.behaviour",                   atl_mqtt_attr_ota_behaviour},
+    {"group.id",                        atl_mqtt_attr_group_id},
+};
+_Static_assert(sizeof(atl_mqtt_attr_keys) / sizeof(atl_json_key_t) <= 32, "Override mask supports up to 32 attribute keys");
+static atl_json_dispatch_t atl_mqtt_attr_dispatch;
+static uint32_t atl_mqtt_attr_group_id_mask = 0;
+
+/**
+ * @fn atl_mqtt_get_attr_keys(size_t *count)
+ * @brief Get the shared attribute keys accepted from server (setters only write to the configuration copy given as context).
+ * @param[out] count - Number of keys
+ * @return const atl_json_key_t* - Key table.
+ */
+const atl_json_key_t* atl_mqtt_get_attr_keys(size_t *count) {
+    *count = sizeof(atl_mqtt_attr_keys) / sizeof(atl_json_key_t);
+    return atl_mqtt_attr_keys;
+}
+
+/**
+ * @fn atl_mqtt_config_update(const atl_config_t *alt_config_local)
+ * @brief Update main ATL configuration structure and commit it to NVS (only if changed, to save flash wear).
+ * @param[in] alt_config_local - Updated local copy of configuration
+ */
+static void atl_mqtt_config_update(const atl_config_t *alt_config_local) {
+    bool changed = false;
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        if (memcmp(&atl_config, alt_config_local, sizeof(atl_config_t)) != 0) {
+            memcpy(&atl_config, alt_config_local, sizeof(atl_config_t));
+            changed = true;
+        }
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+    if (changed == true) {
+        atl_config_commit_nvs();
+    } else {
+        ESP_LOGI(TAG, "Configuration unchanged, NVS commit skipped");
+    }
+}
+
+/**
+ * @fn atl_mqtt_process_attributes(const char *data, int data_len, atl_config_t *alt_config_local)
+ * @brief Apply shared attributes updated from server.
+ * @details The message is decoded in a single pass (atl_json) and each known key is dispatched to its setter, no DOM is
+ *  built. Configuration is only updated if the whole message is valid JSON.
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in,out] alt_config_local - Local copy of configuration to be updated
+ */
+static void atl_mqtt_process_attributes(const char *data, int data_len, atl_config_t *alt_config_local) {
+    uint32_t applied_mask = 0;
+    ESP_LOGI(TAG, "Configuration updated from server: %.*s", data_len, data);
+
+    /* Decode JSON message */
+    if (atl_json_dispatch_mask(&atl_mqtt_attr_dispatch, data, data_len, alt_config_local, 0, &applied_mask) != ESP_OK) {
+        ESP_LOGW(TAG, "Invalid JSON message!");
+        return;
+    }
+
+    /* Settings set per device are not overwritten by group configuration */
+    alt_config_local->group.override_mask |= (applied_mask & ~atl_mqtt_attr_group_id_mask);
+
+    /* Update local copy to main ATL configuration structure */
+    atl_mqtt_config_update(alt_config_local);
+}
+
+/**
+ * @fn atl_mqtt_group_version_cb(const char *key, int key_len, uint8_t depth, const atl_json_value_t *value, void *arg)
+ * @brief Tokenizer callback to get the version of a group configuration.
+ * @param[in] key - Value key
+ * @param[in] key_len - Value key length
+ * @param[in] depth - Value nesting level
+ * @param[in] value - Value
+ * @param[out] arg - Group configuration version (uint32_t)
+ * @return esp_err_t - Always ESP_OK.
+ */
+static esp_err_t atl_mqtt_group_version_cb(const char *key, int key_len, uint8_t depth, const atl_json_value_t *value, void *arg) {
+    if ((depth == 1) && (key != NULL) && (key_len == strlen("version")) && (strncmp(key, "version", key_len) == 0) &&
+        (value->type == ATL_JSON_NUMBER) && (value->number >= 1) && (value->number <= UINT32_MAX)) {
+        *(uint32_t*)arg = (uint32_t)value->number;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_mqtt_process_group_config(const char *data, int data_len, atl_config_t *alt_config_local)
+ * @brief Apply group (fleet) configuration received from retained group topic.
+ * @details Versions already applied are skipped (retained message is delivered again at each connection) and
+ *  settings overridden by device attributes are kept.
+ * @param[in] data - JSON message
+ * @param[in] data_len - JSON message length
+ * @param[in,out] alt_config_local - Local copy of configuration to be updated
+ */
+static void atl_mqtt_process_group_config(const char *data, int data_len, atl_config_t *alt_config_local) {
+    uint32_t version = 0;
+
+    /* Check version before decoding the settings */
+    if ((atl_json_parse(data, data_len, atl_mqtt_group_version_cb, &version) != ESP_OK) || (version == 0)) {
+        ESP_LOGW(TAG, "Invalid group configuration (JSON object with version required)!");
+        return;
+    } else if (version <= alt_config_local->group.version) {
+        ESP_LOGI(TAG, "Group configuration version %lu already applied, skipped", version);
+        return;
+    }
+    ESP_LOGI(TAG, "Group configuration version %lu: %.*s", version, data_len, data);
+
+    /* Decode JSON message (group ID is not changed by group configuration) */
+    if (atl_json_dispatch_mask(&atl_mqtt_attr_dispatch, data, data_len, alt_config_local,
+                               alt_config_local->group.override_mask | atl_mqtt_attr_group_id_mask, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Invalid JSON message!");
+        return;
+    }
+    alt_config_local->group.version = version;
+
+    /* Update local copy to main ATL configuration structure */
+    atl_mqtt_config_update(alt_config_local);
+}
+
+/**
+ * @fn atl_mqtt_fw_info_cb(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg)
+ * @brief Firmware information request callback (response of request attributes).
+ * @param[in] client - MQTT client handle
+ * @param[in] status - Request status
+ * @param[in] data - JSON message (reassembled)
+ * @param[in] data_len - JSON message length
+ * @param[in] offset - Not used (always 0)
+ * @param[in] total_len - JSON message length
+ * @param[in] arg - Not used
+ */
+static void atl_mqtt_fw_info_cb(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg) {
+
+    /* Check if request was answered */
+    if (status != ATL_MQTT_REQUEST_RESPONSE) {
+        ESP_LOGW(TAG, "Firmware information not received!");
+        return;
+    }
+
+    /* Check if it is an empty message */
+    if ((strncmp(data, "{}", data_len) == 0) || (strncmp(data, "[]", data_len) == 0)) {
+        ESP_LOGW(TAG, "Received an empty JSON message: %.*s", data_len, data);
+        return;
+    }
+
+    /* Check if a firmware download is already in progress */
+    if (atl_mqtt_ota.active == true) {
+        ESP_LOGW(TAG, "Firmware download already in progress!");
+        return;
+    }
+
+    /* Metered uplinks are reserved for telemetry, firmware is requested again after reconnecting through other uplink */
+    if (atl_netmgr_is_metered() == true) {
+        ESP_LOGW(TAG, "Active uplink is metered, deferring firmware check!");
+        return;
+    }
+
+    /* Parse JSON message */
+    cJSON *root = cJSON_ParseWithLength(data, data_len);
+    if (root == NULL) {
+        ESP_LOGW(TAG, "Invalid JSON message!");
+        return;
+    }
+    cJSON *shared = cJSON_GetObjectItem(root, "shared");
+    cJSON *fw_version = cJSON_GetObjectItem(shared, "fw_version");
+    cJSON *fw_title = cJSON_GetObjectItem(shared, "fw_title");
+    //cJSON *fw_checksum = cJSON_GetObjectItem(shared, "fw_checksum");
+    //cJSON *fw_checksum_algorithm = cJSON_GetObjectItem(shared, "fw_checksum_algorithm");
+    cJSON *fw_size = cJSON_GetObjectItem(shared, "fw_size");
+    if (!cJSON_IsString(fw_title) || !cJSON_IsString(fw_version) || !cJSON_IsNumber(fw_size) || (cJSON_GetNumberValue(fw_size) <= 0)) {
+        ESP_LOGW(TAG, "Incomplete firmware information!");
+        cJSON_Delete(root);
+        return;
+    }
+
+    esp_app_desc_t app_info;
+    const esp_partition_t *partition_info_ptr;
+    partition_info_ptr = esp_ota_get_running_partition();
+    esp_ota_get_partition_description(partition_info_ptr, &app_info);
+
+    // Check if running firmware is updated
+    if ((strcmp(cJSON_GetStringValue(fw_title), app_info.project_name) == 0) && (strcmp(cJSON_GetStringValue(fw_version), app_info.version) == 0)) {
+        atl_mqtt_publish_fw_state(client, "UPDATED");
+    }
+
+    // Check if running firmware is out of date
+    else if ((strcmp(cJSON_GetStringValue(fw_title), app_info.project_name) == 0) && (strcmp(cJSON_GetStringValue(fw_version), app_info.version) != 0)) {
+        ESP_LOGW(TAG, "Current firmware is out of date! Current: %s - Server: %s", app_info.version, cJSON_GetStringValue(fw_version));
+
+        // Set device to DOWNLOADING state
+        atl_mqtt_publish_fw_state(client, "DOWNLOADING");
+
+        // Prepare new partition and request the first chunks of new firmware from server
+        memset(&atl_mqtt_ota, 0, sizeof(atl_mqtt_ota_t));
+        atl_mqtt_ota.fw_size = (uint32_t)cJSON_GetNumberValue(fw_size);
+        atl_mqtt_ota.chunk_size = CONFIG_ATL_OTA_CHUNK_SIZE & ~(ATL_MQTT_OTA_WRITE_ALIGN - 1);
+        atl_mqtt_ota.chunk_count = ceil(cJSON_GetNumberValue(fw_size)/atl_mqtt_ota.chunk_size);
+        atl_mqtt_ota.pipeline_depth = atl_netprof_pipeline_depth(atl_mqtt_ota.chunk_size, CONFIG_ATL_OTA_PIPELINE_DEPTH);
+        ESP_LOGW(TAG, "Downloading firmware %s from server!", cJSON_GetStringValue(fw_version));
+        ESP_LOGW(TAG, "Total size: %lu bytes (Chunk size: %lu bytes - Total chunks: %lu - Pipeline: %d)", atl_mqtt_ota.fw_size, atl_mqtt_ota.chunk_size, atl_mqtt_ota.chunk_count, atl_mqtt_ota.pipeline_depth);
+        if (atl_mqtt_ota_begin(client) == ESP_OK) {
+            atl_mqtt_ota_fill_pipeline(client);
+        }
+    }
+    cJSON_Delete(root);
+}
+
+/**
+ * @fn atl_mqtt_get_rx_topic(const char *topic, int topic_len)
+ * @brief Classify an inbound MQTT topic.
+ * @param[in] topic - MQTT topic (not null terminated)
+ * @param[in] topic_len - MQTT topic length
+ * @return atl_mqtt_rx_topic_e - Topic class.
+ */
+static atl_mqtt_rx_topic_e atl_mqtt_get_rx_topic(const char *topic, int topic_len) {
+    const char attributes[] = "v1/devices/me/attributes";
+    const char attributes_response[] = "v1/devices/me/attributes/response/";
+    const char fw_response[] = "v2/fw/response/";
+    if ((topic_len == strlen(attributes)) && (strncmp(topic, attributes, topic_len) == 0)) {
+        return ATL_MQTT_RX_ATTRIBUTES;
+    } else if ((topic_len > strlen(attributes_response)) && (strncmp(topic, attributes_response, strlen(attributes_response)) == 0)) {
+        return ATL_MQTT_RX_ATTRIBUTES_RESPONSE;
+    } else if ((topic_len > strlen(fw_response)) && (strncmp(topic, fw_response, strlen(fw_response)) == 0)) {
+        return ATL_MQTT_RX_FW_CHUNK;
+    } else if ((atl_mqtt_group_topic[0] != '\0') && (topic_len == strlen(atl_mqtt_group_topic)) && (strncmp(topic, atl_mqtt_group_topic, topic_len) == 0)) {
+        return ATL_MQTT_RX_GROUP_CONFIG;
+    }
+    return ATL_MQTT_RX_UNKNOWN;
+}
+
+/**
+ * @fn atl_mqtt_rx_is_duplicate(const char *data, int data_len)
+ * @brief Check if a complete QoS1/2 message is a redelivery of a message already processed.
+ * @details Only messages flagged as DUP are checked, keyed by packet id and content hash (packet ids are reused by
+ *  broker). Processed messages are remembered at a small ring.
+ * @param[in] data - Message
+ * @param[in] data_len - Message length
+ * @return bool - True if duplicate.
+ */
+static bool atl_mqtt_rx_is_duplicate(const char *data, int data_len) {
+    if (atl_mqtt_rx.msg_id < 0) {
+        return false;
+    }
+    uint32_t hash = atl_json_hash(data, data_len);
+    if (atl_mqtt_rx.dup == true) {
+        for (uint8_t i = 0; i < ATL_MQTT_RX_SEEN_SIZE; i++) {
+            if ((atl_mqtt_rx_seen[i].msg_id == atl_mqtt_rx.msg_id) && (atl_mqtt_rx_seen[i].hash == hash)) {
+                return true;
+            }
+        }
+    }
+    atl_mqtt_rx_seen[atl_mqtt_rx_seen_next].msg_id = atl_mqtt_rx.msg_id;
+    atl_mqtt_rx_seen[atl_mqtt_rx_seen_next].hash = hash;
+    atl_mqtt_rx_seen_next = (atl_mqtt_rx_seen_next + 1) % ATL_MQTT_RX_SEEN_SIZE;
+    return false;
+}
+
+/**
+ * @fn atl_mqtt_rx_data(esp_mqtt_client_handle_t client, esp_mqtt_event_handle_t event, atl_config_t *alt_config_local)
+ * @brief Process an inbound MQTT_EVENT_DATA fragment.
+ * @details Messages larger than the MQTT receive buffer are delivered as several MQTT_EVENT_DATA events and only the
+ *  first one carries the topic. Firmware chunks are streamed to flash fragment by fragment, JSON messages are
+ *  reassembled into a bounded buffer and parsed when complete.
+ * @param[in] client - MQTT client handle
+ * @param[in] event - MQTT event
+ * @param[in,out] alt_config_local - Local copy of configuration
+ */
+static void atl_mqtt_rx_data(esp_mqtt_client_handle_t client, esp_mqtt_event_handle_t event, atl_config_t *alt_config_local) {
+
+    /* First fragment carries the topic and starts a new message */
+    if (event->current_data_offset == 0) {
+        if ((event->topic == NULL) || (event->topic_len == 0)) {
+            ESP_LOGW(TAG, "MQTT_EVENT_DATA [null topic]");
+            atl_mqtt_rx.topic = ATL_MQTT_RX_NONE;
+            return;
+        } else if (event->total_data_len == 0) {
+            ESP_LOGW(TAG, "MQTT_EVENT_DATA [message empty]");
+            atl_mqtt_rx.topic = ATL_MQTT_RX_NONE;
+            return;
+        }
+        ESP_LOGI(TAG, "MQTT_EVENT_DATA from [%.*s], msg_id=%d (%d bytes)", event->topic_len, event->topic, event->msg_id, event->total_data_len);
+        atl_mqtt_rx.topic = atl_mqtt_get_rx_topic(event->topic, event->topic_len);
+        atl_mqtt_rx.request_id = -1;
+        atl_mqtt_rx.msg_id = (event->qos > 0) ? event->msg_id : -1;
+        atl_mqtt_rx.dup = event->dup;
+        atl_mqtt_rx.total_len = event->total_data_len;
+        atl_mqtt_rx.received = 0;
+        atl_mqtt_rx.discard = false;
+
+        /* JSON messages must fit into the reassembly buffer */
+        if ((atl_mqtt_rx.topic != ATL_MQTT_RX_FW_CHUNK) && (atl_mqtt_rx.total_len > CONFIG_ATL_MQTT_RX_BUFFER_SIZE)) {
+            ESP_LOGW(TAG, "Message too large (%d bytes - max. %d bytes), discarding!", atl_mqtt_rx.total_len, CONFIG_ATL_MQTT_RX_BUFFER_SIZE);
+            atl_mqtt_rx.discard = true;
+        }
+
+        /* Responses must answer an outstanding request */
+        if ((atl_mqtt_rx.topic == ATL_MQTT_RX_ATTRIBUTES_RESPONSE) || (atl_mqtt_rx.topic == ATL_MQTT_RX_FW_CHUNK)) {
+            atl_mqtt_rx.request_id = atl_mqtt_request_match(event);
+            if (atl_mqtt_rx.request_id < 0) {
+                ESP_LOGW(TAG, "Response not requested or already timed out!");
+                atl_mqtt_rx.discard = true;
+            }
+        }
+    } 
+    
+    /* Following fragments must continue the message in progress */
+    else if ((atl_mqtt_rx.topic == ATL_MQTT_RX_NONE) || (event->current_data_offset != atl_mqtt_rx.received)) {
+        ESP_LOGW(TAG, "Unexpected MQTT_EVENT_DATA fragment (offset %d), discarding!", event->current_data_offset);
+        atl_mqtt_rx.topic = ATL_MQTT_RX_NONE;
+        return;
+    }
+
+    /* Consume fragment */
+    bool last_fragment = ((event->current_data_offset + event->data_len) >= event->total_data_len);
+    if (atl_mqtt_rx.discard == false) {
+        if (atl_mqtt_rx.topic == ATL_MQTT_RX_FW_CHUNK) {
+            if (atl_mqtt_request_deliver(client, atl_mqtt_rx.request_id, event->data, event->data_len, event->current_data_offset, event->total_data_len) != ESP_OK) {
+                atl_mqtt_rx.discard = true;
+            }
+        } else if (atl_mqtt_rx.topic != ATL_MQTT_RX_UNKNOWN) {
+            memcpy(&atl_mqtt_rx.buffer[atl_mqtt_rx.received], event->data, event->data_len);
+        }
+    }
+    atl_mqtt_rx.received += event->data_len;
+    if (!last_fragment) {
+        return;
+    }
+
+    /*** Parse complete message in accordance with MQTT topic ***/
+    if ((atl_mqtt_rx.discard == false) && (atl_mqtt_rx.topic != ATL_MQTT_RX_FW_CHUNK) && (atl_mqtt_rx.topic != ATL_MQTT_RX_UNKNOWN)) {
+        if (atl_mqtt_rx_is_duplicate(atl_mqtt_rx.buffer, atl_mqtt_rx.received) == true) {
+            ESP_LOGW(TAG, "Duplicate message (msg_id=%d), discarding!", atl_mqtt_rx.msg_id);
+            atl_mqtt_rx.discard = true;
+        }
+    }
+    if (atl_mqtt_rx.discard == false) {
+
+        /* Attributes updated from server */
+        if (atl_mqtt_rx.topic == ATL_MQTT_RX_ATTRIBUTES) {
+            atl_mqtt_rx.buffer[atl_mqtt_rx.received] = '\0';
+            atl_trace_begin("mqtt_attributes");
+            atl_mqtt_process_attributes(atl_mqtt_rx.buffer, atl_mqtt_rx.received, alt_config_local);
+            atl_trace_end("mqtt_attributes");
+        }
+
+        /* Group configuration (retained) */
+        else if (atl_mqtt_rx.topic == ATL_MQTT_RX_GROUP_CONFIG) {
+            atl_mqtt_rx.buffer[atl_mqtt_rx.received] = '\0';
+            atl_trace_begin("mqtt_group_config");
+            atl_mqtt_process_group_config(atl_mqtt_rx.buffer, atl_mqtt_rx.received, alt_config_local);
+            atl_trace_end("mqtt_group_config");
+        }
+
+        /* Response of previous request attributes */
+        else if (atl_mqtt_rx.topic == ATL_MQTT_RX_ATTRIBUTES_RESPONSE) {
+            atl_mqtt_rx.buffer[atl_mqtt_rx.received] = '\0';
+            atl_mqtt_request_deliver(client, atl_mqtt_rx.request_id, atl_mqtt_rx.buffer, atl_mqtt_rx.received, 0, atl_mqtt_rx.received);
+        }
+    }
+    atl_mqtt_rx.topic = ATL_MQTT_RX_NONE;
+}
+
+
 /**
  * @brief Event handler registered to receive MQTT events
  *
@@ -123,15 +1371,10 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%" PRIi32, base, event_id);
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t client = event->client;
-    static int msg_id = 0;
-    static int request_id = 0;
-    static uint32_t chunk_size = 4096;
-    static uint32_t chunk_count = 0;
-    static uint32_t chunk_current = 0;
     cJSON *root;
-    static const esp_partition_t *update_partition = NULL;
-    static esp_ota_handle_t update_handle = 0 ;
-    esp_err_t err;
+    atl_trace_begin("mqtt_event");
+    atl_stall_begin(atl_mqtt_stall_event);
+    atl_energy_begin(ATL_ENERGY_MQTT);
 
     ESP_LOGD(TAG, "free heap size is %" PRIu32 ", minimum %" PRIu32, esp_get_free_heap_size(), esp_get_minimum_free_heap_size());
     
@@ -151,6 +1394,13 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
             //print_user_property(event->property->user_property);    
+            atl_mqtt_tls_lock(false);
+            atl_mqtt_keepalive_connected();
+            atl_mqtt_keepalive_arm(true);
+            atl_mqtt_transport_errno = -1;
+            atl_mqtt_status.connected = true;
+            atl_netmgr_set_session(true);
+            atl_mqtt_status.connects++;
 
             /* If GreenField is connected at AgroTechLab Cloud */
             if (alt_config_local.mqtt_client.mode == ATL_MQTT_AGROTECHLAB_CLOUD) {
@@ -350,6 +1600,8 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
                 } else if (reset_reason == ESP_RST_SDIO) {
                     cJSON_AddStringToObject(root, "last_reboot_reason", "Reset over SDIO");
                 }                                               
+                cJSON_AddStringToObject(root, "group.id", (const char*)alt_config_local.group.id);
+                cJSON_AddNumberToObject(root, "group.version", alt_config_local.group.version);
                 msg_id = esp_mqtt_client_publish(client, "v1/devices/me/attributes", cJSON_Print(root), 0, 1, 0);
                 esp_mqtt5_client_delete_user_property(publish_property.user_property);
                 publish_property.user_property = NULL;
@@ -359,22 +1611,45 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
                 /* Request from ThingsBoard the firmware info */
                 if (alt_config_local.ota.behaviour != ATL_OTA_BEHAVIOUR_DISABLED) {
                     esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
 	                root = cJSON_CreateObject();
                     cJSON_AddStringToObject(root, "sharedKeys", "fw_checksum,fw_checksum_algorithm,fw_size,fw_title,fw_version");
-                    request_id = msg_id + 1;
-                    char fw_topic[60] = {};
-                    sprintf(fw_topic, "v1/devices/me/attributes/request/%d", request_id);          
-                    msg_id = esp_mqtt_client_publish(client, fw_topic, cJSON_Print(root), 0, 1, 0);
+                    char *payload = cJSON_PrintUnformatted(root);
+                    int fw_info_request_id = atl_mqtt_request_send(client, &publish_property, "v1/devices/me/attributes/request", "v1/devices/me/attributes/response", NULL,
+                        payload, 0, 1, 0, atl_mqtt_fw_info_cb, NULL);
                     esp_mqtt5_client_delete_user_property(publish_property.user_property);
                     publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Requesting firmware information to [%s], msg_id=%d", fw_topic, msg_id);
+                    ESP_LOGI(TAG, "Requesting firmware information, request_id=%d", fw_info_request_id);
                     cJSON_Delete(root);
+                    free(payload);
                 }
             }
+
+            /* Subscribe to retained group configuration topic (if member of a group) */
+            atl_mqtt_group_topic[0] = '\0';
+            if (alt_config_local.group.id[0] != '\0') {
+                snprintf(atl_mqtt_group_topic, sizeof(atl_mqtt_group_topic), "%s%.*s/config", CONFIG_ATL_MQTT_GROUP_TOPIC_PREFIX,
+                         (int)sizeof(alt_config_local.group.id), (const char*)alt_config_local.group.id);
+                esp_mqtt5_client_set_user_property(&subscribe_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
+                esp_mqtt5_client_set_subscribe_property(client, &subscribe_property);
+                msg_id = esp_mqtt_client_subscribe(client, atl_mqtt_group_topic, 1);
+                esp_mqtt5_client_delete_user_property(subscribe_property.user_property);
+                subscribe_property.user_property = NULL;
+                ESP_LOGI(TAG, "Sending subscribe to [%s], msg_id=%d", atl_mqtt_group_topic, msg_id);
+            }
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+            atl_mqtt_window_resume(client);
+#endif
             break;
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "MQTT_EVENT_DISCONNECTED");            
+            atl_mqtt_tls_lock(false);
+            atl_mqtt_request_cancel_all(client);
+            atl_mqtt_keepalive_arm(false);
+            atl_mqtt_keepalive_disconnected(atl_mqtt_keepalive_idle_drop());
+            atl_mqtt_transport_errno = -1;
+            atl_mqtt_status.connected = false;
+            atl_netmgr_set_session(false);
+            atl_mqtt_status.disconnects++;
             break;
         case MQTT_EVENT_SUBSCRIBED:            
             ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED [msg_id=%d]", event->msg_id);                        
@@ -384,535 +1659,77 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
             break;        
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED [msg_id=%d]", event->msg_id);            
+            atl_mqtt_status.published++;
+            atl_age_acked(event->msg_id);
             break;        
         case MQTT_EVENT_DATA:
-            ESP_LOGI(TAG, "MQTT_EVENT_DATA from [%.*s],  msg_id=%d", event->topic_len, event->topic, event->msg_id);
-            
-            // TODO: Check some unexpected behaviours
-            if (event->topic == NULL) {
-                ESP_LOGW(TAG, "MQTT_EVENT_DATA [null topic]");
-                break;
-            } else if (event->data_len == 0) {
-                ESP_LOGW(TAG, "MQTT_EVENT_DATA [message empty]");
-                break;
+            if (event->current_data_offset == 0) {
+                atl_mqtt_status.received++;
             }
+            atl_trace_begin("mqtt_rx_data");
+            atl_mqtt_rx_data(client, event, &alt_config_local);
+            atl_trace_end("mqtt_rx_data");
+            break;
+        case MQTT_EVENT_BEFORE_CONNECT:
+            ESP_LOGI(TAG, "MQTT_EVENT_BEFORE_CONNECT");            
 
-            //print_user_property(event->property->user_property);
-            // ESP_LOGI(TAG, "payload_format_indicator is %d", event->property->payload_format_indicator);
-            // ESP_LOGI(TAG, "response_topic is %.*s", event->property->response_topic_len, event->property->response_topic);
-            // ESP_LOGI(TAG, "correlation_data is %.*s", event->property->correlation_data_len, event->property->correlation_data);
-            // ESP_LOGI(TAG, "content_type is %.*s", event->property->content_type_len, event->property->content_type);
-            // ESP_LOGI(TAG, "topic: %.*s", event->topic_len, event->topic);
-            // ESP_LOGI(TAG, "data: %.*s", event->data_len, event->data); 
-
-            /*** Parse message in accordance with MQTT topic ***/
-            /* Attributes updated from server */
-            if (strncmp(event->topic, "v1/devices/me/attributes", event->topic_len) == 0) {
-                ESP_LOGI(TAG, "Configuration updated from server: %.*s", event->data_len, event->data);
-                
-                /* Parse JSON message */
-                root = NULL;                
-                root = cJSON_ParseWithLength(event->data, event->data_len);
-                if (root == NULL) {                    
-                    ESP_LOGW(TAG, "Invalid JSON message!");
-                    break;
-                }
-
-                /* Checking Moisture Monitor configuration */                
-                // if (cJSON_HasObjectItem(root, "moisture.enabled") == true) {                    
-                //     if (cJSON_IsTrue(cJSON_GetObjectItem(root, "moisture.enabled"))) {
-                //         x200_config.moisture.enabled = true;
-                //     } else {
-                //         x200_config.moisture.enabled = false;
-                //     }                    
-                // }
-                // if (cJSON_HasObjectItem(root, "moisture.sample_period") == true) {
-                //     cJSON *key = cJSON_GetObjectItem(root, "moisture.sample_period");
-                //     x200_config.moisture.sample_period = (uint16_t)cJSON_GetNumberValue(key);
-                // }
-                // if (cJSON_HasObjectItem(root, "moisture.sample_window") == true) {
-                //     cJSON *key = cJSON_GetObjectItem(root, "moisture.sample_window");
-                //     x200_config.moisture.sample_window = (uint16_t)cJSON_GetNumberValue(key);
-                // }
-                // if (cJSON_HasObjectItem(root, "moisture.update_period") == true) {
-                //     cJSON *key = cJSON_GetObjectItem(root, "moisture.update_period");
-                //     x200_config.moisture.update_period = (uint16_t)cJSON_GetNumberValue(key);
-                // }
-
-                /* Checking Analog Input configuration */
-                // char json_key[64];
-                // for (uint8_t i = 0; i < 4; i++) {                    
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.mode", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         if (cJSON_GetNumberValue(key) == X200_ANALOG_DISABLED) {
-                //             x200_config.analog_input[i].mode = X200_ANALOG_DISABLED;
-                //         } else if (cJSON_GetNumberValue(key) == X200_ANALOG_INPUT_4_20_MA) {
-                //             x200_config.analog_input[i].mode = X200_ANALOG_INPUT_4_20_MA;
-                //         } else if (cJSON_GetNumberValue(key) == X200_ANALOG_INPUT_0_10_V) {
-                //             x200_config.analog_input[i].mode = X200_ANALOG_INPUT_0_10_V;
-                //         } else {
-                //             ESP_LOGW(TAG, "Unknown value [%s:%d]", json_key, (uint16_t)cJSON_GetNumberValue(key));
-                //         }
-                //     }
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.sample_period", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         x200_config.analog_input[i].sample_period = (uint16_t)cJSON_GetNumberValue(key);
-                //     }
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.sample_window", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         x200_config.analog_input[i].sample_window = (uint16_t)cJSON_GetNumberValue(key);
-                //     }
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.update_period", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         x200_config.analog_input[i].update_period = (uint16_t)cJSON_GetNumberValue(key);
-                //     }
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.convert", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         if (cJSON_IsTrue(cJSON_GetObjectItem(root, json_key))) {
-                //             x200_config.analog_input[i].convert = true;
-                //         } else {
-                //             x200_config.analog_input[i].convert = false;
-                //         }                        
-                //     }                    
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.scale_min_value", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         x200_config.analog_input[i].scale_min_value = (uint16_t)cJSON_GetNumberValue(key);
-                //     }
-                //     memset(&json_key, 0, sizeof(json_key));
-                //     sprintf(json_key, "analog_input_%d.scale_max_value", i);
-                //     if (cJSON_HasObjectItem(root, json_key) == true) { 
-                //         cJSON *key = cJSON_GetObjectItem(root, json_key);
-                //         x200_config.analog_input[i].scale_max_value = (uint16_t)cJSON_GetNumberValue(key);
-                //     }                                                                                                                       
-                // }                                
-
-                /* Checking MQTT Client configuration */                
-                if (cJSON_HasObjectItem(root, "mqtt_client.mode") == true) {                    
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.mode");
-                    if (cJSON_GetNumberValue(key) == ATL_MQTT_DISABLED) {
-                        alt_config_local.mqtt_client.mode = ATL_MQTT_DISABLED;
-                    } else if (cJSON_GetNumberValue(key) == ATL_MQTT_AGROTECHLAB_CLOUD) {
-                        alt_config_local.mqtt_client.mode = ATL_MQTT_AGROTECHLAB_CLOUD;
-                    } else if (cJSON_GetNumberValue(key) == ATL_MQTT_AGROTECHLAB_CLOUD) {
-                        alt_config_local.mqtt_client.mode = ATL_MQTT_AGROTECHLAB_CLOUD;
-                    } else {
-                        ESP_LOGW(TAG, "Unknown value [mqtt_client.mode:%d]", (uint16_t)cJSON_GetNumberValue(key));
-                    }
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.broker_address") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.broker_address");
-                    strncpy((char*)&alt_config_local.mqtt_client.broker_address, (char*)cJSON_GetStringValue(key), sizeof(alt_config_local.mqtt_client.broker_address));
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.broker_port") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.broker_port");
-                    alt_config_local.mqtt_client.broker_port = (uint16_t)cJSON_GetNumberValue(key);
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.transport") == true) {                    
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.transport");
-                    if (cJSON_GetNumberValue(key) == MQTT_TRANSPORT_OVER_TCP) {
-                        alt_config_local.mqtt_client.transport = MQTT_TRANSPORT_OVER_TCP;
-                    } else if (cJSON_GetNumberValue(key) == MQTT_TRANSPORT_OVER_SSL) {
-                        alt_config_local.mqtt_client.transport = MQTT_TRANSPORT_OVER_SSL;
-                    } else {
-                        ESP_LOGW(TAG, "Unknown value [mqtt_client.transport:%d]", (uint16_t)cJSON_GetNumberValue(key));
-                    }
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.disable_cn_check") == true) {                    
-                    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "mqtt_client.disable_cn_check"))) {
-                        alt_config_local.mqtt_client.disable_cn_check = true;
-                    } else {
-                        alt_config_local.mqtt_client.disable_cn_check = false;
-                    }                    
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.user") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.user");
-                    strncpy((char*)&alt_config_local.mqtt_client.user, (char*)cJSON_GetStringValue(key), sizeof(alt_config_local.mqtt_client.user));
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.pass") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.pass");                    
-                    strncpy((char*)&alt_config_local.mqtt_client.pass, (char*)cJSON_GetStringValue(key), sizeof(alt_config_local.mqtt_client.pass));
-                }
-                if (cJSON_HasObjectItem(root, "mqtt_client.qos") == true) {                    
-                    cJSON *key = cJSON_GetObjectItem(root, "mqtt_client.qos");
-                    if (cJSON_GetNumberValue(key) == ATL_MQTT_QOS0) {
-                        alt_config_local.mqtt_client.qos = ATL_MQTT_QOS0;
-                    } else if (cJSON_GetNumberValue(key) == ATL_MQTT_QOS1) {
-                        alt_config_local.mqtt_client.qos = ATL_MQTT_QOS1;
-                    } else if (cJSON_GetNumberValue(key) == ATL_MQTT_QOS2) {
-                        alt_config_local.mqtt_client.qos = ATL_MQTT_QOS2;
-                    } else {
-                        ESP_LOGW(TAG, "Unknown value [mqtt_client.qos:%d]", (uint16_t)cJSON_GetNumberValue(key));
-                    }
-                }                                
-
-                /* Checking WiFi configuration */                
-                if (cJSON_HasObjectItem(root, "wifi.startup_mode") == true) {                    
-                    cJSON *key = cJSON_GetObjectItem(root, "wifi.startup_mode");
-                    if (cJSON_GetNumberValue(key) == ATL_WIFI_DISABLED) {
-                        alt_config_local.wifi.mode = ATL_WIFI_DISABLED;
-                    } else if (cJSON_GetNumberValue(key) == ATL_WIFI_AP_MODE) {
-                        alt_config_local.wifi.mode = ATL_WIFI_AP_MODE;
-                    } else if (cJSON_GetNumberValue(key) == ATL_WIFI_STA_MODE) {
-                        alt_config_local.wifi.mode = ATL_WIFI_STA_MODE;
-                    } else {
-                        ESP_LOGW(TAG, "Unknown value [wifi.startup_mode:%d]", (uint16_t)cJSON_GetNumberValue(key));
-                    }
-                }
-                if (cJSON_HasObjectItem(root, "wifi.sta_ssid") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "wifi.sta_ssid");
-                    strncpy((char*)&alt_config_local.wifi.sta_ssid, (char*)cJSON_GetStringValue(key), sizeof(alt_config_local.wifi.sta_ssid));
-                }
-                if (cJSON_HasObjectItem(root, "wifi.sta_pass") == true) {
-                    cJSON *key = cJSON_GetObjectItem(root, "wifi.sta_pass");
-                    strncpy((char*)&alt_config_local.wifi.sta_pass, (char*)cJSON_GetStringValue(key), sizeof(alt_config_local.wifi.sta_pass));
-                }                
-                
-                /* Checking Fimware Update configuration */                
-                if (cJSON_HasObjectItem(root, "ota.behaviour") == true) {                    
-                    cJSON *key = cJSON_GetObjectItem(root, "ota.behaviour");
-                    if (cJSON_GetNumberValue(key) == ATL_OTA_BEHAVIOUR_DISABLED) {
-                        alt_config_local.ota.behaviour = ATL_OTA_BEHAVIOUR_DISABLED;
-                    } else if (cJSON_GetNumberValue(key) == ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY) {
-                        alt_config_local.ota.behaviour = ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY;
-                    } else if (cJSON_GetNumberValue(key) == ATL_OTA_BEHAVIOU_DOWNLOAD) {
-                        alt_config_local.ota.behaviour = ATL_OTA_BEHAVIOU_DOWNLOAD;
-                    } else if (cJSON_GetNumberValue(key) == ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT) {
-                        alt_config_local.ota.behaviour = ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT;
-                    } else {
-                        ESP_LOGW(TAG, "Unknown value [ota.behaviour:%d]", (uint16_t)cJSON_GetNumberValue(key));
-                    }
-                }                
-
-                /* Update local copy to main ATL configuration structure */                
-                if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
-                    memcpy(&atl_config, &alt_config_local, sizeof(atl_config_t));
-                    xSemaphoreGive(atl_config_mutex);
-                }
-                else {
-                    ESP_LOGW(TAG, "Fail to get configuration mutex!");
-                }
-
-                /* Release memory */                
-                cJSON_Delete(root);
-                
-                /* Commit configuration to NVS */
-                atl_config_commit_nvs();                                  
-            } 
-            
-            /* Response of previous request attributes */
-            else if (strstr(event->topic, "v1/devices/me/attributes/response/") != NULL) {         
-                
-                /* Check if it is a response of previous request_id */
-                char check_event_topic[60] = {};
-                sprintf(check_event_topic, "v1/devices/me/attributes/response/%d", request_id);
-                if (strncmp(event->topic, check_event_topic, event->topic_len) != 0) {
-                    ESP_LOGW(TAG, "Received response not requested or out of order!");
-                    break;
-                }
-
-                /* Check if it is an empty message */
-                sprintf(check_event_topic, "v1/devices/me/attributes/response/%d", request_id);
-                if ((strncmp(event->data, "{}", event->data_len) == 0) || (strncmp(event->data, "[]", event->data_len) == 0)) {
-                    ESP_LOGW(TAG, "Received an empty JSON message: %.*s", event->data_len, event->data);
-                    break;
-                }
-
-                /* Parse JSON message */
-                root = NULL;            
-                root = cJSON_ParseWithLength(event->data, event->data_len);
-                if (root == NULL) {
-                    //const char *error_ptr = cJSON_GetErrorPtr();
-                    ESP_LOGW(TAG, "Invalid JSON message!");
-                    break;
-                }
-                cJSON *shared = cJSON_GetObjectItem(root, "shared");
-                cJSON *fw_version = cJSON_GetObjectItem(shared, "fw_version");
-                cJSON *fw_title = cJSON_GetObjectItem(shared, "fw_title");
-                //cJSON *fw_checksum = cJSON_GetObjectItem(shared, "fw_checksum");
-                //cJSON *fw_checksum_algorithm = cJSON_GetObjectItem(shared, "fw_checksum_algorithm");
-                cJSON *fw_size = cJSON_GetObjectItem(shared, "fw_size");
-
-                esp_app_desc_t app_info;
-                const esp_partition_t *partition_info_ptr;
-                partition_info_ptr = esp_ota_get_running_partition();
-                esp_ota_get_partition_description(partition_info_ptr, &app_info);
-                
-                // Check if running firmware is updated
-                if ((strcmp(cJSON_GetStringValue(fw_title), app_info.project_name) == 0) && (strcmp(cJSON_GetStringValue(fw_version), app_info.version) == 0)) {
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    cJSON *response;
-                    response = cJSON_CreateObject();
-                    cJSON_AddStringToObject(response, "fw_state", "UPDATED");
-                    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                    cJSON_Delete(response);
-                }
-                
-                // Check if running firmware is out of date
-                else if ((strcmp(cJSON_GetStringValue(fw_title), app_info.project_name) == 0) && (strcmp(cJSON_GetStringValue(fw_version), app_info.version) != 0)) {
-                    ESP_LOGW(TAG, "Current firmware is out of date! Current: %s - Server: %s", app_info.version, cJSON_GetStringValue(fw_version));
-
-                    // Set device to DOWNLOADING state
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    cJSON *response;
-                    response = cJSON_CreateObject();
-                    cJSON_AddStringToObject(response, "fw_state", "DOWNLOADING");
-                    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                    cJSON_Delete(response);
-
-                    // Get the first chunk of new firmware from server
-                    chunk_count = ceil(cJSON_GetNumberValue(fw_size)/chunk_size);
-                    ESP_LOGW(TAG, "Downloading firmware %s from server!", cJSON_GetStringValue(fw_version));
-                    ESP_LOGW(TAG, "Total size: %lu bytes (Chunk size: %lu bytes - Total chunks: %lu)", (uint32_t)cJSON_GetNumberValue(fw_size), chunk_size, chunk_count);
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    char fw_topic[60] = {};
-                    char fw_chunk_size[10] = {};
-                    request_id = msg_id + 1;
-                    sprintf(fw_topic, "v2/fw/request/%d/chunk/%lu", request_id, chunk_current);
-                    sprintf(fw_chunk_size, "%lu", chunk_size);
-                    msg_id = esp_mqtt_client_publish(client, fw_topic, fw_chunk_size, 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [%s], msg_id=%d", fw_topic, msg_id);
-                }
-                cJSON_Delete(root);
+            /* Resolve broker from cache (TLS keeps verifying the broker hostname) */
+            if (atl_resolver_resolve((const char*)&mqtt_client_config.broker_address, atl_mqtt_broker_ip, sizeof(atl_mqtt_broker_ip)) == ESP_OK) {
+                mqtt5_cfg.broker.address.hostname = atl_mqtt_broker_ip;
+            } else {
+                mqtt5_cfg.broker.address.hostname = (const char*)&mqtt_client_config.broker_address;
             }
 
-            /* Check if is a firmware chunk data */
-            else if (strstr(event->topic, "v2/fw/response/") != NULL) {
-                
-                /* Check if it is a response of previous request_id */
-                char check_event_topic[60] = {};
-                sprintf(check_event_topic, "v2/fw/response/%d/chunk/", request_id);
-                if (strncmp(event->topic, check_event_topic, event->topic_len) != 0) {
-                    ESP_LOGW(TAG, "Firmware chunk not requested or out of order!");
+            /* Apply keepalive adapted to network idle timeout */
+            mqtt5_cfg.session.keepalive = atl_mqtt_keepalive_get();
+            esp_mqtt_set_config(client, &mqtt5_cfg);
+            atl_mqtt_tls_lock(true);
+            break;
+        case MQTT_USER_EVENT:
+            if (event->msg_id == ATL_MQTT_USER_EVENT_TELEMETRY) {
+                atl_mqtt_publish_batches(client);
+            } else if ((event->msg_id == ATL_MQTT_USER_EVENT_HEALTH) || (event->msg_id == ATL_MQTT_USER_EVENT_ENERGY)) {
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+                if (atl_mqtt_window_defer(event->msg_id) == true) {
                     break;
                 }
-                
-                ESP_LOGI(TAG, "Chunk %lu/%lu received! (Size: %d bytes)", chunk_current + 1, chunk_count, event->data_len);
-                
-                /* If it is the first chunk of new firmware, prepare new OTA partition */
-                if (chunk_current == 0) {
-                    
-                    /* Check if boot configured partition is the same of running partition */
-                    const esp_partition_t *boot_partition = esp_ota_get_boot_partition();
-                    const esp_partition_t *running_partition = esp_ota_get_running_partition();
-                    if ((boot_partition != NULL) && (running_partition != NULL)) {
-                        if (boot_partition != running_partition) {
-                            ESP_LOGW(TAG, "Configured OTA boot partition at offset 0x%08lx, but running from offset 0x%08lx",
-                                boot_partition->address, running_partition->address);
-                            ESP_LOGW(TAG, "This can happen if either the OTA boot data or preferred boot image become corrupted somehow!");
-                        }
-                    } else {
-                        ESP_LOGE(TAG, "Fail getting boot/running partition! Boot: %s Running: %s", boot_partition->label, running_partition->label);
-                    }
-                    
-                    /* Get pointer to next partition to write new firmware */
-                    update_partition = esp_ota_get_next_update_partition(NULL);
-                    if (update_partition == NULL) {
-                        ESP_LOGE(TAG, "Fail getting update partition!");
-                        // goto fw_update_failed;
-                    } 
-
-                    /* Erase new partition to write new firmware */
-                    err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &update_handle);
-                    if (err != ESP_OK) {
-                        ESP_LOGE(TAG, "OTA begin failed! Error: (%d) %s", err, esp_err_to_name(err));
-                        esp_ota_abort(update_handle);
-                        
-                        // Set ThingsBoard to FAILED status
-                        esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                        esp_mqtt5_client_set_publish_property(client, &publish_property);
-                        cJSON *response;
-                        response = cJSON_CreateObject();
-                        cJSON_AddStringToObject(response, "fw_state", "FAILED");
-                        msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                        esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                        publish_property.user_property = NULL;
-                        ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                        cJSON_Delete(response);
-                    }
-                    ESP_LOGI(TAG, "OTA begin succeeded!");
-                }
-                
-                /* Write the first chunk at next partition */
-                err = esp_ota_write(update_handle, (const void*)event->data, event->data_len);
-                if (err != ESP_OK) {
-                    ESP_LOGE(TAG, "Fail writing chunk %lu/%lu! Error: (%d) %s", chunk_current, chunk_count, err, esp_err_to_name(err));
-                    esp_ota_abort(update_handle);
-
-                    /* Set ThingsBoard firmware update to FAILED status */
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    cJSON *response;
-                    response = cJSON_CreateObject();
-                    cJSON_AddStringToObject(response, "fw_state", "FAILED");
-                    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                    cJSON_Delete(response);                     
+#endif
+                if (event->msg_id == ATL_MQTT_USER_EVENT_HEALTH) {
+                    atl_mqtt_publish_report(client, atl_age_report, "sample age");
+                } else {
+                    atl_mqtt_publish_report(client, atl_energy_report, "energy");
                 }
-
-                /* Update chunk count */
-                chunk_current++;
-
-                /* If not all new firmware chunks was received, request next chunk */
-                if (chunk_current < chunk_count) {
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    char fw_topic[60] = {};
-                    char fw_chunk_size[10] = {};
-                    request_id = msg_id + 1;
-                    sprintf(fw_topic, "v2/fw/request/%d/chunk/%lu", request_id, chunk_current);
-                    sprintf(fw_chunk_size, "%lu", chunk_size);
-                    msg_id = esp_mqtt_client_publish(client, fw_topic, fw_chunk_size, 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [%s], msg_id=%d", fw_topic, msg_id);
-                
-                } 
-                
-                /* If all new firmware chunks was received, update status and partition boot order */
-                else if (chunk_current == chunk_count) {
-
-                    /* Set device to DOWNLOADED state */
-                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                    cJSON *response;
-                    response = cJSON_CreateObject();
-                    cJSON_AddStringToObject(response, "fw_state", "DOWNLOADED");
-                    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                    publish_property.user_property = NULL;
-                    ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                    cJSON_Delete(response);
-
-                    /* Finalize partition write and verify checksum of new firmware */
-                    err = esp_ota_end(update_handle);
-                    if (err != ESP_OK) {
-                        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
-                            ESP_LOGE(TAG, "Image validation failed, image is corrupted!");
-                        } else {
-                            ESP_LOGE(TAG, "OTA end failed! Error: (%d) %s", err, esp_err_to_name(err));
-                        }
-
-                        /* Set ThingsBoard firmware update to FAILED status */
-                        esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                        esp_mqtt5_client_set_publish_property(client, &publish_property);
-                        cJSON *response;
-                        response = cJSON_CreateObject();
-                        cJSON_AddStringToObject(response, "fw_state", "FAILED");
-                        msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                        esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                        publish_property.user_property = NULL;
-                        ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                        cJSON_Delete(response);
-                    } else {
-
-                        /* Get new partition and verify checksum of firmware writed at new partition */
-                        esp_app_desc_t new_app_info;
-                        err = esp_ota_get_partition_description(update_partition, &new_app_info);
-                        if (err != ESP_OK) {
-                            ESP_LOGE(TAG, "Fail getting update app info! Error: (%d) %s", err, esp_err_to_name(err));
-                        } else {
-                            uint8_t sha_256[32] = { 0 };  /* 32 bytes for SHA-256 digest length */
-                            err = esp_partition_get_sha256(update_partition, sha_256);
-                            if (err != ESP_OK) {
-                                ESP_LOGE(TAG, "Fail getting update SHA-256! Error: (%d) %s", err, esp_err_to_name(err));
-                            } else {
-                                char hash_print[32 * 2 + 1];
-                                memset(&hash_print, 0, sizeof(hash_print));
-                                for (uint8_t i = 0; i < 32; ++i) {
-                                    sprintf(&hash_print[i * 2], "%02x", sha_256[i]);
-                                }
-                                ESP_LOGI(TAG, "New firmware (%s at 0x%08lx - SHA256: %s)", update_partition->label, update_partition->address, hash_print);
-
-                                /* If SHA256 checked, notify ThingsBoard that firmware was VERIFIED */
-                                esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                                esp_mqtt5_client_set_publish_property(client, &publish_property);
-                                cJSON *response;
-                                response = cJSON_CreateObject();
-                                cJSON_AddStringToObject(response, "fw_state", "VERIFIED");
-                                msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                                esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                                publish_property.user_property = NULL;
-                                ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                                cJSON_Delete(response);
-
-                                /* Notify ThingsBoard that X200 will apply new firmware */
-                                esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                                esp_mqtt5_client_set_publish_property(client, &publish_property);
-                                //cJSON *response;
-                                response = cJSON_CreateObject();
-                                cJSON_AddStringToObject(response, "fw_state", "UPDATING");
-                                msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                                esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                                publish_property.user_property = NULL;
-                                ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                                cJSON_Delete(response);
-
-                                /* Update boot partition in bootloader */
-                                err = esp_ota_set_boot_partition(update_partition);
-                                if (err != ESP_OK) {
-                                    ESP_LOGE(TAG, "OTA set boot partition failed! Error: (%d) %s", err, esp_err_to_name(err));
-                                    
-                                    /* Set ThingsBoard firmware update to FAILED status */
-                                    esp_mqtt5_client_set_user_property(&publish_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
-                                    esp_mqtt5_client_set_publish_property(client, &publish_property);
-                                    cJSON *response;
-                                    response = cJSON_CreateObject();
-                                    cJSON_AddStringToObject(response, "fw_state", "FAILED");
-                                    msg_id = esp_mqtt_client_publish(client, "v1/devices/me/telemetry", cJSON_Print(response), 0, 1, 0);
-                                    esp_mqtt5_client_delete_user_property(publish_property.user_property);
-                                    publish_property.user_property = NULL;
-                                    ESP_LOGI(TAG, "Sent publish successful to [v1/devices/me/telemetry], msg_id=%d", msg_id);
-                                    cJSON_Delete(response);
-
-                                } else {
-                                    /* Restart X200 */
-                                    ESP_LOGW(TAG, "Rebooting X200!");
-                                    esp_restart();
-                                }
-                            }
-                        }
-                    }
+            } else if (event->msg_id == ATL_MQTT_USER_EVENT_KEEPALIVE) {
+                /* Connection survived, reopen it to probe a longer keepalive (applied before connection) */
+                if ((atl_mqtt_status.connected == true) && (atl_mqtt_keepalive_confirm() == true)) {
+                    esp_mqtt_client_disconnect(client);
+                    esp_mqtt_client_reconnect(client);
                 }
-            } 
-            break;
-        case MQTT_EVENT_BEFORE_CONNECT:
-            ESP_LOGI(TAG, "MQTT_EVENT_BEFORE_CONNECT");            
+            } else {
+                atl_mqtt_request_expire(client);
+            }
             break;
         case MQTT_EVENT_DELETED:
             ESP_LOGW(TAG, "MQTT_EVENT_DELETED [msg_id=%d]", event->msg_id);
+            atl_age_lost(event->msg_id);
             break;
         case MQTT_EVENT_ERROR:
             ESP_LOGE(TAG, "MQTT_EVENT_ERROR");                        
+            atl_mqtt_tls_lock(false);
+            atl_mqtt_status.errors++;
             if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) {
                 //ESP_LOGE(TAG, "Error: %s", strerror(event->error_handle->esp_transport_sock_errno));
                 ESP_LOGE(TAG, "Last error code reported from esp-tls: 0x%x", event->error_handle->esp_tls_last_esp_err);
                 ESP_LOGE(TAG, "Last tls stack error number: 0x%x", event->error_handle->esp_tls_stack_err);
                 ESP_LOGE(TAG, "Last captured errno : %d (%s)",  event->error_handle->esp_transport_sock_errno,
                      strerror(event->error_handle->esp_transport_sock_errno));
+                atl_mqtt_transport_errno = event->error_handle->esp_transport_sock_errno;
+
+                /* Cached broker address not reachable, resolve again at next connection */
+                if ((event->error_handle->esp_tls_last_esp_err == ESP_ERR_ESP_TLS_FAILED_CONNECT_TO_HOST) ||
+                    (event->error_handle->esp_tls_last_esp_err == ESP_ERR_ESP_TLS_CONNECTION_TIMEOUT)) {
+                    atl_resolver_invalidate((const char*)&mqtt_client_config.broker_address);
+                }
             } else if (event->error_handle->error_type == MQTT_ERROR_TYPE_CONNECTION_REFUSED) {
                 ESP_LOGE(TAG, "Connection refused error: 0x%x", event->error_handle->connect_return_code);
             } else if (event->error_handle->error_type == MQTT_ERROR_TYPE_SUBSCRIBE_FAILED) {
@@ -925,6 +1742,28 @@ static void atl_mqtt5_event_handler(void *handler_args, esp_event_base_t base, i
             ESP_LOGW(TAG, "MQTT_EVENT_UNKNOWN [event_id=%d]", event->event_id);
             break;
     }
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+    atl_mqtt_window_update(client);
+#endif
+    atl_energy_end(ATL_ENERGY_MQTT);
+    atl_stall_end(atl_mqtt_stall_event);
+    atl_trace_end("mqtt_event");
+}
+
+/**
+ * @fn atl_mqtt_uplink_switch_cb(atl_netmgr_uplink_e type, bool metered)
+ * @brief Active uplink changed, reconnect so the session moves to the new uplink.
+ * @details Disconnection cancels pending requests, so a firmware download in progress is aborted.
+ * @param[in] type - New uplink type
+ * @param[in] metered - New uplink is metered
+ */
+static void atl_mqtt_uplink_switch_cb(atl_netmgr_uplink_e type, bool metered) {
+    if (client == NULL) {
+        return;
+    }
+    ESP_LOGI(TAG, "Uplink switched to %s, reconnecting%s", atl_netmgr_get_active_str(), metered ? " (metered)" : "");
+    esp_mqtt_client_disconnect(client);
+    esp_mqtt_client_reconnect(client);
 }
 
 /**
@@ -954,7 +1793,7 @@ void atl_mqtt_init(void) {
     /* MQTT5 conection properties */
     esp_mqtt5_connection_property_config_t connect_property = {
         .session_expiry_interval = 10,
-        .maximum_packet_size = 1024,
+        .maximum_packet_size = ATL_MQTT_MAX_PACKET_SIZE,
         .receive_maximum = 65535,
         // .topic_alias_maximum = 2,
         // .request_resp_info = true,
@@ -968,7 +1807,6 @@ void atl_mqtt_init(void) {
     };
 
     /* Make a local copy of MQTT client configuration */
-    atl_mqtt_client_t mqtt_client_config;
     memset(&mqtt_client_config, 0, sizeof(atl_mqtt_client_t));
     if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
         memcpy(&mqtt_client_config, &atl_config.mqtt_client, sizeof(atl_mqtt_client_t));
@@ -978,15 +1816,22 @@ void atl_mqtt_init(void) {
         ESP_LOGW(TAG, "Fail to get configuration mutex!");
     }
 
-    esp_mqtt_client_config_t mqtt5_cfg = {
+    atl_mqtt_keepalive_init();
+    if (atl_mqtt_stall_event < 0) {
+        atl_mqtt_stall_event = atl_stall_register("mqtt_event", ATL_STALL_HANDLER_BUDGET);
+        atl_mqtt_stall_ota = atl_stall_register("ota_write", ATL_STALL_FLASH_BUDGET);
+    }
+    mqtt5_cfg = (esp_mqtt_client_config_t) {
         .broker.address.hostname = (const char*)&mqtt_client_config.broker_address,
         .broker.address.port = mqtt_client_config.broker_port,
         .broker.address.transport = mqtt_client_config.transport,
         // .broker.verification.certificate = (const char *)mqtt_cert_start,
         // .broker.verification.certificate_len = mqtt_cert_end - mqtt_cert_start,
         // .broker.verification.skip_cert_common_name_check = mqtt_client_config.disable_cn_check,
+        .broker.verification.common_name = (const char*)&mqtt_client_config.broker_address,
         .session.protocol_ver = MQTT_PROTOCOL_V_5,
-        .network.disable_auto_reconnect = true,
+        .session.keepalive = atl_mqtt_keepalive_get(),
+        .network.disable_auto_reconnect = false,
         .credentials.username = (const char*)&mqtt_client_config.user,
         .credentials.authentication.password = (const char*)&mqtt_client_config.pass,
         //.session.last_will.topic = "/topic/will",
@@ -1007,7 +1852,13 @@ void atl_mqtt_init(void) {
     }
     
     //esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt5_cfg);
+    if (atl_mqtt_batch_queue == NULL) {
+        atl_mqtt_batch_queue = xQueueCreate(CONFIG_ATL_MQTT_BATCH_QUEUE, sizeof(atl_mqtt_batch_t));
+    }
     client = esp_mqtt_client_init(&mqtt5_cfg);
+    atl_mqtt_request_init(client);
+    atl_json_dispatch_init(&atl_mqtt_attr_dispatch, atl_mqtt_attr_keys, sizeof(atl_mqtt_attr_keys) / sizeof(atl_json_key_t));
+    atl_mqtt_attr_group_id_mask = 1UL << atl_json_dispatch_find(&atl_mqtt_attr_dispatch, "group.id", strlen("group.id"));
 
     /* Set connection properties and user properties */
     esp_mqtt5_client_set_user_property(&connect_property.user_property, atl_user_property_arr, USE_PROPERTY_ARR_SIZE);
@@ -1023,4 +1874,69 @@ void atl_mqtt_init(void) {
     /* The last argument may be used to pass data to the event handler, in this example mqtt_event_handler */
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, atl_mqtt5_event_handler, NULL);
     esp_mqtt_client_start(client);
+    atl_mqtt_status.started = true;
+    atl_netmgr_register_switch_cb(atl_mqtt_uplink_switch_cb);
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+    atl_wifi_window_register_cb(atl_mqtt_window_cb);
+#endif
+
+    /* Sample age health report and energy report */
+#ifdef CONFIG_ATL_AGE
+    atl_mqtt_report_timer_start(&atl_mqtt_health_timer, ATL_MQTT_USER_EVENT_HEALTH, CONFIG_ATL_AGE_REPORT_INTERVAL);
+#endif
+#ifdef CONFIG_ATL_ENERGY
+    atl_mqtt_report_timer_start(&atl_mqtt_energy_timer, ATL_MQTT_USER_EVENT_ENERGY, CONFIG_ATL_ENERGY_REPORT_INTERVAL);
+#endif
+}
+
+/**
+ * @fn atl_mqtt_publish_telemetry(const char *payload, int64_t acquired_us)
+ * @brief Queue a sample batch to ThingsBoard telemetry topic (published by MQTT task with QoS 1).
+ * @details Batch age is recorded when queued, published and acknowledged by broker (see atl_age.h). With WiFi
+ *  connect on demand batches wait at queue for next publish window (opened at once when queue fills up).
+ * @param[in] payload - Telemetry JSON (copied)
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch (esp_timer_get_time())
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if MQTT client is not started, ESP_ERR_NO_MEM if queue is full, otherwise fail.
+ */
+esp_err_t atl_mqtt_publish_telemetry(const char *payload, int64_t acquired_us) {
+    if ((atl_mqtt_status.started == false) || (atl_mqtt_batch_queue == NULL)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    atl_mqtt_batch_t batch = {
+        .payload = strdup(payload),
+        .acquired_us = acquired_us,
+    };
+    if (batch.payload == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xQueueSend(atl_mqtt_batch_queue, &batch, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Sample batch queue full, batch dropped!");
+        free(batch.payload);
+        return ESP_ERR_NO_MEM;
+    }
+    atl_age_record(ATL_AGE_QUEUED, acquired_us);
+
+    /* Queue is full, do not wait for next publish window (ignored if radio is on) */
+    if (uxQueueSpacesAvailable(atl_mqtt_batch_queue) == 0) {
+        atl_wifi_window_open();
+    }
+
+    /* A failed signal is recovered by the next batch */
+    return atl_mqtt_dispatch_user_event(ATL_MQTT_USER_EVENT_TELEMETRY);
+}
+
+/**
+ * @fn atl_mqtt_get_status(atl_mqtt_status_t *status)
+ * @brief Get MQTT client status.
+ * @param[out] status - Client status
+ */
+void atl_mqtt_get_status(atl_mqtt_status_t *status) {
+    memcpy(status, &atl_mqtt_status, sizeof(atl_mqtt_status_t));
+    if (status->started == true) {
+        status->outbox_size = esp_mqtt_client_get_outbox_size(client);
+    }
+    status->keepalive = atl_mqtt_keepalive_get();
+    status->ota_active = atl_mqtt_ota.active;
+    status->ota_chunk_done = atl_mqtt_ota.chunk_done;
+    status->ota_chunk_count = atl_mqtt_ota.chunk_count;
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
  * @brief MQTT header.
  * @version 0.1.0
  * @date 2024-03-13 (created)
- * @date 2024-03-13 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -16,6 +16,11 @@
  */
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "atl_json.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +45,26 @@ typedef enum {
     ATL_MQTT_QOS2,
 } atl_mqtt_qos_e;
 
+/**
+ * @typedef atl_mqtt_status_t
+ * @brief MQTT client status (session counters since boot).
+ */
+typedef struct {
+    bool        started;        /**< MQTT client started.*/
+    bool        connected;      /**< Connected to broker.*/
+    uint32_t    connects;       /**< Connections established.*/
+    uint32_t    disconnects;    /**< Connections lost.*/
+    uint32_t    errors;         /**< Client errors reported.*/
+    uint32_t    published;      /**< QoS1/2 messages acknowledged by broker.*/
+    uint32_t    received;       /**< Messages received.*/
+    uint32_t    batches;        /**< Sample batches published.*/
+    int         outbox_size;    /**< Bytes waiting at outbox.*/
+    uint16_t    keepalive;      /**< Keepalive in use (in seconds).*/
+    bool        ota_active;     /**< Firmware download in progress.*/
+    uint32_t    ota_chunk_done; /**< Firmware chunks written.*/
+    uint32_t    ota_chunk_count;/**< Total of firmware chunks.*/
+} atl_mqtt_status_t;
+
 /**
  * @brief Get the MQTT mode string object
  * @param mode 
@@ -68,12 +93,38 @@ const char* atl_mqtt_get_transport_str(esp_mqtt_transport_t transport);
  */
 esp_mqtt_transport_t atl_mqtt_get_transport(char* transport_str);
 
+/**
+ * @fn atl_mqtt_get_attr_keys(size_t *count)
+ * @brief Get the shared attribute keys accepted from server (setters only write to the configuration copy given as context).
+ * @param[out] count - Number of keys
+ * @return const atl_json_key_t* - Key table.
+ */
+const atl_json_key_t* atl_mqtt_get_attr_keys(size_t *count);
+
 /**
  * @fn atl_mqtt_init(void)
  * @brief Initialize MQTT client service.
  */
 void atl_mqtt_init(void);
 
+/**
+ * @fn atl_mqtt_get_status(atl_mqtt_status_t *status)
+ * @brief Get MQTT client status.
+ * @param[out] status - Client status
+ */
+void atl_mqtt_get_status(atl_mqtt_status_t *status);
+
+/**
+ * @fn atl_mqtt_publish_telemetry(const char *payload, int64_t acquired_us)
+ * @brief Queue a sample batch to ThingsBoard telemetry topic (published by MQTT task with QoS 1).
+ * @details Batch age is recorded when queued, published and acknowledged by broker (see atl_age.h). With WiFi
+ *  connect on demand batches wait at queue for next publish window (opened at once when queue fills up).
+ * @param[in] payload - Telemetry JSON (copied)
+ * @param[in] acquired_us - Acquisition time of oldest sample at batch (esp_timer_get_time())
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if MQTT client is not started, ESP_ERR_NO_MEM if queue is full, otherwise fail.
+ */
+esp_err_t atl_mqtt_publish_telemetry(const char *payload, int64_t acquired_us);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+/**
+ * @file atl_mqtt_keepalive.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief MQTT adaptive keepalive functions.
+ * @details A connection that survives ATL_MQTT_KEEPALIVE_CONFIRM keepalive intervals confirms its keepalive, which
+ *  becomes safe, and the connection is reopened with the next value to probe. Keepalive is backed off only when a
+ *  connection dies with an idle cause (PINGRESP timeout or reset while the uplink is still up) after the first
+ *  keepalive interval (NAT/idle timeout dropping the idle connection). The longest confirmed value (safe) and the
+ *  shortest dropped value (ceiling) are persisted with WiFi fast connect data, so the search converges once per
+ *  network.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include "atl_wifi.h"
+#include "atl_mqtt_keepalive.h"
+#include "sdkconfig.h"
+
+/* Constants */
+static const char *TAG = "atl-mqtt-keepalive";     /**< Module identification.*/
+#define ATL_MQTT_KEEPALIVE_CONFIRM      3           /**< Keepalive intervals a connection must survive to confirm it.*/
+#define ATL_MQTT_KEEPALIVE_MAX_FAILURES 2           /**< Drops with safe keepalive before lowering it.*/
+
+/* Initial keepalive clamped to the adaptive range */
+#if CONFIG_ATL_MQTT_KEEPALIVE_MIN > CONFIG_ATL_MQTT_KEEPALIVE_MAX
+#error "CONFIG_ATL_MQTT_KEEPALIVE_MIN must not be greater than CONFIG_ATL_MQTT_KEEPALIVE_MAX"
+#elif CONFIG_ATL_MQTT_KEEPALIVE_INITIAL < CONFIG_ATL_MQTT_KEEPALIVE_MIN
+#define ATL_MQTT_KEEPALIVE_INITIAL      CONFIG_ATL_MQTT_KEEPALIVE_MIN
+#elif CONFIG_ATL_MQTT_KEEPALIVE_INITIAL > CONFIG_ATL_MQTT_KEEPALIVE_MAX
+#define ATL_MQTT_KEEPALIVE_INITIAL      CONFIG_ATL_MQTT_KEEPALIVE_MAX
+#else
+#define ATL_MQTT_KEEPALIVE_INITIAL      CONFIG_ATL_MQTT_KEEPALIVE_INITIAL
+#endif
+
+/**
+ * @typedef atl_mqtt_keepalive_t
+ * @brief Keepalive controller state.
+ */
+typedef struct {
+    uint16_t    current;        /**< Keepalive in use (in seconds).*/
+    uint16_t    safe;           /**< Longest keepalive confirmed (in seconds).*/
+    uint16_t    ceiling;        /**< Shortest keepalive dropped (in seconds, 0 if unknown).*/
+    uint8_t     safe_failures;  /**< Drops with safe keepalive.*/
+    int64_t     connected_at;   /**< Connection timestamp (in us, 0 if not connected).*/
+} atl_mqtt_keepalive_t;
+
+/* Global variables */
+static atl_mqtt_keepalive_t atl_mqtt_keepalive = {
+    .current = ATL_MQTT_KEEPALIVE_INITIAL,
+    .safe = ATL_MQTT_KEEPALIVE_INITIAL,
+};
+
+/**
+ * @fn atl_mqtt_keepalive_next_probe(void)
+ * @brief Get the next keepalive to probe (doubling while no ceiling is known, bisecting otherwise).
+ * @return uint16_t - Keepalive (in seconds), safe value if converged.
+ */
+static uint16_t atl_mqtt_keepalive_next_probe(void) {
+    uint32_t next;
+    if (atl_mqtt_keepalive.ceiling == 0) {
+        next = (uint32_t)atl_mqtt_keepalive.safe * 2;
+        if (next > CONFIG_ATL_MQTT_KEEPALIVE_MAX) {
+            next = CONFIG_ATL_MQTT_KEEPALIVE_MAX;
+        }
+    } else {
+        next = ((uint32_t)atl_mqtt_keepalive.safe + atl_mqtt_keepalive.ceiling) / 2;
+    }
+    if (next < (uint32_t)atl_mqtt_keepalive.safe + CONFIG_ATL_MQTT_KEEPALIVE_RESOLUTION) {
+        return atl_mqtt_keepalive.safe;
+    }
+    return (uint16_t)next;
+}
+
+/**
+ * @fn atl_mqtt_keepalive_init(void)
+ * @brief Initialize keepalive controller with the values learned at current network (WiFi fast connect data).
+ */
+void atl_mqtt_keepalive_init(void) {
+    atl_wifi_fast_connect_t fast_connect;
+    memset(&atl_mqtt_keepalive, 0, sizeof(atl_mqtt_keepalive_t));
+    atl_mqtt_keepalive.safe = ATL_MQTT_KEEPALIVE_INITIAL;
+    if ((atl_wifi_get_fast_connect(&fast_connect) == ESP_OK) &&
+        (fast_connect.mqtt_keepalive >= CONFIG_ATL_MQTT_KEEPALIVE_MIN) &&
+        (fast_connect.mqtt_keepalive <= CONFIG_ATL_MQTT_KEEPALIVE_MAX)) {
+        atl_mqtt_keepalive.safe = fast_connect.mqtt_keepalive;
+        if (fast_connect.mqtt_keepalive_ceiling > fast_connect.mqtt_keepalive) {
+            atl_mqtt_keepalive.ceiling = fast_connect.mqtt_keepalive_ceiling;
+        }
+    }
+    atl_mqtt_keepalive.current = atl_mqtt_keepalive.safe;
+    ESP_LOGI(TAG, "MQTT keepalive %ds (ceiling %ds)", atl_mqtt_keepalive.current, atl_mqtt_keepalive.ceiling);
+}
+
+/**
+ * @fn atl_mqtt_keepalive_get(void)
+ * @brief Get the keepalive to be used at next MQTT connection.
+ * @return uint16_t - Keepalive (in seconds).
+ */
+uint16_t atl_mqtt_keepalive_get(void) {
+    return atl_mqtt_keepalive.current;
+}
+
+/**
+ * @fn atl_mqtt_keepalive_connected(void)
+ * @brief Signal a MQTT connection established with the current keepalive (must be called from MQTT client task).
+ */
+void atl_mqtt_keepalive_connected(void) {
+    atl_mqtt_keepalive.connected_at = esp_timer_get_time();
+}
+
+/**
+ * @fn atl_mqtt_keepalive_store(uint16_t safe, uint16_t ceiling)
+ * @brief Store learned values at WiFi fast connect data if they changed.
+ * @param[in] safe - Safe keepalive before the change (in seconds)
+ * @param[in] ceiling - Keepalive ceiling before the change (in seconds)
+ */
+static void atl_mqtt_keepalive_store(uint16_t safe, uint16_t ceiling) {
+    if ((safe != atl_mqtt_keepalive.safe) || (ceiling != atl_mqtt_keepalive.ceiling)) {
+        if (atl_wifi_set_mqtt_keepalive(atl_mqtt_keepalive.safe, atl_mqtt_keepalive.ceiling) != ESP_OK) {
+            ESP_LOGW(TAG, "Fail to store MQTT keepalive!");
+        }
+    }
+}
+
+/**
+ * @fn atl_mqtt_keepalive_get_confirm_period(void)
+ * @brief Get the time a connection must survive to confirm the current keepalive.
+ * @return uint32_t - Confirm period (in seconds).
+ */
+uint32_t atl_mqtt_keepalive_get_confirm_period(void) {
+    return (uint32_t)atl_mqtt_keepalive.current * ATL_MQTT_KEEPALIVE_CONFIRM;
+}
+
+/**
+ * @fn atl_mqtt_keepalive_confirm(void)
+ * @brief Signal the connection survived the confirm period, so current keepalive is safe (must be called from MQTT client task).
+ * @details If a longer keepalive is still to be probed, the connection lifetime is no longer learned and the caller
+ *  must reopen the connection (next connection uses the probed keepalive).
+ * @return bool - True if the connection must be reopened to probe a longer keepalive.
+ */
+bool atl_mqtt_keepalive_confirm(void) {
+    uint16_t safe = atl_mqtt_keepalive.safe;
+    uint16_t ceiling = atl_mqtt_keepalive.ceiling;
+    uint16_t next;
+
+    if (atl_mqtt_keepalive.connected_at == 0) {
+        return false;
+    }
+    atl_mqtt_keepalive.safe = atl_mqtt_keepalive.current;
+    atl_mqtt_keepalive.safe_failures = 0;
+    next = atl_mqtt_keepalive_next_probe();
+    atl_mqtt_keepalive_store(safe, ceiling);
+    if (next == atl_mqtt_keepalive.current) {
+        ESP_LOGI(TAG, "Keepalive %ds confirmed (safe %ds, ceiling %ds)", atl_mqtt_keepalive.current,
+                 atl_mqtt_keepalive.safe, atl_mqtt_keepalive.ceiling);
+        return false;
+    }
+    ESP_LOGI(TAG, "Keepalive %ds confirmed, reconnecting to probe %ds (ceiling %ds)", atl_mqtt_keepalive.current,
+             next, atl_mqtt_keepalive.ceiling);
+    atl_mqtt_keepalive.current = next;
+    atl_mqtt_keepalive.connected_at = 0;
+    return true;
+}
+
+/**
+ * @fn atl_mqtt_keepalive_disconnected(bool idle)
+ * @brief Signal a MQTT disconnection and adapt keepalive to connection lifetime (must be called from MQTT client task).
+ * @details Only drops with an idle cause after the first keepalive interval are related to idle timeouts. Other
+ *  drops (uplink loss, broker restart) are ignored.
+ * @param[in] idle - Drop has an idle cause (PINGRESP timeout or connection reset while the uplink is still up)
+ */
+void atl_mqtt_keepalive_disconnected(bool idle) {
+    uint16_t safe = atl_mqtt_keepalive.safe;
+    uint16_t ceiling = atl_mqtt_keepalive.ceiling;
+    int64_t lifetime;
+
+    if (atl_mqtt_keepalive.connected_at == 0) {
+        return;
+    }
+    lifetime = (esp_timer_get_time() - atl_mqtt_keepalive.connected_at) / 1000000;
+    atl_mqtt_keepalive.connected_at = 0;
+
+    if (idle == false) {
+        ESP_LOGD(TAG, "Connection lifetime %llds, drop not related to idle timeout", lifetime);
+        return;
+    } else if (lifetime >= (int64_t)atl_mqtt_keepalive.current * ATL_MQTT_KEEPALIVE_CONFIRM) {
+        /* Connection survived, current keepalive is safe */
+        atl_mqtt_keepalive.safe = atl_mqtt_keepalive.current;
+        atl_mqtt_keepalive.safe_failures = 0;
+        atl_mqtt_keepalive.current = atl_mqtt_keepalive_next_probe();
+    } else if (lifetime >= atl_mqtt_keepalive.current) {
+        /* Idle connection dropped */
+        if (atl_mqtt_keepalive.current > atl_mqtt_keepalive.safe) {
+            atl_mqtt_keepalive.ceiling = atl_mqtt_keepalive.current;
+            atl_mqtt_keepalive.current = atl_mqtt_keepalive.safe;
+        } else if (++atl_mqtt_keepalive.safe_failures >= ATL_MQTT_KEEPALIVE_MAX_FAILURES) {
+            /* Network changed its idle timeout, restart the search below */
+            atl_mqtt_keepalive.ceiling = atl_mqtt_keepalive.safe;
+            atl_mqtt_keepalive.safe = atl_mqtt_keepalive.safe / 2;
+            if (atl_mqtt_keepalive.safe < CONFIG_ATL_MQTT_KEEPALIVE_MIN) {
+                atl_mqtt_keepalive.safe = CONFIG_ATL_MQTT_KEEPALIVE_MIN;
+            }
+            if (atl_mqtt_keepalive.ceiling <= atl_mqtt_keepalive.safe) {
+                atl_mqtt_keepalive.ceiling = 0;
+            }
+            atl_mqtt_keepalive.safe_failures = 0;
+            atl_mqtt_keepalive.current = atl_mqtt_keepalive.safe;
+        }
+    } else {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Connection lifetime %llds, next keepalive %ds (safe %ds, ceiling %ds)", lifetime,
+             atl_mqtt_keepalive.current, atl_mqtt_keepalive.safe, atl_mqtt_keepalive.ceiling);
+    atl_mqtt_keepalive_store(safe, ceiling);
+}
+
+/**
+ * @fn atl_mqtt_keepalive_closed(void)
+ * @brief Signal a MQTT connection closed on purpose (its lifetime is not learned).
+ */
+void atl_mqtt_keepalive_closed(void) {
+    atl_mqtt_keepalive.connected_at = 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file atl_mqtt_keepalive.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief MQTT adaptive keepalive header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @fn atl_mqtt_keepalive_init(void)
+ * @brief Initialize keepalive controller with the values learned at current network (WiFi fast connect data).
+ */
+void atl_mqtt_keepalive_init(void);
+
+/**
+ * @fn atl_mqtt_keepalive_get(void)
+ * @brief Get the keepalive to be used at next MQTT connection.
+ * @return uint16_t - Keepalive (in seconds).
+ */
+uint16_t atl_mqtt_keepalive_get(void);
+
+/**
+ * @fn atl_mqtt_keepalive_connected(void)
+ * @brief Signal a MQTT connection established with the current keepalive (must be called from MQTT client task).
+ */
+void atl_mqtt_keepalive_connected(void);
+
+/**
+ * @fn atl_mqtt_keepalive_get_confirm_period(void)
+ * @brief Get the time a connection must survive to confirm the current keepalive.
+ * @return uint32_t - Confirm period (in seconds).
+ */
+uint32_t atl_mqtt_keepalive_get_confirm_period(void);
+
+/**
+ * @fn atl_mqtt_keepalive_confirm(void)
+ * @brief Signal the connection survived the confirm period, so current keepalive is safe (must be called from MQTT client task).
+ * @return bool - True if the connection must be reopened to probe a longer keepalive.
+ */
+bool atl_mqtt_keepalive_confirm(void);
+
+/**
+ * @fn atl_mqtt_keepalive_disconnected(bool idle)
+ * @brief Signal a MQTT disconnection and adapt keepalive to connection lifetime (must be called from MQTT client task).
+ * @param[in] idle - Drop has an idle cause (PINGRESP timeout or connection reset while the uplink is still up)
+ */
+void atl_mqtt_keepalive_disconnected(bool idle);
+
+/**
+ * @fn atl_mqtt_keepalive_closed(void)
+ * @brief Signal a MQTT connection closed on purpose (its lifetime is not learned).
+ */
+void atl_mqtt_keepalive_closed(void);
+
+#ifdef __cplusplus
+}
+#endif
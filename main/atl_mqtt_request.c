@@ -0,0 +1,415 @@
+/**
+ * @file atl_mqtt_request.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief MQTT request/response functions.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <mqtt_client.h>
+#include "atl_mqtt_request.h"
+#include "sdkconfig.h"
+
+/* Constants */
+static const char *TAG = "atl-mqtt-request";       /**< Module identification.*/
+#define ATL_MQTT_REQUEST_TOPIC_LEN      80          /**< Max. request/response topic length.*/
+#define ATL_MQTT_REQUEST_RETRY_DELAY    250         /**< Expiration signal retry delay if MQTT task queue is full (in ms).*/
+
+/**
+ * @typedef atl_mqtt_request_t
+ * @brief Outstanding request.
+ */
+typedef struct {
+    bool                    in_use;                                         /**< Slot in use.*/
+    int                     id;                                             /**< Request id.*/
+    uint32_t                timeout_ms;                                     /**< Request timeout.*/
+    int64_t                 deadline;                                       /**< Request deadline (in us).*/
+    atl_mqtt_request_cb_t   cb;                                             /**< Response callback.*/
+    void                    *arg;                                           /**< Callback argument.*/
+    char                    response_topic[ATL_MQTT_REQUEST_TOPIC_LEN];     /**< Expected response topic.*/
+} atl_mqtt_request_t;
+
+/* Global variables */
+static atl_mqtt_request_t atl_mqtt_request_table[CONFIG_ATL_MQTT_REQUEST_MAX];
+static SemaphoreHandle_t atl_mqtt_request_mutex = NULL;
+static esp_timer_handle_t atl_mqtt_request_timer = NULL;
+static esp_mqtt_client_handle_t atl_mqtt_request_client = NULL;
+static int atl_mqtt_request_last_id = 0;
+static bool atl_mqtt_request_expire_pending = false;
+
+/**
+ * @fn atl_mqtt_request_find(int request_id)
+ * @brief Find an outstanding request (mutex must be held).
+ * @param[in] request_id - Request id
+ * @return atl_mqtt_request_t* - Request slot if found, otherwise NULL.
+ */
+static atl_mqtt_request_t* atl_mqtt_request_find(int request_id) {
+    for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+        if ((atl_mqtt_request_table[i].in_use == true) && (atl_mqtt_request_table[i].id == request_id)) {
+            return &atl_mqtt_request_table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn atl_mqtt_request_arm(bool retry)
+ * @brief Arm the deadline timer for the nearest outstanding request deadline (mutex must be held).
+ * @details The timer is one-shot and stays stopped without outstanding requests (or while an expiration signal waits for
+ *  MQTT client task), so it does not wake the chip from light sleep while idle.
+ * @param[in] retry - Wait at least ATL_MQTT_REQUEST_RETRY_DELAY (expiration signal was not accepted)
+ */
+static void atl_mqtt_request_arm(bool retry) {
+    int64_t deadline = INT64_MAX;
+    esp_timer_stop(atl_mqtt_request_timer);
+    if (atl_mqtt_request_expire_pending == true) {
+        return;
+    }
+    for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+        if ((atl_mqtt_request_table[i].in_use == true) && (atl_mqtt_request_table[i].deadline < deadline)) {
+            deadline = atl_mqtt_request_table[i].deadline;
+        }
+    }
+    if (deadline == INT64_MAX) {
+        return;
+    }
+    int64_t delay = deadline - esp_timer_get_time();
+    int64_t min_delay = (retry == true) ? (ATL_MQTT_REQUEST_RETRY_DELAY * 1000) : 1000;
+    esp_timer_start_once(atl_mqtt_request_timer, (delay > min_delay) ? delay : min_delay);
+}
+
+/**
+ * @fn atl_mqtt_request_timer_cb(void *arg)
+ * @brief Check outstanding request deadlines (timer armed for the nearest one).
+ * @details Runs at esp_timer task, so expired requests are only signaled to MQTT client task (MQTT_USER_EVENT) where
+ *  callbacks are called. The timer is armed again when expired requests are released.
+ * @param[in] arg - Not used
+ */
+static void atl_mqtt_request_timer_cb(void *arg) {
+    bool expired = false;
+    int64_t now = esp_timer_get_time();
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        if (atl_mqtt_request_expire_pending == false) {
+            for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+                if ((atl_mqtt_request_table[i].in_use == true) && (atl_mqtt_request_table[i].deadline <= now)) {
+                    expired = true;
+                    atl_mqtt_request_expire_pending = true;
+                    break;
+                }
+            }
+
+            /* Deadline was refreshed (response fragment received) */
+            if (expired == false) {
+                atl_mqtt_request_arm(false);
+            }
+        }
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    if (expired == true) {
+        esp_mqtt_event_t event = {
+            .event_id = MQTT_USER_EVENT,
+            .client = atl_mqtt_request_client,
+        };
+        if (esp_mqtt_dispatch_custom_event(atl_mqtt_request_client, &event) != ESP_OK) {
+            if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+                atl_mqtt_request_expire_pending = false;
+                atl_mqtt_request_arm(true);
+                xSemaphoreGive(atl_mqtt_request_mutex);
+            }
+        }
+    }
+}
+
+/**
+ * @fn atl_mqtt_request_release(bool expired_only, atl_mqtt_request_status_e status, esp_mqtt_client_handle_t client)
+ * @brief Release outstanding requests and notify their callbacks (outside the mutex).
+ * @param[in] expired_only - Release only requests with deadline expired
+ * @param[in] status - Status reported to callbacks
+ * @param[in] client - MQTT client handle
+ */
+static void atl_mqtt_request_release(bool expired_only, atl_mqtt_request_status_e status, esp_mqtt_client_handle_t client) {
+    atl_mqtt_request_t released[CONFIG_ATL_MQTT_REQUEST_MAX];
+    uint8_t released_count = 0;
+    int64_t now = esp_timer_get_time();
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+            if ((atl_mqtt_request_table[i].in_use == true) && ((expired_only == false) || (atl_mqtt_request_table[i].deadline <= now))) {
+                memcpy(&released[released_count++], &atl_mqtt_request_table[i], sizeof(atl_mqtt_request_t));
+                atl_mqtt_request_table[i].in_use = false;
+            }
+        }
+        if (expired_only == true) {
+            atl_mqtt_request_expire_pending = false;
+        }
+        atl_mqtt_request_arm(false);
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    for (uint8_t i = 0; i < released_count; i++) {
+        ESP_LOGW(TAG, "Request %d [%s] %s", released[i].id, released[i].response_topic, (status == ATL_MQTT_REQUEST_TIMEOUT) ? "timed out" : "cancelled");
+        if (released[i].cb != NULL) {
+            released[i].cb(client, status, NULL, 0, 0, 0, released[i].arg);
+        }
+    }
+}
+
+/**
+ * @fn atl_mqtt_request_init(esp_mqtt_client_handle_t client)
+ * @brief Initialize the outstanding request table and its deadline timer (armed only while requests are outstanding).
+ * @param[in] client - MQTT client handle
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_mqtt_request_init(esp_mqtt_client_handle_t client) {
+    esp_err_t err = ESP_OK;
+    atl_mqtt_request_client = client;
+    memset(&atl_mqtt_request_table, 0, sizeof(atl_mqtt_request_table));
+    if (atl_mqtt_request_mutex == NULL) {
+        atl_mqtt_request_mutex = xSemaphoreCreateMutex();
+        if (atl_mqtt_request_mutex == NULL) {
+            ESP_LOGE(TAG, "Fail creating request table mutex!");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (atl_mqtt_request_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = &atl_mqtt_request_timer_cb,
+            .name = "atl_mqtt_req",
+        };
+        err = esp_timer_create(&timer_args, &atl_mqtt_request_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fail creating request timer! Error: (%d) %s", err, esp_err_to_name(err));
+            return err;
+        }
+    }
+    return err;
+}
+
+/**
+ * @fn atl_mqtt_request_send(esp_mqtt_client_handle_t client, const esp_mqtt5_publish_property_config_t *property, const char *request_topic, const char *response_topic, const char *topic_suffix, const char *data, int data_len, int qos, uint32_t timeout_ms, atl_mqtt_request_cb_t cb, void *arg)
+ * @brief Publish a request and register it at the outstanding request table.
+ * @details Request and response topics are built as "<topic>/<request id><topic_suffix>" (ThingsBoard RPC style). The
+ *  request is also tagged with MQTT5 response topic and correlation data (request id).
+ * @param[in] client - MQTT client handle
+ * @param[in] property - Base MQTT5 publish property (restored after publish)
+ * @param[in] request_topic - Request topic prefix
+ * @param[in] response_topic - Response topic prefix
+ * @param[in] topic_suffix - Topic suffix appended after request id (may be NULL)
+ * @param[in] data - Request payload
+ * @param[in] data_len - Request payload length (0 to use strlen)
+ * @param[in] qos - Request QoS
+ * @param[in] timeout_ms - Time to wait for a response (0 to use CONFIG_ATL_MQTT_REQUEST_TIMEOUT)
+ * @param[in] cb - Response callback
+ * @param[in] arg - Callback argument
+ * @return int - Request id (> 0) if success, otherwise -1 (table full or publish fail).
+ */
+int atl_mqtt_request_send(esp_mqtt_client_handle_t client, const esp_mqtt5_publish_property_config_t *property, const char *request_topic, const char *response_topic, const char *topic_suffix, const char *data, int data_len, int qos, uint32_t timeout_ms, atl_mqtt_request_cb_t cb, void *arg) {
+    atl_mqtt_request_t *request = NULL;
+    int request_id = -1;
+    char topic[ATL_MQTT_REQUEST_TOPIC_LEN] = {};
+    char expected_topic[ATL_MQTT_REQUEST_TOPIC_LEN] = {};
+    char correlation_data[12] = {};
+
+    if (timeout_ms == 0) {
+        timeout_ms = CONFIG_ATL_MQTT_REQUEST_TIMEOUT;
+    }
+    if (topic_suffix == NULL) {
+        topic_suffix = "";
+    }
+
+    /* Get a free slot at outstanding request table */
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+            if (atl_mqtt_request_table[i].in_use == false) {
+                request = &atl_mqtt_request_table[i];
+                break;
+            }
+        }
+        if (request != NULL) {
+            if (++atl_mqtt_request_last_id <= 0) {
+                atl_mqtt_request_last_id = 1;
+            }
+            request_id = atl_mqtt_request_last_id;
+            request->in_use = true;
+            request->id = request_id;
+            request->timeout_ms = timeout_ms;
+            request->deadline = esp_timer_get_time() + ((int64_t)timeout_ms * 1000);
+            request->cb = cb;
+            request->arg = arg;
+            snprintf(request->response_topic, sizeof(request->response_topic), "%s/%d%s", response_topic, request_id, topic_suffix);
+            memcpy(expected_topic, request->response_topic, sizeof(expected_topic));
+            atl_mqtt_request_arm(false);
+        }
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    if (request == NULL) {
+        ESP_LOGW(TAG, "Outstanding request table full (%d requests)!", CONFIG_ATL_MQTT_REQUEST_MAX);
+        return -1;
+    }
+
+    /* Tag request with MQTT5 response topic and correlation data */
+    esp_mqtt5_publish_property_config_t request_property = {};
+    if (property != NULL) {
+        memcpy(&request_property, property, sizeof(esp_mqtt5_publish_property_config_t));
+    }
+    snprintf(correlation_data, sizeof(correlation_data), "%d", request_id);
+    request_property.response_topic = expected_topic;
+    request_property.correlation_data = correlation_data;
+    request_property.correlation_data_len = strlen(correlation_data);
+    esp_mqtt5_client_set_publish_property(client, &request_property);
+
+    /* Publish request */
+    snprintf(topic, sizeof(topic), "%s/%d%s", request_topic, request_id, topic_suffix);
+    int msg_id = esp_mqtt_client_publish(client, topic, data, data_len, qos, 0);
+
+    /* Restore base publish property (response topic and correlation data are stack allocated) */
+    memset(&request_property, 0, sizeof(esp_mqtt5_publish_property_config_t));
+    esp_mqtt5_client_set_publish_property(client, (property != NULL) ? property : &request_property);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Fail publishing request to [%s]!", topic);
+        if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+            request = atl_mqtt_request_find(request_id);
+            if (request != NULL) {
+                request->in_use = false;
+                atl_mqtt_request_arm(false);
+            }
+            xSemaphoreGive(atl_mqtt_request_mutex);
+        }
+        return -1;
+    }
+    ESP_LOGI(TAG, "Sent request %d to [%s], msg_id=%d", request_id, topic, msg_id);
+    return request_id;
+}
+
+/**
+ * @fn atl_mqtt_request_match(esp_mqtt_event_handle_t event)
+ * @brief Find the outstanding request answered by an inbound message (first fragment).
+ * @details MQTT5 correlation data is used if sent back, otherwise the message topic is compared with the expected
+ *  response topic.
+ * @param[in] event - MQTT event (MQTT_EVENT_DATA with offset 0)
+ * @return int - Request id if found, otherwise -1.
+ */
+int atl_mqtt_request_match(esp_mqtt_event_handle_t event) {
+    int request_id = -1;
+    int correlation_id = -1;
+
+    /* Correlation data echoed by responder */
+    if ((event->property != NULL) && (event->property->correlation_data != NULL) &&
+        (event->property->correlation_data_len > 0) && (event->property->correlation_data_len < 12)) {
+        char correlation_data[12] = {};
+        memcpy(correlation_data, event->property->correlation_data, event->property->correlation_data_len);
+        correlation_id = atoi(correlation_data);
+    }
+
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+            atl_mqtt_request_t *request = &atl_mqtt_request_table[i];
+            if (request->in_use == false) {
+                continue;
+            }
+            if (correlation_id > 0) {
+                if (request->id == correlation_id) {
+                    request_id = request->id;
+                    break;
+                }
+            } else if ((strlen(request->response_topic) == event->topic_len) &&
+                       (strncmp(request->response_topic, event->topic, event->topic_len) == 0)) {
+                request_id = request->id;
+                break;
+            }
+        }
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    return request_id;
+}
+
+/**
+ * @fn atl_mqtt_request_deliver(esp_mqtt_client_handle_t client, int request_id, const char *data, int data_len, int offset, int total_len)
+ * @brief Deliver a response (or response fragment) to the request callback.
+ * @details The request deadline is refreshed on each fragment and the request is released at the last one.
+ * @param[in] client - MQTT client handle
+ * @param[in] request_id - Request id (from atl_mqtt_request_match)
+ * @param[in] data - Response data
+ * @param[in] data_len - Response data length
+ * @param[in] offset - Fragment offset
+ * @param[in] total_len - Response total length
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if request is no longer outstanding.
+ */
+esp_err_t atl_mqtt_request_deliver(esp_mqtt_client_handle_t client, int request_id, const char *data, int data_len, int offset, int total_len) {
+    atl_mqtt_request_cb_t cb = NULL;
+    void *arg = NULL;
+    bool found = false;
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_mqtt_request_t *request = atl_mqtt_request_find(request_id);
+        if (request != NULL) {
+            found = true;
+            cb = request->cb;
+            arg = request->arg;
+            if ((offset + data_len) >= total_len) {
+                request->in_use = false;
+                atl_mqtt_request_arm(false);
+            } else {
+                request->deadline = esp_timer_get_time() + ((int64_t)request->timeout_ms * 1000);
+            }
+        }
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    if (found == false) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (cb != NULL) {
+        cb(client, ATL_MQTT_REQUEST_RESPONSE, data, data_len, offset, total_len, arg);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_mqtt_request_expire(esp_mqtt_client_handle_t client)
+ * @brief Release expired requests and notify their callbacks (must be called from MQTT client task).
+ * @param[in] client - MQTT client handle
+ */
+void atl_mqtt_request_expire(esp_mqtt_client_handle_t client) {
+    atl_mqtt_request_release(true, ATL_MQTT_REQUEST_TIMEOUT, client);
+}
+
+/**
+ * @fn atl_mqtt_request_cancel_all(esp_mqtt_client_handle_t client)
+ * @brief Release all outstanding requests and notify their callbacks (i.e. on disconnection).
+ * @param[in] client - MQTT client handle
+ */
+void atl_mqtt_request_cancel_all(esp_mqtt_client_handle_t client) {
+    atl_mqtt_request_release(false, ATL_MQTT_REQUEST_CANCELLED, client);
+}
+
+/**
+ * @fn atl_mqtt_request_pending(void)
+ * @brief Get the number of outstanding requests.
+ * @return uint8_t - Outstanding requests.
+ */
+uint8_t atl_mqtt_request_pending(void) {
+    uint8_t pending = 0;
+    if (xSemaphoreTake(atl_mqtt_request_mutex, portMAX_DELAY) == pdTRUE) {
+        for (uint8_t i = 0; i < CONFIG_ATL_MQTT_REQUEST_MAX; i++) {
+            if (atl_mqtt_request_table[i].in_use == true) {
+                pending++;
+            }
+        }
+        xSemaphoreGive(atl_mqtt_request_mutex);
+    }
+    return pending;
+}
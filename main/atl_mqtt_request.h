@@ -0,0 +1,118 @@
+/**
+ * @file atl_mqtt_request.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief MQTT request/response header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <mqtt_client.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef atl_mqtt_request_status_e
+ * @brief Outstanding request status (reported to request callback).
+ */
+typedef enum {
+    ATL_MQTT_REQUEST_RESPONSE,      /**< Response (or response fragment) received.*/
+    ATL_MQTT_REQUEST_TIMEOUT,       /**< No response received until request deadline.*/
+    ATL_MQTT_REQUEST_CANCELLED,     /**< Request cancelled (i.e. MQTT disconnected).*/
+} atl_mqtt_request_status_e;
+
+/**
+ * @typedef atl_mqtt_request_cb_t
+ * @brief Request callback, always called from MQTT client task.
+ * @details Large responses are delivered fragment by fragment (offset/total_len), the request is released after
+ *  the last fragment. For TIMEOUT and CANCELLED status data is NULL.
+ */
+typedef void (*atl_mqtt_request_cb_t)(esp_mqtt_client_handle_t client, atl_mqtt_request_status_e status, const char *data, int data_len, int offset, int total_len, void *arg);
+
+/**
+ * @fn atl_mqtt_request_init(esp_mqtt_client_handle_t client)
+ * @brief Initialize the outstanding request table and its timeout timer.
+ * @param[in] client - MQTT client handle
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_mqtt_request_init(esp_mqtt_client_handle_t client);
+
+/**
+ * @fn atl_mqtt_request_send(esp_mqtt_client_handle_t client, const esp_mqtt5_publish_property_config_t *property, const char *request_topic, const char *response_topic, const char *topic_suffix, const char *data, int data_len, int qos, uint32_t timeout_ms, atl_mqtt_request_cb_t cb, void *arg)
+ * @brief Publish a request and register it at the outstanding request table.
+ * @details Request and response topics are built as "<topic>/<request id><topic_suffix>" (ThingsBoard RPC style). The
+ *  request is also tagged with MQTT5 response topic and correlation data (request id).
+ * @param[in] client - MQTT client handle
+ * @param[in] property - Base MQTT5 publish property (restored after publish)
+ * @param[in] request_topic - Request topic prefix
+ * @param[in] response_topic - Response topic prefix
+ * @param[in] topic_suffix - Topic suffix appended after request id (may be NULL)
+ * @param[in] data - Request payload
+ * @param[in] data_len - Request payload length (0 to use strlen)
+ * @param[in] qos - Request QoS
+ * @param[in] timeout_ms - Time to wait for a response (0 to use CONFIG_ATL_MQTT_REQUEST_TIMEOUT)
+ * @param[in] cb - Response callback
+ * @param[in] arg - Callback argument
+ * @return int - Request id (> 0) if success, otherwise -1 (table full or publish fail).
+ */
+int atl_mqtt_request_send(esp_mqtt_client_handle_t client, const esp_mqtt5_publish_property_config_t *property, const char *request_topic, const char *response_topic, const char *topic_suffix, const char *data, int data_len, int qos, uint32_t timeout_ms, atl_mqtt_request_cb_t cb, void *arg);
+
+/**
+ * @fn atl_mqtt_request_match(esp_mqtt_event_handle_t event)
+ * @brief Find the outstanding request answered by an inbound message (first fragment).
+ * @details MQTT5 correlation data is used if sent back, otherwise the message topic is compared with the expected
+ *  response topic.
+ * @param[in] event - MQTT event (MQTT_EVENT_DATA with offset 0)
+ * @return int - Request id if found, otherwise -1.
+ */
+int atl_mqtt_request_match(esp_mqtt_event_handle_t event);
+
+/**
+ * @fn atl_mqtt_request_deliver(esp_mqtt_client_handle_t client, int request_id, const char *data, int data_len, int offset, int total_len)
+ * @brief Deliver a response (or response fragment) to the request callback.
+ * @details The request deadline is refreshed on each fragment and the request is released at the last one.
+ * @param[in] client - MQTT client handle
+ * @param[in] request_id - Request id (from atl_mqtt_request_match)
+ * @param[in] data - Response data
+ * @param[in] data_len - Response data length
+ * @param[in] offset - Fragment offset
+ * @param[in] total_len - Response total length
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if request is no longer outstanding.
+ */
+esp_err_t atl_mqtt_request_deliver(esp_mqtt_client_handle_t client, int request_id, const char *data, int data_len, int offset, int total_len);
+
+/**
+ * @fn atl_mqtt_request_expire(esp_mqtt_client_handle_t client)
+ * @brief Release expired requests and notify their callbacks (must be called from MQTT client task).
+ * @param[in] client - MQTT client handle
+ */
+void atl_mqtt_request_expire(esp_mqtt_client_handle_t client);
+
+/**
+ * @fn atl_mqtt_request_cancel_all(esp_mqtt_client_handle_t client)
+ * @brief Release all outstanding requests and notify their callbacks (i.e. on disconnection).
+ * @param[in] client - MQTT client handle
+ */
+void atl_mqtt_request_cancel_all(esp_mqtt_client_handle_t client);
+
+/**
+ * @fn atl_mqtt_request_pending(void)
+ * @brief Get the number of outstanding requests.
+ * @return uint8_t - Outstanding requests.
+ */
+uint8_t atl_mqtt_request_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,452 @@
+/**
+ * @file atl_netmgr.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Network manager (multiple uplinks with failover).
+ * @details Each uplink is health checked with a TCP connection to the MQTT broker bound to its interface. While the
+ *  MQTT session is up the active uplink is not probed (session keepalive is the health signal, no probe traffic on
+ *  metered uplinks). The best healthy uplink (unmetered first, then lowest priority value) becomes the default
+ *  route and the switch callbacks are called so sessions move to it. Link events and session loss trigger an
+ *  immediate check, so failover does not wait for the check interval. Standby metered uplinks are only probed when
+ *  no unmetered uplink is healthy, and one successful probe is enough while the active uplink is down.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_event.h>
+#include <esp_wifi.h>
+#include <esp_netif.h>
+#include <lwip/sockets.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
+#include "atl_resolver.h"
+#include "atl_netmgr.h"
+
+#define ATL_NETMGR_RECOVER_COUNT    2       /* Successful probes to consider an uplink healthy again (active uplink healthy) */
+
+/* Constants */
+static const char *TAG = "atl-netmgr";
+static const char *atl_netmgr_uplink_str[] = {
+    "wifi",
+    "ethernet",
+    "cellular",
+};
+
+/**
+ * @typedef atl_netmgr_uplink_t
+ * @brief Registered uplink.
+ */
+typedef struct {
+    atl_netmgr_uplink_e type;           /**< Uplink type.*/
+    esp_netif_t         *netif;         /**< Uplink network interface.*/
+    uint8_t             priority;       /**< Uplink priority (lower is preferred).*/
+    bool                metered;        /**< Uplink traffic is charged.*/
+    bool                up;             /**< Link up with IP address.*/
+    bool                healthy;        /**< Broker reachable through the uplink.*/
+    uint8_t             fails;          /**< Consecutive probe failures.*/
+    uint8_t             successes;      /**< Consecutive probe successes.*/
+} atl_netmgr_uplink_t;
+
+/* Global variables */
+static atl_netmgr_uplink_t atl_netmgr_uplinks[ATL_NETMGR_MAX_UPLINKS];
+static uint8_t atl_netmgr_uplink_count = 0;
+static atl_netmgr_uplink_t *atl_netmgr_active = NULL;
+static atl_netmgr_switch_cb_t atl_netmgr_callbacks[ATL_NETMGR_MAX_CALLBACKS];
+static uint8_t atl_netmgr_callback_count = 0;
+static SemaphoreHandle_t atl_netmgr_mutex = NULL;
+static TaskHandle_t atl_netmgr_task_handle = NULL;
+static bool atl_netmgr_events_registered = false;
+static bool atl_netmgr_session_up = false;      /* Broker session up through the active uplink */
+
+/* Global external variables */
+extern atl_config_t atl_config;
+
+/**
+ * @fn atl_netmgr_find(esp_netif_t *netif)
+ * @brief Find the uplink of a network interface (mutex must be held).
+ * @param[in] netif - Network interface
+ * @return atl_netmgr_uplink_t* - Uplink if registered, otherwise NULL.
+ */
+static atl_netmgr_uplink_t* atl_netmgr_find(esp_netif_t *netif) {
+    for (uint8_t i = 0; i < atl_netmgr_uplink_count; i++) {
+        if (atl_netmgr_uplinks[i].netif == netif) {
+            return &atl_netmgr_uplinks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn atl_netmgr_event_handler(void* handler_args, esp_event_base_t event_base, int32_t event_id, void* event_data)
+ * @brief Link event handler, updates uplink state and wakes up the health check task.
+ * @param[in] handler_args - Not used
+ * @param[in] event_base - Event base (IP_EVENT or WIFI_EVENT)
+ * @param[in] event_id - Event id
+ * @param[in] event_data - Event data
+ */
+static void atl_netmgr_event_handler(void* handler_args, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    atl_netmgr_uplink_t *uplink = NULL;
+    bool changed = false;
+    if (xSemaphoreTake(atl_netmgr_mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    if (event_base == IP_EVENT) {
+        if ((event_id == IP_EVENT_STA_GOT_IP) || (event_id == IP_EVENT_ETH_GOT_IP) || (event_id == IP_EVENT_PPP_GOT_IP)) {
+            ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+            uplink = atl_netmgr_find(event->esp_netif);
+            if (uplink != NULL) {
+                uplink->up = true;
+                uplink->fails = 0;
+                uplink->successes = 0;
+                changed = true;
+            }
+        } else if ((event_id == IP_EVENT_STA_LOST_IP) || (event_id == IP_EVENT_ETH_LOST_IP) || (event_id == IP_EVENT_PPP_LOST_IP)) {
+            ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+            uplink = atl_netmgr_find(event->esp_netif);
+            if (uplink != NULL) {
+                uplink->up = false;
+                uplink->healthy = false;
+                changed = true;
+            }
+        }
+    } else if ((event_base == WIFI_EVENT) && (event_id == WIFI_EVENT_STA_DISCONNECTED)) {
+        /* WiFi keeps its address for a while after disconnection, do not wait for IP lost event */
+        for (uint8_t i = 0; i < atl_netmgr_uplink_count; i++) {
+            if ((atl_netmgr_uplinks[i].type == ATL_NETMGR_UPLINK_WIFI) && (atl_netmgr_uplinks[i].up == true)) {
+                uplink = &atl_netmgr_uplinks[i];
+                uplink->up = false;
+                uplink->healthy = false;
+                changed = true;
+            }
+        }
+    }
+    xSemaphoreGive(atl_netmgr_mutex);
+    if ((changed == true) && (atl_netmgr_task_handle != NULL)) {
+        ESP_LOGI(TAG, "Uplink %s is %s", atl_netmgr_uplink_str[uplink->type], uplink->up ? "up" : "down");
+        xTaskNotifyGive(atl_netmgr_task_handle);
+    }
+}
+
+/**
+ * @fn atl_netmgr_probe(esp_netif_t *netif, const char *ip, uint16_t port)
+ * @brief Check if a TCP connection can be opened through a network interface.
+ * @param[in] netif - Network interface
+ * @param[in] ip - Destination address (if empty only interface address is checked)
+ * @param[in] port - Destination port
+ * @return bool - True if reachable.
+ */
+static bool atl_netmgr_probe(esp_netif_t *netif, const char *ip, uint16_t port) {
+    esp_netif_ip_info_t ip_info;
+    struct ifreq ifr;
+    bool reachable = false;
+    if ((esp_netif_get_ip_info(netif, &ip_info) != ESP_OK) || (ip_info.ip.addr == 0)) {
+        return false;
+    }
+    if (ip[0] == '\0') {
+        return true;
+    }
+
+    /* Open a socket bound to the uplink interface */
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return false;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    esp_netif_get_netif_impl_name(netif, ifr.ifr_name);
+    setsockopt(sock, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr));
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    struct sockaddr_in dest_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+    };
+    inet_pton(AF_INET, ip, &dest_addr.sin_addr);
+
+    /* Non-blocking connect with timeout */
+    if (connect(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) == 0) {
+        reachable = true;
+    } else if (errno == EINPROGRESS) {
+        fd_set wfds;
+        struct timeval timeout = {
+            .tv_sec = CONFIG_ATL_NETMGR_PROBE_TIMEOUT / 1000,
+            .tv_usec = (CONFIG_ATL_NETMGR_PROBE_TIMEOUT % 1000) * 1000,
+        };
+        FD_ZERO(&wfds);
+        FD_SET(sock, &wfds);
+        if (select(sock + 1, NULL, &wfds, NULL, &timeout) > 0) {
+            int sock_err = 0;
+            socklen_t len = sizeof(sock_err);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &sock_err, &len);
+            reachable = (sock_err == 0);
+        }
+    }
+    close(sock);
+    return reachable;
+}
+
+/**
+ * @fn atl_netmgr_check(void)
+ * @brief Probe uplinks and move the default route to the best healthy one.
+ */
+static void atl_netmgr_check(void) {
+    char broker_ip[ATL_RESOLVER_IP_STR_LEN] = "";
+    char broker_address[sizeof(atl_config.mqtt_client.broker_address) + 1] = "";
+    uint16_t broker_port = 0;
+    bool unmetered_healthy = false;
+    atl_netmgr_uplink_t *best = NULL;
+    atl_netmgr_uplink_t *previous = NULL;
+
+    /* Probe destination (MQTT broker) */
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        if (atl_config.mqtt_client.mode != ATL_MQTT_DISABLED) {
+            memcpy(broker_address, atl_config.mqtt_client.broker_address, sizeof(atl_config.mqtt_client.broker_address));
+            broker_port = atl_config.mqtt_client.broker_port;
+        }
+        xSemaphoreGive(atl_config_mutex);
+    }
+    if ((broker_address[0] != '\0') && (atl_resolver_resolve(broker_address, broker_ip, sizeof(broker_ip)) != ESP_OK)) {
+        broker_ip[0] = '\0';
+    }
+
+    /* Unmetered uplinks first, metered ones only when they may be needed */
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t i = 0; i < atl_netmgr_uplink_count; i++) {
+            atl_netmgr_uplink_t *uplink = &atl_netmgr_uplinks[i];
+            if ((uplink->metered != (pass == 1)) || (uplink->up == false)) {
+                continue;
+            }
+            if ((pass == 1) && (unmetered_healthy == true) && (uplink != atl_netmgr_active)) {
+                continue;
+            }
+            bool reachable = true;
+            if ((uplink != atl_netmgr_active) || (atl_netmgr_session_up == false)) {
+                reachable = atl_netmgr_probe(uplink->netif, broker_ip, broker_port);
+            }
+            if (xSemaphoreTake(atl_netmgr_mutex, portMAX_DELAY) == pdTRUE) {
+                /* Failover (no healthy active uplink) does not wait for a second probe */
+                uint8_t recover = ATL_NETMGR_RECOVER_COUNT;
+                if ((atl_netmgr_active == NULL) || (atl_netmgr_active->up == false) || (atl_netmgr_active->healthy == false)) {
+                    recover = 1;
+                }
+                if (reachable == true) {
+                    uplink->fails = 0;
+                    if ((uplink->healthy == false) && (++uplink->successes >= recover)) {
+                        uplink->healthy = true;
+                        ESP_LOGI(TAG, "Uplink %s is healthy", atl_netmgr_uplink_str[uplink->type]);
+                    }
+                } else {
+                    uplink->successes = 0;
+                    if ((uplink->healthy == true) && (++uplink->fails >= CONFIG_ATL_NETMGR_FAIL_THRESHOLD)) {
+                        uplink->healthy = false;
+                        ESP_LOGW(TAG, "Uplink %s is unhealthy (broker not reachable)", atl_netmgr_uplink_str[uplink->type]);
+                    }
+                }
+
+                if ((uplink->healthy == true) && (uplink->metered == false)) {
+                    unmetered_healthy = true;
+                }
+                xSemaphoreGive(atl_netmgr_mutex);
+            }
+        }
+    }
+
+    /* Select the best healthy uplink */
+    if (xSemaphoreTake(atl_netmgr_mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    for (uint8_t i = 0; i < atl_netmgr_uplink_count; i++) {
+        atl_netmgr_uplink_t *uplink = &atl_netmgr_uplinks[i];
+        if ((uplink->up == false) || (uplink->healthy == false)) {
+            continue;
+        }
+        if ((best == NULL) || (uplink->metered < best->metered) ||
+            ((uplink->metered == best->metered) && (uplink->priority < best->priority))) {
+            best = uplink;
+        }
+    }
+    previous = atl_netmgr_active;
+    if ((best != NULL) && (best != atl_netmgr_active)) {
+        esp_netif_set_default_netif(best->netif);
+        atl_netmgr_active = best;
+        atl_netmgr_session_up = false;
+    }
+    xSemaphoreGive(atl_netmgr_mutex);
+
+    /* Notify uplink switch */
+    if ((best != NULL) && (best != previous)) {
+        ESP_LOGW(TAG, "Active uplink: %s -> %s%s", (previous != NULL) ? atl_netmgr_uplink_str[previous->type] : "none",
+                 atl_netmgr_uplink_str[best->type], best->metered ? " (metered)" : "");
+        for (uint8_t i = 0; i < atl_netmgr_callback_count; i++) {
+            atl_netmgr_callbacks[i](best->type, best->metered);
+        }
+    } else if ((best == NULL) && (previous != NULL)) {
+        ESP_LOGD(TAG, "No healthy uplink, keeping %s", atl_netmgr_uplink_str[previous->type]);
+    }
+}
+
+/**
+ * @fn atl_netmgr_task(void *args)
+ * @brief Health check task (periodic or woken up by link events).
+ * @param[in] args - Not used
+ */
+static void atl_netmgr_task(void *args) {
+    uint32_t interval = CONFIG_ATL_NETMGR_CHECK_INTERVAL;
+    while (true) {
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+        /* Session loss wakes the task up, so standby uplinks are probed less often while session is up */
+        interval = atl_netmgr_session_up ? CONFIG_ATL_NETMGR_SLEEP_INTERVAL : CONFIG_ATL_NETMGR_CHECK_INTERVAL;
+#endif
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(interval * 1000));
+        atl_netmgr_check();
+    }
+}
+
+/**
+ * @fn atl_netmgr_init(void)
+ * @brief Initialize network manager (uplink table and health check task).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_netmgr_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_netmgr_mutex != NULL) {
+        return ESP_OK;
+    }
+    atl_netmgr_mutex = xSemaphoreCreateMutex();
+    if (atl_netmgr_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    if (xTaskCreatePinnedToCore(atl_netmgr_task, "atl_netmgr_task", 4096, NULL, 5, &atl_netmgr_task_handle, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating network manager task!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
+
+/**
+ * @fn atl_netmgr_register(atl_netmgr_uplink_e type, esp_netif_t *netif, uint8_t priority, bool metered)
+ * @brief Register an uplink (must be called after default event loop creation).
+ * @details Unmetered uplinks are always preferred, metered ones are kept as backup. Among the same class the lowest
+ *  priority value wins.
+ * @param[in] type - Uplink type
+ * @param[in] netif - Uplink network interface
+ * @param[in] priority - Uplink priority (lower is preferred)
+ * @param[in] metered - Uplink traffic is charged (reserved for priority traffic)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if uplink table is full.
+ */
+esp_err_t atl_netmgr_register(atl_netmgr_uplink_e type, esp_netif_t *netif, uint8_t priority, bool metered) {
+    esp_err_t err = ESP_OK;
+    if ((atl_netmgr_mutex == NULL) || (netif == NULL)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_netmgr_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    if (atl_netmgr_uplink_count >= ATL_NETMGR_MAX_UPLINKS) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        atl_netmgr_uplink_t *uplink = &atl_netmgr_uplinks[atl_netmgr_uplink_count++];
+        memset(uplink, 0, sizeof(atl_netmgr_uplink_t));
+        uplink->type = type;
+        uplink->netif = netif;
+        uplink->priority = priority;
+        uplink->metered = metered;
+    }
+    xSemaphoreGive(atl_netmgr_mutex);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail registering uplink %s! Error: %s", atl_netmgr_uplink_str[type], esp_err_to_name(err));
+        return err;
+    }
+
+    /* Link events (default event loop is created by the first uplink driver) */
+    if (atl_netmgr_events_registered == false) {
+        err = esp_event_handler_instance_register(IP_EVENT, ESP_EVENT_ANY_ID, &atl_netmgr_event_handler, NULL, NULL);
+        if (err == ESP_OK) {
+            err = esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &atl_netmgr_event_handler, NULL, NULL);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fail registering network manager event handler!");
+            return err;
+        }
+        atl_netmgr_events_registered = true;
+    }
+    ESP_LOGI(TAG, "Uplink %s registered (priority %d%s)", atl_netmgr_uplink_str[type], priority, metered ? ", metered" : "");
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_netmgr_register_switch_cb(atl_netmgr_switch_cb_t cb)
+ * @brief Register a callback notified when the active uplink changes.
+ * @param[in] cb - Callback
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if callback table is full.
+ */
+esp_err_t atl_netmgr_register_switch_cb(atl_netmgr_switch_cb_t cb) {
+    if (atl_netmgr_callback_count >= ATL_NETMGR_MAX_CALLBACKS) {
+        return ESP_ERR_NO_MEM;
+    }
+    atl_netmgr_callbacks[atl_netmgr_callback_count++] = cb;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_netmgr_set_session(bool connected)
+ * @brief Signal broker session state through the active uplink (health signal without probe traffic).
+ * @details Session loss triggers an immediate check.
+ * @param[in] connected - Session connected
+ */
+void atl_netmgr_set_session(bool connected) {
+    atl_netmgr_session_up = connected;
+    if ((connected == false) && (atl_netmgr_task_handle != NULL)) {
+        xTaskNotifyGive(atl_netmgr_task_handle);
+    }
+}
+
+/**
+ * @fn atl_netmgr_is_metered(void)
+ * @brief Check if active uplink is metered (bulk transfers must be deferred).
+ * @return bool - True if active uplink is metered.
+ */
+bool atl_netmgr_is_metered(void) {
+    atl_netmgr_uplink_t *active = atl_netmgr_active;
+    return (active != NULL) && (active->metered == true);
+}
+
+/**
+ * @fn atl_netmgr_is_up(void)
+ * @brief Check if active uplink link is up (with IP address).
+ * @return bool - True if active uplink is up.
+ */
+bool atl_netmgr_is_up(void) {
+    atl_netmgr_uplink_t *active = atl_netmgr_active;
+    return (active != NULL) && (active->up == true);
+}
+
+/**
+ * @fn atl_netmgr_get_active_str(void)
+ * @brief Get active uplink name.
+ * @return const char* - Uplink name ("none" if there is no active uplink).
+ */
+const char* atl_netmgr_get_active_str(void) {
+    atl_netmgr_uplink_t *active = atl_netmgr_active;
+    return (active != NULL) ? atl_netmgr_uplink_str[active->type] : "none";
+}
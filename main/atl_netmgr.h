@@ -0,0 +1,106 @@
+/**
+ * @file atl_netmgr.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Network manager (multiple uplinks with failover) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp_netif.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_NETMGR_MAX_UPLINKS      3       /**< Max. uplinks registered.*/
+#define ATL_NETMGR_MAX_CALLBACKS    4       /**< Max. uplink switch callbacks.*/
+
+/**
+ * @enum    atl_netmgr_uplink_e
+ * @brief   Uplink type.
+ */
+typedef enum {
+    ATL_NETMGR_UPLINK_WIFI,
+    ATL_NETMGR_UPLINK_ETHERNET,
+    ATL_NETMGR_UPLINK_CELLULAR,
+} atl_netmgr_uplink_e;
+
+/**
+ * @typedef atl_netmgr_switch_cb_t
+ * @brief Active uplink changed callback (called from network manager task).
+ * @details Sessions opened through the previous uplink (i.e. MQTT) must be reopened.
+ */
+typedef void (*atl_netmgr_switch_cb_t)(atl_netmgr_uplink_e type, bool metered);
+
+/**
+ * @fn atl_netmgr_init(void)
+ * @brief Initialize network manager (uplink table and health check task).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_netmgr_init(void);
+
+/**
+ * @fn atl_netmgr_register(atl_netmgr_uplink_e type, esp_netif_t *netif, uint8_t priority, bool metered)
+ * @brief Register an uplink (must be called after default event loop creation).
+ * @details Unmetered uplinks are always preferred, metered ones are kept as backup. Among the same class the lowest
+ *  priority value wins.
+ * @param[in] type - Uplink type
+ * @param[in] netif - Uplink network interface
+ * @param[in] priority - Uplink priority (lower is preferred)
+ * @param[in] metered - Uplink traffic is charged (reserved for priority traffic)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if uplink table is full.
+ */
+esp_err_t atl_netmgr_register(atl_netmgr_uplink_e type, esp_netif_t *netif, uint8_t priority, bool metered);
+
+/**
+ * @fn atl_netmgr_register_switch_cb(atl_netmgr_switch_cb_t cb)
+ * @brief Register a callback notified when the active uplink changes.
+ * @param[in] cb - Callback
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if callback table is full.
+ */
+esp_err_t atl_netmgr_register_switch_cb(atl_netmgr_switch_cb_t cb);
+
+/**
+ * @fn atl_netmgr_set_session(bool connected)
+ * @brief Signal broker session state through the active uplink (health signal without probe traffic).
+ * @details Session loss triggers an immediate check.
+ * @param[in] connected - Session connected
+ */
+void atl_netmgr_set_session(bool connected);
+
+/**
+ * @fn atl_netmgr_is_metered(void)
+ * @brief Check if active uplink is metered (bulk transfers must be deferred).
+ * @return bool - True if active uplink is metered.
+ */
+bool atl_netmgr_is_metered(void);
+
+/**
+ * @fn atl_netmgr_is_up(void)
+ * @brief Check if active uplink link is up (with IP address).
+ * @return bool - True if active uplink is up.
+ */
+bool atl_netmgr_is_up(void);
+
+/**
+ * @fn atl_netmgr_get_active_str(void)
+ * @brief Get active uplink name.
+ * @return const char* - Uplink name ("none" if there is no active uplink).
+ */
+const char* atl_netmgr_get_active_str(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file atl_netprof.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Network tuning profile (bulk transfers vs. low memory).
+ * @details lwIP and WiFi buffers belong to other components, so they are set at build time by the sdkconfig fragments
+ *  at profiles/ (one per profile). At runtime bulk transfers (OTA, diagnostics download) suspend WiFi power save, size
+ *  their pipelines from TCP window and free heap, and record their throughput.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_wifi.h>
+#include <esp_heap_caps.h>
+#include "sdkconfig.h"
+#include "atl_netprof.h"
+
+/* Constants */
+static const char *TAG = "atl-netprof";
+static const char *atl_netprof_str[] = {
+    "balanced",
+    "bulk",
+    "low-memory",
+};
+
+/* Global variables */
+static atl_netprof_stats_t atl_netprof_stats;
+static wifi_ps_type_t atl_netprof_saved_ps = WIFI_PS_NONE;  /* WiFi power save before first bulk transfer */
+static bool atl_netprof_ps_suspended = false;
+static SemaphoreHandle_t atl_netprof_mutex = NULL;
+
+/**
+ * @fn atl_netprof_get_str(atl_netprof_e profile)
+ * @brief Get network tuning profile name.
+ * @param[in] profile - Network tuning profile
+ * @return const char* - Profile name.
+ */
+const char* atl_netprof_get_str(atl_netprof_e profile) {
+    return atl_netprof_str[profile];
+}
+
+/**
+ * @fn atl_netprof_bulk_begin(void)
+ * @brief Mark the start of a bulk transfer (WiFi power save is suspended while any bulk transfer runs).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if not initialized.
+ */
+esp_err_t atl_netprof_bulk_begin(void) {
+    if (atl_netprof_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_netprof_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    atl_netprof_stats.bulk_active++;
+#ifdef CONFIG_ATL_NETPROF_BULK_PS_OFF
+    /* Modem sleep delays every received frame up to a beacon interval */
+    if ((atl_netprof_stats.bulk_active == 1) && (esp_wifi_get_ps(&atl_netprof_saved_ps) == ESP_OK) &&
+        (atl_netprof_saved_ps != WIFI_PS_NONE)) {
+        if (esp_wifi_set_ps(WIFI_PS_NONE) == ESP_OK) {
+            atl_netprof_ps_suspended = true;
+            ESP_LOGD(TAG, "WiFi power save suspended for bulk transfer");
+        }
+    }
+#endif
+    xSemaphoreGive(atl_netprof_mutex);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_netprof_bulk_end(uint32_t bytes, uint32_t elapsed_ms)
+ * @brief Mark the end of a bulk transfer and record its throughput.
+ * @param[in] bytes - Bytes transferred
+ * @param[in] elapsed_ms - Transfer duration (in ms)
+ */
+void atl_netprof_bulk_end(uint32_t bytes, uint32_t elapsed_ms) {
+    if (atl_netprof_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(atl_netprof_mutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    if (atl_netprof_stats.bulk_active > 0) {
+        atl_netprof_stats.bulk_active--;
+    }
+    if ((atl_netprof_stats.bulk_active == 0) && (atl_netprof_ps_suspended == true)) {
+        esp_wifi_set_ps(atl_netprof_saved_ps);
+        atl_netprof_ps_suspended = false;
+    }
+    atl_netprof_stats.bulk_count++;
+    atl_netprof_stats.last_bytes = bytes;
+    atl_netprof_stats.last_ms = elapsed_ms;
+    xSemaphoreGive(atl_netprof_mutex);
+    ESP_LOGI(TAG, "Bulk transfer: %lu bytes in %lu ms (%lu B/s, profile %s)", bytes, elapsed_ms,
+        (elapsed_ms > 0) ? (uint32_t)(((uint64_t)bytes * 1000) / elapsed_ms) : 0, atl_netprof_str[atl_netprof_stats.profile]);
+}
+
+/**
+ * @fn atl_netprof_pipeline_depth(uint32_t chunk_size, uint8_t max_depth)
+ * @brief Get the number of chunks to keep in flight at a pipelined download.
+ * @details Depth is limited by the TCP window (further chunks only wait at sender) and by free internal heap (each
+ *  chunk in flight may be buffered at WiFi and lwIP), so downloads run as fast as RAM allows.
+ * @param[in] chunk_size - Chunk size (in bytes)
+ * @param[in] max_depth - Max. depth configured
+ * @return uint8_t - Chunks in flight (at least 1).
+ */
+uint8_t atl_netprof_pipeline_depth(uint32_t chunk_size, uint8_t max_depth) {
+    uint32_t depth = max_depth;
+    if (chunk_size == 0) {
+        return (max_depth > 0) ? max_depth : 1;
+    }
+
+    /* One chunk more than the window keeps the sender busy while the previous request is answered */
+    uint32_t window_depth = (CONFIG_LWIP_TCP_WND_DEFAULT / chunk_size) + 1;
+    if (depth > window_depth) {
+        depth = window_depth;
+    }
+
+    /* Keep heap reserve to the rest of firmware */
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    uint32_t heap_depth = (free_heap > CONFIG_ATL_NETPROF_HEAP_RESERVE) ? ((free_heap - CONFIG_ATL_NETPROF_HEAP_RESERVE) / chunk_size) : 0;
+    if (depth > heap_depth) {
+        depth = heap_depth;
+    }
+    return (depth > 0) ? depth : 1;
+}
+
+/**
+ * @fn atl_netprof_get_stats(atl_netprof_stats_t *stats)
+ * @brief Get network tuning profile and bulk transfer statistics.
+ * @param[out] stats - Statistics
+ */
+void atl_netprof_get_stats(atl_netprof_stats_t *stats) {
+    if ((atl_netprof_mutex != NULL) && (xSemaphoreTake(atl_netprof_mutex, portMAX_DELAY) == pdTRUE)) {
+        memcpy(stats, &atl_netprof_stats, sizeof(atl_netprof_stats_t));
+        xSemaphoreGive(atl_netprof_mutex);
+    } else {
+        memset(stats, 0, sizeof(atl_netprof_stats_t));
+    }
+}
+
+/**
+ * @fn atl_netprof_init(void)
+ * @brief Initialize network tuning profile (must be called before any bulk transfer).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_netprof_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_netprof_mutex != NULL) {
+        return ESP_OK;
+    }
+    memset(&atl_netprof_stats, 0, sizeof(atl_netprof_stats_t));
+#if defined(CONFIG_ATL_NETPROF_BULK)
+    atl_netprof_stats.profile = ATL_NETPROF_BULK;
+#elif defined(CONFIG_ATL_NETPROF_LOW_MEMORY)
+    atl_netprof_stats.profile = ATL_NETPROF_LOW_MEMORY;
+#else
+    atl_netprof_stats.profile = ATL_NETPROF_BALANCED;
+#endif
+    atl_netprof_stats.tcp_wnd = CONFIG_LWIP_TCP_WND_DEFAULT;
+    atl_netprof_stats.tcp_snd_buf = CONFIG_LWIP_TCP_SND_BUF_DEFAULT;
+    atl_netprof_stats.tcp_mss = CONFIG_LWIP_TCP_MSS;
+    atl_netprof_mutex = xSemaphoreCreateMutex();
+    if (atl_netprof_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    ESP_LOGI(TAG, "Network profile %s (TCP window %lu, send buffer %lu, MSS %lu)", atl_netprof_str[atl_netprof_stats.profile],
+        atl_netprof_stats.tcp_wnd, atl_netprof_stats.tcp_snd_buf, atl_netprof_stats.tcp_mss);
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file atl_netprof.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Network tuning profile (bulk transfers vs. low memory) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum    atl_netprof_e
+ * @brief   Network tuning profile (selected at build time).
+ */
+typedef enum {
+    ATL_NETPROF_BALANCED,       /**< Stock lwIP and WiFi buffers.*/
+    ATL_NETPROF_BULK,           /**< Large TCP window and WiFi buffers (OTA and downloads).*/
+    ATL_NETPROF_LOW_MEMORY,     /**< Small TCP window and WiFi buffers (telemetry only).*/
+} atl_netprof_e;
+
+/**
+ * @typedef atl_netprof_stats_t
+ * @brief Network tuning profile and bulk transfer statistics.
+ */
+typedef struct {
+    atl_netprof_e   profile;        /**< Build time profile.*/
+    uint32_t        tcp_wnd;        /**< TCP receive window (in bytes).*/
+    uint32_t        tcp_snd_buf;    /**< TCP send buffer (in bytes).*/
+    uint32_t        tcp_mss;        /**< TCP max. segment size (in bytes).*/
+    uint8_t         bulk_active;    /**< Bulk transfers running.*/
+    uint32_t        bulk_count;     /**< Bulk transfers finished.*/
+    uint32_t        last_bytes;     /**< Bytes of last bulk transfer.*/
+    uint32_t        last_ms;        /**< Duration of last bulk transfer (in ms).*/
+} atl_netprof_stats_t;
+
+/**
+ * @fn atl_netprof_init(void)
+ * @brief Initialize network tuning profile (must be called before any bulk transfer).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_netprof_init(void);
+
+/**
+ * @fn atl_netprof_get_str(atl_netprof_e profile)
+ * @brief Get network tuning profile name.
+ * @param[in] profile - Network tuning profile
+ * @return const char* - Profile name.
+ */
+const char* atl_netprof_get_str(atl_netprof_e profile);
+
+/**
+ * @fn atl_netprof_bulk_begin(void)
+ * @brief Mark the start of a bulk transfer (WiFi power save is suspended while any bulk transfer runs).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if not initialized.
+ */
+esp_err_t atl_netprof_bulk_begin(void);
+
+/**
+ * @fn atl_netprof_bulk_end(uint32_t bytes, uint32_t elapsed_ms)
+ * @brief Mark the end of a bulk transfer and record its throughput.
+ * @param[in] bytes - Bytes transferred
+ * @param[in] elapsed_ms - Transfer duration (in ms)
+ */
+void atl_netprof_bulk_end(uint32_t bytes, uint32_t elapsed_ms);
+
+/**
+ * @fn atl_netprof_pipeline_depth(uint32_t chunk_size, uint8_t max_depth)
+ * @brief Get the number of chunks to keep in flight at a pipelined download.
+ * @details Depth is limited by the TCP window (further chunks only wait at sender) and by free internal heap (each
+ *  chunk in flight may be buffered at WiFi and lwIP), so downloads run as fast as RAM allows.
+ * @param[in] chunk_size - Chunk size (in bytes)
+ * @param[in] max_depth - Max. depth configured
+ * @return uint8_t - Chunks in flight (at least 1).
+ */
+uint8_t atl_netprof_pipeline_depth(uint32_t chunk_size, uint8_t max_depth);
+
+/**
+ * @fn atl_netprof_get_stats(atl_netprof_stats_t *stats)
+ * @brief Get network tuning profile and bulk transfer statistics.
+ * @param[out] stats - Statistics
+ */
+void atl_netprof_get_stats(atl_netprof_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
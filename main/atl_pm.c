@@ -0,0 +1,193 @@
+/**
+ * @file atl_pm.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Power management (dynamic frequency scaling, automatic light sleep and PM locks).
+ * @details With dynamic frequency scaling the CPU runs at the minimum frequency unless a PM lock (held by drivers,
+ *  WiFi or this application) asks for more, and with automatic light sleep the chip sleeps at FreeRTOS tickless idle
+ *  until next timer or wakeup source. Application locks keep TLS handshakes and firmware updates at maximum
+ *  frequency and keep the chip awake while web portal sessions are open (their sockets would not be served).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include "sdkconfig.h"
+#ifdef CONFIG_ATL_PM
+#include <esp_pm.h>
+#endif
+#include "atl_pm.h"
+
+/* Constants */
+static const char *atl_pm_lock_name[] = {
+    "tls",
+    "ota",
+    "http",
+    "uart",
+};
+
+/**
+ * @fn atl_pm_lock_str(atl_pm_lock_e lock)
+ * @brief Get PM lock name.
+ * @param[in] lock - PM lock
+ * @return const char* - PM lock name ("?" if invalid).
+ */
+const char* atl_pm_lock_str(atl_pm_lock_e lock) {
+    if (lock >= ATL_PM_LOCK_MAX) {
+        return "?";
+    }
+    return atl_pm_lock_name[lock];
+}
+
+#ifdef CONFIG_ATL_PM
+
+/* Constants */
+static const char *TAG = "atl-pm";
+static const esp_pm_lock_type_t atl_pm_lock_type[] = {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+    ESP_PM_NO_LIGHT_SLEEP,
+};
+
+/* Global variables */
+static esp_pm_lock_handle_t atl_pm_locks[ATL_PM_LOCK_MAX];
+static atl_pm_lock_info_t atl_pm_lock_info[ATL_PM_LOCK_MAX];
+static portMUX_TYPE atl_pm_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @fn atl_pm_init(void)
+ * @brief Configure dynamic frequency scaling and automatic light sleep, and create the PM locks.
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_pm_init(void) {
+    esp_err_t err = ESP_OK;
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_ATL_PM_MIN_FREQ,
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#else
+        .light_sleep_enable = false,
+#endif
+    };
+    if (pm_config.min_freq_mhz > pm_config.max_freq_mhz) {
+        pm_config.min_freq_mhz = pm_config.max_freq_mhz;
+    }
+
+    /* Create application locks first (they are valid even if configuration fails) */
+    for (uint8_t i = 0; i < ATL_PM_LOCK_MAX; i++) {
+        err = esp_pm_lock_create(atl_pm_lock_type[i], 0, atl_pm_lock_name[i], &atl_pm_locks[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Fail creating PM lock [%s]: %s", atl_pm_lock_name[i], esp_err_to_name(err));
+            goto error_proc;
+        }
+    }
+
+    /* Enable dynamic frequency scaling (and automatic light sleep) */
+    err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail configuring power management: %s", esp_err_to_name(err));
+        goto error_proc;
+    }
+    ESP_LOGI(TAG, "Power management enabled (CPU %d-%d MHz, light sleep %s)", pm_config.min_freq_mhz,
+             pm_config.max_freq_mhz, pm_config.light_sleep_enable ? "enabled" : "disabled");
+    return ESP_OK;
+
+    error_proc:
+    for (uint8_t i = 0; i < ATL_PM_LOCK_MAX; i++) {
+        if (atl_pm_locks[i] != NULL) {
+            esp_pm_lock_delete(atl_pm_locks[i]);
+            atl_pm_locks[i] = NULL;
+        }
+    }
+    return err;
+}
+
+/**
+ * @fn atl_pm_acquire(atl_pm_lock_e lock)
+ * @brief Acquire a PM lock (ignored if power management is not initialized).
+ * @param[in] lock - PM lock
+ */
+void atl_pm_acquire(atl_pm_lock_e lock) {
+    if ((lock >= ATL_PM_LOCK_MAX) || (atl_pm_locks[lock] == NULL)) {
+        return;
+    }
+    if (esp_pm_lock_acquire(atl_pm_locks[lock]) == ESP_OK) {
+        portENTER_CRITICAL(&atl_pm_mux);
+        atl_pm_lock_info[lock].held++;
+        atl_pm_lock_info[lock].acquired++;
+        portEXIT_CRITICAL(&atl_pm_mux);
+    }
+}
+
+/**
+ * @fn atl_pm_release(atl_pm_lock_e lock)
+ * @brief Release a PM lock (ignored if it is not held).
+ * @param[in] lock - PM lock
+ */
+void atl_pm_release(atl_pm_lock_e lock) {
+    if ((lock >= ATL_PM_LOCK_MAX) || (atl_pm_locks[lock] == NULL)) {
+        return;
+    }
+    portENTER_CRITICAL(&atl_pm_mux);
+    bool held = (atl_pm_lock_info[lock].held > 0);
+    if (held) {
+        atl_pm_lock_info[lock].held--;
+    }
+    portEXIT_CRITICAL(&atl_pm_mux);
+    if (held) {
+        esp_pm_lock_release(atl_pm_locks[lock]);
+    }
+}
+
+/**
+ * @fn atl_pm_get(atl_pm_lock_e lock, atl_pm_lock_info_t *info)
+ * @brief Get PM lock usage.
+ * @param[in] lock - PM lock
+ * @param[out] info - PM lock usage
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if lock is invalid, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_pm_get(atl_pm_lock_e lock, atl_pm_lock_info_t *info) {
+    if (lock >= ATL_PM_LOCK_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&atl_pm_mux);
+    *info = atl_pm_lock_info[lock];
+    portEXIT_CRITICAL(&atl_pm_mux);
+    return ESP_OK;
+}
+
+#else
+
+/**
+ * @fn atl_pm_init(void)
+ * @brief Power management disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_pm_init(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void atl_pm_acquire(atl_pm_lock_e lock) {
+}
+
+void atl_pm_release(atl_pm_lock_e lock) {
+}
+
+esp_err_t atl_pm_get(atl_pm_lock_e lock, atl_pm_lock_info_t *info) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file atl_pm.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Power management (dynamic frequency scaling, automatic light sleep and PM locks) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum    atl_pm_lock_e
+ * @brief   PM locks held by the application (each one may be acquired several times, it is held until last release).
+ */
+typedef enum {
+    ATL_PM_LOCK_TLS,        /**< Maximum CPU frequency during TLS handshakes.*/
+    ATL_PM_LOCK_OTA,        /**< Maximum CPU frequency while firmware is downloaded and written to flash.*/
+    ATL_PM_LOCK_HTTP,       /**< No light sleep while web portal sessions are open.*/
+    ATL_PM_LOCK_UART,       /**< No light sleep while UART peers may send data (modem session, LoRa AT exchanges).*/
+    ATL_PM_LOCK_MAX,
+} atl_pm_lock_e;
+
+/**
+ * @typedef atl_pm_lock_info_t
+ * @brief PM lock usage.
+ */
+typedef struct {
+    uint32_t    held;       /**< Acquisitions not released yet.*/
+    uint32_t    acquired;   /**< Acquisitions since boot.*/
+} atl_pm_lock_info_t;
+
+/**
+ * @fn atl_pm_init(void)
+ * @brief Configure dynamic frequency scaling and automatic light sleep, and create the PM locks.
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_pm_init(void);
+
+/**
+ * @fn atl_pm_lock_str(atl_pm_lock_e lock)
+ * @brief Get PM lock name.
+ * @param[in] lock - PM lock
+ * @return const char* - PM lock name ("?" if invalid).
+ */
+const char* atl_pm_lock_str(atl_pm_lock_e lock);
+
+/**
+ * @fn atl_pm_acquire(atl_pm_lock_e lock)
+ * @brief Acquire a PM lock (ignored if power management is not initialized).
+ * @param[in] lock - PM lock
+ */
+void atl_pm_acquire(atl_pm_lock_e lock);
+
+/**
+ * @fn atl_pm_release(atl_pm_lock_e lock)
+ * @brief Release a PM lock (ignored if it is not held).
+ * @param[in] lock - PM lock
+ */
+void atl_pm_release(atl_pm_lock_e lock);
+
+/**
+ * @fn atl_pm_get(atl_pm_lock_e lock, atl_pm_lock_info_t *info)
+ * @brief Get PM lock usage.
+ * @param[in] lock - PM lock
+ * @param[out] info - PM lock usage
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if lock is invalid, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_pm_get(atl_pm_lock_e lock, atl_pm_lock_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
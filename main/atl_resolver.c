@@ -0,0 +1,509 @@
+/**
+ * @file atl_resolver.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Hostname resolver cache functions.
+ * @details Queries are sent straight to the interface DNS server to learn the record TTL (lwIP getaddrinfo does not
+ *  report it), getaddrinfo is used as fallback with CONFIG_ATL_RESOLVER_DEFAULT_TTL.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <errno.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_attr.h>
+#include <esp_random.h>
+#include <esp_netif.h>
+#include <nvs.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include "atl_dns.h"
+#include "atl_resolver.h"
+#include "sdkconfig.h"
+
+/* Constants */
+static const char *TAG = "atl-resolver";           /**< Module identification.*/
+#define ATL_RESOLVER_MAGIC          0x41544c52      /**< RTC cache signature.*/
+#define ATL_RESOLVER_MSG_LEN        512             /**< Max. DNS message length (UDP).*/
+#define ATL_RESOLVER_DNS_TYPE_A     1               /**< DNS A record.*/
+#define ATL_RESOLVER_DNS_TYPE_CNAME 5               /**< DNS CNAME record.*/
+
+/**
+ * @typedef atl_resolver_entry_t
+ * @brief Cached hostname.
+ */
+typedef struct {
+    char        hostname[ATL_RESOLVER_HOSTNAME_LEN];    /**< Hostname (empty if slot not in use).*/
+    uint32_t    addr;                                   /**< IPv4 address (network byte order).*/
+    int64_t     expires;                                /**< Expiration time (in seconds, 0 if expired).*/
+    bool        invalid;                                /**< Address failed, do not serve from cache.*/
+} atl_resolver_entry_t;
+
+/**
+ * @typedef atl_resolver_cache_t
+ * @brief Resolver cache.
+ */
+typedef struct {
+    uint32_t                magic;                              /**< Cache signature.*/
+    atl_resolver_entry_t    entry[ATL_RESOLVER_CACHE_SIZE];     /**< Cached hostnames.*/
+} atl_resolver_cache_t;
+
+/* Global variables */
+static RTC_DATA_ATTR atl_resolver_cache_t atl_resolver_cache;  /* Kept across deep sleep */
+static SemaphoreHandle_t atl_resolver_mutex = NULL;
+static bool atl_resolver_revalidating = false;
+static uint8_t atl_resolver_fallback_next = 0;
+
+/**
+ * @fn atl_resolver_now(void)
+ * @brief Get system time (kept by RTC across deep sleep).
+ * @return int64_t - Time (in seconds).
+ */
+static int64_t atl_resolver_now(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec;
+}
+
+/**
+ * @fn atl_resolver_find(const char *hostname)
+ * @brief Find a cached hostname (mutex must be held).
+ * @param[in] hostname - Hostname
+ * @return atl_resolver_entry_t* - Cache entry if found, otherwise NULL.
+ */
+static atl_resolver_entry_t* atl_resolver_find(const char *hostname) {
+    for (uint8_t i = 0; i < ATL_RESOLVER_CACHE_SIZE; i++) {
+        if (strcmp(atl_resolver_cache.entry[i].hostname, hostname) == 0) {
+            return &atl_resolver_cache.entry[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @fn atl_resolver_commit(void)
+ * @brief Write cached addresses at NVS (mutex must be held).
+ */
+static void atl_resolver_commit(void) {
+    esp_err_t err;
+    nvs_handle_t nvs_handler;
+    err = nvs_open("nvs", NVS_READWRITE, &nvs_handler);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail mounting NVS storage");
+        return;
+    }
+    err = nvs_set_blob(nvs_handler, "dns_cache", &atl_resolver_cache, sizeof(atl_resolver_cache_t));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handler);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail writing resolver cache! Error: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs_handler);
+}
+
+/**
+ * @fn atl_resolver_store(const char *hostname, uint32_t addr, uint32_t ttl)
+ * @brief Store a resolved address (replacing the oldest entry if cache is full).
+ * @param[in] hostname - Hostname
+ * @param[in] addr - IPv4 address (network byte order)
+ * @param[in] ttl - Record TTL (in seconds)
+ */
+static void atl_resolver_store(const char *hostname, uint32_t addr, uint32_t ttl) {
+    atl_resolver_entry_t *entry;
+    bool changed = false;
+    if (ttl < CONFIG_ATL_RESOLVER_TTL_MIN) {
+        ttl = CONFIG_ATL_RESOLVER_TTL_MIN;
+    } else if (ttl > CONFIG_ATL_RESOLVER_TTL_MAX) {
+        ttl = CONFIG_ATL_RESOLVER_TTL_MAX;
+    }
+    if (xSemaphoreTake(atl_resolver_mutex, portMAX_DELAY) == pdTRUE) {
+        entry = atl_resolver_find(hostname);
+        if (entry == NULL) {
+            entry = &atl_resolver_cache.entry[0];
+            for (uint8_t i = 1; i < ATL_RESOLVER_CACHE_SIZE; i++) {
+                if (atl_resolver_cache.entry[i].expires < entry->expires) {
+                    entry = &atl_resolver_cache.entry[i];
+                }
+            }
+            memset(entry, 0, sizeof(atl_resolver_entry_t));
+            strncpy(entry->hostname, hostname, sizeof(entry->hostname) - 1);
+            changed = true;
+        }
+        if (entry->addr != addr) {
+            entry->addr = addr;
+            changed = true;
+        }
+        entry->invalid = false;
+        entry->expires = atl_resolver_now() + ttl;
+
+        /* Persist only address changes (TTL is not trusted after reboot) */
+        if (changed == true) {
+            atl_resolver_commit();
+        }
+        xSemaphoreGive(atl_resolver_mutex);
+    }
+}
+
+/**
+ * @fn atl_resolver_skip_name(const uint8_t *msg, int msg_len, int pos)
+ * @brief Skip a DNS name (labels and/or compression pointer).
+ * @param[in] msg - DNS message
+ * @param[in] msg_len - DNS message length
+ * @param[in] pos - Name position
+ * @return int - Position after the name, -1 if malformed.
+ */
+static int atl_resolver_skip_name(const uint8_t *msg, int msg_len, int pos) {
+    while (pos < msg_len) {
+        if ((msg[pos] & 0xC0) == 0xC0) {
+            return pos + 2;
+        } else if (msg[pos] == 0) {
+            return pos + 1;
+        }
+        pos += msg[pos] + 1;
+    }
+    return -1;
+}
+
+/**
+ * @fn atl_resolver_query_dns(uint32_t server, const char *hostname, uint32_t *addr, uint32_t *ttl)
+ * @brief Send an A query to a DNS server and wait for the answer.
+ * @param[in] server - DNS server IPv4 address (network byte order)
+ * @param[in] hostname - Hostname
+ * @param[out] addr - IPv4 address (network byte order)
+ * @param[out] ttl - Lowest TTL at the answer chain (in seconds)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_resolver_query_dns(uint32_t server, const char *hostname, uint32_t *addr, uint32_t *ttl) {
+    esp_err_t err = ESP_FAIL;
+    uint8_t msg[ATL_RESOLVER_MSG_LEN];
+    dns_header_t *header = (dns_header_t*)msg;
+    uint16_t id = (uint16_t)esp_random();
+    const char *label = hostname;
+    int msg_len = sizeof(dns_header_t);
+    int pos, sock;
+
+    /* Build query (header, QNAME labels, QTYPE A, QCLASS IN) */
+    memset(header, 0, sizeof(dns_header_t));
+    header->id = htons(id);
+    header->flags = htons(0x0100);
+    header->qd_count = htons(1);
+    while (*label != '\0') {
+        const char *dot = strchr(label, '.');
+        int label_len = (dot != NULL) ? (dot - label) : strlen(label);
+        if ((label_len == 0) || (label_len > 63) || (msg_len + label_len + 6 > ATL_RESOLVER_MSG_LEN)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        msg[msg_len++] = label_len;
+        memcpy(&msg[msg_len], label, label_len);
+        msg_len += label_len;
+        label += label_len;
+        if (*label == '.') {
+            label++;
+        }
+    }
+    msg[msg_len++] = 0;
+    msg[msg_len++] = 0;
+    msg[msg_len++] = ATL_RESOLVER_DNS_TYPE_A;
+    msg[msg_len++] = 0;
+    msg[msg_len++] = 1;
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    struct timeval timeout = {
+        .tv_sec = CONFIG_ATL_RESOLVER_TIMEOUT / 1000,
+        .tv_usec = (CONFIG_ATL_RESOLVER_TIMEOUT % 1000) * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in dest_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(DNS_PORT),
+        .sin_addr.s_addr = server,
+    };
+    if (sendto(sock, msg, msg_len, 0, (struct sockaddr*)&dest_addr, sizeof(dest_addr)) < 0) {
+        ESP_LOGW(TAG, "Fail sending DNS query: errno %d", errno);
+        goto error_proc;
+    }
+
+    /* Wait for the answer with our id (late answers of previous queries are discarded) */
+    do {
+        msg_len = recv(sock, msg, sizeof(msg), 0);
+        if (msg_len < (int)sizeof(dns_header_t)) {
+            ESP_LOGW(TAG, "No DNS answer for %s", hostname);
+            goto error_proc;
+        }
+    } while (ntohs(header->id) != id);
+    if (((ntohs(header->flags) & 0x8000) == 0) || ((ntohs(header->flags) & 0x000F) != 0)) {
+        ESP_LOGW(TAG, "DNS query for %s failed (flags 0x%04x)", hostname, ntohs(header->flags));
+        err = ESP_ERR_NOT_FOUND;
+        goto error_proc;
+    }
+
+    /* Skip questions and walk answers (CNAME chain followed by A records) */
+    pos = sizeof(dns_header_t);
+    for (uint16_t i = 0; (i < ntohs(header->qd_count)) && (pos > 0); i++) {
+        pos = atl_resolver_skip_name(msg, msg_len, pos);
+        pos = (pos > 0) ? pos + 4 : -1;
+    }
+    err = ESP_ERR_NOT_FOUND;
+    *ttl = UINT32_MAX;
+    for (uint16_t i = 0; (i < ntohs(header->an_count)) && (pos > 0); i++) {
+        pos = atl_resolver_skip_name(msg, msg_len, pos);
+        if ((pos < 0) || (pos + 10 > msg_len)) {
+            break;
+        }
+        uint16_t type = (msg[pos] << 8) | msg[pos + 1];
+        uint32_t record_ttl = ((uint32_t)msg[pos + 4] << 24) | ((uint32_t)msg[pos + 5] << 16) | ((uint32_t)msg[pos + 6] << 8) | msg[pos + 7];
+        uint16_t rd_len = (msg[pos + 8] << 8) | msg[pos + 9];
+        pos += 10;
+        if (pos + rd_len > msg_len) {
+            break;
+        }
+        if ((type == ATL_RESOLVER_DNS_TYPE_CNAME) || (type == ATL_RESOLVER_DNS_TYPE_A)) {
+            *ttl = MIN(*ttl, record_ttl);
+        }
+        if ((type == ATL_RESOLVER_DNS_TYPE_A) && (rd_len == 4)) {
+            memcpy(addr, &msg[pos], 4);
+            err = ESP_OK;
+            break;
+        }
+        pos += rd_len;
+    }
+
+    error_proc:
+    shutdown(sock, 0);
+    close(sock);
+    return err;
+}
+
+/**
+ * @fn atl_resolver_query(const char *hostname, uint32_t *addr, uint32_t *ttl)
+ * @brief Resolve a hostname (DNS server of default interface, getaddrinfo as fallback).
+ * @param[in] hostname - Hostname
+ * @param[out] addr - IPv4 address (network byte order)
+ * @param[out] ttl - Record TTL (in seconds)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_resolver_query(const char *hostname, uint32_t *addr, uint32_t *ttl) {
+    esp_netif_dns_info_t dns_info;
+    esp_netif_t *netif = esp_netif_get_default_netif();
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+
+    if ((netif != NULL) && (esp_netif_get_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns_info) == ESP_OK) &&
+        (dns_info.ip.type == ESP_IPADDR_TYPE_V4) && (dns_info.ip.u_addr.ip4.addr != 0)) {
+        if (atl_resolver_query_dns(dns_info.ip.u_addr.ip4.addr, hostname, addr, ttl) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    if ((getaddrinfo(hostname, NULL, &hints, &res) != 0) || (res == NULL)) {
+        ESP_LOGW(TAG, "Fail resolving %s", hostname);
+        return ESP_ERR_NOT_FOUND;
+    }
+    *addr = ((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+    *ttl = CONFIG_ATL_RESOLVER_DEFAULT_TTL;
+    freeaddrinfo(res);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_resolver_fallback(const char *hostname, uint32_t *addr)
+ * @brief Get a fallback address of the default broker (rotated on each invalidation).
+ * @param[in] hostname - Hostname
+ * @param[out] addr - IPv4 address (network byte order)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if there is no fallback address.
+ */
+static esp_err_t atl_resolver_fallback(const char *hostname, uint32_t *addr) {
+    char fallback[] = CONFIG_ATL_RESOLVER_FALLBACK_IP;
+    char *ip_list[ATL_RESOLVER_CACHE_SIZE];
+    char *saveptr = NULL;
+    uint8_t count = 0;
+    struct in_addr in;
+
+    if (strcmp(hostname, CONFIG_ATL_MQTT_BROKER_ADDR) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    for (char *ip = strtok_r(fallback, ", ", &saveptr); (ip != NULL) && (count < ATL_RESOLVER_CACHE_SIZE); ip = strtok_r(NULL, ", ", &saveptr)) {
+        if (inet_pton(AF_INET, ip, &in) == 1) {
+            ip_list[count++] = ip;
+        }
+    }
+    if (count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    inet_pton(AF_INET, ip_list[atl_resolver_fallback_next % count], &in);
+    *addr = in.s_addr;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_resolver_revalidate_task(void *pvParameters)
+ * @brief Refresh expired cache entries at background.
+ * @param[in] pvParameters - Not used
+ */
+static void atl_resolver_revalidate_task(void *pvParameters) {
+    char hostname[ATL_RESOLVER_HOSTNAME_LEN];
+    uint32_t addr, ttl;
+    int64_t now = atl_resolver_now();
+    for (uint8_t i = 0; i < ATL_RESOLVER_CACHE_SIZE; i++) {
+        hostname[0] = '\0';
+        if (xSemaphoreTake(atl_resolver_mutex, portMAX_DELAY) == pdTRUE) {
+            if ((atl_resolver_cache.entry[i].hostname[0] != '\0') && (atl_resolver_cache.entry[i].expires <= now)) {
+                memcpy(hostname, atl_resolver_cache.entry[i].hostname, sizeof(hostname));
+            }
+            xSemaphoreGive(atl_resolver_mutex);
+        }
+        if ((hostname[0] != '\0') && (atl_resolver_query(hostname, &addr, &ttl) == ESP_OK)) {
+            ESP_LOGI(TAG, "Revalidated %s (TTL %lus)", hostname, ttl);
+            atl_resolver_store(hostname, addr, ttl);
+        }
+    }
+    atl_resolver_revalidating = false;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @fn atl_resolver_init(void)
+ * @brief Initialize resolver cache (kept at RTC memory across deep sleep, restored from NVS after reboot).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_resolver_init(void) {
+    nvs_handle_t nvs_handler;
+    size_t file_size = sizeof(atl_resolver_cache_t);
+    int64_t now = atl_resolver_now();
+
+    if (atl_resolver_mutex == NULL) {
+        atl_resolver_mutex = xSemaphoreCreateMutex();
+        if (atl_resolver_mutex == NULL) {
+            ESP_LOGE(TAG, "Fail creating resolver mutex!");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* Cold boot, restore addresses from NVS (expired, they are served while revalidating) */
+    if (atl_resolver_cache.magic != ATL_RESOLVER_MAGIC) {
+        memset(&atl_resolver_cache, 0, sizeof(atl_resolver_cache_t));
+        if (nvs_open("nvs", NVS_READONLY, &nvs_handler) == ESP_OK) {
+            if ((nvs_get_blob(nvs_handler, "dns_cache", &atl_resolver_cache, &file_size) != ESP_OK) ||
+                (file_size != sizeof(atl_resolver_cache_t))) {
+                memset(&atl_resolver_cache, 0, sizeof(atl_resolver_cache_t));
+            }
+            nvs_close(nvs_handler);
+        }
+        atl_resolver_cache.magic = ATL_RESOLVER_MAGIC;
+        for (uint8_t i = 0; i < ATL_RESOLVER_CACHE_SIZE; i++) {
+            atl_resolver_cache.entry[i].hostname[ATL_RESOLVER_HOSTNAME_LEN - 1] = '\0';
+            atl_resolver_cache.entry[i].expires = 0;
+            atl_resolver_cache.entry[i].invalid = false;
+        }
+    }
+
+    /* System time may have been set backwards/forwards (SNTP), do not trust expirations beyond max. TTL */
+    for (uint8_t i = 0; i < ATL_RESOLVER_CACHE_SIZE; i++) {
+        if (atl_resolver_cache.entry[i].expires > now + CONFIG_ATL_RESOLVER_TTL_MAX) {
+            atl_resolver_cache.entry[i].expires = 0;
+            atl_resolver_cache.entry[i].invalid = false;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_resolver_resolve(const char *hostname, char *ip_str, size_t ip_str_size)
+ * @brief Resolve a hostname to an IPv4 address string.
+ * @param[in] hostname - Hostname
+ * @param[out] ip_str - IPv4 address string
+ * @param[in] ip_str_size - IPv4 address string buffer size (at least ATL_RESOLVER_IP_STR_LEN)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if not resolved, otherwise fail.
+ */
+esp_err_t atl_resolver_resolve(const char *hostname, char *ip_str, size_t ip_str_size) {
+    atl_resolver_entry_t *entry;
+    struct in_addr in;
+    uint32_t addr = 0, ttl, last_addr = 0;
+    bool cached = false, stale = false;
+
+    /* IP literal */
+    if (inet_pton(AF_INET, hostname, &in) == 1) {
+        return (inet_ntop(AF_INET, &in, ip_str, ip_str_size) != NULL) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+    if ((atl_resolver_mutex == NULL) || (hostname[0] == '\0') || (strlen(hostname) >= ATL_RESOLVER_HOSTNAME_LEN)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xSemaphoreTake(atl_resolver_mutex, portMAX_DELAY) == pdTRUE) {
+        entry = atl_resolver_find(hostname);
+        if (entry != NULL) {
+            last_addr = entry->addr;
+            if (entry->invalid == false) {
+                addr = entry->addr;
+                cached = true;
+                stale = (entry->expires <= atl_resolver_now());
+            }
+        }
+        if ((stale == true) && (atl_resolver_revalidating == false)) {
+            atl_resolver_revalidating = true;
+            if (xTaskCreatePinnedToCore(atl_resolver_revalidate_task, "atl_resolver_task", 4096, NULL, 5, NULL, 1) != pdPASS) {
+                atl_resolver_revalidating = false;
+            }
+        }
+        xSemaphoreGive(atl_resolver_mutex);
+    }
+
+    if (cached == true) {
+        ESP_LOGI(TAG, "Resolved %s from cache%s", hostname, (stale == true) ? " (stale, revalidating)" : "");
+    } else if (atl_resolver_query(hostname, &addr, &ttl) == ESP_OK) {
+        ESP_LOGI(TAG, "Resolved %s (TTL %lus)", hostname, ttl);
+        atl_resolver_store(hostname, addr, ttl);
+    } else if (atl_resolver_fallback(hostname, &addr) == ESP_OK) {
+        ESP_LOGW(TAG, "Using fallback address for %s", hostname);
+    } else if (last_addr != 0) {
+        ESP_LOGW(TAG, "Using last known address for %s", hostname);
+        addr = last_addr;
+    } else {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    in.s_addr = addr;
+    return (inet_ntop(AF_INET, &in, ip_str, ip_str_size) != NULL) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @fn atl_resolver_invalidate(const char *hostname)
+ * @brief Invalidate a cached address (i.e. connection failed), so next resolution is not served from cache.
+ * @param[in] hostname - Hostname
+ */
+void atl_resolver_invalidate(const char *hostname) {
+    atl_resolver_entry_t *entry;
+    if (atl_resolver_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(atl_resolver_mutex, portMAX_DELAY) == pdTRUE) {
+        entry = atl_resolver_find(hostname);
+        if (entry != NULL) {
+            entry->invalid = true;
+            entry->expires = 0;
+        }
+        atl_resolver_fallback_next++;
+        xSemaphoreGive(atl_resolver_mutex);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file atl_resolver.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Hostname resolver cache header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_RESOLVER_CACHE_SIZE     4       /**< Max. cached hostnames.*/
+#define ATL_RESOLVER_HOSTNAME_LEN   64      /**< Max. hostname length (including null terminator).*/
+#define ATL_RESOLVER_IP_STR_LEN     16      /**< IPv4 string length (including null terminator).*/
+
+/**
+ * @fn atl_resolver_init(void)
+ * @brief Initialize resolver cache (kept at RTC memory across deep sleep, restored from NVS after reboot).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_resolver_init(void);
+
+/**
+ * @fn atl_resolver_resolve(const char *hostname, char *ip_str, size_t ip_str_size)
+ * @brief Resolve a hostname to an IPv4 address string.
+ * @details Fresh cache entries are returned immediately. Expired entries are also returned immediately (stale while
+ *  revalidate) and refreshed at background. Hostnames not cached are resolved synchronously and, if resolution fails,
+ *  the default broker falls back to CONFIG_ATL_RESOLVER_FALLBACK_IP. IP literals are returned unchanged.
+ * @param[in] hostname - Hostname
+ * @param[out] ip_str - IPv4 address string
+ * @param[in] ip_str_size - IPv4 address string buffer size (at least ATL_RESOLVER_IP_STR_LEN)
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if not resolved, otherwise fail.
+ */
+esp_err_t atl_resolver_resolve(const char *hostname, char *ip_str, size_t ip_str_size);
+
+/**
+ * @fn atl_resolver_invalidate(const char *hostname)
+ * @brief Invalidate a cached address (i.e. connection failed), so next resolution is not served from cache.
+ * @param[in] hostname - Hostname
+ */
+void atl_resolver_invalidate(const char *hostname);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,333 @@
+/**
+ * @file atl_stall.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Stall detector (latency budgets of tasks and handlers).
+ * @details Handlers and task loops time their sections against a registered budget. A periodic monitor reports a
+ *  section while it is still over budget (with the task state, blocked or running), and the section end counts the
+ *  overrun and keeps a backtrace snapshot of the offending call path (logged as code addresses, decoded by idf.py
+ *  monitor or addr2line).
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "sdkconfig.h"
+#if defined(CONFIG_ATL_STALL) && defined(CONFIG_IDF_TARGET_ARCH_XTENSA)
+#include <esp_debug_helpers.h>
+#include <esp_cpu_utils.h>
+#endif
+#include "atl_stall.h"
+
+#ifdef CONFIG_ATL_STALL
+
+/**
+ * @typedef atl_stall_entry_t
+ * @brief Latency budget (statistics and section in progress).
+ */
+typedef struct {
+    atl_stall_info_t    info;           /**< Budget statistics.*/
+    bool                active;         /**< Section in progress.*/
+    int64_t             start_us;       /**< Section start.*/
+    TaskHandle_t        task;           /**< Task timing the section.*/
+    char                state;          /**< Task state when monitor found section over budget (0 if not found).*/
+} atl_stall_entry_t;
+
+/* Constants */
+static const char *TAG = "atl-stall";
+static const char atl_stall_state_str[] = {'R', 'R', 'B', 'S', 'D', '?'};
+
+/* Global variables */
+static atl_stall_entry_t atl_stall_entries[CONFIG_ATL_STALL_MAX_BUDGETS];
+static size_t atl_stall_entry_count = 0;
+static uint32_t atl_stall_overruns = 0;
+static esp_timer_handle_t atl_stall_timer = NULL;
+static uint32_t atl_stall_open = 0;                 /* Sections in progress (monitor runs only while a section is open) */
+static portMUX_TYPE atl_stall_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @fn atl_stall_backtrace(uint32_t *backtrace)
+ * @brief Take a backtrace snapshot of calling task.
+ * @param[out] backtrace - Return addresses (0 terminated if shorter than ATL_STALL_BACKTRACE_DEPTH)
+ */
+static void atl_stall_backtrace(uint32_t *backtrace) {
+    memset(backtrace, 0, ATL_STALL_BACKTRACE_DEPTH * sizeof(uint32_t));
+#ifdef CONFIG_IDF_TARGET_ARCH_XTENSA
+    esp_backtrace_frame_t frame = { 0 };
+    esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+    for (int i = 0; i < ATL_STALL_BACKTRACE_DEPTH; i++) {
+        backtrace[i] = esp_cpu_process_stack_pc(frame.pc);
+        if ((frame.next_pc == 0) || (esp_backtrace_get_next_frame(&frame) == false)) {
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * @fn atl_stall_monitor_cb(void *args)
+ * @brief Stall monitor, report sections in progress over budget (once per section).
+ * @param[in] args - Not used
+ */
+static void atl_stall_monitor_cb(void *args) {
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < atl_stall_entry_count; i++) {
+        atl_stall_entry_t *entry = &atl_stall_entries[i];
+        portENTER_CRITICAL(&atl_stall_lock);
+        int64_t start_us = entry->start_us;
+        TaskHandle_t task = entry->task;
+        bool report = ((entry->active == true) && (entry->state == 0) && ((now - start_us) > ((int64_t)entry->info.budget_ms * 1000)));
+        portEXIT_CRITICAL(&atl_stall_lock);
+        if (report == false) {
+            continue;
+        }
+
+        /* Blocked means waiting (lock, queue or network), ready/running means busy at CPU or preempted */
+        eTaskState state = eTaskGetState(task);
+        char state_chr = atl_stall_state_str[(state <= eInvalid) ? state : eInvalid];
+        portENTER_CRITICAL(&atl_stall_lock);
+        if ((entry->active == true) && (entry->start_us == start_us)) {
+            entry->state = state_chr;
+        }
+        portEXIT_CRITICAL(&atl_stall_lock);
+        ESP_LOGW(TAG, "Stall in progress: %s at task %s for %lu ms (budget %lu ms, task state %c)", entry->info.name,
+            pcTaskGetName(task), (unsigned long)((now - start_us) / 1000), (unsigned long)entry->info.budget_ms, state_chr);
+    }
+}
+
+/**
+ * @fn atl_stall_init(void)
+ * @brief Start the stall monitor (in-progress overruns are reported while they happen).
+ * @details Monitor timer runs only while a section is open, so it does not wake the chip from light sleep while idle.
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_stall_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_stall_timer != NULL) {
+        return ESP_OK;
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = atl_stall_monitor_cb,
+        .name = "atl_stall",
+    };
+    esp_timer_handle_t timer = NULL;
+    err = esp_timer_create(&timer_args, &timer);
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+
+    /* Sections may be open already (begun before monitor start) */
+    portENTER_CRITICAL(&atl_stall_lock);
+    atl_stall_timer = timer;
+    if (atl_stall_open > 0) {
+        err = esp_timer_start_periodic(atl_stall_timer, CONFIG_ATL_STALL_CHECK_PERIOD * 1000);
+    }
+    portEXIT_CRITICAL(&atl_stall_lock);
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+    ESP_LOGI(TAG, "Stall monitor started (check every %d ms while a section is open)", CONFIG_ATL_STALL_CHECK_PERIOD);
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
+
+/**
+ * @fn atl_stall_register(const char *name, uint32_t budget_ms)
+ * @brief Register a latency budget (may be called before atl_stall_init()).
+ * @details A budget is timed by one task at a time. Tasks time each loop iteration calling atl_stall_end() before
+ *  blocking on purpose and atl_stall_begin() after it.
+ * @param[in] name - Budget name (must be a string constant, only its pointer is stored)
+ * @param[in] budget_ms - Latency budget (in ms)
+ * @return int - Budget identifier (negative if disabled at menuconfig or budget table is full).
+ */
+int atl_stall_register(const char *name, uint32_t budget_ms) {
+    int id = -1;
+    portENTER_CRITICAL(&atl_stall_lock);
+    if (atl_stall_entry_count < CONFIG_ATL_STALL_MAX_BUDGETS) {
+        id = atl_stall_entry_count;
+        memset(&atl_stall_entries[id], 0, sizeof(atl_stall_entry_t));
+        atl_stall_entries[id].info.name = name;
+        atl_stall_entries[id].info.budget_ms = budget_ms;
+        atl_stall_entry_count++;
+    }
+    portEXIT_CRITICAL(&atl_stall_lock);
+    if (id < 0) {
+        ESP_LOGW(TAG, "Budget table full, %s not registered!", name);
+    }
+    return id;
+}
+
+/**
+ * @fn atl_stall_begin(int id)
+ * @brief Begin a section timed against its budget at calling task (monitor is started at first open section).
+ * @param[in] id - Budget identifier (ignored if negative)
+ */
+void atl_stall_begin(int id) {
+    if ((id < 0) || (id >= atl_stall_entry_count)) {
+        return;
+    }
+    atl_stall_entry_t *entry = &atl_stall_entries[id];
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&atl_stall_lock);
+    if ((entry->active == false) && (atl_stall_open++ == 0) && (atl_stall_timer != NULL)) {
+        esp_timer_start_periodic(atl_stall_timer, CONFIG_ATL_STALL_CHECK_PERIOD * 1000);
+    }
+    entry->active = true;
+    entry->start_us = now;
+    entry->task = task;
+    entry->state = 0;
+    portEXIT_CRITICAL(&atl_stall_lock);
+}
+
+/**
+ * @fn atl_stall_end(int id)
+ * @brief End a timed section (overrun is counted with a backtrace snapshot, ignored if section was not begun).
+ * @details Monitor is stopped when no section is left open.
+ * @param[in] id - Budget identifier (ignored if negative)
+ */
+void atl_stall_end(int id) {
+    if ((id < 0) || (id >= atl_stall_entry_count)) {
+        return;
+    }
+    atl_stall_entry_t *entry = &atl_stall_entries[id];
+    int64_t now = esp_timer_get_time();
+    uint32_t backtrace[ATL_STALL_BACKTRACE_DEPTH];
+
+    portENTER_CRITICAL(&atl_stall_lock);
+    bool active = entry->active;
+    int64_t start_us = entry->start_us;
+    char state = entry->state;
+    entry->active = false;
+    if ((active == true) && (--atl_stall_open == 0) && (atl_stall_timer != NULL)) {
+        esp_timer_stop(atl_stall_timer);
+    }
+    portEXIT_CRITICAL(&atl_stall_lock);
+    if (active == false) {
+        return;
+    }
+    uint32_t elapsed_ms = (now - start_us) / 1000;
+    bool overrun = (elapsed_ms > entry->info.budget_ms);
+
+    /* Snapshot is taken out of the critical section (unwinding the stack is slow) */
+    const char *task_name = pcTaskGetName(NULL);
+    if (overrun == true) {
+        atl_stall_backtrace(backtrace);
+    }
+    portENTER_CRITICAL(&atl_stall_lock);
+    entry->info.runs++;
+    if (elapsed_ms > entry->info.max_ms) {
+        entry->info.max_ms = elapsed_ms;
+    }
+    if (overrun == true) {
+        entry->info.overruns++;
+        entry->info.last_overrun_ms = elapsed_ms;
+        entry->info.last_state = (state != 0) ? state : '?';
+        snprintf(entry->info.last_task, sizeof(entry->info.last_task), "%s", task_name);
+        memcpy(entry->info.backtrace, backtrace, sizeof(backtrace));
+        atl_stall_overruns++;
+    }
+    portEXIT_CRITICAL(&atl_stall_lock);
+    if (overrun == false) {
+        return;
+    }
+    char backtrace_str[ATL_STALL_BACKTRACE_DEPTH * 11 + 1] = "";
+    for (int i = 0, len = 0; (i < ATL_STALL_BACKTRACE_DEPTH) && (backtrace[i] != 0); i++) {
+        len += snprintf(&backtrace_str[len], sizeof(backtrace_str) - len, " 0x%08lx", (unsigned long)backtrace[i]);
+    }
+    ESP_LOGW(TAG, "Stall: %s at task %s took %lu ms (budget %lu ms)", entry->info.name, task_name,
+        (unsigned long)elapsed_ms, (unsigned long)entry->info.budget_ms);
+    ESP_LOGW(TAG, "Backtrace:%s", backtrace_str);
+#ifdef CONFIG_ATL_STALL_ASSERT
+    ESP_LOGE(TAG, "Latency budget exceeded (CONFIG_ATL_STALL_ASSERT), aborting!");
+    abort();
+#endif
+}
+
+/**
+ * @fn atl_stall_count(void)
+ * @brief Get the number of budgets registered.
+ * @return size_t - Budgets registered.
+ */
+size_t atl_stall_count(void) {
+    return atl_stall_entry_count;
+}
+
+/**
+ * @fn atl_stall_get(size_t index, atl_stall_info_t *info)
+ * @brief Get budget statistics.
+ * @param[in] index - Budget index (less than atl_stall_count())
+ * @param[out] info - Budget statistics
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if index is invalid.
+ */
+esp_err_t atl_stall_get(size_t index, atl_stall_info_t *info) {
+    if (index >= atl_stall_entry_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&atl_stall_lock);
+    memcpy(info, &atl_stall_entries[index].info, sizeof(atl_stall_info_t));
+    portEXIT_CRITICAL(&atl_stall_lock);
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_stall_get_overruns(void)
+ * @brief Get overruns of all budgets.
+ * @return uint32_t - Overruns since boot.
+ */
+uint32_t atl_stall_get_overruns(void) {
+    return atl_stall_overruns;
+}
+
+#else
+
+/**
+ * @fn atl_stall_init(void)
+ * @brief Stall detector disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_stall_init(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+int atl_stall_register(const char *name, uint32_t budget_ms) {
+    return -1;
+}
+
+void atl_stall_begin(int id) {
+}
+
+void atl_stall_end(int id) {
+}
+
+size_t atl_stall_count(void) {
+    return 0;
+}
+
+esp_err_t atl_stall_get(size_t index, atl_stall_info_t *info) {
+    return ESP_ERR_INVALID_ARG;
+}
+
+uint32_t atl_stall_get_overruns(void) {
+    return 0;
+}
+
+#endif
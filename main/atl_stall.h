@@ -0,0 +1,116 @@
+/**
+ * @file atl_stall.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Stall detector (latency budgets of tasks and handlers) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATL_STALL_BACKTRACE_DEPTH   8       /**< Return addresses kept of last overrun.*/
+#define ATL_STALL_TASK_NAME_LEN     16      /**< Task name kept of last overrun.*/
+
+/* Budgets of each kind of section (in ms) */
+#ifdef CONFIG_ATL_STALL
+#define ATL_STALL_HANDLER_BUDGET    CONFIG_ATL_STALL_HANDLER_BUDGET
+#define ATL_STALL_FLASH_BUDGET      CONFIG_ATL_STALL_FLASH_BUDGET
+#define ATL_STALL_TASK_BUDGET       CONFIG_ATL_STALL_TASK_BUDGET
+#else
+#define ATL_STALL_HANDLER_BUDGET    0
+#define ATL_STALL_FLASH_BUDGET      0
+#define ATL_STALL_TASK_BUDGET       0
+#endif
+
+/**
+ * @typedef atl_stall_info_t
+ * @brief Latency budget statistics.
+ */
+typedef struct {
+    const char  *name;                                  /**< Budget name.*/
+    uint32_t    budget_ms;                              /**< Latency budget (in ms).*/
+    uint32_t    runs;                                   /**< Sections finished.*/
+    uint32_t    overruns;                               /**< Sections finished over budget.*/
+    uint32_t    max_ms;                                 /**< Longest section (in ms).*/
+    uint32_t    last_overrun_ms;                        /**< Last overrun duration (in ms).*/
+    char        last_task[ATL_STALL_TASK_NAME_LEN];     /**< Task of last overrun.*/
+    char        last_state;                             /**< Task state when overrun was detected (R running/ready, B blocked, ? not seen by monitor).*/
+    uint32_t    backtrace[ATL_STALL_BACKTRACE_DEPTH];   /**< Backtrace of last overrun, taken at section end (0 terminated).*/
+} atl_stall_info_t;
+
+/**
+ * @fn atl_stall_init(void)
+ * @brief Start the stall monitor (in-progress overruns are reported while they happen).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_stall_init(void);
+
+/**
+ * @fn atl_stall_register(const char *name, uint32_t budget_ms)
+ * @brief Register a latency budget (may be called before atl_stall_init()).
+ * @details A budget is timed by one task at a time. Tasks time each loop iteration calling atl_stall_end() before
+ *  blocking on purpose and atl_stall_begin() after it.
+ * @param[in] name - Budget name (must be a string constant, only its pointer is stored)
+ * @param[in] budget_ms - Latency budget (in ms)
+ * @return int - Budget identifier (negative if disabled at menuconfig or budget table is full).
+ */
+int atl_stall_register(const char *name, uint32_t budget_ms);
+
+/**
+ * @fn atl_stall_begin(int id)
+ * @brief Begin a section timed against its budget at calling task.
+ * @param[in] id - Budget identifier (ignored if negative)
+ */
+void atl_stall_begin(int id);
+
+/**
+ * @fn atl_stall_end(int id)
+ * @brief End a timed section (overrun is counted with a backtrace snapshot, ignored if section was not begun).
+ * @param[in] id - Budget identifier (ignored if negative)
+ */
+void atl_stall_end(int id);
+
+/**
+ * @fn atl_stall_count(void)
+ * @brief Get the number of budgets registered.
+ * @return size_t - Budgets registered.
+ */
+size_t atl_stall_count(void);
+
+/**
+ * @fn atl_stall_get(size_t index, atl_stall_info_t *info)
+ * @brief Get budget statistics.
+ * @param[in] index - Budget index (less than atl_stall_count())
+ * @param[out] info - Budget statistics
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_ARG if index is invalid.
+ */
+esp_err_t atl_stall_get(size_t index, atl_stall_info_t *info);
+
+/**
+ * @fn atl_stall_get_overruns(void)
+ * @brief Get overruns of all budgets.
+ * @return uint32_t - Overruns since boot.
+ */
+uint32_t atl_stall_get_overruns(void);
+
+#ifdef __cplusplus
+}
+#endif
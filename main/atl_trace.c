@@ -0,0 +1,515 @@
+/**
+ * @file atl_trace.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Span and task tracing.
+ * @details Events (span begin/end, instant and running task change) are 16 bytes records at a RAM ring that overwrites
+ *  the oldest ones. FreeRTOS trace macros can only be defined by FreeRTOS component itself, so the running task of each
+ *  core is sampled at tick hook and at every span event (a task running less than a tick between spans is not seen).
+ *  SystemView needs the application trace over JTAG, so the ring is exported as Chrome trace event JSON instead.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_freertos_hooks.h>
+#include "sdkconfig.h"
+#include "atl_trace.h"
+
+#ifdef CONFIG_ATL_TRACE
+
+#define ATL_TRACE_LINE          160     /* Max. JSON line of an event */
+#define ATL_TRACE_OUT           1024    /* Output buffer (events are sent in blocks, not one by one) */
+
+/**
+ * @enum atl_trace_type_e
+ * @brief Trace event type.
+ */
+typedef enum {
+    ATL_TRACE_BEGIN = 0,    /**< Span begin.*/
+    ATL_TRACE_END,          /**< Span end.*/
+    ATL_TRACE_INSTANT,      /**< Instant event.*/
+    ATL_TRACE_SWITCH,       /**< Running task changed at core.*/
+} atl_trace_type_e;
+
+/**
+ * @typedef atl_trace_event_t
+ * @brief Trace event (ring record).
+ */
+typedef struct {
+    uint32_t    ts;         /**< Timestamp since trace start (in us).*/
+    const char  *name;      /**< Span or event name (NULL at task switch).*/
+    void        *task;      /**< Task handle.*/
+    uint8_t     type;       /**< Event type (atl_trace_type_e).*/
+    uint8_t     core;       /**< Core.*/
+} atl_trace_event_t;
+
+/**
+ * @typedef atl_trace_stream_t
+ * @brief Trace export output stream.
+ */
+typedef struct {
+    atl_diag_sink_t sink;                   /**< Output function.*/
+    void            *ctx;                   /**< Output function context.*/
+    esp_err_t       err;                    /**< First output error (output stops).*/
+    bool            first;                  /**< Next event is the first (no separator).*/
+    TaskStatus_t    *tasks;                 /**< Tasks alive at export (to name task handles).*/
+    UBaseType_t     task_count;             /**< Tasks at array.*/
+    size_t          len;                    /**< Bytes at output buffer.*/
+    char            line[ATL_TRACE_LINE];   /**< Line buffer.*/
+    char            out[ATL_TRACE_OUT];     /**< Output buffer.*/
+} atl_trace_stream_t;
+
+/* Constants */
+static const char *TAG = "atl-trace";
+
+/* Global variables */
+static atl_trace_event_t *atl_trace_ring = NULL;
+static uint32_t atl_trace_total = 0;                /* Events ever written at ring (ring index = total % size) */
+static int64_t atl_trace_start_us = 0;
+static volatile bool atl_trace_running = false;
+static void *atl_trace_cpu_task[portNUM_PROCESSORS];
+static portMUX_TYPE atl_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @fn atl_trace_put(atl_trace_type_e type, const char *name, void *task, uint8_t core)
+ * @brief Write an event at ring, preceded by a task switch if the running task of the core changed.
+ * @details Called from tick interrupt, so it is kept at IRAM (flash cache may be disabled by a flash write).
+ * @param[in] type - Event type (ATL_TRACE_SWITCH only checks running task)
+ * @param[in] name - Span or event name
+ * @param[in] task - Running task
+ * @param[in] core - Core
+ */
+static void IRAM_ATTR atl_trace_put(atl_trace_type_e type, const char *name, void *task, uint8_t core) {
+    if ((atl_trace_running == false) || (atl_trace_ring == NULL)) {
+        return;
+    }
+    uint32_t ts = (uint32_t)(esp_timer_get_time() - atl_trace_start_us);
+    atl_trace_event_t *event;
+    portENTER_CRITICAL_SAFE(&atl_trace_lock);
+    if (task != atl_trace_cpu_task[core]) {
+        atl_trace_cpu_task[core] = task;
+        event = &atl_trace_ring[atl_trace_total % CONFIG_ATL_TRACE_RING_EVENTS];
+        event->ts = ts;
+        event->name = NULL;
+        event->task = task;
+        event->type = ATL_TRACE_SWITCH;
+        event->core = core;
+        atl_trace_total++;
+    }
+    if (type != ATL_TRACE_SWITCH) {
+        event = &atl_trace_ring[atl_trace_total % CONFIG_ATL_TRACE_RING_EVENTS];
+        event->ts = ts;
+        event->name = name;
+        event->task = task;
+        event->type = type;
+        event->core = core;
+        atl_trace_total++;
+    }
+    portEXIT_CRITICAL_SAFE(&atl_trace_lock);
+}
+
+#ifdef CONFIG_ATL_TRACE_TASK_SWITCH
+/**
+ * @fn atl_trace_tick_hook(void)
+ * @brief Tick hook, sample the running task of the core.
+ */
+static void IRAM_ATTR atl_trace_tick_hook(void) {
+    BaseType_t core = xPortGetCoreID();
+    atl_trace_put(ATL_TRACE_SWITCH, NULL, xTaskGetCurrentTaskHandleForCore(core), core);
+}
+#endif
+
+/**
+ * @fn atl_trace_record(atl_trace_type_e type, const char *name)
+ * @brief Write an event of calling task at ring.
+ * @param[in] type - Event type
+ * @param[in] name - Span or event name
+ */
+static void atl_trace_record(atl_trace_type_e type, const char *name) {
+    if (atl_trace_running == false) {
+        return;
+    }
+    atl_trace_put(type, name, xTaskGetCurrentTaskHandle(), xPortGetCoreID());
+}
+
+/**
+ * @fn atl_trace_write(atl_trace_stream_t *stream, const char *data, size_t len)
+ * @brief Write data to export output buffer (sent to sink when full).
+ * @param[in,out] stream - Output stream
+ * @param[in] data - Data
+ * @param[in] len - Data length
+ */
+static void atl_trace_write(atl_trace_stream_t *stream, const char *data, size_t len) {
+    while ((len > 0) && (stream->err == ESP_OK)) {
+        size_t n = MIN(len, sizeof(stream->out) - stream->len);
+        memcpy(&stream->out[stream->len], data, n);
+        stream->len += n;
+        data += n;
+        len -= n;
+        if (stream->len == sizeof(stream->out)) {
+            stream->err = stream->sink(stream->ctx, stream->out, stream->len);
+            stream->len = 0;
+        }
+    }
+}
+
+/**
+ * @fn atl_trace_flush(atl_trace_stream_t *stream)
+ * @brief Send export output buffer to sink.
+ * @param[in,out] stream - Output stream
+ */
+static void atl_trace_flush(atl_trace_stream_t *stream) {
+    if ((stream->err == ESP_OK) && (stream->len > 0)) {
+        stream->err = stream->sink(stream->ctx, stream->out, stream->len);
+        stream->len = 0;
+    }
+}
+
+/**
+ * @fn atl_trace_printf(atl_trace_stream_t *stream, const char *fmt, ...)
+ * @brief Write formatted text to export output (nothing is written after an output error).
+ * @param[in,out] stream - Output stream
+ * @param[in] fmt - Text format
+ */
+static void atl_trace_printf(atl_trace_stream_t *stream, const char *fmt, ...) {
+    if (stream->err != ESP_OK) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(stream->line, sizeof(stream->line), fmt, args);
+    va_end(args);
+    if (len > 0) {
+        atl_trace_write(stream, stream->line, MIN(len, sizeof(stream->line) - 1));
+    }
+}
+
+/**
+ * @fn atl_trace_event_printf(atl_trace_stream_t *stream, const char *fmt, ...)
+ * @brief Write a trace event object (separated from previous one) to export output.
+ * @param[in,out] stream - Output stream
+ * @param[in] fmt - Event object format
+ */
+static void atl_trace_event_printf(atl_trace_stream_t *stream, const char *fmt, ...) {
+    if (stream->err != ESP_OK) {
+        return;
+    }
+    char *line = stream->line;
+    size_t size = sizeof(stream->line);
+    if (stream->first == false) {
+        line[0] = ',';
+        line[1] = '\n';
+        line += 2;
+        size -= 2;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, size, fmt, args);
+    va_end(args);
+    if (len > 0) {
+        len = MIN(len, size - 1) + (line - stream->line);
+        atl_trace_write(stream, stream->line, len);
+        stream->first = false;
+    }
+}
+
+/**
+ * @fn atl_trace_task_name(atl_trace_stream_t *stream, void *task, char *name, size_t name_len)
+ * @brief Get task name from its handle (tasks deleted since the event are named by handle).
+ * @param[in] stream - Output stream (with tasks alive)
+ * @param[in] task - Task handle
+ * @param[out] name - Task name
+ * @param[in] name_len - Task name buffer size
+ */
+static void atl_trace_task_name(atl_trace_stream_t *stream, void *task, char *name, size_t name_len) {
+    for (UBaseType_t i = 0; i < stream->task_count; i++) {
+        if (stream->tasks[i].xHandle == task) {
+            snprintf(name, name_len, "%s", stream->tasks[i].pcTaskName);
+            return;
+        }
+    }
+    snprintf(name, name_len, "task@0x%08lx", (uint32_t)(uintptr_t)task);
+}
+
+/**
+ * @fn atl_trace_init(void)
+ * @brief Initialize tracing (task switch sampling and start at boot, if enabled at menuconfig).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_trace_init(void) {
+    esp_err_t err = ESP_OK;
+#ifdef CONFIG_ATL_TRACE_TASK_SWITCH
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        err = esp_register_freertos_tick_hook_for_cpu(atl_trace_tick_hook, core);
+        if (err != ESP_OK) {
+            goto error_proc;
+        }
+    }
+#endif
+#ifdef CONFIG_ATL_TRACE_AUTOSTART
+    err = atl_trace_start();
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+#endif
+    ESP_LOGI(TAG, "Tracing initialized (%d events ring, %s)", CONFIG_ATL_TRACE_RING_EVENTS,
+        (atl_trace_running == true) ? "running" : "stopped");
+    return err;
+
+    /* Error procedure */
+#if defined(CONFIG_ATL_TRACE_TASK_SWITCH) || defined(CONFIG_ATL_TRACE_AUTOSTART)
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+#endif
+}
+
+/**
+ * @fn atl_trace_start(void)
+ * @brief Clear trace ring and start tracing (ring is allocated at first start).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_trace_start(void) {
+    /* Internal RAM, ring is written from tick interrupt even while flash cache is disabled */
+    if (atl_trace_ring == NULL) {
+        atl_trace_event_t *ring = heap_caps_calloc(CONFIG_ATL_TRACE_RING_EVENTS, sizeof(atl_trace_event_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (ring == NULL) {
+            ESP_LOGE(TAG, "Fail allocating trace ring (%d bytes)!", CONFIG_ATL_TRACE_RING_EVENTS * sizeof(atl_trace_event_t));
+            return ESP_ERR_NO_MEM;
+        }
+        atl_trace_ring = ring;
+    }
+    atl_trace_running = false;
+    portENTER_CRITICAL(&atl_trace_lock);
+    atl_trace_total = 0;
+    memset(atl_trace_cpu_task, 0, sizeof(atl_trace_cpu_task));
+    atl_trace_start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&atl_trace_lock);
+    atl_trace_running = true;
+    ESP_LOGI(TAG, "Tracing started");
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_trace_stop(void)
+ * @brief Stop tracing (events are kept at ring until next start).
+ */
+void atl_trace_stop(void) {
+    if (atl_trace_running == true) {
+        atl_trace_running = false;
+        ESP_LOGI(TAG, "Tracing stopped");
+    }
+}
+
+/**
+ * @fn atl_trace_begin(const char *name)
+ * @brief Begin a span at calling task.
+ * @param[in] name - Span name (must be a string constant, only its pointer is stored)
+ */
+void atl_trace_begin(const char *name) {
+    atl_trace_record(ATL_TRACE_BEGIN, name);
+}
+
+/**
+ * @fn atl_trace_end(const char *name)
+ * @brief End a span at calling task.
+ * @param[in] name - Span name (same as atl_trace_begin())
+ */
+void atl_trace_end(const char *name) {
+    atl_trace_record(ATL_TRACE_END, name);
+}
+
+/**
+ * @fn atl_trace_instant(const char *name)
+ * @brief Record an instant event at calling task.
+ * @param[in] name - Event name (must be a string constant, only its pointer is stored)
+ */
+void atl_trace_instant(const char *name) {
+    atl_trace_record(ATL_TRACE_INSTANT, name);
+}
+
+/**
+ * @fn atl_trace_get_status(atl_trace_status_t *status)
+ * @brief Get trace status.
+ * @param[out] status - Trace status
+ */
+void atl_trace_get_status(atl_trace_status_t *status) {
+    portENTER_CRITICAL(&atl_trace_lock);
+    uint32_t total = atl_trace_total;
+    portEXIT_CRITICAL(&atl_trace_lock);
+    status->running = atl_trace_running;
+    status->capacity = CONFIG_ATL_TRACE_RING_EVENTS;
+    status->events = MIN(total, CONFIG_ATL_TRACE_RING_EVENTS);
+    status->dropped = total - status->events;
+}
+
+/**
+ * @fn atl_trace_export(atl_diag_sink_t sink, void *ctx)
+ * @brief Write trace ring as Chrome trace event JSON (opened by Perfetto UI and chrome://tracing).
+ * @details Spans are at process "spans" (one thread per task) and running task samples at process "cpu" (one thread
+ *  per core). Tracing is paused while exporting.
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise first sink error.
+ */
+esp_err_t atl_trace_export(atl_diag_sink_t sink, void *ctx) {
+    atl_trace_stream_t *stream = calloc(1, sizeof(atl_trace_stream_t));
+    if (stream == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stream->sink = sink;
+    stream->ctx = ctx;
+    stream->err = ESP_OK;
+    stream->first = true;
+
+    /* Tasks alive (to name task handles) */
+    UBaseType_t task_max = uxTaskGetNumberOfTasks() + 4;
+    stream->tasks = calloc(task_max, sizeof(TaskStatus_t));
+    if (stream->tasks != NULL) {
+        stream->task_count = uxTaskGetSystemState(stream->tasks, task_max, NULL);
+    }
+
+    /* Pause tracing, so ring is not overwritten while it is read */
+    bool was_running = atl_trace_running;
+    atl_trace_running = false;
+    portENTER_CRITICAL(&atl_trace_lock);
+    uint32_t total = atl_trace_total;
+    portEXIT_CRITICAL(&atl_trace_lock);
+    uint32_t pos = (total > CONFIG_ATL_TRACE_RING_EVENTS) ? (total - CONFIG_ATL_TRACE_RING_EVENTS) : 0;
+
+    /* Header and track names */
+    atl_trace_printf(stream, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"events\":%lu,\"dropped\":%lu},\"traceEvents\":[\n",
+        total - pos, pos);
+    atl_trace_event_printf(stream, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"spans\"}}");
+    atl_trace_event_printf(stream, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"cpu\"}}");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        atl_trace_event_printf(stream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}", core, core);
+    }
+    for (UBaseType_t i = 0; i < stream->task_count; i++) {
+        atl_trace_event_printf(stream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+            (uint32_t)(uintptr_t)stream->tasks[i].xHandle, stream->tasks[i].pcTaskName);
+    }
+
+    /* Events (running task is a span at its core track) */
+    void *cpu_task[portNUM_PROCESSORS] = { 0 };
+    uint32_t ts = 0;
+    char task_name[configMAX_TASK_NAME_LEN + 16];
+    for (; (pos < total) && (stream->err == ESP_OK); pos++) {
+        portENTER_CRITICAL(&atl_trace_lock);
+        atl_trace_event_t event = atl_trace_ring[pos % CONFIG_ATL_TRACE_RING_EVENTS];
+        portEXIT_CRITICAL(&atl_trace_lock);
+        ts = event.ts;
+        uint32_t tid = (uint32_t)(uintptr_t)event.task;
+        switch (event.type) {
+            case ATL_TRACE_BEGIN:
+                atl_trace_event_printf(stream, "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%lu,\"pid\":1,\"tid\":%lu,\"args\":{\"core\":%u}}",
+                    event.name, ts, tid, event.core);
+                break;
+            case ATL_TRACE_END:
+                atl_trace_event_printf(stream, "{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%lu,\"pid\":1,\"tid\":%lu}", event.name, ts, tid);
+                break;
+            case ATL_TRACE_INSTANT:
+                atl_trace_event_printf(stream, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,\"pid\":1,\"tid\":%lu}", event.name, ts, tid);
+                break;
+            case ATL_TRACE_SWITCH:
+                if (event.core >= portNUM_PROCESSORS) {
+                    break;
+                }
+                if (cpu_task[event.core] != NULL) {
+                    atl_trace_event_printf(stream, "{\"ph\":\"E\",\"ts\":%lu,\"pid\":2,\"tid\":%u}", ts, event.core);
+                }
+                atl_trace_task_name(stream, event.task, task_name, sizeof(task_name));
+                atl_trace_event_printf(stream, "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%lu,\"pid\":2,\"tid\":%u}", task_name, ts, event.core);
+                cpu_task[event.core] = event.task;
+                break;
+            default:
+                break;
+        }
+    }
+
+    /* Close running task spans at last event */
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (cpu_task[core] != NULL) {
+            atl_trace_event_printf(stream, "{\"ph\":\"E\",\"ts\":%lu,\"pid\":2,\"tid\":%d}", ts, core);
+        }
+    }
+    atl_trace_printf(stream, "\n]}\n");
+    atl_trace_flush(stream);
+    atl_trace_running = was_running;
+
+    esp_err_t err = stream->err;
+    free(stream->tasks);
+    free(stream);
+    return err;
+}
+
+#else
+
+/**
+ * @fn atl_trace_init(void)
+ * @brief Tracing disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_trace_init(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @fn atl_trace_start(void)
+ * @brief Tracing disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_trace_start(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void atl_trace_stop(void) {
+}
+
+void atl_trace_begin(const char *name) {
+}
+
+void atl_trace_end(const char *name) {
+}
+
+void atl_trace_instant(const char *name) {
+}
+
+/**
+ * @fn atl_trace_get_status(atl_trace_status_t *status)
+ * @brief Tracing disabled at menuconfig (empty status).
+ * @param[out] status - Trace status
+ */
+void atl_trace_get_status(atl_trace_status_t *status) {
+    memset(status, 0, sizeof(atl_trace_status_t));
+}
+
+/**
+ * @fn atl_trace_export(atl_diag_sink_t sink, void *ctx)
+ * @brief Tracing disabled at menuconfig.
+ * @return esp_err_t - ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t atl_trace_export(atl_diag_sink_t sink, void *ctx) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file atl_trace.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief Span and task tracing header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "atl_diag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef atl_trace_status_t
+ * @brief Trace status.
+ */
+typedef struct {
+    bool        running;    /**< Tracing is running.*/
+    uint32_t    capacity;   /**< Ring capacity (in events).*/
+    uint32_t    events;     /**< Events at ring.*/
+    uint32_t    dropped;    /**< Oldest events overwritten since trace start.*/
+} atl_trace_status_t;
+
+/**
+ * @fn atl_trace_init(void)
+ * @brief Initialize tracing (task switch sampling and start at boot, if enabled at menuconfig).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_trace_init(void);
+
+/**
+ * @fn atl_trace_start(void)
+ * @brief Clear trace ring and start tracing (ring is allocated at first start).
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise fail.
+ */
+esp_err_t atl_trace_start(void);
+
+/**
+ * @fn atl_trace_stop(void)
+ * @brief Stop tracing (events are kept at ring until next start).
+ */
+void atl_trace_stop(void);
+
+/**
+ * @fn atl_trace_begin(const char *name)
+ * @brief Begin a span at calling task.
+ * @param[in] name - Span name (must be a string constant, only its pointer is stored)
+ */
+void atl_trace_begin(const char *name);
+
+/**
+ * @fn atl_trace_end(const char *name)
+ * @brief End a span at calling task.
+ * @param[in] name - Span name (same as atl_trace_begin())
+ */
+void atl_trace_end(const char *name);
+
+/**
+ * @fn atl_trace_instant(const char *name)
+ * @brief Record an instant event at calling task.
+ * @param[in] name - Event name (must be a string constant, only its pointer is stored)
+ */
+void atl_trace_instant(const char *name);
+
+/**
+ * @fn atl_trace_get_status(atl_trace_status_t *status)
+ * @brief Get trace status.
+ * @param[out] status - Trace status
+ */
+void atl_trace_get_status(atl_trace_status_t *status);
+
+/**
+ * @fn atl_trace_export(atl_diag_sink_t sink, void *ctx)
+ * @brief Write trace ring as Chrome trace event JSON (opened by Perfetto UI and chrome://tracing).
+ * @details Spans are at process "spans" (one thread per task) and running task samples at process "cpu" (one thread
+ *  per core). Tracing is paused while exporting.
+ * @param[in] sink - Output function
+ * @param[in] ctx - Output function context
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig, otherwise first sink error.
+ */
+esp_err_t atl_trace_export(atl_diag_sink_t sink, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,7 +4,7 @@
  * @brief Webserver function.
  * @version 0.1.0
  * @date 2024-03-11 (created)
- * @date 2024-03-18 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -17,14 +17,31 @@
 #include <esp_err.h>
 #include <esp_log.h>
 #include <esp_https_server.h>
+#include <esp_http_server.h>
+#include <esp_netif.h>
+#include <lwip/sockets.h>
 #include <esp_tls_crypto.h>
 #include <esp_ota_ops.h>
 #include <esp_image_format.h>
 #include <esp_mac.h>
+#include <esp_timer.h>
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+#include <esp_http_client.h>
+#include <mbedtls/sha256.h>
+#endif
 #include <cJSON.h>
 #include "atl_webserver.h"
 #include "atl_config.h"
 #include "atl_led.h"
+#include "atl_diag.h"
+#include "atl_cellular.h"
+#include "atl_lora.h"
+#include "atl_wifi_link.h"
+#include "atl_netprof.h"
+#include "atl_trace.h"
+#include "atl_stall.h"
+#include "atl_energy.h"
+#include "atl_pm.h"
 
 /* Constants */
 static const char *TAG = "atl-webserver";
@@ -46,6 +63,284 @@ extern const unsigned char prvtkey_pem_end[] asm("_binary_prvtkey_pem_end");
 /* Global external variables */
 extern atl_config_t atl_config;
 
+/**
+ * @typedef atl_webserver_probe_t
+ * @brief Captive portal connectivity probe (OS specific answer).
+ */
+typedef struct {
+    const char  *uri;       /**< Probe URI (query string ignored).*/
+    bool        redirect;   /**< Answer with a redirect to portal (otherwise with a small HTML page pointing to it).*/
+} atl_webserver_probe_t;
+
+/**
+ * @brief Connectivity probes of main OSs. Any answer other than the expected "online" one makes the OS to open the
+ *  portal, so probes are answered at once with the smallest response that points to it.
+ */
+static const atl_webserver_probe_t atl_webserver_probe_table[] = {
+    {"/generate_204",                   true},      /* Android, ChromeOS */
+    {"/gen_204",                        true},      /* Android */
+    {"/hotspot-detect.html",            false},     /* Apple iOS/macOS (requires content) */
+    {"/library/test/success.html",      false},     /* Apple (older) */
+    {"/connecttest.txt",                true},      /* Windows 10+ */
+    {"/ncsi.txt",                       true},      /* Windows 7/8 */
+    {"/redirect",                       true},      /* Windows (opened after a failed probe) */
+    {"/success.txt",                    true},      /* Firefox */
+    {"/canonical.html",                 true},      /* Firefox */
+    {"/check_network_status.txt",       true},      /* Linux (KDE) */
+    {"/nm-check.txt",                   true},      /* Linux (NetworkManager) */
+};
+
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+/* Loopback page request timeout (in ms) */
+#define ATL_WEBSERVER_FETCH_TIMEOUT 10000
+#endif
+
+/* Portal address (from SoftAP netif) */
+static char atl_webserver_https_base[24] = "https://192.168.4.1";
+static char atl_webserver_portal_url[48] = "https://192.168.4.1/index.html";
+static uint32_t atl_webserver_ap_addr = 0;
+static httpd_handle_t atl_webserver_http_server = NULL;
+
+/* Handlers streaming large bodies (downloads and firmware upload) are not timed against a latency budget */
+#define ATL_WEBSERVER_NO_BUDGET             0
+
+#if defined(CONFIG_ATL_TRACE) || defined(CONFIG_ATL_STALL) || defined(CONFIG_ATL_ENERGY)
+/**
+ * @typedef atl_webserver_wrapped_uri_t
+ * @brief URI handler registered through instrumentation wrapper.
+ */
+typedef struct {
+    httpd_uri_t uri;        /**< Registered URI handler.*/
+    int         stall;      /**< Handler latency budget.*/
+} atl_webserver_wrapped_uri_t;
+
+/* Handlers registered through instrumentation wrapper (HTTPS and plain HTTP listeners) */
+#define ATL_WEBSERVER_WRAPPED_URI_MAX       40
+static atl_webserver_wrapped_uri_t atl_webserver_wrapped_uri[ATL_WEBSERVER_WRAPPED_URI_MAX];
+static size_t atl_webserver_wrapped_uri_count = 0;
+#endif
+
+/**
+ * @enum    atl_webserver_page_id_e
+ * @brief   Cached webpages (cache key, httpd reuses the same request URI buffer for every request).
+ */
+typedef enum {
+    ATL_WEBSERVER_PAGE_NONE = 0,    /**< Not cached (free cache entry).*/
+    ATL_WEBSERVER_PAGE_CONF_WIFI,   /**< WiFi configuration.*/
+    ATL_WEBSERVER_PAGE_CONF_MQTT,   /**< MQTT configuration.*/
+    ATL_WEBSERVER_PAGE_CONF_4G,     /**< Cellular configuration.*/
+    ATL_WEBSERVER_PAGE_CONF_LORA,   /**< LoRaWAN configuration.*/
+    ATL_WEBSERVER_PAGE_FW_UPDATE,   /**< Firmware update.*/
+    ATL_WEBSERVER_PAGE_REBOOT,      /**< Reboot.*/
+} atl_webserver_page_id_e;
+
+/**
+ * @typedef atl_webserver_page_t
+ * @brief Webpage being rendered (sent as chunks if there is no memory to buffer it).
+ */
+typedef struct {
+    httpd_req_t             *req;           /**< Request.*/
+    atl_webserver_page_id_e id;             /**< Page (cache key).*/
+    char                    *buf;           /**< Rendered page (NULL if sending chunks).*/
+    size_t                  len;            /**< Rendered page length.*/
+    size_t                  size;           /**< Rendered page buffer size.*/
+    uint32_t                generation;     /**< Configuration generation used to render the page.*/
+} atl_webserver_page_t;
+
+/**
+ * @typedef atl_webserver_page_cache_t
+ * @brief Rendered webpage cache entry.
+ */
+typedef struct {
+    atl_webserver_page_id_e id;             /**< Page (ATL_WEBSERVER_PAGE_NONE if entry is free).*/
+    char                    *body;          /**< Full page (header, article and footer).*/
+    size_t                  len;            /**< Full page length.*/
+    uint32_t                generation;     /**< Configuration generation used to render the page.*/
+    uint32_t                last_used;      /**< Last use tick (LRU eviction).*/
+} atl_webserver_page_cache_t;
+
+/* Rendered webpages (accessed only from HTTPS server task) */
+#define ATL_WEBSERVER_PAGE_CACHE_ENTRIES    4
+#define ATL_WEBSERVER_PAGE_CHUNK            1024
+static atl_webserver_page_cache_t atl_webserver_page_cache[ATL_WEBSERVER_PAGE_CACHE_ENTRIES];
+static size_t atl_webserver_page_cache_used = 0;
+static uint32_t atl_webserver_page_cache_tick = 0;
+
+/**
+ * @fn atl_webserver_page_cache_send(httpd_req_t *req, atl_webserver_page_id_e id)
+ * @brief Send a page from rendered page cache (in a single send).
+ * @param[in] req - request
+ * @param[in] id - Page
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if page is not cached or is outdated.
+ */
+static esp_err_t atl_webserver_page_cache_send(httpd_req_t *req, atl_webserver_page_id_e id) {
+    uint32_t generation = atl_config_get_generation();
+    for (uint8_t i = 0; i < ATL_WEBSERVER_PAGE_CACHE_ENTRIES; i++) {
+        atl_webserver_page_cache_t *entry = &atl_webserver_page_cache[i];
+        if ((entry->id == ATL_WEBSERVER_PAGE_NONE) || (entry->id != id)) {
+            continue;
+        }
+        if (entry->generation != generation) {
+            atl_webserver_page_cache_used -= entry->len;
+            free(entry->body);
+            memset(entry, 0, sizeof(atl_webserver_page_cache_t));
+            return ESP_ERR_NOT_FOUND;
+        }
+        entry->last_used = ++atl_webserver_page_cache_tick;
+        httpd_resp_set_status(req, HTTPD_200);
+        httpd_resp_set_type(req, "text/html");
+        httpd_resp_set_hdr(req, "Connection", "keep-alive");
+        httpd_resp_send(req, entry->body, entry->len);
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @fn atl_webserver_page_cache_store(atl_webserver_page_id_e id, char *body, size_t len, uint32_t generation)
+ * @brief Store a rendered page at cache (least recently used pages are evicted to fit it).
+ * @param[in] id - Page
+ * @param[in] body - Full page (ownership is taken if stored)
+ * @param[in] len - Full page length
+ * @param[in] generation - Configuration generation used to render the page
+ * @return bool - True if stored, otherwise body still belongs to caller.
+ */
+static bool atl_webserver_page_cache_store(atl_webserver_page_id_e id, char *body, size_t len, uint32_t generation) {
+    uint8_t free_entry = ATL_WEBSERVER_PAGE_CACHE_ENTRIES;
+    if ((id == ATL_WEBSERVER_PAGE_NONE) || (len > CONFIG_ATL_WEBSERVER_PAGE_CACHE_SIZE) || (generation != atl_config_get_generation())) {
+        return false;
+    }
+
+    /* Evict least recently used pages until it fits */
+    while (atl_webserver_page_cache_used + len > CONFIG_ATL_WEBSERVER_PAGE_CACHE_SIZE) {
+        atl_webserver_page_cache_t *lru = NULL;
+        for (uint8_t i = 0; i < ATL_WEBSERVER_PAGE_CACHE_ENTRIES; i++) {
+            if ((atl_webserver_page_cache[i].id != ATL_WEBSERVER_PAGE_NONE) && ((lru == NULL) || (atl_webserver_page_cache[i].last_used < lru->last_used))) {
+                lru = &atl_webserver_page_cache[i];
+            }
+        }
+        if (lru == NULL) {
+            return false;
+        }
+        atl_webserver_page_cache_used -= lru->len;
+        free(lru->body);
+        memset(lru, 0, sizeof(atl_webserver_page_cache_t));
+    }
+    for (uint8_t i = 0; i < ATL_WEBSERVER_PAGE_CACHE_ENTRIES; i++) {
+        if (atl_webserver_page_cache[i].id == ATL_WEBSERVER_PAGE_NONE) {
+            free_entry = i;
+            break;
+        }
+    }
+    if (free_entry == ATL_WEBSERVER_PAGE_CACHE_ENTRIES) {
+        return false;
+    }
+    atl_webserver_page_cache[free_entry].id = id;
+    atl_webserver_page_cache[free_entry].body = body;
+    atl_webserver_page_cache[free_entry].len = len;
+    atl_webserver_page_cache[free_entry].generation = generation;
+    atl_webserver_page_cache[free_entry].last_used = ++atl_webserver_page_cache_tick;
+    atl_webserver_page_cache_used += len;
+    return true;
+}
+
+/**
+ * @fn atl_webserver_page_append(atl_webserver_page_t *page, const char *str)
+ * @brief Append a string to webpage being rendered.
+ * @param[in] page - Webpage being rendered
+ * @param[in] str - String to append
+ */
+static void atl_webserver_page_append(atl_webserver_page_t *page, const char *str) {
+    size_t str_len = strlen(str);
+    if (page->buf != NULL && (page->len + str_len + 1 > page->size)) {
+        size_t size = page->size + ((str_len > ATL_WEBSERVER_PAGE_CHUNK) ? str_len : ATL_WEBSERVER_PAGE_CHUNK);
+        char *buf = realloc(page->buf, size);
+        if (buf == NULL) {
+            /* Out of memory, send what was rendered and continue as chunks */
+            httpd_resp_send_chunk(page->req, page->buf, page->len);
+            free(page->buf);
+            page->buf = NULL;
+        } else {
+            page->buf = buf;
+            page->size = size;
+        }
+    }
+    if (page->buf == NULL) {
+        httpd_resp_send_chunk(page->req, str, str_len);
+        return;
+    }
+    memcpy(&page->buf[page->len], str, str_len);
+    page->len += str_len;
+}
+
+/**
+ * @fn atl_webserver_page_begin(atl_webserver_page_t *page, httpd_req_t *req, atl_webserver_page_id_e id)
+ * @brief Start rendering a webpage (response header and page header).
+ * @param[out] page - Webpage being rendered
+ * @param[in] req - request
+ * @param[in] id - Page (cache key)
+ */
+static void atl_webserver_page_begin(atl_webserver_page_t *page, httpd_req_t *req, atl_webserver_page_id_e id) {
+    const size_t header_size = (header_end - header_start);
+    page->req = req;
+    page->id = id;
+    page->len = 0;
+    page->size = header_size + (4 * ATL_WEBSERVER_PAGE_CHUNK);
+    page->buf = malloc(page->size);
+    page->generation = atl_config_get_generation();
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+
+    /* Page header (binary file, not null terminated) */
+    if (page->buf != NULL) {
+        memcpy(page->buf, header_start, header_size);
+        page->len = header_size;
+    } else {
+        httpd_resp_send_chunk(req, (const char *)header_start, header_size);
+    }
+}
+
+/**
+ * @fn atl_webserver_page_end(atl_webserver_page_t *page)
+ * @brief Finish rendering a webpage (page footer), send it and store it at cache.
+ * @param[in] page - Webpage being rendered
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_webserver_page_end(atl_webserver_page_t *page) {
+    const size_t footer_size = (footer_end - footer_start);
+    esp_err_t err;
+    if (page->buf != NULL && (page->len + footer_size > page->size)) {
+        char *buf = realloc(page->buf, page->len + footer_size);
+        if (buf == NULL) {
+            httpd_resp_send_chunk(page->req, page->buf, page->len);
+            free(page->buf);
+            page->buf = NULL;
+        } else {
+            page->buf = buf;
+            page->size = page->len + footer_size;
+        }
+    }
+
+    /* Send as chunks (not cached) */
+    if (page->buf == NULL) {
+        httpd_resp_send_chunk(page->req, (const char *)footer_start, footer_size);
+        return httpd_resp_send_chunk(page->req, NULL, 0);
+    }
+
+    /* Send in a single piece */
+    memcpy(&page->buf[page->len], footer_start, footer_size);
+    page->len += footer_size;
+    err = httpd_resp_send(page->req, page->buf, page->len);
+    if (atl_webserver_page_cache_store(page->id, page->buf, page->len, page->generation) == false) {
+        free(page->buf);
+    }
+    page->buf = NULL;
+    return err;
+}
+
 /**
  * @fn favicon_get_handler(httpd_req_t *req)
  * @brief GET handler for FAVICON file
@@ -127,6 +422,33 @@ static const httpd_uri_t js = {
     .handler = js_get_handler
 };
 
+/**
+ * @fn atl_webserver_probe_handler(httpd_req_t *req)
+ * @brief Answer a captive portal connectivity probe (fast path, no page rendering).
+ * @param[in] req - request
+ * @return esp_err_t - ESP_OK if answered, ESP_ERR_NOT_FOUND if not a probe.
+ */
+static esp_err_t atl_webserver_probe_handler(httpd_req_t *req) {
+    size_t uri_len = strcspn(req->uri, "?");
+    for (uint8_t i = 0; i < sizeof(atl_webserver_probe_table) / sizeof(atl_webserver_probe_t); i++) {
+        if ((strlen(atl_webserver_probe_table[i].uri) == uri_len) && (strncmp(req->uri, atl_webserver_probe_table[i].uri, uri_len) == 0)) {
+            ESP_LOGI(TAG, "Connectivity probe [%s]", atl_webserver_probe_table[i].uri);
+            httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+            if (atl_webserver_probe_table[i].redirect == true) {
+                httpd_resp_set_status(req, "302 Found");
+                httpd_resp_set_hdr(req, "Location", atl_webserver_portal_url);
+                return httpd_resp_send(req, NULL, 0);
+            }
+            char resp_val[160];
+            snprintf(resp_val, sizeof(resp_val), "<html><head><meta http-equiv=\"refresh\" content=\"0;url=%s\"></head><body>GreenField</body></html>", atl_webserver_portal_url);
+            httpd_resp_set_status(req, HTTPD_200);
+            httpd_resp_set_type(req, "text/html");
+            return httpd_resp_send(req, resp_val, HTTPD_RESP_USE_STRLEN);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
 /**
  * @fn http_404_error_handler(httpd_req_t *req, httpd_err_code_t err)
  * @brief 404 error handler
@@ -136,10 +458,25 @@ static const httpd_uri_t js = {
  * @return ESP error code
  */
 static esp_err_t http_404_error_handler(httpd_req_t *req, httpd_err_code_t err) {
+
+    /* Connectivity probes are answered without redirecting to the full home page */
+    if (atl_webserver_probe_handler(req) == ESP_OK) {
+        return ESP_OK;
+    }
     
     /* Set status */
     httpd_resp_set_status(req, "302 Temporary Redirect");
 
+    /* Plain HTTP listener only serves static files, pages are redirected to the same page over HTTPS */
+    if ((atl_webserver_http_server != NULL) && (req->handle == atl_webserver_http_server)) {
+        char location[sizeof(atl_webserver_https_base) + CONFIG_HTTPD_MAX_URI_LEN];
+        snprintf(location, sizeof(location), "%s%s", atl_webserver_https_base, req->uri);
+        httpd_resp_set_hdr(req, "Location", location);
+        httpd_resp_send(req, NULL, 0);
+        ESP_LOGI(TAG, "Redirecting request to HTTPS!");
+        return ESP_OK;
+    }
+
     /* Redirect to the root directory */
     httpd_resp_set_hdr(req, "Location", "/index.html");
 
@@ -203,14 +540,14 @@ static esp_err_t conf_wifi_get_handler(httpd_req_t *req) {
     char resp_val[65];
     ESP_LOGD(TAG, "Sending conf_wifi.html");
 
-    /* Set response status, type and header */
-    httpd_resp_set_status(req, HTTPD_200);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_CONF_WIFI) == ESP_OK) {
+        return ESP_OK;
+    }
 
-    /* Send header chunck */
-    const size_t header_size = (header_end - header_start);
-    httpd_resp_send_chunk(req, (const char *)header_start, header_size);
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_CONF_WIFI);
 
     /* Make a local copy of WIFI configuration */
     atl_config_wifi_t wifi_config;
@@ -224,7 +561,7 @@ static esp_err_t conf_wifi_get_handler(httpd_req_t *req) {
     }
 
     /* Send article chunks */    
-    httpd_resp_sendstr_chunk(req, "<form action=\"conf_wifi_post.html\" method=\"post\"> \
+    atl_webserver_page_append(&page, "<form action=\"conf_wifi_post.html\" method=\"post\"> \
                                       <div class=\"row\"> \
                                       <table><tr><th>Parameter</th><th>Value</th></tr> \
                                       <tr><td>MAC Address</td><td>");
@@ -234,44 +571,39 @@ static esp_err_t conf_wifi_get_handler(httpd_req_t *req) {
         mac_addr[5]++;
     } 
     sprintf(resp_val, "%02X:%02X:%02X:%02X:%02X:%02X", mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5]);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req,"</td></tr><tr><td>WiFi mode</td><td><select name=\"wifi_mode\" id=\"wifi_mode\">");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "</td></tr><tr><td>WiFi mode</td><td><select name=\"wifi_mode\" id=\"wifi_mode\">");
     if (wifi_config.mode == ATL_WIFI_AP_MODE) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"AP_MODE\">Access Point</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"AP_MODE\">Access Point</option> \
                                        <option value=\"STA_MODE\">Station</option> \
                                        </select></td></tr>");
     } else if (wifi_config.mode == ATL_WIFI_STA_MODE) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"AP_MODE\">Access Point</option> \
+        atl_webserver_page_append(&page, "<option value=\"AP_MODE\">Access Point</option> \
                                        <option selected value=\"STA_MODE\">Station</option> \
                                        </select></td></tr>");
     }
     
     /* Process station BSSID name */
-    httpd_resp_sendstr_chunk(req, "<tr><td>Network (BSSID):</td> \
-                                    <td><input type=\"text\" id=\"bssid\" name=\"bssid\" value=\"");        
+    atl_webserver_page_append(&page, "<tr><td>Network (BSSID):</td> \
+                                    <td><input type=\"text\" id=\"bssid\" name=\"bssid\" list=\"ssid_list\" value=\"");        
     sprintf(resp_val, "%s", wifi_config.sta_ssid);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr>");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"><datalist id=\"ssid_list\"></datalist></td></tr>");
 
     /* Process station BSSID password */
-    httpd_resp_sendstr_chunk(req, "<tr><td>Password:</td> \
+    atl_webserver_page_append(&page, "<tr><td>Password:</td> \
                                    <td><input type=\"password\" id=\"pass\" name=\"pass\" value=\"");           
     sprintf(resp_val, "%s", wifi_config.sta_pass);          
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr></table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr></table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
 
     /* Send button chunks */
-    httpd_resp_sendstr_chunk(req, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
-                                    onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form>");     
-
-    /* Send footer chunck */
-    const size_t footer_size = (footer_end - footer_start);
-    httpd_resp_send_chunk(req, (const char *)footer_start, footer_size);
+    atl_webserver_page_append(&page, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
+                                    onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form> \
+                                    <script>getWifiScan(0);</script>");     
 
-    /* Send empty chunk to signal HTTP response completion */
-    httpd_resp_sendstr_chunk(req, NULL);
-
-    return ESP_OK;
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
 }
 
 /**
@@ -285,14 +617,14 @@ static esp_err_t conf_mqtt_get_handler(httpd_req_t *req) {
     char resp_val[65];
     ESP_LOGD(TAG, "Sending conf_mqtt.html");
 
-    /* Set response status, type and header */
-    httpd_resp_set_status(req, HTTPD_200);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_CONF_MQTT) == ESP_OK) {
+        return ESP_OK;
+    }
 
-    /* Send header chunck */
-    const size_t header_size = (header_end - header_start);
-    httpd_resp_send_chunk(req, (const char *)header_start, header_size);
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_CONF_MQTT);
 
     /* Make a local copy of MQTT client configuration */
     atl_mqtt_client_t mqtt_client_config;
@@ -306,84 +638,78 @@ static esp_err_t conf_mqtt_get_handler(httpd_req_t *req) {
     }
     
     /* Send article chunks */    
-    httpd_resp_sendstr_chunk(req, "<form action=\"conf_mqtt_post.html\" method=\"post\"><div class=\"row\"> \
+    atl_webserver_page_append(&page, "<form action=\"conf_mqtt_post.html\" method=\"post\"><div class=\"row\"> \
                                       <table><tr><th>Parameter</th><th>Value</th></tr> \
                                       <tr><td>MQTT Mode</td><td><select name=\"mqtt_mode\" id=\"mqtt_mode\">");
     if (mqtt_client_config.mode == ATL_MQTT_DISABLED) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
                                        <option value=\"ATL_MQTT_AGROTECHLAB_CLOUD\">AgroTechLab Cloud</option> \
                                        <option value=\"ATL_MQTT_THIRD\">Third Server</option> \
                                        </select></td></tr>");
     } else if (mqtt_client_config.mode == ATL_MQTT_AGROTECHLAB_CLOUD) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
                                        <option selected value=\"ATL_MQTT_AGROTECHLAB_CLOUD\">AgroTechLab Cloud</option> \
                                        <option value=\"ATL_MQTT_THIRD\">Third Server</option> \
                                        </select></td></tr>");
     } else if (mqtt_client_config.mode == ATL_MQTT_THIRD) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_MQTT_DISABLED\">MQTT Client Disabled</option> \
                                        <option value=\"ATL_MQTT_AGROTECHLAB_CLOUD\">AgroTechLab Cloud</option> \
                                        <option selected value=\"ATL_MQTT_THIRD\">Third Server</option> \
                                        </select></td></tr>");
     }    
-    httpd_resp_sendstr_chunk(req, "<tr><td>MQTT Server Address</td><td><input type=\"text\" id=\"mqtt_srv_addr\" name=\"mqtt_srv_addr\" value=\"");
+    atl_webserver_page_append(&page, "<tr><td>MQTT Server Address</td><td><input type=\"text\" id=\"mqtt_srv_addr\" name=\"mqtt_srv_addr\" value=\"");
     sprintf(resp_val, "%s", mqtt_client_config.broker_address);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr><tr><td>MQTT Server Port</td><td><input type=\"number\" id=\"mqtt_srv_port\" name=\"mqtt_srv_port\" value=\"");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>MQTT Server Port</td><td><input type=\"number\" id=\"mqtt_srv_port\" name=\"mqtt_srv_port\" value=\"");
     sprintf(resp_val, "%d", mqtt_client_config.broker_port);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr><tr><td>Transport</td><td><select name=\"mqtt_transport\" id=\"mqtt_transport\">");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>Transport</td><td><select name=\"mqtt_transport\" id=\"mqtt_transport\">");
     if (mqtt_client_config.transport == MQTT_TRANSPORT_OVER_TCP) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"MQTT_TRANSPORT_OVER_TCP\">MQTT (TCP)</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"MQTT_TRANSPORT_OVER_TCP\">MQTT (TCP)</option> \
                                        <option value=\"MQTT_TRANSPORT_OVER_SSL\">MQTTS (TCP+TLS)</option></select></td></tr>");
     } else if (mqtt_client_config.transport == MQTT_TRANSPORT_OVER_SSL) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"MQTT_TRANSPORT_OVER_TCP\">MQTT (TCP)</option> \
+        atl_webserver_page_append(&page, "<option value=\"MQTT_TRANSPORT_OVER_TCP\">MQTT (TCP)</option> \
                                        <option selected value=\"MQTT_TRANSPORT_OVER_SSL\">MQTTS (TCP+TLS)</option></select></td></tr>");
     }
-    httpd_resp_sendstr_chunk(req, "<tr><td>Disable Common Name (CN) check</td><td><select name=\"mqtt_disable_cn_check\" id=\"mqtt_disable_cn_check\">");
+    atl_webserver_page_append(&page, "<tr><td>Disable Common Name (CN) check</td><td><select name=\"mqtt_disable_cn_check\" id=\"mqtt_disable_cn_check\">");
     if (mqtt_client_config.disable_cn_check == true) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"true\">true</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"true\">true</option> \
                                        <option value=\"false\">false</option></select></td></tr>");
     } else {
-        httpd_resp_sendstr_chunk(req, "<option value=\"true\">true</option> \
+        atl_webserver_page_append(&page, "<option value=\"true\">true</option> \
                                        <option selected value=\"false\">false</option></select></td></tr>");
     }    
-    httpd_resp_sendstr_chunk(req, "<tr><td>Username</td><td><input type=\"text\" id=\"mqtt_username\" name=\"mqtt_username\" value=\"");
+    atl_webserver_page_append(&page, "<tr><td>Username</td><td><input type=\"text\" id=\"mqtt_username\" name=\"mqtt_username\" value=\"");
     sprintf(resp_val, "%s", mqtt_client_config.user);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr><tr><td>Password</td><td><input type=\"password\" id=\"mqtt_pass\" name=\"mqtt_pass\" value=\"");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>Password</td><td><input type=\"password\" id=\"mqtt_pass\" name=\"mqtt_pass\" value=\"");
     sprintf(resp_val, "%s", mqtt_client_config.pass);
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "\"></td></tr><tr><td>QoS</td><td><select name=\"mqtt_qos\" id=\"mqtt_qos\">");
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>QoS</td><td><select name=\"mqtt_qos\" id=\"mqtt_qos\">");
     if (mqtt_client_config.qos == ATL_MQTT_QOS0) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
                                        <option value=\"ATL_MQTT_QOS1\">At least once (QoS 1)</option> \
                                        <option value=\"ATL_MQTT_QOS2\">Exactly once (QoS 2)</option> \
                                        </select></td></tr>");
     } else if (mqtt_client_config.qos == ATL_MQTT_QOS1) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
                                        <option selected value=\"ATL_MQTT_QOS1\">At least once (QoS 1)</option> \
                                        <option value=\"ATL_MQTT_QOS2\">Exactly once (QoS 2)</option> \
                                        </select></td></tr>");
     } else if (mqtt_client_config.qos == ATL_MQTT_QOS2) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_MQTT_QOS0\">At most once (QoS 0)</option> \
                                        <option value=\"ATL_MQTT_QOS1\">At least once (QoS 1)</option> \
                                        <option selected value=\"ATL_MQTT_QOS2\">Exactly once (QoS 2)</option> \
                                        </select></td></tr>");
     }
-    httpd_resp_sendstr_chunk(req, "</table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");    
+    atl_webserver_page_append(&page, "</table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");    
 
     /* Send button chunks */    
-    httpd_resp_sendstr_chunk(req, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
+    atl_webserver_page_append(&page, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
                                     onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form>");     
 
-    /* Send footer chunck */
-    const size_t footer_size = (footer_end - footer_start);
-    httpd_resp_send_chunk(req, (const char *)footer_start, footer_size);
-
-    /* Send empty chunk to signal HTTP response completion */
-    httpd_resp_sendstr_chunk(req, NULL);
-
-    return ESP_OK;
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
 }
 
 /**
@@ -395,6 +721,85 @@ static const httpd_uri_t conf_mqtt_get = {
     .handler = conf_mqtt_get_handler
 };
 
+/**
+ * @fn atl_webserver_parse_mqtt_form(char *body, atl_mqtt_client_t *mqtt_client)
+ * @brief Parse the MQTT client configuration form body (POST handler and form benchmark).
+ * @details Body is tokenized in place. Fields not present at the form are kept unchanged.
+ * @param[in,out] body - Form body (URL encoded fields, NUL terminated)
+ * @param[in,out] mqtt_client - MQTT client configuration updated with form fields
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if out of memory.
+ */
+esp_err_t atl_webserver_parse_mqtt_form(char *body, atl_mqtt_client_t *mqtt_client) {
+    char* token;
+    char* key;
+    char* value;
+    int token_len, value_len;
+    token = strtok(body, "&");
+    while (token) {
+        token_len = strlen(token);
+        value = strchr(token, '=');
+        if (value == NULL) {
+            token = strtok(NULL, "&");
+            continue;
+        }
+        value++;
+        value_len = strlen(value);
+        key = calloc(1, (token_len - value_len));
+        if (!key) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(key, token, (token_len - value_len - 1));
+        if (strcmp(key, "mqtt_mode") == 0) {
+            if (strcmp(value, "ATL_MQTT_DISABLED") == 0) {
+                mqtt_client->mode = ATL_MQTT_DISABLED;
+            } else if (strcmp(value, "ATL_MQTT_AGROTECHLAB_CLOUD") == 0) {
+                mqtt_client->mode = ATL_MQTT_AGROTECHLAB_CLOUD;
+            } else if (strcmp(value, "ATL_MQTT_THIRD") == 0) {
+                mqtt_client->mode = ATL_MQTT_THIRD;
+            }            
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_srv_addr") == 0) {
+            strncpy((char*)&mqtt_client->broker_address, value, sizeof(mqtt_client->broker_address));
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_srv_port") == 0) {
+            mqtt_client->broker_port = atoi(value);
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_transport") == 0) {
+            if (strcmp(value, "MQTT_TRANSPORT_OVER_TCP") == 0) {
+                mqtt_client->transport = MQTT_TRANSPORT_OVER_TCP;
+            } else if (strcmp(value, "MQTT_TRANSPORT_OVER_SSL") == 0) {
+                mqtt_client->transport = MQTT_TRANSPORT_OVER_SSL;
+            }            
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_disable_cn_check") == 0) {
+            if (strcmp(value, "true") == 0) {
+                mqtt_client->disable_cn_check = true;
+            } else if (strcmp(value, "false") == 0) {
+                mqtt_client->disable_cn_check = false;
+            }
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_username") == 0) {
+            strncpy((char*)&mqtt_client->user, value, sizeof(mqtt_client->user));
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_pass") == 0) {
+            strncpy((char*)&mqtt_client->pass, value, sizeof(mqtt_client->pass));
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "mqtt_qos") == 0) {
+            if (strcmp(value, "ATL_MQTT_QOS0") == 0) {
+                mqtt_client->qos = ATL_MQTT_QOS0;
+            } else if (strcmp(value, "ATL_MQTT_QOS1") == 0) {
+                mqtt_client->qos = ATL_MQTT_QOS1;
+            } else if (strcmp(value, "ATL_MQTT_QOS2") == 0) {
+                mqtt_client->qos = ATL_MQTT_QOS2;
+            }
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        }
+        free(key);
+        token = strtok(NULL, "&");
+    }
+    return ESP_OK;
+}
+
 /**
  * @fn conf_mqtt_update_handler(httpd_req_t *req)
  * @brief POST handler for MQTT Client configuration webpage
@@ -441,6 +846,98 @@ static esp_err_t conf_mqtt_post_handler(httpd_req_t *req) {
         ESP_LOGW(TAG, "Fail to get configuration mutex!");
     }
 
+    /* Parse form fields */
+    if (atl_webserver_parse_mqtt_form(buf, &mqtt_client_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate memory!");
+        free(buf);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    free(buf);
+    
+    /* Update current MQTT client configuration */        
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&atl_config.mqtt_client, &mqtt_client_config, sizeof(atl_mqtt_client_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
+    /* Commit configuration to NVS */
+    atl_config_commit_nvs();    
+
+    /* Restart X200 device */
+    ESP_LOGW(TAG, ">>> Rebooting GreenField!");
+    atl_led_builtin_blink(10, 100, 255, 69, 0);
+    esp_restart();
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP POST Handler for MQTT client webpage
+ */
+static const httpd_uri_t conf_mqtt_post = {
+    .uri = "/conf_mqtt_post.html",
+    .method = HTTP_POST,
+    .handler = conf_mqtt_post_handler
+};
+
+/**
+ * @brief HTTP GET Handler for wifi webpage
+ */
+static const httpd_uri_t conf_wifi_get = {
+    .uri = "/conf_wifi.html",
+    .method = HTTP_GET,
+    .handler = conf_wifi_get_handler
+};
+
+/**
+ * @fn conf_wifi_post_handler(httpd_req_t *req)
+ * @brief POST handler for WiFi configuration webpage
+ * @details HTTP POST handler for WiFi configuration webpage
+ * @param[in] req - request
+ * @return ESP error code
+ */
+static esp_err_t conf_wifi_post_handler(httpd_req_t *req) {
+    ESP_LOGD(TAG, "Processing POST conf_wifi_post");
+
+    /* Allocate memory to process request */
+    int    ret;
+    size_t off = 0;
+    char*  buf = calloc(1, req->content_len + 1);
+    if (!buf) {
+        ESP_LOGE(TAG, "Failed to allocate memory of %d bytes!", req->content_len + 1);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    /* Receive all data */
+    while (off < req->content_len) {
+        /* Read data received in the request */
+        ret = httpd_req_recv(req, buf + off, req->content_len - off);
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                httpd_resp_send_408(req);
+            }
+            free(buf);
+            return ESP_FAIL;
+        }
+        off += ret;
+    }
+    buf[off] = '\0';
+
+    /* Make a local copy of WIFI configuration */
+    atl_config_wifi_t wifi_config;
+    memset(&wifi_config, 0, sizeof(atl_config_wifi_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&wifi_config, &atl_config.wifi, sizeof(atl_config_wifi_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
     /* Search for custom header field */
     char* token;
     char* key;
@@ -458,58 +955,222 @@ static esp_err_t conf_mqtt_post_handler(httpd_req_t *req) {
             return ESP_FAIL;
         }
         memcpy(key, token, (token_len - value_len - 1));
-        if (strcmp(key, "mqtt_mode") == 0) {
-            if (strcmp(value, "ATL_MQTT_DISABLED") == 0) {
-                mqtt_client_config.mode = ATL_MQTT_DISABLED;
-            } else if (strcmp(value, "ATL_MQTT_AGROTECHLAB_CLOUD") == 0) {
-                mqtt_client_config.mode = ATL_MQTT_AGROTECHLAB_CLOUD;
-            } else if (strcmp(value, "ATL_MQTT_THIRD") == 0) {
-                mqtt_client_config.mode = ATL_MQTT_THIRD;
-            }            
-            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_srv_addr") == 0) {
-            strncpy((char*)&mqtt_client_config.broker_address, value, sizeof(mqtt_client_config.broker_address));
+        if (strcmp(key, "wifi_mode") == 0) {
+            if (strcmp(value, "AP_MODE") == 0) {
+                wifi_config.mode = ATL_WIFI_AP_MODE;
+            } else if (strcmp(value, "STA_MODE") == 0) {
+                wifi_config.mode = ATL_WIFI_STA_MODE;
+            } else if (strcmp(value, "WIFI_DISABLED") == 0) {
+                wifi_config.mode = ATL_WIFI_DISABLED;
+            }
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_srv_port") == 0) {
-            mqtt_client_config.broker_port = atoi(value);
+        } else if (strcmp(key, "bssid") == 0) {
+            strncpy((char*)&wifi_config.sta_ssid, value, sizeof(wifi_config.sta_ssid));
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_transport") == 0) {
-            if (strcmp(value, "MQTT_TRANSPORT_OVER_TCP") == 0) {
-                mqtt_client_config.transport = MQTT_TRANSPORT_OVER_TCP;
-            } else if (strcmp(value, "MQTT_TRANSPORT_OVER_SSL") == 0) {
-                mqtt_client_config.transport = MQTT_TRANSPORT_OVER_SSL;
-            }            
+        } else if (strcmp(key, "pass") == 0) {
+            strncpy((char*)&wifi_config.sta_pass, value, sizeof(wifi_config.sta_pass));
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_disable_cn_check") == 0) {
+        }
+        free(key);
+        token = strtok(NULL, "&");
+    }
+    
+    /* Use the channel found at last scan (skip full scan at first connection) */
+    uint8_t sta_channel = atl_wifi_scan_get_channel((const char*)wifi_config.sta_ssid);
+
+    /* Update current WIFI configuration */        
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        if (sta_channel != 0) {
+            wifi_config.sta_channel = sta_channel;
+        } else if (strncmp((const char*)wifi_config.sta_ssid, (const char*)atl_config.wifi.sta_ssid, sizeof(wifi_config.sta_ssid)) != 0) {
+            wifi_config.sta_channel = 0;
+        }
+        memcpy(&atl_config.wifi, &wifi_config, sizeof(atl_config_wifi_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
+    /* Commit configuration to NVS */
+    atl_config_commit_nvs();    
+
+    /* Restart X200 device */
+    ESP_LOGW(TAG, ">>> Rebooting X200!");
+    atl_led_builtin_blink(10, 100, 255, 69, 0);
+    esp_restart();
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP POST Handler for wifi webpage
+ */
+static const httpd_uri_t conf_wifi_post = {
+    .uri = "/conf_wifi_post.html",
+    .method = HTTP_POST,
+    .handler = conf_wifi_post_handler
+};
+
+/**
+ * @fn conf_4g_get_handler(httpd_req_t *req)
+ * @brief GET handler for cellular (4G) configuration webpage
+ * @details HTTP GET handler for cellular (4G) configuration webpage (modem status is loaded by script)
+ * @param[in] req - request
+ * @return ESP error code
+ */
+static esp_err_t conf_4g_get_handler(httpd_req_t *req) {
+    char resp_val[65];
+    ESP_LOGD(TAG, "Sending conf_4g.html");
+
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_CONF_4G) == ESP_OK) {
+        return ESP_OK;
+    }
+
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_CONF_4G);
+
+    /* Make a local copy of cellular configuration */
+    atl_config_cellular_t cellular_config;
+    memset(&cellular_config, 0, sizeof(atl_config_cellular_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&cellular_config, &atl_config.cellular, sizeof(atl_config_cellular_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
+    /* Send article chunks */
+    atl_webserver_page_append(&page, "<form action=\"conf_4g_post.html\" method=\"post\"><div class=\"row\"> \
+                                      <table><tr><th>Parameter</th><th>Value</th></tr> \
+                                      <tr><td>Cellular modem</td><td><select name=\"cell_enabled\" id=\"cell_enabled\">");
+    if (cellular_config.enabled == true) {
+        atl_webserver_page_append(&page, "<option selected value=\"true\">Enabled</option> \
+                                       <option value=\"false\">Disabled</option></select></td></tr>");
+    } else {
+        atl_webserver_page_append(&page, "<option value=\"true\">Enabled</option> \
+                                       <option selected value=\"false\">Disabled</option></select></td></tr>");
+    }
+    atl_webserver_page_append(&page, "<tr><td>APN</td><td><input type=\"text\" id=\"cell_apn\" name=\"cell_apn\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%s", cellular_config.apn);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>SIM PIN</td><td><input type=\"password\" id=\"cell_pin\" name=\"cell_pin\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%.*s", (int)sizeof(cellular_config.pin), cellular_config.pin);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr></table><br> \
+                                      <table><tr><th>Status</th><th>Value</th></tr> \
+                                      <tr><td>Link</td><td id=\"cell_link\">-</td></tr> \
+                                      <tr><td>Registration</td><td id=\"cell_reg\">-</td></tr> \
+                                      <tr><td>Operator</td><td id=\"cell_operator\">-</td></tr> \
+                                      <tr><td>Signal</td><td id=\"cell_signal\">-</td></tr> \
+                                      <tr><td>Cell (TAC/CI)</td><td id=\"cell_id\">-</td></tr> \
+                                      </table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
+
+    /* Send button chunks */
+    atl_webserver_page_append(&page, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
+                                    onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form> \
+                                    <script>getCellularStatus();</script>");
+
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
+}
+
+/**
+ * @brief HTTP GET Handler for cellular (4G) webpage
+ */
+static const httpd_uri_t conf_4g_get = {
+    .uri = "/conf_4g.html",
+    .method = HTTP_GET,
+    .handler = conf_4g_get_handler
+};
+
+/**
+ * @fn conf_4g_post_handler(httpd_req_t *req)
+ * @brief POST handler for cellular (4G) configuration webpage
+ * @details HTTP POST handler for cellular (4G) configuration webpage
+ * @param[in] req - request
+ * @return ESP error code
+ */
+static esp_err_t conf_4g_post_handler(httpd_req_t *req) {
+    ESP_LOGD(TAG, "Processing POST conf_4g_post");
+
+    /* Allocate memory to process request */
+    int    ret;
+    size_t off = 0;
+    char*  buf = calloc(1, req->content_len + 1);
+    if (!buf) {
+        ESP_LOGE(TAG, "Failed to allocate memory of %d bytes!", req->content_len + 1);
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    /* Receive all data */
+    while (off < req->content_len) {
+        /* Read data received in the request */
+        ret = httpd_req_recv(req, buf + off, req->content_len - off);
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                httpd_resp_send_408(req);
+            }
+            free(buf);
+            return ESP_FAIL;
+        }
+        off += ret;
+    }
+    buf[off] = '\0';
+
+    /* Make a local copy of cellular configuration */
+    atl_config_cellular_t cellular_config;
+    memset(&cellular_config, 0, sizeof(atl_config_cellular_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&cellular_config, &atl_config.cellular, sizeof(atl_config_cellular_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
+    /* Search for custom header field */
+    char* token;
+    char* key;
+    char* value;
+    int token_len, value_len;
+    token = strtok(buf, "&");
+    while (token) {
+        token_len = strlen(token);
+        value = strstr(token, "=") + 1;
+        value_len = strlen(value);
+        key = calloc(1, (token_len - value_len));
+        if (!key) {
+            ESP_LOGE(TAG, "Failed to allocate memory!");
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+        memcpy(key, token, (token_len - value_len - 1));
+        if (strcmp(key, "cell_enabled") == 0) {
             if (strcmp(value, "true") == 0) {
-                mqtt_client_config.disable_cn_check = true;
+                cellular_config.enabled = true;
             } else if (strcmp(value, "false") == 0) {
-                mqtt_client_config.disable_cn_check = false;
+                cellular_config.enabled = false;
             }
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_username") == 0) {
-            strncpy((char*)&mqtt_client_config.user, value, sizeof(mqtt_client_config.user));
-            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_pass") == 0) {
-            strncpy((char*)&mqtt_client_config.pass, value, sizeof(mqtt_client_config.pass));
-            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "mqtt_qos") == 0) {
-            if (strcmp(value, "ATL_MQTT_QOS0") == 0) {
-                mqtt_client_config.qos = ATL_MQTT_QOS0;
-            } else if (strcmp(value, "ATL_MQTT_QOS1") == 0) {
-                mqtt_client_config.qos = ATL_MQTT_QOS1;
-            } else if (strcmp(value, "ATL_MQTT_QOS2") == 0) {
-                mqtt_client_config.qos = ATL_MQTT_QOS2;
-            }
+        } else if (strcmp(key, "cell_apn") == 0) {
+            strncpy((char*)&cellular_config.apn, value, sizeof(cellular_config.apn));
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "cell_pin") == 0) {
+            strncpy((char*)&cellular_config.pin, value, sizeof(cellular_config.pin));
+            ESP_LOGI(TAG, "Updating [%s]", key);
         }
         free(key);
         token = strtok(NULL, "&");
     }
-    
-    /* Update current MQTT client configuration */        
+    free(buf);
+
+    /* Update current cellular configuration */
     if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
-        memcpy(&atl_config.mqtt_client, &mqtt_client_config, sizeof(atl_mqtt_client_t));
+        memcpy(&atl_config.cellular, &cellular_config, sizeof(atl_config_cellular_t));
         xSemaphoreGive(atl_config_mutex);
     }
     else {
@@ -517,9 +1178,9 @@ static esp_err_t conf_mqtt_post_handler(httpd_req_t *req) {
     }
 
     /* Commit configuration to NVS */
-    atl_config_commit_nvs();    
+    atl_config_commit_nvs();
 
-    /* Restart X200 device */
+    /* Restart GreenField device */
     ESP_LOGW(TAG, ">>> Rebooting GreenField!");
     atl_led_builtin_blink(10, 100, 255, 69, 0);
     esp_restart();
@@ -527,32 +1188,163 @@ static esp_err_t conf_mqtt_post_handler(httpd_req_t *req) {
 }
 
 /**
- * @brief HTTP POST Handler for MQTT client webpage
+ * @brief HTTP POST Handler for cellular (4G) webpage
  */
-static const httpd_uri_t conf_mqtt_post = {
-    .uri = "/conf_mqtt_post.html",
+static const httpd_uri_t conf_4g_post = {
+    .uri = "/conf_4g_post.html",
     .method = HTTP_POST,
-    .handler = conf_mqtt_post_handler
+    .handler = conf_4g_post_handler
 };
 
 /**
- * @brief HTTP GET Handler for wifi webpage
+ * @fn api_v1_cellular_status_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (answers from last modem status query, modem is never queried by the request)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_cellular_status_handler(httpd_req_t *req) {
+    atl_cellular_status_t status;
+    ESP_LOGD(TAG, "Processing /api/v1/cellular/status");
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Create root JSON object */
+    cJSON *root = cJSON_CreateObject();
+    if (atl_cellular_get_status(&status) != ESP_OK) {
+        cJSON_AddBoolToObject(root, "enabled", false);
+    } else {
+        cJSON_AddBoolToObject(root, "enabled", true);
+        cJSON_AddBoolToObject(root, "started", status.started);
+        cJSON_AddBoolToObject(root, "cmux", status.cmux);
+        cJSON_AddBoolToObject(root, "ppp_up", status.ppp_up);
+        if (status.age_ms == UINT32_MAX) {
+            cJSON_AddNullToObject(root, "age");
+        } else {
+            cJSON_AddNumberToObject(root, "age", status.age_ms / 1000);
+            cJSON_AddBoolToObject(root, "registered", status.registered);
+            cJSON_AddNumberToObject(root, "reg_stat", status.reg_stat);
+            cJSON_AddStringToObject(root, "operator", status.operator_name);
+            cJSON_AddNumberToObject(root, "rssi", status.rssi_dbm);
+            cJSON_AddNumberToObject(root, "ber", status.ber);
+            cJSON_AddNumberToObject(root, "tac", status.tac);
+            cJSON_AddNumberToObject(root, "cell_id", status.cell_id);
+            cJSON_AddNumberToObject(root, "act", status.act);
+        }
+    }
+
+    /* Sent response */
+    const char *status_info = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, status_info);
+
+    /* Free objects */
+    cJSON_Delete(root);
+    free((void *)status_info);
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP GET API Handler for cellular modem status
  */
-static const httpd_uri_t conf_wifi_get = {
-    .uri = "/conf_wifi.html",
+static const httpd_uri_t api_v1_cellular_status = {
+    .uri = "/api/v1/cellular/status",
+    .method = HTTP_GET,
+    .handler = api_v1_cellular_status_handler
+};
+
+/**
+ * @fn conf_lora_get_handler(httpd_req_t *req)
+ * @brief GET handler for LoRaWAN configuration webpage
+ * @details HTTP GET handler for LoRaWAN configuration webpage (uplink status is loaded by script)
+ * @param[in] req - request
+ * @return ESP error code
+ */
+static esp_err_t conf_lora_get_handler(httpd_req_t *req) {
+    char resp_val[65];
+    ESP_LOGD(TAG, "Sending conf_lora.html");
+
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_CONF_LORA) == ESP_OK) {
+        return ESP_OK;
+    }
+
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_CONF_LORA);
+
+    /* Make a local copy of LoRaWAN configuration */
+    atl_config_lora_t lora_config;
+    memset(&lora_config, 0, sizeof(atl_config_lora_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&lora_config, &atl_config.lora, sizeof(atl_config_lora_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    else {
+        ESP_LOGW(TAG, "Fail to get configuration mutex!");
+    }
+
+    /* Send article chunks */
+    atl_webserver_page_append(&page, "<form action=\"conf_lora_post.html\" method=\"post\"><div class=\"row\"> \
+                                      <table><tr><th>Parameter</th><th>Value</th></tr> \
+                                      <tr><td>LoRaWAN uplink</td><td><select name=\"lora_enabled\" id=\"lora_enabled\">");
+    if (lora_config.enabled == true) {
+        atl_webserver_page_append(&page, "<option selected value=\"true\">Enabled</option> \
+                                       <option value=\"false\">Disabled</option></select></td></tr>");
+    } else {
+        atl_webserver_page_append(&page, "<option value=\"true\">Enabled</option> \
+                                       <option selected value=\"false\">Disabled</option></select></td></tr>");
+    }
+    atl_webserver_page_append(&page, "<tr><td>DevEUI</td><td><input type=\"text\" id=\"lora_dev_eui\" name=\"lora_dev_eui\" maxlength=\"16\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%.*s", (int)sizeof(lora_config.dev_eui), lora_config.dev_eui);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>JoinEUI</td><td><input type=\"text\" id=\"lora_join_eui\" name=\"lora_join_eui\" maxlength=\"16\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%.*s", (int)sizeof(lora_config.join_eui), lora_config.join_eui);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>AppKey</td><td><input type=\"password\" id=\"lora_app_key\" name=\"lora_app_key\" maxlength=\"32\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%.*s", (int)sizeof(lora_config.app_key), lora_config.app_key);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr><tr><td>Uplink interval (s)</td><td><input type=\"number\" id=\"lora_interval\" name=\"lora_interval\" min=\"60\" max=\"65535\" value=\"");
+    snprintf(resp_val, sizeof(resp_val), "%d", lora_config.interval);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "\"></td></tr></table><br> \
+                                      <table><tr><th>Status</th><th>Value</th></tr> \
+                                      <tr><td>Network</td><td id=\"lora_net\">-</td></tr> \
+                                      <tr><td>Data rate</td><td id=\"lora_dr\">-</td></tr> \
+                                      <tr><td>Last uplink</td><td id=\"lora_last\">-</td></tr> \
+                                      <tr><td>Airtime (today)</td><td id=\"lora_airtime\">-</td></tr> \
+                                      <tr><td>Last downlink</td><td id=\"lora_signal\">-</td></tr> \
+                                      </table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
+
+    /* Send button chunks */
+    atl_webserver_page_append(&page, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
+                                    onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form> \
+                                    <script>getLoraStatus();</script>");
+
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
+}
+
+/**
+ * @brief HTTP GET Handler for LoRaWAN webpage
+ */
+static const httpd_uri_t conf_lora_get = {
+    .uri = "/conf_lora.html",
     .method = HTTP_GET,
-    .handler = conf_wifi_get_handler
+    .handler = conf_lora_get_handler
 };
 
 /**
- * @fn conf_wifi_post_handler(httpd_req_t *req)
- * @brief POST handler for WiFi configuration webpage
- * @details HTTP POST handler for WiFi configuration webpage
+ * @fn conf_lora_post_handler(httpd_req_t *req)
+ * @brief POST handler for LoRaWAN configuration webpage
+ * @details HTTP POST handler for LoRaWAN configuration webpage
  * @param[in] req - request
  * @return ESP error code
  */
-static esp_err_t conf_wifi_post_handler(httpd_req_t *req) {
-    ESP_LOGD(TAG, "Processing POST conf_wifi_post");
+static esp_err_t conf_lora_post_handler(httpd_req_t *req) {
+    ESP_LOGD(TAG, "Processing POST conf_lora_post");
 
     /* Allocate memory to process request */
     int    ret;
@@ -579,11 +1371,11 @@ static esp_err_t conf_wifi_post_handler(httpd_req_t *req) {
     }
     buf[off] = '\0';
 
-    /* Make a local copy of WIFI configuration */
-    atl_config_wifi_t wifi_config;
-    memset(&wifi_config, 0, sizeof(atl_config_wifi_t));
+    /* Make a local copy of LoRaWAN configuration */
+    atl_config_lora_t lora_config;
+    memset(&lora_config, 0, sizeof(atl_config_lora_t));
     if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
-        memcpy(&wifi_config, &atl_config.wifi, sizeof(atl_config_wifi_t));
+        memcpy(&lora_config, &atl_config.lora, sizeof(atl_config_lora_t));
         xSemaphoreGive(atl_config_mutex);
     }
     else {
@@ -607,29 +1399,34 @@ static esp_err_t conf_wifi_post_handler(httpd_req_t *req) {
             return ESP_FAIL;
         }
         memcpy(key, token, (token_len - value_len - 1));
-        if (strcmp(key, "wifi_mode") == 0) {
-            if (strcmp(value, "AP_MODE") == 0) {
-                wifi_config.mode = ATL_WIFI_AP_MODE;
-            } else if (strcmp(value, "STA_MODE") == 0) {
-                wifi_config.mode = ATL_WIFI_STA_MODE;
-            } else if (strcmp(value, "WIFI_DISABLED") == 0) {
-                wifi_config.mode = ATL_WIFI_DISABLED;
+        if (strcmp(key, "lora_enabled") == 0) {
+            if (strcmp(value, "true") == 0) {
+                lora_config.enabled = true;
+            } else if (strcmp(value, "false") == 0) {
+                lora_config.enabled = false;
             }
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "bssid") == 0) {
-            strncpy((char*)&wifi_config.sta_ssid, value, sizeof(wifi_config.sta_ssid));
+        } else if (strcmp(key, "lora_dev_eui") == 0) {
+            strncpy((char*)&lora_config.dev_eui, value, sizeof(lora_config.dev_eui));
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
-        } else if (strcmp(key, "pass") == 0) {
-            strncpy((char*)&wifi_config.sta_pass, value, sizeof(wifi_config.sta_pass));
+        } else if (strcmp(key, "lora_join_eui") == 0) {
+            strncpy((char*)&lora_config.join_eui, value, sizeof(lora_config.join_eui));
+            ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
+        } else if (strcmp(key, "lora_app_key") == 0) {
+            strncpy((char*)&lora_config.app_key, value, sizeof(lora_config.app_key));
+            ESP_LOGI(TAG, "Updating [%s]", key);
+        } else if (strcmp(key, "lora_interval") == 0) {
+            lora_config.interval = atoi(value);
             ESP_LOGI(TAG, "Updating [%s:%s]", key,  value);
         }
         free(key);
         token = strtok(NULL, "&");
     }
-    
-    /* Update current WIFI configuration */        
+    free(buf);
+
+    /* Update current LoRaWAN configuration */
     if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
-        memcpy(&atl_config.wifi, &wifi_config, sizeof(atl_config_wifi_t));
+        memcpy(&atl_config.lora, &lora_config, sizeof(atl_config_lora_t));
         xSemaphoreGive(atl_config_mutex);
     }
     else {
@@ -637,22 +1434,77 @@ static esp_err_t conf_wifi_post_handler(httpd_req_t *req) {
     }
 
     /* Commit configuration to NVS */
-    atl_config_commit_nvs();    
+    atl_config_commit_nvs();
 
-    /* Restart X200 device */
-    ESP_LOGW(TAG, ">>> Rebooting X200!");
+    /* Restart GreenField device */
+    ESP_LOGW(TAG, ">>> Rebooting GreenField!");
     atl_led_builtin_blink(10, 100, 255, 69, 0);
     esp_restart();
     return ESP_OK;
 }
 
 /**
- * @brief HTTP POST Handler for wifi webpage
+ * @brief HTTP POST Handler for LoRaWAN webpage
  */
-static const httpd_uri_t conf_wifi_post = {
-    .uri = "/conf_wifi_post.html",
+static const httpd_uri_t conf_lora_post = {
+    .uri = "/conf_lora_post.html",
     .method = HTTP_POST,
-    .handler = conf_wifi_post_handler
+    .handler = conf_lora_post_handler
+};
+
+/**
+ * @fn api_v1_lora_status_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (answers from LoRaWAN uplink counters, radio is never accessed by the request)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_lora_status_handler(httpd_req_t *req) {
+    atl_lora_status_t status;
+    ESP_LOGD(TAG, "Processing /api/v1/lora/status");
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Create root JSON object */
+    cJSON *root = cJSON_CreateObject();
+    if (atl_lora_get_status(&status) != ESP_OK) {
+        cJSON_AddBoolToObject(root, "enabled", false);
+    } else {
+        cJSON_AddBoolToObject(root, "enabled", true);
+        cJSON_AddStringToObject(root, "radio", status.radio);
+        cJSON_AddBoolToObject(root, "joined", status.joined);
+        cJSON_AddNumberToObject(root, "dr", status.dr);
+        cJSON_AddNumberToObject(root, "uplinks", status.uplinks);
+        cJSON_AddNumberToObject(root, "deferred", status.deferred);
+        cJSON_AddNumberToObject(root, "last_port", status.last_port);
+        cJSON_AddNumberToObject(root, "last_len", status.last_len);
+        cJSON_AddNumberToObject(root, "last_airtime", status.last_airtime_ms);
+        cJSON_AddNumberToObject(root, "airtime_day", status.airtime_day_ms);
+        cJSON_AddNumberToObject(root, "airtime_budget", CONFIG_ATL_LORA_DAILY_AIRTIME * 1000UL);
+        cJSON_AddNumberToObject(root, "rssi", status.rssi);
+        cJSON_AddNumberToObject(root, "snr", status.snr);
+    }
+
+    /* Sent response */
+    const char *status_info = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, status_info);
+
+    /* Free objects */
+    cJSON_Delete(root);
+    free((void *)status_info);
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP GET API Handler for LoRaWAN uplink status
+ */
+static const httpd_uri_t api_v1_lora_status = {
+    .uri = "/api/v1/lora/status",
+    .method = HTTP_GET,
+    .handler = api_v1_lora_status_handler
 };
 
 /**
@@ -1032,6 +1884,268 @@ static const httpd_uri_t api_v1_system_set_conf = {
     .handler = api_v1_system_set_conf_handler
 };
 
+/**
+ * @fn api_v1_wifi_scan_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (answers from scan cache, a stale cache only triggers a background scan)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_wifi_scan_handler(httpd_req_t *req) {
+    uint8_t count = 0;
+    uint32_t age_ms = 0;
+    bool scanning = false;
+    ESP_LOGD(TAG, "Processing /api/v1/wifi/scan");
+
+    atl_wifi_scan_result_t *results = calloc(CONFIG_ATL_WIFI_SCAN_MAX_AP, sizeof(atl_wifi_scan_result_t));
+    if (results == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory!");
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    atl_wifi_scan_get(results, CONFIG_ATL_WIFI_SCAN_MAX_AP, &count, &age_ms, &scanning);
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Create root JSON object */
+    cJSON *root = cJSON_CreateObject();
+    if (age_ms == UINT32_MAX) {
+        cJSON_AddNullToObject(root, "age");
+    } else {
+        cJSON_AddNumberToObject(root, "age", age_ms / 1000);
+    }
+    cJSON_AddBoolToObject(root, "scanning", scanning);
+    cJSON *root_aps = cJSON_AddArrayToObject(root, "aps");
+    for (uint8_t i = 0; i < count; i++) {
+        cJSON *ap = cJSON_CreateObject();
+        cJSON_AddStringToObject(ap, "ssid", results[i].ssid);
+        cJSON_AddNumberToObject(ap, "rssi", results[i].rssi);
+        cJSON_AddNumberToObject(ap, "channel", results[i].channel);
+        cJSON_AddNumberToObject(ap, "auth", results[i].authmode);
+        cJSON_AddItemToArray(root_aps, ap);
+    }
+    free(results);
+
+    /* Sent response */
+    const char *scan_info = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, scan_info);
+
+    /* Free objects */
+    cJSON_Delete(root);
+    free((void *)scan_info);
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP GET API Handler for WiFi scan results
+ */
+static const httpd_uri_t api_v1_wifi_scan = {
+    .uri = "/api/v1/wifi/scan",
+    .method = HTTP_GET,
+    .handler = api_v1_wifi_scan_handler
+};
+
+/**
+ * @fn api_v1_wifi_link_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (answers from link adaptation metrics, sampled by its own task)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_wifi_link_handler(httpd_req_t *req) {
+    atl_wifi_link_t link;
+    ESP_LOGD(TAG, "Processing /api/v1/wifi/link");
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Create root JSON object */
+    cJSON *root = cJSON_CreateObject();
+    if (atl_wifi_link_get(&link) != ESP_OK) {
+        cJSON_AddBoolToObject(root, "enabled", false);
+    } else {
+        cJSON_AddBoolToObject(root, "enabled", true);
+        cJSON_AddBoolToObject(root, "connected", link.connected);
+        cJSON_AddNumberToObject(root, "rssi", link.rssi);
+        cJSON_AddNumberToObject(root, "rssi_avg", link.rssi_avg);
+        cJSON_AddNumberToObject(root, "rssi_min", link.rssi_min);
+        cJSON_AddNumberToObject(root, "rssi_max", link.rssi_max);
+        cJSON_AddNumberToObject(root, "tx_power", link.tx_power);
+        cJSON_AddNumberToObject(root, "channel", link.channel);
+        cJSON_AddBoolToObject(root, "ap_lr", link.ap_lr);
+        cJSON_AddStringToObject(root, "phy", atl_wifi_link_get_phy_str(link.phy));
+        cJSON_AddNumberToObject(root, "phy_mode", link.phy_mode);
+        cJSON_AddNumberToObject(root, "link_losses", link.link_losses);
+        cJSON_AddNumberToObject(root, "phy_switches", link.phy_switches);
+        cJSON_AddNumberToObject(root, "tx_power_steps", link.tx_power_steps);
+    }
+
+    /* Sent response */
+    const char *link_info = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, link_info);
+
+    /* Free objects */
+    cJSON_Delete(root);
+    free((void *)link_info);
+    return ESP_OK;
+}
+
+/**
+ * @brief HTTP GET API Handler for WiFi STA link metrics
+ */
+static const httpd_uri_t api_v1_wifi_link = {
+    .uri = "/api/v1/wifi/link",
+    .method = HTTP_GET,
+    .handler = api_v1_wifi_link_handler
+};
+
+/**
+ * @typedef api_v1_diagnostics_ctx_t
+ * @brief Diagnostics bundle output context.
+ */
+typedef struct {
+    httpd_req_t     *req;       /**< Request.*/
+    uint32_t        bytes;      /**< Bytes sent.*/
+} api_v1_diagnostics_ctx_t;
+
+/**
+ * @fn api_v1_diagnostics_sink(void *ctx, const char *data, size_t len)
+ * @brief Diagnostics bundle output (HTTP chunk).
+ * @param[in] ctx - Output context
+ * @param[in] data - Bundle data
+ * @param[in] len - Bundle data length
+ * @return ESP error code
+ */
+static esp_err_t api_v1_diagnostics_sink(void *ctx, const char *data, size_t len) {
+    api_v1_diagnostics_ctx_t *diag_ctx = (api_v1_diagnostics_ctx_t *)ctx;
+    diag_ctx->bytes += len;
+    return httpd_resp_send_chunk(diag_ctx->req, data, len);
+}
+
+/**
+ * @fn api_v1_diagnostics_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (diagnostics bundle streamed as chunks)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_diagnostics_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "Processing /api/v1/diagnostics");
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/x-tar");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"greenfield_diag.tar\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Stream bundle (connection is closed if it fails midway) */
+    api_v1_diagnostics_ctx_t diag_ctx = { .req = req, .bytes = 0 };
+    int64_t start_time = esp_timer_get_time();
+    atl_netprof_bulk_begin();
+    esp_err_t err = atl_diag_bundle_write(api_v1_diagnostics_sink, &diag_ctx);
+    atl_netprof_bulk_end(diag_ctx.bytes, (esp_timer_get_time() - start_time) / 1000);
+    if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    /* Send empty chunk to signal HTTP response completion */
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief HTTP GET API Handler for diagnostics bundle
+ */
+static const httpd_uri_t api_v1_diagnostics = {
+    .uri = "/api/v1/diagnostics",
+    .method = HTTP_GET,
+    .handler = api_v1_diagnostics_handler
+};
+
+/**
+ * @fn api_v1_trace_handler(httpd_req_t *req)
+ * @brief GET handler
+ * @details HTTP GET Handler (?action=start or ?action=stop controls tracing, otherwise trace is streamed as Chrome
+ *  trace event JSON)
+ * @param[in] req - request
+ * @return ESP error code
+*/
+static esp_err_t api_v1_trace_handler(httpd_req_t *req) {
+    char query[32];
+    char action[8] = "";
+    atl_trace_status_t status;
+    ESP_LOGI(TAG, "Processing /api/v1/trace");
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "action", action, sizeof(action));
+    }
+
+    /* Start or stop tracing and answer with trace status */
+    if ((strcmp(action, "start") == 0) || (strcmp(action, "stop") == 0)) {
+        if (strcmp(action, "start") == 0) {
+            if (atl_trace_start() != ESP_OK) {
+                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Tracing not available");
+                return ESP_FAIL;
+            }
+        } else {
+            atl_trace_stop();
+        }
+        atl_trace_get_status(&status);
+        httpd_resp_set_status(req, HTTPD_200);
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+        cJSON *root = cJSON_CreateObject();
+        cJSON_AddBoolToObject(root, "running", status.running);
+        cJSON_AddNumberToObject(root, "capacity", status.capacity);
+        cJSON_AddNumberToObject(root, "events", status.events);
+        cJSON_AddNumberToObject(root, "dropped", status.dropped);
+        const char *resp = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+        if (resp == NULL) {
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+        httpd_resp_sendstr(req, resp);
+        cJSON_free((void *)resp);
+        return ESP_OK;
+    }
+
+    /* Set response status, type and header */
+    httpd_resp_set_status(req, HTTPD_200);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"greenfield_trace.json\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Stream trace (connection is closed if it fails midway) */
+    api_v1_diagnostics_ctx_t diag_ctx = { .req = req, .bytes = 0 };
+    int64_t start_time = esp_timer_get_time();
+    atl_netprof_bulk_begin();
+    esp_err_t err = atl_trace_export(api_v1_diagnostics_sink, &diag_ctx);
+    atl_netprof_bulk_end(diag_ctx.bytes, (esp_timer_get_time() - start_time) / 1000);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Tracing disabled at firmware");
+        return ESP_OK;
+    } else if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    /* Send empty chunk to signal HTTP response completion */
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * @brief HTTP GET API Handler for trace export
+ */
+static const httpd_uri_t api_v1_trace = {
+    .uri = "/api/v1/trace",
+    .method = HTTP_GET,
+    .handler = api_v1_trace_handler
+};
+
 /**
  * @fn conf_fw_get_update_handler(httpd_req_t *req)
  * @brief GET handler
@@ -1043,35 +2157,35 @@ static esp_err_t conf_fw_update_get_handler(httpd_req_t *req) {
     ESP_LOGD(TAG, "Sending conf_fw_update.html");
     char resp_val[65];
 
-    /* Set response status, type and header */
-    httpd_resp_set_status(req, HTTPD_200);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_FW_UPDATE) == ESP_OK) {
+        return ESP_OK;
+    }
 
-    /* Send header chunck */
-    const size_t header_size = (header_end - header_start);
-    httpd_resp_send_chunk(req, (const char *)header_start, header_size);
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_FW_UPDATE);
 
     /* Send information chunks */
-    httpd_resp_sendstr_chunk(req, "<table><tr><th>Parameter</th><th>Value</th></tr><tr><td>Firmware version</td><td>");
+    atl_webserver_page_append(&page, "<table><tr><th>Parameter</th><th>Value</th></tr><tr><td>Firmware version</td><td>");
     esp_app_desc_t app_info;
     const esp_partition_t *partition_info_ptr;
     partition_info_ptr = esp_ota_get_running_partition();
     if (esp_ota_get_partition_description(partition_info_ptr, &app_info) == ESP_OK) {
         sprintf(resp_val, "%s", app_info.version);
-        httpd_resp_sendstr_chunk(req, resp_val);
-        httpd_resp_sendstr_chunk(req, "</td></tr><tr><td>Build</td><td>");
+        atl_webserver_page_append(&page, resp_val);
+        atl_webserver_page_append(&page, "</td></tr><tr><td>Build</td><td>");
         sprintf(resp_val, "%s %s", app_info.date, app_info.time);
-        httpd_resp_sendstr_chunk(req, resp_val);
-        httpd_resp_sendstr_chunk(req, "</td></tr><tr><td>SDK version</td><td>");
+        atl_webserver_page_append(&page, resp_val);
+        atl_webserver_page_append(&page, "</td></tr><tr><td>SDK version</td><td>");
         sprintf(resp_val, "%s", app_info.idf_ver);
-        httpd_resp_sendstr_chunk(req, resp_val);
-        httpd_resp_sendstr_chunk(req, "</td></tr><tr><td>Running partition name</td><td>");
+        atl_webserver_page_append(&page, resp_val);
+        atl_webserver_page_append(&page, "</td></tr><tr><td>Running partition name</td><td>");
         sprintf(resp_val, "%s", partition_info_ptr->label);
-        httpd_resp_sendstr_chunk(req, resp_val);
-        httpd_resp_sendstr_chunk(req, "</td></tr><tr><td>Running partition size</td><td>");
+        atl_webserver_page_append(&page, resp_val);
+        atl_webserver_page_append(&page, "</td></tr><tr><td>Running partition size</td><td>");
         sprintf(resp_val, "%ld bytes", partition_info_ptr->size);
-        httpd_resp_sendstr_chunk(req, resp_val);
+        atl_webserver_page_append(&page, resp_val);
     }
     const esp_partition_pos_t running_pos  = {
         .offset = partition_info_ptr->address,
@@ -1080,10 +2194,10 @@ static esp_err_t conf_fw_update_get_handler(httpd_req_t *req) {
     esp_image_metadata_t data;
     data.start_addr = running_pos.offset;
     esp_image_verify(ESP_IMAGE_VERIFY, &running_pos, &data);
-    httpd_resp_sendstr_chunk(req, "</td></tr><tr><td>Running firmware size</td><td>");
+    atl_webserver_page_append(&page, "</td></tr><tr><td>Running firmware size</td><td>");
     sprintf(resp_val, "%ld bytes", data.image_len);
-    httpd_resp_sendstr_chunk(req, resp_val);    
-    httpd_resp_sendstr_chunk(req, "</td></tr></table><br><br>");
+    atl_webserver_page_append(&page, resp_val);    
+    atl_webserver_page_append(&page, "</td></tr></table><br><br>");
 
     /* Make a local copy of WIFI configuration */
     atl_config_ota_t ota_config;
@@ -1097,52 +2211,46 @@ static esp_err_t conf_fw_update_get_handler(httpd_req_t *req) {
     }
 
     /* Send parameters chunks */
-    httpd_resp_sendstr_chunk(req, "<form action=\"conf_fw_update_post.html\" method=\"post\"> \
+    atl_webserver_page_append(&page, "<form action=\"conf_fw_update_post.html\" method=\"post\"> \
                                       <div class=\"row\"> \
                                       <table><tr><th>Parameter</th><th>Value</th></tr> \
                                       <tr><td>FW Update Behaviour</td>");
     
-    httpd_resp_sendstr_chunk(req,"<td><select name=\"ota_behaviour\" id=\"ota_behaviour\">");
+    atl_webserver_page_append(&page, "<td><select name=\"ota_behaviour\" id=\"ota_behaviour\">");
     if (ota_config.behaviour == ATL_OTA_BEHAVIOUR_DISABLED) {
-        httpd_resp_sendstr_chunk(req, "<option selected value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
+        atl_webserver_page_append(&page, "<option selected value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
                                        <option value=\"ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY\">Verify & Notify</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD\">Download</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT\">Download & Reboot</option> \
                                        </select></td></tr>");
     } else if (ota_config.behaviour == ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
                                        <option selected value=\"ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY\">Verify & Notify</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD\">Download</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT\">Download & Reboot</option> \
                                        </select></td></tr>");
     } else if (ota_config.behaviour == ATL_OTA_BEHAVIOU_DOWNLOAD) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
                                        <option value=\"ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY\">Verify & Notify</option> \
                                        <option selected value=\"ATL_OTA_BEHAVIOU_DOWNLOAD\">Download</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT\">Download & Reboot</option> \
                                        </select></td></tr>");
     } else if (ota_config.behaviour == ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT) {
-        httpd_resp_sendstr_chunk(req, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
+        atl_webserver_page_append(&page, "<option value=\"ATL_OTA_BEHAVIOUR_DISABLED\">Disabled</option> \
                                        <option value=\"ATL_OTA_BEHAVIOUR_VERIFY_NOTIFY\">Verify & Notify</option> \
                                        <option value=\"ATL_OTA_BEHAVIOU_DOWNLOAD\">Download</option> \
                                        <option selected value=\"ATL_OTA_BEHAVIOU_DOWNLOAD_REBOOT\">Download & Reboot</option> \
                                        </select></td></tr>");
     }
-    httpd_resp_sendstr_chunk(req, "</table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
+    atl_webserver_page_append(&page, "</table><br><div class=\"reboot-msg\" id=\"delayMsg\"></div>");
 
     /* Send button chunks */    
-    httpd_resp_sendstr_chunk(req, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
+    atl_webserver_page_append(&page, "<br><input class=\"btn_generic\" name=\"btn_save_reboot\" type=\"submit\" \
                                     onclick=\"delayRedirect()\" value=\"Save & Reboot\"></div></form>"); 
-    //httpd_resp_sendstr_chunk(req, "</td></tr></table><br><input class=\"btn_generic\" name=\"btn_upload_fw\" type=\"submit\" value=\"Upload firmware\"></div></form>");
+    //atl_webserver_page_append(&page, "</td></tr></table><br><input class=\"btn_generic\" name=\"btn_upload_fw\" type=\"submit\" value=\"Upload firmware\"></div></form>");
 
-    /* Send footer chunck */
-    const size_t footer_size = (footer_end - footer_start);
-    httpd_resp_send_chunk(req, (const char *)footer_start, footer_size);
-
-    /* Send empty chunk to signal HTTP response completion */
-    httpd_resp_sendstr_chunk(req, NULL);
-
-    return ESP_OK;
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
 }
 
 /**
@@ -1264,17 +2372,17 @@ static esp_err_t conf_reboot_get_handler(httpd_req_t *req) {
     ESP_LOGD(TAG, "Sending conf_reboot.html");
     char resp_val[65];
 
-    /* Set response status, type and header */
-    httpd_resp_set_status(req, HTTPD_200);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    /* Send cached page if configuration was not changed since it was rendered */
+    if (atl_webserver_page_cache_send(req, ATL_WEBSERVER_PAGE_REBOOT) == ESP_OK) {
+        return ESP_OK;
+    }
 
-    /* Send header chunck */
-    const size_t header_size = (header_end - header_start);
-    httpd_resp_send_chunk(req, (const char *)header_start, header_size);
+    /* Render page header */
+    atl_webserver_page_t page;
+    atl_webserver_page_begin(&page, req, ATL_WEBSERVER_PAGE_REBOOT);
 
     /* Send article chunks */
-    httpd_resp_sendstr_chunk(req, "<form action=\"conf_reboot_post.html\" method=\"post\"> \
+    atl_webserver_page_append(&page, "<form action=\"conf_reboot_post.html\" method=\"post\"> \
         <div class=\"row\"> \
         <table><tr><th>Parameter</th><th>Value</th></tr> \
         <tr><td>Last reboot reason</td><td>");
@@ -1303,17 +2411,11 @@ static esp_err_t conf_reboot_get_handler(httpd_req_t *req) {
     } else if (reset_reason == ESP_RST_SDIO) {
         sprintf(resp_val, "Reset over SDIO");
     }
-    httpd_resp_sendstr_chunk(req, resp_val);
-    httpd_resp_sendstr_chunk(req, "</td></tr></table><br><input class=\"btn_generic\" name=\"btn_reboot\" type=\"submit\" value=\"Reboot X200\"></div></form>");
-
-    /* Send footer chunck */
-    const size_t footer_size = (footer_end - footer_start);
-    httpd_resp_send_chunk(req, (const char *)footer_start, footer_size);
-
-    /* Send empty chunk to signal HTTP response completion */
-    httpd_resp_sendstr_chunk(req, NULL);
+    atl_webserver_page_append(&page, resp_val);
+    atl_webserver_page_append(&page, "</td></tr></table><br><input class=\"btn_generic\" name=\"btn_reboot\" type=\"submit\" value=\"Reboot X200\"></div></form>");
 
-    return ESP_OK;
+    /* Render page footer, send and cache it */
+    return atl_webserver_page_end(&page);
 }
 
 /**
@@ -1449,6 +2551,62 @@ static esp_err_t basic_auth_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+#if defined(CONFIG_ATL_TRACE) || defined(CONFIG_ATL_STALL) || defined(CONFIG_ATL_ENERGY)
+/**
+ * @fn atl_webserver_wrapper_handler(httpd_req_t *req)
+ * @brief Instrumentation wrapper of URI handlers (trace span named by URI, latency budget and portal energy section
+ *  around the handler).
+ * @param[in] req - request (user context is the registered URI handler)
+ * @return ESP error code
+ */
+static esp_err_t atl_webserver_wrapper_handler(httpd_req_t *req) {
+    const atl_webserver_wrapped_uri_t *wrapped = req->user_ctx;
+
+    /* Handler gets its own user context */
+    req->user_ctx = wrapped->uri.user_ctx;
+    atl_trace_begin(wrapped->uri.uri);
+    atl_stall_begin(wrapped->stall);
+    atl_energy_begin(ATL_ENERGY_PORTAL);
+    esp_err_t err = wrapped->uri.handler(req);
+    atl_energy_end(ATL_ENERGY_PORTAL);
+    atl_stall_end(wrapped->stall);
+    atl_trace_end(wrapped->uri.uri);
+    return err;
+}
+#endif
+
+/**
+ * @fn atl_webserver_register_uri(httpd_handle_t server, const httpd_uri_t *uri, uint32_t budget_ms)
+ * @brief Register a URI handler (through instrumentation wrapper, if tracing, stall detector or energy accounting is
+ *  enabled at menuconfig).
+ * @param[in] server - Server handle
+ * @param[in] uri - URI handler (URI string must be a constant, it names the trace span and latency budget)
+ * @param[in] budget_ms - Handler latency budget (in ms, ATL_WEBSERVER_NO_BUDGET for streaming handlers)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_webserver_register_uri(httpd_handle_t server, const httpd_uri_t *uri, uint32_t budget_ms) {
+#if defined(CONFIG_ATL_TRACE) || defined(CONFIG_ATL_STALL) || defined(CONFIG_ATL_ENERGY)
+    if (atl_webserver_wrapped_uri_count < ATL_WEBSERVER_WRAPPED_URI_MAX) {
+        atl_webserver_wrapped_uri_t *wrapped = &atl_webserver_wrapped_uri[atl_webserver_wrapped_uri_count];
+        httpd_uri_t wrapper;
+        memcpy(&wrapped->uri, uri, sizeof(httpd_uri_t));
+        wrapped->stall = -1;
+        memcpy(&wrapper, uri, sizeof(httpd_uri_t));
+        wrapper.handler = atl_webserver_wrapper_handler;
+        wrapper.user_ctx = wrapped;
+        esp_err_t err = httpd_register_uri_handler(server, &wrapper);
+        if ((err == ESP_OK) && (budget_ms != ATL_WEBSERVER_NO_BUDGET)) {
+            wrapped->stall = atl_stall_register(uri->uri, budget_ms);
+        }
+        if (err == ESP_OK) {
+            atl_webserver_wrapped_uri_count++;
+        }
+        return err;
+    }
+#endif
+    return httpd_register_uri_handler(server, uri);
+}
+
 /**
  * @brief HTTP GET Handler for basic authentication
  */
@@ -1479,7 +2637,7 @@ static void httpd_register_basic_auth(httpd_handle_t server) {
     }    
 
     basic_auth.user_ctx = basic_auth_info;
-    httpd_register_uri_handler(server, &basic_auth);
+    atl_webserver_register_uri(server, &basic_auth, ATL_STALL_HANDLER_BUDGET);
 }
 
 /**
@@ -1492,6 +2650,9 @@ static void https_server_user_callback(esp_https_server_user_cb_arg_t *user_cb)
         case HTTPD_SSL_USER_CB_SESS_CREATE:
             ESP_LOGI(TAG, "HTTPS session creation");
 
+            /* Keep awake while session is open (socket is not served during light sleep) */
+            atl_pm_acquire(ATL_PM_LOCK_HTTP);
+
             /* Logging the socket FD */
             int sockfd = -1;
             esp_err_t esp_ret;
@@ -1512,6 +2673,7 @@ static void https_server_user_callback(esp_https_server_user_cb_arg_t *user_cb)
 
         case HTTPD_SSL_USER_CB_SESS_CLOSE:
             ESP_LOGI(TAG, "HTTPS session close");
+            atl_pm_release(ATL_PM_LOCK_HTTP);
 
             /* Logging the peer certificate */
             ssl_ctx = (mbedtls_ssl_context *) esp_tls_get_ssl_context(user_cb->tls);
@@ -1528,6 +2690,162 @@ static void https_server_user_callback(esp_https_server_user_cb_arg_t *user_cb)
     }
 }
 
+/**
+ * @fn atl_webserver_http_open(httpd_handle_t hd, int sockfd)
+ * @brief Plain HTTP listener session open callback (only connections to SoftAP address are accepted).
+ * @param[in] hd - Listener handle
+ * @param[in] sockfd - Session socket
+ * @return esp_err_t - ESP_OK to accept the session, otherwise closed.
+ */
+static esp_err_t atl_webserver_http_open(httpd_handle_t hd, int sockfd) {
+    struct sockaddr_storage local_addr;
+    socklen_t addr_len = sizeof(local_addr);
+    uint32_t addr = 0;
+
+    /* Keep awake while session is open (refused sessions are released at close callback too) */
+    atl_pm_acquire(ATL_PM_LOCK_HTTP);
+    if (getsockname(sockfd, (struct sockaddr*)&local_addr, &addr_len) != 0) {
+        return ESP_FAIL;
+    }
+    if (local_addr.ss_family == AF_INET) {
+        addr = ((struct sockaddr_in*)&local_addr)->sin_addr.s_addr;
+    } else if (local_addr.ss_family == AF_INET6) {
+        /* IPv4 mapped address (dual stack listener) */
+        memcpy(&addr, &((struct sockaddr_in6*)&local_addr)->sin6_addr.s6_addr[12], sizeof(addr));
+    }
+    if (addr != atl_webserver_ap_addr) {
+        ESP_LOGW(TAG, "Plain HTTP session refused (not at SoftAP interface)");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_webserver_http_close(httpd_handle_t hd, int sockfd)
+ * @brief Plain HTTP listener session close callback.
+ * @param[in] hd - Listener handle
+ * @param[in] sockfd - Session socket
+ */
+static void atl_webserver_http_close(httpd_handle_t hd, int sockfd) {
+    atl_pm_release(ATL_PM_LOCK_HTTP);
+    close(sockfd);
+}
+
+/**
+ * @fn atl_webserver_http_init(void)
+ * @brief Start plain HTTP listener at SoftAP interface.
+ * @details Answers captive portal probes (and serves static files if ATL_WEBSERVER_HTTP_ENABLE) without TLS costs,
+ *  everything else (pages with credentials) is redirected to HTTPS.
+ * @return httpd_handle_t - Listener handle (NULL if fail).
+ */
+static httpd_handle_t atl_webserver_http_init(void) {
+    httpd_handle_t server = NULL;
+    esp_netif_ip_info_t ip_info;
+
+    /* Portal address is the SoftAP address */
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
+    if ((netif == NULL) || (esp_netif_get_ip_info(netif, &ip_info) != ESP_OK) || (ip_info.ip.addr == 0)) {
+        ESP_LOGE(TAG, "SoftAP interface not found, plain HTTP listener not started!");
+        return NULL;
+    }
+    atl_webserver_ap_addr = ip_info.ip.addr;
+    snprintf(atl_webserver_https_base, sizeof(atl_webserver_https_base), "https://" IPSTR, IP2STR(&ip_info.ip));
+    snprintf(atl_webserver_portal_url, sizeof(atl_webserver_portal_url), "%s/index.html", atl_webserver_https_base);
+
+    /* Small listener (static files and probes are answered at once) */
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = 80;
+    config.ctrl_port = ESP_HTTPD_DEF_CTRL_PORT + 1;
+    config.max_open_sockets = 3;
+    config.max_uri_handlers = 4;
+    config.lru_purge_enable = true;
+    config.open_fn = atl_webserver_http_open;
+    config.close_fn = atl_webserver_http_close;
+    if (httpd_start(&server, &config) != ESP_OK) {
+        ESP_LOGE(TAG, "Fail starting plain HTTP listener!");
+        return NULL;
+    }
+#ifdef CONFIG_ATL_WEBSERVER_HTTP_ENABLE
+    atl_webserver_register_uri(server, &favicon, ATL_STALL_HANDLER_BUDGET);
+    atl_webserver_register_uri(server, &css, ATL_STALL_HANDLER_BUDGET);
+    atl_webserver_register_uri(server, &js, ATL_STALL_HANDLER_BUDGET);
+#endif
+    httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, http_404_error_handler);
+    atl_webserver_http_server = server;
+    ESP_LOGI(TAG, "Plain HTTP listener started at SoftAP (portal at %s)", atl_webserver_portal_url);
+    return server;
+}
+
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+/**
+ * @fn atl_webserver_fetch(const char *uri, int *status, size_t *len, uint8_t *sha256)
+ * @brief Request a webpage from HTTPS server over loopback (rendering and page cache check).
+ * @details Uses the configured administrator credentials. Must not be called from HTTPS server task.
+ * @param[in] uri - Page URI (e.g. "/conf_wifi.html")
+ * @param[out] status - HTTP status code
+ * @param[out] len - Body length
+ * @param[out] sha256 - Body SHA-256 (32 bytes)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_webserver_fetch(const char *uri, int *status, size_t *len, uint8_t *sha256) {
+    esp_err_t err = ESP_OK;
+    char url[sizeof("https://127.0.0.1") + CONFIG_HTTPD_MAX_URI_LEN];
+    char buf[256];
+    int read_len = 0;
+    atl_config_webserver_t webserver;
+    mbedtls_sha256_context sha_ctx;
+
+    /* Credentials */
+    memset(&webserver, 0, sizeof(atl_config_webserver_t));
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(&webserver, &atl_config.webserver, sizeof(atl_config_webserver_t));
+        xSemaphoreGive(atl_config_mutex);
+    }
+    webserver.username[sizeof(webserver.username) - 1] = '\0';
+    webserver.password[sizeof(webserver.password) - 1] = '\0';
+
+    /* Server certificate is self-signed (common name is not the loopback address) */
+    snprintf(url, sizeof(url), "https://127.0.0.1%s", uri);
+    esp_http_client_config_t config = {
+        .url = url,
+        .username = (const char*)webserver.username,
+        .password = (const char*)webserver.password,
+        .auth_type = HTTP_AUTH_TYPE_BASIC,
+        .cert_pem = (const char*)servercert_start,
+        .skip_cert_common_name_check = true,
+        .timeout_ms = ATL_WEBSERVER_FETCH_TIMEOUT,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return err;
+    }
+    esp_http_client_fetch_headers(client);
+    *status = esp_http_client_get_status_code(client);
+
+    /* Hash the body as it is read */
+    *len = 0;
+    mbedtls_sha256_init(&sha_ctx);
+    mbedtls_sha256_starts(&sha_ctx, 0);
+    while ((read_len = esp_http_client_read(client, buf, sizeof(buf))) > 0) {
+        mbedtls_sha256_update(&sha_ctx, (const unsigned char*)buf, read_len);
+        *len += read_len;
+    }
+    if (read_len < 0) {
+        err = ESP_FAIL;
+    }
+    mbedtls_sha256_finish(&sha_ctx, sha256);
+    mbedtls_sha256_free(&sha_ctx);
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return err;
+}
+#endif /* CONFIG_ATL_WEBSERVER_SELFTEST */
+
 /**
  * @fn atl_webserver_init(void)
  * @brief Initialize Webserver.
@@ -1538,7 +2856,7 @@ httpd_handle_t atl_webserver_init(void) {
 
     /* Creates default webserver configuration */
     httpd_ssl_config_t config = HTTPD_SSL_CONFIG_DEFAULT();    
-    config.httpd.max_uri_handlers = 25;
+    config.httpd.max_uri_handlers = 32;
     config.httpd.max_open_sockets = 7;
     config.httpd.lru_purge_enable = true;
     config.user_cb = https_server_user_callback;
@@ -1552,28 +2870,46 @@ httpd_handle_t atl_webserver_init(void) {
         
         /* Set URI handlers */
         ESP_LOGD(TAG, "Registering URI handlers");
-        httpd_register_uri_handler(server, &favicon);
-        httpd_register_uri_handler(server, &css);
-        httpd_register_uri_handler(server, &js);
+        atl_webserver_register_uri(server, &favicon, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &css, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &js, ATL_STALL_HANDLER_BUDGET);
         httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, http_404_error_handler);        
-        httpd_register_uri_handler(server, &home_get);        
-        httpd_register_uri_handler(server, &conf_mqtt_get);
-        httpd_register_uri_handler(server, &conf_mqtt_post);        
-        httpd_register_uri_handler(server, &conf_wifi_get);
-        httpd_register_uri_handler(server, &conf_wifi_post);
+        atl_webserver_register_uri(server, &home_get, ATL_STALL_HANDLER_BUDGET);        
+        atl_webserver_register_uri(server, &conf_mqtt_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_mqtt_post, ATL_STALL_HANDLER_BUDGET);        
+        atl_webserver_register_uri(server, &conf_wifi_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_wifi_post, ATL_STALL_HANDLER_BUDGET);
         // httpd_register_uri_handler(server, &conf_ethernet_get);
-        // httpd_register_uri_handler(server, &conf_4g_get);
-        // httpd_register_uri_handler(server, &conf_lora_get);
-        httpd_register_uri_handler(server, &conf_configuration_get);
-        httpd_register_uri_handler(server, &api_v1_system_get_conf);
-        httpd_register_uri_handler(server, &api_v1_system_set_conf);
-        httpd_register_uri_handler(server, &conf_fw_update_get);
-        httpd_register_uri_handler(server, &conf_fw_update_post);
-        httpd_register_uri_handler(server, &conf_reboot_get);
-        httpd_register_uri_handler(server, &conf_reboot_post);
+        atl_webserver_register_uri(server, &conf_4g_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_4g_post, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_lora_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_lora_post, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_configuration_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_system_get_conf, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_system_set_conf, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_wifi_scan, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_wifi_link, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_cellular_status, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_lora_status, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_diagnostics, ATL_WEBSERVER_NO_BUDGET);
+        atl_webserver_register_uri(server, &api_v1_trace, ATL_WEBSERVER_NO_BUDGET);
+        atl_webserver_register_uri(server, &conf_fw_update_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_fw_update_post, ATL_WEBSERVER_NO_BUDGET);
+        atl_webserver_register_uri(server, &conf_reboot_get, ATL_STALL_HANDLER_BUDGET);
+        atl_webserver_register_uri(server, &conf_reboot_post, ATL_STALL_HANDLER_BUDGET);
         httpd_register_basic_auth(server);               
     } else {        
         ESP_LOGE(TAG, "Fail starting webserver!");
     }
+
+    /* Plain HTTP listener at SoftAP (captive portal probes are sent over plain HTTP) */
+    atl_wifi_mode_e wifi_mode = ATL_WIFI_DISABLED;
+    if (xSemaphoreTake(atl_config_mutex, portMAX_DELAY) == pdTRUE) {
+        wifi_mode = atl_config.wifi.mode;
+        xSemaphoreGive(atl_config_mutex);
+    }
+    if (wifi_mode == ATL_WIFI_AP_MODE) {
+        atl_webserver_http_init();
+    }
     return server;
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
  * @brief Webserver header.
  * @version 0.1.0
  * @date 2024-03-11 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -20,7 +20,11 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
 #include <esp_https_server.h>
+#include "sdkconfig.h"
+#include "atl_config.h"
 
 #define HTTPD_401   "401 UNAUTHORIZED"
 
@@ -31,6 +35,30 @@ extern "C" {
  */
 httpd_handle_t atl_webserver_init(void);
 
+/**
+ * @fn atl_webserver_parse_mqtt_form(char *body, atl_mqtt_client_t *mqtt_client)
+ * @brief Parse the MQTT client configuration form body (POST handler and form benchmark).
+ * @details Body is tokenized in place. Fields not present at the form are kept unchanged.
+ * @param[in,out] body - Form body (URL encoded fields, NUL terminated)
+ * @param[in,out] mqtt_client - MQTT client configuration updated with form fields
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NO_MEM if out of memory.
+ */
+esp_err_t atl_webserver_parse_mqtt_form(char *body, atl_mqtt_client_t *mqtt_client);
+
+#ifdef CONFIG_ATL_WEBSERVER_SELFTEST
+/**
+ * @fn atl_webserver_fetch(const char *uri, int *status, size_t *len, uint8_t *sha256)
+ * @brief Request a webpage from HTTPS server over loopback (rendering and page cache check).
+ * @details Uses the configured administrator credentials. Must not be called from HTTPS server task.
+ * @param[in] uri - Page URI (e.g. "/conf_wifi.html")
+ * @param[out] status - HTTP status code
+ * @param[out] len - Body length
+ * @param[out] sha256 - Body SHA-256 (32 bytes)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_webserver_fetch(const char *uri, int *status, size_t *len, uint8_t *sha256);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
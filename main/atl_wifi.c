@@ -4,7 +4,7 @@
  * @brief Wifi function.
  * @version 0.1.0
  * @date 2024-03-11 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -14,15 +14,23 @@
  * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions 
  * and limitations under the License.
  */
+#include <stdlib.h>
 #include <string.h>
 // #include <freertos/event_groups.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include <esp_wifi.h>
 #include <esp_mac.h>
+#include <esp_timer.h>
+#include <nvs.h>
 #include "atl_config.h"
 // #include "atl_led.h"
 #include "atl_wifi.h"
+#include "atl_netmgr.h"
+#include "atl_wifi_link.h"
+#include "atl_energy.h"
 
 /* Constants */
 static const char *TAG = "atl-wifi";
@@ -34,6 +42,24 @@ const char *atl_wifi_mode_str[] = {
 
 /* Global variables */
 static EventGroupHandle_t s_wifi_event_group;   /* FreeRTOS event group to signal when we are connected */
+static atl_wifi_fast_connect_t atl_wifi_fast_connect;       /* Data learned from last STA connection */
+static SemaphoreHandle_t atl_wifi_fast_connect_mutex = NULL;
+static atl_wifi_scan_result_t atl_wifi_scan_cache[CONFIG_ATL_WIFI_SCAN_MAX_AP];  /* Access points found at last scan */
+static uint8_t atl_wifi_scan_count = 0;
+static int64_t atl_wifi_scan_time = 0;                      /* Last scan done time (0 if never scanned) */
+static bool atl_wifi_scan_running = false;
+static bool atl_wifi_scan_restore_ap = false;               /* Switched from SoftAP to AP+STA to scan (restored at scan done) */
+static SemaphoreHandle_t atl_wifi_scan_mutex = NULL;
+static bool atl_wifi_parked = false;                        /* STA radio stopped on purpose (no reconnection) */
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+static TaskHandle_t atl_wifi_window_task_handle = NULL;
+static atl_wifi_window_cb_t atl_wifi_window_cb = NULL;
+static atl_wifi_window_t atl_wifi_window_status;
+static bool atl_wifi_window_busy = true;                    /* Uplink has traffic pending */
+static bool atl_wifi_window_held = false;                   /* Window max. length ignored */
+static int64_t atl_wifi_window_idle_us = 0;                 /* Time uplink became idle */
+static portMUX_TYPE atl_wifi_window_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 /* Global external variables */
 extern atl_config_t atl_config;
@@ -55,6 +81,276 @@ atl_wifi_mode_e atl_wifi_get_mode(char* mode_str) {
     return 255;
 }
 
+/**
+ * @fn atl_wifi_fast_connect_commit(void)
+ * @brief Write fast connect data at NVS (mutex must be held).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_wifi_fast_connect_commit(void) {
+    esp_err_t err;
+    nvs_handle_t nvs_handler;
+    err = nvs_open("nvs", NVS_READWRITE, &nvs_handler);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail mounting NVS storage");
+        return err;
+    }
+    err = nvs_set_blob(nvs_handler, "wifi_fast", &atl_wifi_fast_connect, sizeof(atl_wifi_fast_connect_t));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_handler);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Fail writing fast connect data! Error: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs_handler);
+    return err;
+}
+
+/**
+ * @fn atl_wifi_fast_connect_load(const char *ssid)
+ * @brief Load fast connect data from NVS (discarded if it belongs to another network).
+ * @param[in] ssid - Configured STA SSID
+ */
+static void atl_wifi_fast_connect_load(const char *ssid) {
+    nvs_handle_t nvs_handler;
+    size_t file_size = sizeof(atl_wifi_fast_connect_t);
+    if (atl_wifi_fast_connect_mutex == NULL) {
+        atl_wifi_fast_connect_mutex = xSemaphoreCreateMutex();
+    }
+    memset(&atl_wifi_fast_connect, 0, sizeof(atl_wifi_fast_connect_t));
+    if (nvs_open("nvs", NVS_READONLY, &nvs_handler) == ESP_OK) {
+        if ((nvs_get_blob(nvs_handler, "wifi_fast", &atl_wifi_fast_connect, &file_size) != ESP_OK) ||
+            (file_size != sizeof(atl_wifi_fast_connect_t))) {
+            memset(&atl_wifi_fast_connect, 0, sizeof(atl_wifi_fast_connect_t));
+        }
+        nvs_close(nvs_handler);
+    }
+    if (strncmp((const char*)atl_wifi_fast_connect.ssid, ssid, sizeof(atl_wifi_fast_connect.ssid)) != 0) {
+        memset(&atl_wifi_fast_connect, 0, sizeof(atl_wifi_fast_connect_t));
+        strncpy((char*)atl_wifi_fast_connect.ssid, ssid, sizeof(atl_wifi_fast_connect.ssid));
+    } else if (atl_wifi_fast_connect.channel != 0) {
+        ESP_LOGI(TAG, "Fast connect to "MACSTR" (channel %d)", MAC2STR(atl_wifi_fast_connect.bssid), atl_wifi_fast_connect.channel);
+    }
+}
+
+/**
+ * @fn atl_wifi_get_fast_connect(atl_wifi_fast_connect_t *fast_connect)
+ * @brief Get data learned from last STA connection.
+ * @param[out] fast_connect - Fast connect data
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if there is no data to current network.
+ */
+esp_err_t atl_wifi_get_fast_connect(atl_wifi_fast_connect_t *fast_connect) {
+    if (atl_wifi_fast_connect_mutex == NULL) {
+        memset(fast_connect, 0, sizeof(atl_wifi_fast_connect_t));
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (xSemaphoreTake(atl_wifi_fast_connect_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(fast_connect, &atl_wifi_fast_connect, sizeof(atl_wifi_fast_connect_t));
+        xSemaphoreGive(atl_wifi_fast_connect_mutex);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_wifi_set_mqtt_keepalive(uint16_t keepalive, uint16_t ceiling)
+ * @brief Store MQTT keepalive learned at current network (only written at NVS if changed).
+ * @param[in] keepalive - Longest MQTT keepalive confirmed (in seconds)
+ * @param[in] ceiling - Shortest MQTT keepalive with silent drops (in seconds, 0 if unknown)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_set_mqtt_keepalive(uint16_t keepalive, uint16_t ceiling) {
+    esp_err_t err = ESP_OK;
+    if (atl_wifi_fast_connect_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_wifi_fast_connect_mutex, portMAX_DELAY) == pdTRUE) {
+        if ((atl_wifi_fast_connect.mqtt_keepalive != keepalive) || (atl_wifi_fast_connect.mqtt_keepalive_ceiling != ceiling)) {
+            atl_wifi_fast_connect.mqtt_keepalive = keepalive;
+            atl_wifi_fast_connect.mqtt_keepalive_ceiling = ceiling;
+            err = atl_wifi_fast_connect_commit();
+        }
+        xSemaphoreGive(atl_wifi_fast_connect_mutex);
+    }
+    return err;
+}
+
+/**
+ * @fn atl_wifi_scan_done(void)
+ * @brief Copy scan results to cache (called from WiFi event loop at scan done event).
+ * @details Hidden networks are skipped and each SSID is kept once (strongest AP), sorted by RSSI. SoftAP mode is restored
+ *  if it was switched to AP+STA to scan (scan done is also sent when scan fails).
+ */
+static void atl_wifi_scan_done(void) {
+    uint16_t ap_num = 0;
+    wifi_ap_record_t *ap_records = NULL;
+    esp_wifi_scan_get_ap_num(&ap_num);
+    if (ap_num > 64) {
+        ap_num = 64;
+    }
+    if (ap_num > 0) {
+        ap_records = calloc(ap_num, sizeof(wifi_ap_record_t));
+    }
+    if (ap_records == NULL) {
+        ap_num = 0;
+    }
+
+    /* Always called, it releases the memory allocated by the scan */
+    esp_wifi_scan_get_ap_records(&ap_num, ap_records);
+    if (xSemaphoreTake(atl_wifi_scan_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_wifi_scan_count = 0;
+        for (uint16_t i = 0; i < ap_num; i++) {
+            if (ap_records[i].ssid[0] == '\0') {
+                continue;
+            }
+
+            /* Find the SSID at cache (or the insertion point by RSSI) */
+            uint8_t pos = atl_wifi_scan_count;
+            bool duplicated = false;
+            for (uint8_t j = 0; j < atl_wifi_scan_count; j++) {
+                if (strncmp(atl_wifi_scan_cache[j].ssid, (const char*)ap_records[i].ssid, sizeof(atl_wifi_scan_cache[j].ssid)) == 0) {
+                    duplicated = true;
+                    break;
+                }
+            }
+            if (duplicated == true) {
+                continue;
+            }
+            while ((pos > 0) && (atl_wifi_scan_cache[pos - 1].rssi < ap_records[i].rssi)) {
+                pos--;
+            }
+            if (pos >= CONFIG_ATL_WIFI_SCAN_MAX_AP) {
+                continue;
+            }
+            if (atl_wifi_scan_count < CONFIG_ATL_WIFI_SCAN_MAX_AP) {
+                atl_wifi_scan_count++;
+            }
+            memmove(&atl_wifi_scan_cache[pos + 1], &atl_wifi_scan_cache[pos], (atl_wifi_scan_count - pos - 1) * sizeof(atl_wifi_scan_result_t));
+            snprintf(atl_wifi_scan_cache[pos].ssid, sizeof(atl_wifi_scan_cache[pos].ssid), "%s", (const char*)ap_records[i].ssid);
+            atl_wifi_scan_cache[pos].rssi = ap_records[i].rssi;
+            atl_wifi_scan_cache[pos].channel = ap_records[i].primary;
+            atl_wifi_scan_cache[pos].authmode = ap_records[i].authmode;
+        }
+        atl_wifi_scan_time = esp_timer_get_time();
+        atl_wifi_scan_running = false;
+        if (atl_wifi_scan_restore_ap == true) {
+            atl_wifi_scan_restore_ap = false;
+            esp_wifi_set_mode(WIFI_MODE_AP);
+        }
+        xSemaphoreGive(atl_wifi_scan_mutex);
+    }
+    free(ap_records);
+    ESP_LOGI(TAG, "Scan done, %d networks found", atl_wifi_scan_count);
+}
+
+/**
+ * @fn atl_wifi_scan_start(void)
+ * @brief Start a background WiFi scan (non-blocking, results are cached at scan done event).
+ * @details At SoftAP mode the interface is switched to AP+STA, since scan needs the station interface (SoftAP mode is
+ *  restored when scan is done or fails to start).
+ * @return esp_err_t - If ERR_OK success (or a scan is already running), otherwise fail.
+ */
+esp_err_t atl_wifi_scan_start(void) {
+    esp_err_t err = ESP_OK;
+    wifi_mode_t mode;
+    wifi_scan_config_t scan_config;
+    if (atl_wifi_scan_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_wifi_scan_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    if (atl_wifi_scan_running == true) {
+        xSemaphoreGive(atl_wifi_scan_mutex);
+        return ESP_OK;
+    }
+
+    /* Scan needs the station interface */
+    err = esp_wifi_get_mode(&mode);
+    if ((err == ESP_OK) && (mode == WIFI_MODE_AP)) {
+        err = esp_wifi_set_mode(WIFI_MODE_APSTA);
+        atl_wifi_scan_restore_ap = (err == ESP_OK);
+    }
+    if (err == ESP_OK) {
+        memset(&scan_config, 0, sizeof(wifi_scan_config_t));
+        scan_config.show_hidden = false;
+        err = esp_wifi_scan_start(&scan_config, false);
+    }
+    if (err == ESP_OK) {
+        atl_wifi_scan_running = true;
+    } else {
+        ESP_LOGW(TAG, "Fail starting WiFi scan! Error: %s", esp_err_to_name(err));
+        if (atl_wifi_scan_restore_ap == true) {
+            atl_wifi_scan_restore_ap = false;
+            esp_wifi_set_mode(WIFI_MODE_AP);
+        }
+    }
+    xSemaphoreGive(atl_wifi_scan_mutex);
+    return err;
+}
+
+/**
+ * @fn atl_wifi_scan_get(atl_wifi_scan_result_t *results, uint8_t max_results, uint8_t *count, uint32_t *age_ms, bool *scanning)
+ * @brief Get cached scan results (never blocks on a scan).
+ * @details If cache is empty or older than CONFIG_ATL_WIFI_SCAN_MAX_AGE a background scan is started.
+ * @param[out] results - Scan results (sorted by RSSI, may be NULL)
+ * @param[in] max_results - Results buffer size
+ * @param[out] count - Number of results copied
+ * @param[out] age_ms - Cache age (in ms, UINT32_MAX if never scanned)
+ * @param[out] scanning - True if a scan is running (may be NULL)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_scan_get(atl_wifi_scan_result_t *results, uint8_t max_results, uint8_t *count, uint32_t *age_ms, bool *scanning) {
+    bool expired = false;
+    *count = 0;
+    *age_ms = UINT32_MAX;
+    if (atl_wifi_scan_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_wifi_scan_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    if (atl_wifi_scan_time != 0) {
+        *age_ms = (uint32_t)((esp_timer_get_time() - atl_wifi_scan_time) / 1000);
+    }
+    if ((results != NULL) && (max_results > 0)) {
+        *count = (atl_wifi_scan_count < max_results) ? atl_wifi_scan_count : max_results;
+        memcpy(results, atl_wifi_scan_cache, *count * sizeof(atl_wifi_scan_result_t));
+    }
+    expired = ((atl_wifi_scan_time == 0) || (atl_wifi_scan_count == 0) || (*age_ms > (CONFIG_ATL_WIFI_SCAN_MAX_AGE * 1000)));
+    xSemaphoreGive(atl_wifi_scan_mutex);
+
+    /* Refresh cache at background */
+    if (expired == true) {
+        atl_wifi_scan_start();
+    }
+    if (scanning != NULL) {
+        *scanning = atl_wifi_scan_running;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_wifi_scan_get_channel(const char *ssid)
+ * @brief Get the channel of strongest cached access point of a network.
+ * @param[in] ssid - Network SSID
+ * @return uint8_t - Channel if found at cache, otherwise 0.
+ */
+uint8_t atl_wifi_scan_get_channel(const char *ssid) {
+    uint8_t channel = 0;
+    if ((atl_wifi_scan_mutex == NULL) || (ssid == NULL)) {
+        return 0;
+    }
+    if (xSemaphoreTake(atl_wifi_scan_mutex, portMAX_DELAY) == pdTRUE) {
+        for (uint8_t i = 0; i < atl_wifi_scan_count; i++) {
+            if (strncmp(atl_wifi_scan_cache[i].ssid, ssid, sizeof(atl_wifi_scan_cache[i].ssid)) == 0) {
+                channel = atl_wifi_scan_cache[i].channel;
+                break;
+            }
+        }
+        xSemaphoreGive(atl_wifi_scan_mutex);
+    }
+    return channel;
+}
+
 /**
  * @fn atl_wifi_event_handler(void* handler_args, esp_event_base_t event_base, int32_t event_id, void* event_data)
  * @brief Event handler registered to receive WiFi events.
@@ -67,21 +363,59 @@ atl_wifi_mode_e atl_wifi_get_mode(char* mode_str) {
 static void atl_wifi_event_handler(void* handler_args, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     uint8_t conn_retry = 0;
 
-    /* Check if WiFi interface was started and then connect to AP */
+    /* Check if WiFi interface was started and then connect to AP (station interface is also started to scan at SoftAP mode) */
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        if (s_wifi_event_group != NULL) {
+            esp_wifi_connect();
+        }
     } 
+
+    /* Check if a background scan was finished */
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
+        atl_wifi_scan_done();
+    }
     
     /* Check if station was connected */
     else if (event_id == WIFI_EVENT_STA_CONNECTED) {
         wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*) event_data;
         ESP_LOGI(TAG, "Connected at %s ("MACSTR")", event->ssid, MAC2STR(event->bssid));
+        atl_wifi_link_sta_connected(event);
+
+        /* Store BSSID and channel to skip the scan at next connection */
+        if ((atl_wifi_fast_connect_mutex != NULL) && (xSemaphoreTake(atl_wifi_fast_connect_mutex, portMAX_DELAY) == pdTRUE)) {
+            if ((memcmp(atl_wifi_fast_connect.bssid, event->bssid, sizeof(atl_wifi_fast_connect.bssid)) != 0) ||
+                (atl_wifi_fast_connect.channel != event->channel)) {
+                memcpy(atl_wifi_fast_connect.bssid, event->bssid, sizeof(atl_wifi_fast_connect.bssid));
+                atl_wifi_fast_connect.channel = event->channel;
+                atl_wifi_fast_connect_commit();
+            }
+            xSemaphoreGive(atl_wifi_fast_connect_mutex);
+        }
     }
 
     /* Check if station was disconnected */
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
         ESP_LOGI(TAG, "Disconnected from %s ("MACSTR") reason: %d", event->ssid, MAC2STR(event->bssid), event->reason);
+
+        /* Link adaptation applies pending PHY mode before reconnecting */
+        atl_wifi_link_sta_disconnected(event);
+
+        /* Radio stopped between publish windows */
+        if (atl_wifi_parked == true) {
+            return;
+        }
+
+        /* If stored AP was not found, fall back to full scan */
+        if (event->reason == WIFI_REASON_NO_AP_FOUND) {
+            wifi_config_t wifi_config;
+            if ((esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) && (wifi_config.sta.bssid_set == true)) {
+                ESP_LOGW(TAG, "Fast connect AP not found, scanning all channels");
+                wifi_config.sta.bssid_set = false;
+                wifi_config.sta.channel = 0;
+                esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+            }
+        }
         if (conn_retry < atl_config.wifi.sta_max_conn_retry) {
             esp_wifi_connect();
             conn_retry++;
@@ -121,6 +455,253 @@ const char* atl_wifi_get_mode_str(atl_wifi_mode_e mode) {
     return atl_wifi_mode_str[mode];
 }
 
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+
+#define ATL_WIFI_WINDOW_OPEN_BIT    BIT0    /* Window requested before next interval */
+#define ATL_WIFI_WINDOW_STATE_BIT   BIT1    /* Uplink busy or hold state changed */
+
+/**
+ * @fn atl_wifi_window_ticks(int64_t us)
+ * @brief Convert a wait time to ticks (rounded up, long intervals do not overflow pdMS_TO_TICKS()).
+ * @param[in] us - Wait time (in us)
+ * @return TickType_t - Wait time (in ticks).
+ */
+static TickType_t atl_wifi_window_ticks(int64_t us) {
+    return (TickType_t)(us / 1000 / portTICK_PERIOD_MS) + 1;
+}
+
+/**
+ * @fn atl_wifi_window_connect(void)
+ * @brief Start the radio and wait for an IP address (STA configuration keeps fast connect BSSID and channel).
+ * @return bool - True if connected before window max. length.
+ */
+static bool atl_wifi_window_connect(void) {
+    portENTER_CRITICAL(&atl_wifi_window_mux);
+    atl_wifi_window_busy = true;
+    atl_wifi_window_status.open = true;
+    portEXIT_CRITICAL(&atl_wifi_window_mux);
+    atl_wifi_parked = false;
+    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+    if (esp_wifi_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Fail starting WiFi interface!");
+        return false;
+    }
+    atl_energy_radio(true);
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(CONFIG_ATL_WIFI_ON_DEMAND_WINDOW * 1000));
+    return ((bits & WIFI_CONNECTED_BIT) != 0);
+}
+
+/**
+ * @fn atl_wifi_window_wait_idle(int64_t open_us)
+ * @brief Wait until uplink is idle for linger time or window max. length is reached (unless held).
+ * @param[in] open_us - Window open time
+ */
+static void atl_wifi_window_wait_idle(int64_t open_us) {
+    uint32_t notified;
+    while (true) {
+        int64_t now_us = esp_timer_get_time();
+        int64_t close_us = open_us + CONFIG_ATL_WIFI_ON_DEMAND_WINDOW * 1000000LL;
+        portENTER_CRITICAL(&atl_wifi_window_mux);
+        bool busy = atl_wifi_window_busy;
+        bool held = atl_wifi_window_held;
+        int64_t idle_us = atl_wifi_window_idle_us;
+        portEXIT_CRITICAL(&atl_wifi_window_mux);
+        if (held == true) {
+            xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+            continue;
+        }
+        if ((busy == false) && (idle_us + CONFIG_ATL_WIFI_ON_DEMAND_LINGER * 1000000LL < close_us)) {
+            close_us = idle_us + CONFIG_ATL_WIFI_ON_DEMAND_LINGER * 1000000LL;
+        }
+        if (now_us >= close_us) {
+            return;
+        }
+        xTaskNotifyWait(0, UINT32_MAX, &notified, atl_wifi_window_ticks(close_us - now_us));
+    }
+}
+
+/**
+ * @fn atl_wifi_window_close(int64_t open_us, bool connected)
+ * @brief Stop uplink session and radio until next window.
+ * @param[in] open_us - Window open time
+ * @param[in] connected - Window got connected
+ */
+static void atl_wifi_window_close(int64_t open_us, bool connected) {
+    uint32_t on_ms = (esp_timer_get_time() - open_us) / 1000;
+    if (atl_wifi_window_cb != NULL) {
+        atl_wifi_window_cb(false);
+    }
+    atl_wifi_parked = true;
+    esp_wifi_disconnect();
+    esp_wifi_stop();
+    atl_energy_radio(false);
+    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+    portENTER_CRITICAL(&atl_wifi_window_mux);
+    atl_wifi_window_status.open = false;
+    atl_wifi_window_status.windows++;
+    atl_wifi_window_status.missed += (connected == true) ? 0 : 1;
+    atl_wifi_window_status.last_ms = on_ms;
+    portEXIT_CRITICAL(&atl_wifi_window_mux);
+    ESP_LOGI(TAG, "Publish window closed after %lu ms%s, radio off", (unsigned long)on_ms, connected ? "" : " (not connected)");
+}
+
+/**
+ * @fn atl_wifi_window_wait_next(int64_t open_us)
+ * @brief Wait for next window (interval counted from last window open) or an early open request.
+ * @param[in] open_us - Last window open time
+ */
+static void atl_wifi_window_wait_next(int64_t open_us) {
+    uint32_t notified = 0;
+    int64_t next_us = open_us + CONFIG_ATL_WIFI_ON_DEMAND_INTERVAL * 1000000LL;
+    int64_t now_us = esp_timer_get_time();
+    while (now_us < next_us) {
+        if ((xTaskNotifyWait(0, UINT32_MAX, &notified, atl_wifi_window_ticks(next_us - now_us)) == pdTRUE) &&
+            ((notified & ATL_WIFI_WINDOW_OPEN_BIT) != 0)) {
+            ESP_LOGI(TAG, "Publish window requested before interval");
+            return;
+        }
+        now_us = esp_timer_get_time();
+    }
+}
+
+/**
+ * @fn atl_wifi_window_task(void *args)
+ * @brief Publish window task (first window is the connection made at startup).
+ * @param[in] args - Not used
+ */
+static void atl_wifi_window_task(void *args) {
+    int64_t open_us = esp_timer_get_time();
+    bool connected = ((xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT) != 0);
+    if (connected == true) {
+        atl_wifi_window_wait_idle(open_us);
+    }
+    while (true) {
+        atl_wifi_window_close(open_us, connected);
+        atl_wifi_window_wait_next(open_us);
+        open_us = esp_timer_get_time();
+        connected = atl_wifi_window_connect();
+        if (connected == true) {
+            ESP_LOGI(TAG, "Publish window connected after %lu ms", (unsigned long)((esp_timer_get_time() - open_us) / 1000));
+            if (atl_wifi_window_cb != NULL) {
+                atl_wifi_window_cb(true);
+            }
+            atl_wifi_window_wait_idle(open_us);
+        }
+    }
+}
+
+/**
+ * @fn atl_wifi_window_start(void)
+ * @brief Start connect on demand (radio is stopped when uplink is idle after startup connection).
+ */
+static void atl_wifi_window_start(void) {
+    if (atl_config.cellular.enabled == true) {
+        ESP_LOGW(TAG, "WiFi connect on demand ignored (cellular uplink enabled)");
+        return;
+    }
+    atl_wifi_window_status.open = true;
+    if (xTaskCreatePinnedToCore(atl_wifi_window_task, "atl_wifi_window", 3072, NULL, 5, &atl_wifi_window_task_handle, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating WiFi window task!");
+        return;
+    }
+    ESP_LOGI(TAG, "WiFi connect on demand (window every %ds)", CONFIG_ATL_WIFI_ON_DEMAND_INTERVAL);
+}
+
+/**
+ * @fn atl_wifi_window_register_cb(atl_wifi_window_cb_t cb)
+ * @brief Register the publish window callback (uplink session is started when window opens and stopped before it closes).
+ * @param[in] cb - Window callback
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_wifi_window_register_cb(atl_wifi_window_cb_t cb) {
+    atl_wifi_window_cb = cb;
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_wifi_window_open(void)
+ * @brief Open a publish window now (ignored if radio is already on).
+ */
+void atl_wifi_window_open(void) {
+    if (atl_wifi_window_task_handle != NULL) {
+        xTaskNotify(atl_wifi_window_task_handle, ATL_WIFI_WINDOW_OPEN_BIT, eSetBits);
+    }
+}
+
+/**
+ * @fn atl_wifi_window_set_busy(bool busy)
+ * @brief Signal if uplink has traffic pending (window closes after linger time once it is idle).
+ * @param[in] busy - Traffic pending
+ */
+void atl_wifi_window_set_busy(bool busy) {
+    int64_t now_us = esp_timer_get_time();
+    bool changed;
+    portENTER_CRITICAL(&atl_wifi_window_mux);
+    changed = (atl_wifi_window_busy != busy);
+    if (changed == true) {
+        atl_wifi_window_busy = busy;
+        atl_wifi_window_idle_us = now_us;
+    }
+    portEXIT_CRITICAL(&atl_wifi_window_mux);
+    if ((changed == true) && (atl_wifi_window_task_handle != NULL)) {
+        xTaskNotify(atl_wifi_window_task_handle, ATL_WIFI_WINDOW_STATE_BIT, eSetBits);
+    }
+}
+
+/**
+ * @fn atl_wifi_window_hold(bool hold)
+ * @brief Keep the radio on beyond the window max. length (firmware update in progress).
+ * @param[in] hold - Keep radio on
+ */
+void atl_wifi_window_hold(bool hold) {
+    bool changed;
+    portENTER_CRITICAL(&atl_wifi_window_mux);
+    changed = (atl_wifi_window_held != hold);
+    atl_wifi_window_held = hold;
+    portEXIT_CRITICAL(&atl_wifi_window_mux);
+    if ((changed == true) && (atl_wifi_window_task_handle != NULL)) {
+        xTaskNotify(atl_wifi_window_task_handle, ATL_WIFI_WINDOW_STATE_BIT, eSetBits);
+    }
+}
+
+/**
+ * @fn atl_wifi_window_get(atl_wifi_window_t *window)
+ * @brief Get connect on demand status.
+ * @param[out] window - Window status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig (or cellular uplink is enabled).
+ */
+esp_err_t atl_wifi_window_get(atl_wifi_window_t *window) {
+    if (atl_wifi_window_task_handle == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    portENTER_CRITICAL(&atl_wifi_window_mux);
+    *window = atl_wifi_window_status;
+    portEXIT_CRITICAL(&atl_wifi_window_mux);
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t atl_wifi_window_register_cb(atl_wifi_window_cb_t cb) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void atl_wifi_window_open(void) {
+}
+
+void atl_wifi_window_set_busy(bool busy) {
+}
+
+void atl_wifi_window_hold(bool hold) {
+}
+
+esp_err_t atl_wifi_window_get(atl_wifi_window_t *window) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
 /**
  * @fn atl_wifi_init_softap(void)
  * @brief Initialize WiFi interface in SoftAP mode.
@@ -160,6 +741,7 @@ esp_err_t atl_wifi_init_softap(void) {
     }
 
     /* Register event handlers */ 
+    atl_wifi_scan_mutex = xSemaphoreCreateMutex();
     err = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &atl_wifi_event_handler, NULL, NULL);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Fail registering WiFi event handler!");
@@ -211,6 +793,12 @@ esp_err_t atl_wifi_init_softap(void) {
         ESP_LOGE(TAG, "Fail starting WiFi interface!");
         goto error_proc;
     }
+    atl_energy_radio(true);
+
+    /* Portal clients are nearby, full TX power is seldom needed */
+    if (esp_wifi_set_max_tx_power(CONFIG_ATL_WIFI_AP_TX_POWER * 4) != ESP_OK) {
+        ESP_LOGW(TAG, "Fail setting AP TX power!");
+    }
    
     return err;
 
@@ -240,15 +828,15 @@ esp_err_t atl_wifi_init_sta(void) {
         goto error_proc;
     }
 
-    /* Initialize event loop */
+    /* Initialize event loop (it may be already created by cellular modem) */
     err = esp_event_loop_create_default();
-    if (err != ESP_OK) {
+    if ((err != ESP_OK) && (err != ESP_ERR_INVALID_STATE)) {
         ESP_LOGE(TAG, "Fail creating WiFi event loop!");
         goto error_proc;
     }
 
     /* Initialize default WiFi station */
-    esp_netif_create_default_wifi_sta();
+    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
 
     /* Get default WiFi station configuration */
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -262,6 +850,7 @@ esp_err_t atl_wifi_init_sta(void) {
     
     /* Register event handlers to WiFi */
     esp_event_handler_instance_t instance_any_id;
+    atl_wifi_scan_mutex = xSemaphoreCreateMutex();
     err = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &atl_wifi_event_handler, NULL, &instance_any_id);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Fail registering WiFi event handler!");
@@ -275,6 +864,9 @@ esp_err_t atl_wifi_init_sta(void) {
         ESP_LOGE(TAG, "Fail registering IP event handler!");
         goto error_proc;
     }
+
+    /* Register WiFi as network manager uplink */
+    atl_netmgr_register(ATL_NETMGR_UPLINK_WIFI, sta_netif, CONFIG_ATL_NETMGR_PRIORITY_WIFI, false);
     
     /* Get cofiguration mutex to setup station WiFi config */
     memset(&wifi_config, 0, sizeof(wifi_config_t));
@@ -292,6 +884,14 @@ esp_err_t atl_wifi_init_sta(void) {
         goto error_proc;
     }    
 
+    /* Use BSSID and channel learned from last connection (skip scan) */
+    atl_wifi_fast_connect_load((const char*)wifi_config.sta.ssid);
+    if (atl_wifi_fast_connect.channel != 0) {
+        wifi_config.sta.channel = atl_wifi_fast_connect.channel;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, atl_wifi_fast_connect.bssid, sizeof(wifi_config.sta.bssid));
+    }
+
     /* Setup WiFi to Station Mode */
     err = esp_wifi_set_mode(WIFI_MODE_STA);
     if (err != ESP_OK) {
@@ -306,20 +906,28 @@ esp_err_t atl_wifi_init_sta(void) {
         goto error_proc;
     }
 
+    /* Initialize link adaptation (PHY mode and TX power follow RSSI) */
+    if (atl_wifi_link_init() != ESP_OK) {
+        ESP_LOGW(TAG, "WiFi link adaptation not available, using default PHY mode and TX power");
+    }
+
     /* Start WiFi interface */
     err = esp_wifi_start();
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Fail starting WiFi interface!");
         goto error_proc;
     }
+    atl_energy_radio(true);
        
     /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
+     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above). If cellular modem is
+     * enabled, traffic may go through it meanwhile, so do not wait forever */
+    TickType_t wait_ticks = (atl_config.cellular.enabled == true) ? pdMS_TO_TICKS(CONFIG_ATL_WIFI_STA_CONNECT_TIMEOUT * 1000) : portMAX_DELAY;
     EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
             WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
             pdFALSE,
             pdFALSE,
-            portMAX_DELAY);
+            wait_ticks);
     
     /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
      * happened. */
@@ -329,9 +937,16 @@ esp_err_t atl_wifi_init_sta(void) {
     } else if (bits & WIFI_FAIL_BIT) {
         ESP_LOGI(TAG, "Failed to connect SSID %s with password %s",
                  wifi_config.sta.ssid, wifi_config.sta.password);
+    } else if (wait_ticks != portMAX_DELAY) {
+        ESP_LOGW(TAG, "Not connected to SSID %s yet, keep trying in background", wifi_config.sta.ssid);
     } else {
         ESP_LOGE(TAG, "UNEXPECTED EVENT");
     }
+
+#ifdef CONFIG_ATL_WIFI_ON_DEMAND
+    /* Radio is only on during publish windows from now on */
+    atl_wifi_window_start();
+#endif
     
     return err;
  
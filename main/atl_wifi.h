@@ -4,7 +4,7 @@
  * @brief Wifi header.
  * @version 0.1.0
  * @date 2024-03-10 (created)
- * @date 2024-03-11 (updated)
+ * @date 2026-10-19 (updated)
  * 
  * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
  * ![LICENSE license](../figs/license.png)<br>
@@ -16,6 +16,9 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <esp_wifi_types.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +36,48 @@ typedef enum {
     ATL_WIFI_STA_MODE,   
 } atl_wifi_mode_e;
 
+/**
+ * @typedef atl_wifi_fast_connect_t
+ * @brief Data learned from last STA connection (persisted at NVS).
+ * @details BSSID and channel skip the full scan at next connection. MQTT keepalive learned at this network is stored
+ *  alongside, so it is discarded together when STA SSID changes.
+ */
+typedef struct {
+    uint8_t     ssid[32];                   /**< Network SSID (record key).*/
+    uint8_t     bssid[6];                   /**< Last AP BSSID.*/
+    uint8_t     channel;                    /**< Last AP channel (0 if unknown).*/
+    uint16_t    mqtt_keepalive;             /**< Longest MQTT keepalive confirmed at this network (0 if unknown).*/
+    uint16_t    mqtt_keepalive_ceiling;     /**< Shortest MQTT keepalive with silent drops at this network (0 if unknown).*/
+} atl_wifi_fast_connect_t;
+
+/**
+ * @typedef atl_wifi_scan_result_t
+ * @brief Access point found at last WiFi scan.
+ */
+typedef struct {
+    char                ssid[33];           /**< Network SSID (null terminated).*/
+    int8_t              rssi;               /**< Signal strength (in dBm).*/
+    uint8_t             channel;            /**< Primary channel.*/
+    wifi_auth_mode_t    authmode;           /**< Authentication mode.*/
+} atl_wifi_scan_result_t;
+
+/**
+ * @typedef atl_wifi_window_t
+ * @brief Connect on demand status (STA radio is only on during publish windows).
+ */
+typedef struct {
+    bool        open;       /**< Radio is on (window in progress).*/
+    uint32_t    windows;    /**< Windows closed since boot.*/
+    uint32_t    missed;     /**< Windows closed without connection (AP not found or no IP address).*/
+    uint32_t    last_ms;    /**< Radio-on time of last window (in ms).*/
+} atl_wifi_window_t;
+
+/**
+ * @typedef atl_wifi_window_cb_t
+ * @brief Publish window callback (called from window task when connected and before radio is stopped).
+ */
+typedef void (*atl_wifi_window_cb_t)(bool open);
+
 /**
  * @brief Get the wifi mode enum
  * @param mode_str 
@@ -47,6 +92,88 @@ atl_wifi_mode_e atl_wifi_get_mode(char* mode_str);
  */
 const char* atl_wifi_get_mode_str(atl_wifi_mode_e mode);
 
+/**
+ * @fn atl_wifi_get_fast_connect(atl_wifi_fast_connect_t *fast_connect)
+ * @brief Get data learned from last STA connection.
+ * @param[out] fast_connect - Fast connect data
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_FOUND if there is no data to current network.
+ */
+esp_err_t atl_wifi_get_fast_connect(atl_wifi_fast_connect_t *fast_connect);
+
+/**
+ * @fn atl_wifi_set_mqtt_keepalive(uint16_t keepalive, uint16_t ceiling)
+ * @brief Store MQTT keepalive learned at current network (only written at NVS if changed).
+ * @param[in] keepalive - Longest MQTT keepalive confirmed (in seconds)
+ * @param[in] ceiling - Shortest MQTT keepalive with silent drops (in seconds, 0 if unknown)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_set_mqtt_keepalive(uint16_t keepalive, uint16_t ceiling);
+
+/**
+ * @fn atl_wifi_scan_start(void)
+ * @brief Start a background WiFi scan (non-blocking, results are cached at scan done event).
+ * @details At SoftAP mode the interface is switched to AP+STA, since scan needs the station interface.
+ * @return esp_err_t - If ERR_OK success (or a scan is already running), otherwise fail.
+ */
+esp_err_t atl_wifi_scan_start(void);
+
+/**
+ * @fn atl_wifi_scan_get(atl_wifi_scan_result_t *results, uint8_t max_results, uint8_t *count, uint32_t *age_ms, bool *scanning)
+ * @brief Get cached scan results (never blocks on a scan).
+ * @details If cache is empty or older than CONFIG_ATL_WIFI_SCAN_MAX_AGE a background scan is started.
+ * @param[out] results - Scan results (sorted by RSSI, may be NULL)
+ * @param[in] max_results - Results buffer size
+ * @param[out] count - Number of results copied
+ * @param[out] age_ms - Cache age (in ms, UINT32_MAX if never scanned)
+ * @param[out] scanning - True if a scan is running (may be NULL)
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_scan_get(atl_wifi_scan_result_t *results, uint8_t max_results, uint8_t *count, uint32_t *age_ms, bool *scanning);
+
+/**
+ * @fn atl_wifi_scan_get_channel(const char *ssid)
+ * @brief Get the channel of strongest cached access point of a network.
+ * @param[in] ssid - Network SSID
+ * @return uint8_t - Channel if found at cache, otherwise 0.
+ */
+uint8_t atl_wifi_scan_get_channel(const char *ssid);
+
+/**
+ * @fn atl_wifi_window_register_cb(atl_wifi_window_cb_t cb)
+ * @brief Register the publish window callback (uplink session is started when window opens and stopped before it closes).
+ * @param[in] cb - Window callback
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig.
+ */
+esp_err_t atl_wifi_window_register_cb(atl_wifi_window_cb_t cb);
+
+/**
+ * @fn atl_wifi_window_open(void)
+ * @brief Open a publish window now (ignored if radio is already on).
+ */
+void atl_wifi_window_open(void);
+
+/**
+ * @fn atl_wifi_window_set_busy(bool busy)
+ * @brief Signal if uplink has traffic pending (window closes after linger time once it is idle).
+ * @param[in] busy - Traffic pending
+ */
+void atl_wifi_window_set_busy(bool busy);
+
+/**
+ * @fn atl_wifi_window_hold(bool hold)
+ * @brief Keep the radio on beyond the window max. length (firmware update in progress).
+ * @param[in] hold - Keep radio on
+ */
+void atl_wifi_window_hold(bool hold);
+
+/**
+ * @fn atl_wifi_window_get(atl_wifi_window_t *window)
+ * @brief Get connect on demand status.
+ * @param[out] window - Window status
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_NOT_SUPPORTED if disabled at menuconfig (or cellular uplink is enabled).
+ */
+esp_err_t atl_wifi_window_get(atl_wifi_window_t *window);
+
 /**
  * @fn atl_wifi_init_softap(void)
  * @brief Initialize WiFi interface in SoftAP mode.
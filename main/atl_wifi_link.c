@@ -0,0 +1,389 @@
+/**
+ * @file atl_wifi_link.c
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief WiFi STA link adaptation (PHY mode and TX power).
+ * @details RSSI of the associated AP is sampled periodically and averaged. TX power is lowered while the average is
+ *  above the target RSSI (path loss is assumed symmetric, so the AP keeps receiving us about the target) and raised
+ *  back at once when the signal falls. PHY mode follows the average: HT40 with strong signal, HT20 otherwise and
+ *  Espressif 802.11 LR at the edge of coverage when the AP supports it. PHY mode changes need a new association, so
+ *  they are rate limited and applied between disconnection and reconnection.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_wifi.h>
+#include <esp_timer.h>
+#include "sdkconfig.h"
+#include "atl_stall.h"
+#include "atl_wifi_link.h"
+
+#define ATL_WIFI_LINK_PROTOCOL_BGN  (WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N)
+#define ATL_WIFI_LINK_MIN_SAMPLES   6       /* RSSI samples at association before PHY mode decisions */
+#define ATL_WIFI_LINK_TX_STEP_DOWN  2       /* Max. TX power decrease per sample (in dB) */
+#define ATL_WIFI_LINK_TX_MARGIN     2       /* Min. TX power decrease applied (in dB) */
+#ifdef CONFIG_ATL_PM_LIGHT_SLEEP
+#define ATL_WIFI_LINK_INTERVAL      CONFIG_ATL_WIFI_LINK_SLEEP_INTERVAL     /* Each sample wakes the chip up */
+#else
+#define ATL_WIFI_LINK_INTERVAL      CONFIG_ATL_WIFI_LINK_INTERVAL
+#endif
+
+/* Constants */
+static const char *TAG = "atl-wifi-link";
+static const char *atl_wifi_link_phy_str[] = {
+    "HT40",
+    "HT20",
+    "LR",
+};
+
+/* Global variables */
+static atl_wifi_link_t atl_wifi_link;
+static int16_t atl_wifi_link_rssi_avg16 = 0;                            /* Average RSSI (x16, exponential moving average) */
+static uint32_t atl_wifi_link_samples = 0;                              /* RSSI samples at current association */
+static atl_wifi_link_phy_e atl_wifi_link_pending = ATL_WIFI_LINK_PHY_HT20;  /* PHY mode applied at next connection */
+static bool atl_wifi_link_switching = false;                            /* Disconnection requested to switch PHY mode */
+static int64_t atl_wifi_link_phy_time = 0;                              /* Last PHY mode switch time (0 if never) */
+static SemaphoreHandle_t atl_wifi_link_mutex = NULL;
+static TaskHandle_t atl_wifi_link_task_handle = NULL;
+
+/**
+ * @fn atl_wifi_link_get_phy_str(atl_wifi_link_phy_e phy)
+ * @brief Get PHY mode name.
+ * @param[in] phy - PHY mode
+ * @return const char* - PHY mode name.
+ */
+const char* atl_wifi_link_get_phy_str(atl_wifi_link_phy_e phy) {
+    return atl_wifi_link_phy_str[phy];
+}
+
+/**
+ * @fn atl_wifi_link_apply_phy(atl_wifi_link_phy_e phy)
+ * @brief Set STA protocol and bandwidth of a PHY mode (used at next association).
+ * @param[in] phy - PHY mode
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+static esp_err_t atl_wifi_link_apply_phy(atl_wifi_link_phy_e phy) {
+    esp_err_t err;
+    if (phy == ATL_WIFI_LINK_PHY_LR) {
+        err = esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_LR);
+    } else {
+        err = esp_wifi_set_protocol(WIFI_IF_STA, ATL_WIFI_LINK_PROTOCOL_BGN);
+        if (err == ESP_OK) {
+            err = esp_wifi_set_bandwidth(WIFI_IF_STA, (phy == ATL_WIFI_LINK_PHY_HT40) ? WIFI_BW_HT40 : WIFI_BW_HT20);
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Fail setting PHY mode %s! Error: %s", atl_wifi_link_phy_str[phy], esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * @fn atl_wifi_link_set_tx_power(int8_t power)
+ * @brief Set max. TX power and store the value accepted by WiFi driver.
+ * @param[in] power - TX power (in dBm)
+ */
+static void atl_wifi_link_set_tx_power(int8_t power) {
+    int8_t quarter_dbm = power * 4;
+    if (esp_wifi_set_max_tx_power(quarter_dbm) != ESP_OK) {
+        ESP_LOGW(TAG, "Fail setting TX power to %d dBm!", power);
+        return;
+    }
+    if (esp_wifi_get_max_tx_power(&quarter_dbm) == ESP_OK) {
+        power = quarter_dbm / 4;
+    }
+    if (xSemaphoreTake(atl_wifi_link_mutex, portMAX_DELAY) == pdTRUE) {
+        if (atl_wifi_link.tx_power != power) {
+            atl_wifi_link.tx_power_steps++;
+        }
+        atl_wifi_link.tx_power = power;
+        xSemaphoreGive(atl_wifi_link_mutex);
+    }
+}
+
+#ifdef CONFIG_ATL_WIFI_LINK_ADAPT
+/**
+ * @fn atl_wifi_link_select_phy(atl_wifi_link_phy_e phy, int8_t rssi, bool ap_lr)
+ * @brief Select PHY mode from average RSSI (with hysteresis around thresholds).
+ * @param[in] phy - Current PHY mode
+ * @param[in] rssi - Average RSSI (dBm)
+ * @param[in] ap_lr - AP supports 802.11 LR
+ * @return atl_wifi_link_phy_e - PHY mode selected.
+ */
+static atl_wifi_link_phy_e atl_wifi_link_select_phy(atl_wifi_link_phy_e phy, int8_t rssi, bool ap_lr) {
+    switch (phy) {
+        case ATL_WIFI_LINK_PHY_LR:
+            if (rssi > (CONFIG_ATL_WIFI_LINK_LR_RSSI + CONFIG_ATL_WIFI_LINK_HYSTERESIS)) {
+                return ATL_WIFI_LINK_PHY_HT20;
+            }
+            break;
+        case ATL_WIFI_LINK_PHY_HT20:
+            if ((rssi <= CONFIG_ATL_WIFI_LINK_LR_RSSI) && (ap_lr == true)) {
+                return ATL_WIFI_LINK_PHY_LR;
+            }
+            if (rssi >= CONFIG_ATL_WIFI_LINK_HT40_RSSI) {
+                return ATL_WIFI_LINK_PHY_HT40;
+            }
+            break;
+        case ATL_WIFI_LINK_PHY_HT40:
+            if (rssi < (CONFIG_ATL_WIFI_LINK_HT40_RSSI - CONFIG_ATL_WIFI_LINK_HYSTERESIS)) {
+                return ATL_WIFI_LINK_PHY_HT20;
+            }
+            break;
+    }
+    return phy;
+}
+
+/**
+ * @fn atl_wifi_link_select_tx_power(int8_t power, int8_t rssi, atl_wifi_link_phy_e phy)
+ * @brief Select TX power from average RSSI (raised at once, lowered in steps).
+ * @param[in] power - Current TX power (dBm)
+ * @param[in] rssi - Average RSSI (dBm)
+ * @param[in] phy - Current PHY mode
+ * @return int8_t - TX power selected (dBm).
+ */
+static int8_t atl_wifi_link_select_tx_power(int8_t power, int8_t rssi, atl_wifi_link_phy_e phy) {
+    if (phy == ATL_WIFI_LINK_PHY_LR) {
+        return CONFIG_ATL_WIFI_LINK_TX_POWER_MAX;
+    }
+    int16_t desired = CONFIG_ATL_WIFI_LINK_TX_POWER_MAX - (rssi - CONFIG_ATL_WIFI_LINK_TARGET_RSSI);
+    if (desired > CONFIG_ATL_WIFI_LINK_TX_POWER_MAX) {
+        desired = CONFIG_ATL_WIFI_LINK_TX_POWER_MAX;
+    } else if (desired < CONFIG_ATL_WIFI_LINK_TX_POWER_MIN) {
+        desired = CONFIG_ATL_WIFI_LINK_TX_POWER_MIN;
+    }
+    if (desired > power) {
+        return desired;
+    }
+    if ((power - desired) < ATL_WIFI_LINK_TX_MARGIN) {
+        return power;
+    }
+    return ((power - desired) > ATL_WIFI_LINK_TX_STEP_DOWN) ? (power - ATL_WIFI_LINK_TX_STEP_DOWN) : desired;
+}
+#endif /* CONFIG_ATL_WIFI_LINK_ADAPT */
+
+/**
+ * @fn atl_wifi_link_task(void *args)
+ * @brief RSSI sampling and link adaptation task.
+ * @param[in] args - Not used
+ */
+static void atl_wifi_link_task(void *args) {
+    wifi_ap_record_t ap_info;
+    wifi_phy_mode_t phy_mode;
+    atl_wifi_link_phy_e phy, next_phy;
+    int8_t tx_power, next_tx_power;
+    int8_t rssi_avg;
+    int stall = atl_stall_register("wifi_link_task", ATL_STALL_TASK_BUDGET);
+    while (true) {
+        atl_stall_end(stall);
+        vTaskDelay(pdMS_TO_TICKS(ATL_WIFI_LINK_INTERVAL * 1000));
+        atl_stall_begin(stall);
+        if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+            continue;
+        }
+        bool negotiated = (esp_wifi_sta_get_negotiated_phymode(&phy_mode) == ESP_OK);
+
+        /* Update metrics */
+        if (xSemaphoreTake(atl_wifi_link_mutex, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if ((atl_wifi_link.connected == false) || (atl_wifi_link_switching == true)) {
+            xSemaphoreGive(atl_wifi_link_mutex);
+            continue;
+        }
+        if (atl_wifi_link_samples == 0) {
+            atl_wifi_link_rssi_avg16 = ap_info.rssi * 16;
+            atl_wifi_link.rssi_min = ap_info.rssi;
+            atl_wifi_link.rssi_max = ap_info.rssi;
+        } else {
+            atl_wifi_link_rssi_avg16 += (ap_info.rssi * 16 - atl_wifi_link_rssi_avg16) / 4;
+            if (ap_info.rssi < atl_wifi_link.rssi_min) {
+                atl_wifi_link.rssi_min = ap_info.rssi;
+            }
+            if (ap_info.rssi > atl_wifi_link.rssi_max) {
+                atl_wifi_link.rssi_max = ap_info.rssi;
+            }
+        }
+        atl_wifi_link_samples++;
+        atl_wifi_link.rssi = ap_info.rssi;
+        atl_wifi_link.rssi_avg = atl_wifi_link_rssi_avg16 / 16;
+        atl_wifi_link.channel = ap_info.primary;
+        atl_wifi_link.ap_lr = (ap_info.phy_lr == 1);
+        if (negotiated == true) {
+            atl_wifi_link.phy_mode = phy_mode;
+        }
+        phy = next_phy = atl_wifi_link.phy;
+        tx_power = next_tx_power = atl_wifi_link.tx_power;
+        rssi_avg = atl_wifi_link.rssi_avg;
+
+#ifdef CONFIG_ATL_WIFI_LINK_ADAPT
+        /* PHY mode needs a stable average and is held for a while after each switch */
+        int64_t now = esp_timer_get_time();
+        if ((atl_wifi_link_samples >= ATL_WIFI_LINK_MIN_SAMPLES) &&
+            ((atl_wifi_link_phy_time == 0) || ((now - atl_wifi_link_phy_time) >= (CONFIG_ATL_WIFI_LINK_PHY_HOLD * 1000000LL)))) {
+            next_phy = atl_wifi_link_select_phy(phy, rssi_avg, atl_wifi_link.ap_lr);
+        }
+        if (next_phy != phy) {
+            atl_wifi_link_pending = next_phy;
+            atl_wifi_link_switching = true;
+            atl_wifi_link_phy_time = now;
+        } else {
+            next_tx_power = atl_wifi_link_select_tx_power(tx_power, rssi_avg, phy);
+        }
+#endif
+        xSemaphoreGive(atl_wifi_link_mutex);
+
+        /* Reconnect with new PHY mode (applied at disconnection event) or update TX power */
+        if (next_phy != phy) {
+            ESP_LOGI(TAG, "Switching PHY mode %s -> %s (RSSI avg. %d dBm)", atl_wifi_link_phy_str[phy], atl_wifi_link_phy_str[next_phy], rssi_avg);
+            esp_wifi_disconnect();
+        } else if (next_tx_power != tx_power) {
+            ESP_LOGD(TAG, "TX power %d -> %d dBm (RSSI avg. %d dBm)", tx_power, next_tx_power, rssi_avg);
+            atl_wifi_link_set_tx_power(next_tx_power);
+        }
+    }
+}
+
+/**
+ * @fn atl_wifi_link_sta_connected(const wifi_event_sta_connected_t *event)
+ * @brief Notify STA association (called from WiFi event handler).
+ * @param[in] event - Connected event data
+ */
+void atl_wifi_link_sta_connected(const wifi_event_sta_connected_t *event) {
+    atl_wifi_link_phy_e phy = ATL_WIFI_LINK_PHY_HT20;
+    if (atl_wifi_link_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(atl_wifi_link_mutex, portMAX_DELAY) == pdTRUE) {
+        atl_wifi_link.connected = true;
+        atl_wifi_link.channel = event->channel;
+        atl_wifi_link.rssi = 0;
+        atl_wifi_link.rssi_avg = 0;
+        atl_wifi_link.rssi_min = 0;
+        atl_wifi_link.rssi_max = 0;
+        atl_wifi_link_samples = 0;
+        atl_wifi_link_switching = false;
+        phy = atl_wifi_link.phy;
+        xSemaphoreGive(atl_wifi_link_mutex);
+    }
+
+    /* Each association starts at max. TX power */
+    atl_wifi_link_set_tx_power(CONFIG_ATL_WIFI_LINK_TX_POWER_MAX);
+    ESP_LOGI(TAG, "Associated with PHY mode %s", atl_wifi_link_phy_str[phy]);
+}
+
+/**
+ * @fn atl_wifi_link_sta_disconnected(const wifi_event_sta_disconnected_t *event)
+ * @brief Notify STA disconnection (called from WiFi event handler before reconnecting).
+ * @details Pending PHY mode is applied here, so it is used by the next connection attempt.
+ * @param[in] event - Disconnected event data
+ */
+void atl_wifi_link_sta_disconnected(const wifi_event_sta_disconnected_t *event) {
+    bool apply = false;
+    bool restore_tx_power = false;
+    atl_wifi_link_phy_e phy = ATL_WIFI_LINK_PHY_HT20;
+    if (atl_wifi_link_mutex == NULL) {
+        return;
+    }
+    if (xSemaphoreTake(atl_wifi_link_mutex, portMAX_DELAY) == pdTRUE) {
+        if (atl_wifi_link_switching == false) {
+            if (atl_wifi_link.connected == true) {
+                atl_wifi_link.link_losses++;
+            }
+
+            /* LR association lost (or refused): fall back to legacy PHY */
+            if (atl_wifi_link.phy == ATL_WIFI_LINK_PHY_LR) {
+                ESP_LOGW(TAG, "LR link failed (reason %d), falling back to %s", event->reason, atl_wifi_link_phy_str[ATL_WIFI_LINK_PHY_HT20]);
+                atl_wifi_link_pending = ATL_WIFI_LINK_PHY_HT20;
+                atl_wifi_link_phy_time = esp_timer_get_time();
+            }
+        }
+        if (atl_wifi_link_pending != atl_wifi_link.phy) {
+            atl_wifi_link.phy = atl_wifi_link_pending;
+            atl_wifi_link.phy_switches++;
+            apply = true;
+        }
+        phy = atl_wifi_link.phy;
+        restore_tx_power = (atl_wifi_link.tx_power < CONFIG_ATL_WIFI_LINK_TX_POWER_MAX);
+        atl_wifi_link.connected = false;
+        atl_wifi_link_switching = false;
+        xSemaphoreGive(atl_wifi_link_mutex);
+    }
+
+    /* Reconnection is attempted with new PHY mode and max. TX power */
+    if (apply == true) {
+        atl_wifi_link_apply_phy(phy);
+    }
+    if (restore_tx_power == true) {
+        atl_wifi_link_set_tx_power(CONFIG_ATL_WIFI_LINK_TX_POWER_MAX);
+    }
+}
+
+/**
+ * @fn atl_wifi_link_get(atl_wifi_link_t *link)
+ * @brief Get WiFi STA link quality metrics.
+ * @param[out] link - Link metrics
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if link adaptation is not initialized.
+ */
+esp_err_t atl_wifi_link_get(atl_wifi_link_t *link) {
+    if (atl_wifi_link_mutex == NULL) {
+        memset(link, 0, sizeof(atl_wifi_link_t));
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xSemaphoreTake(atl_wifi_link_mutex, portMAX_DELAY) == pdTRUE) {
+        memcpy(link, &atl_wifi_link, sizeof(atl_wifi_link_t));
+        xSemaphoreGive(atl_wifi_link_mutex);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @fn atl_wifi_link_init(void)
+ * @brief Initialize link adaptation (must be called after STA mode is set and before WiFi start).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_link_init(void) {
+    esp_err_t err = ESP_OK;
+    if (atl_wifi_link_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    /* First association uses HT20 (robust at unknown distance) */
+    memset(&atl_wifi_link, 0, sizeof(atl_wifi_link_t));
+    atl_wifi_link.phy = ATL_WIFI_LINK_PHY_HT20;
+    atl_wifi_link.tx_power = CONFIG_ATL_WIFI_LINK_TX_POWER_MAX;
+    atl_wifi_link_pending = ATL_WIFI_LINK_PHY_HT20;
+    err = atl_wifi_link_apply_phy(ATL_WIFI_LINK_PHY_HT20);
+    if (err != ESP_OK) {
+        goto error_proc;
+    }
+    atl_wifi_link_mutex = xSemaphoreCreateMutex();
+    if (atl_wifi_link_mutex == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto error_proc;
+    }
+    if (xTaskCreatePinnedToCore(atl_wifi_link_task, "atl_wifi_link_task", 4096, NULL, 5, &atl_wifi_link_task_handle, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Fail creating WiFi link task!");
+        err = ESP_FAIL;
+        goto error_proc;
+    }
+    return err;
+
+    /* Error procedure */
+error_proc:
+    ESP_LOGE(TAG, "Error: %d = %s", err, esp_err_to_name(err));
+    return err;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file atl_wifi_link.h
+ * @author Robson Costa (robson.costa@ifsc.edu.br)
+ * @brief WiFi STA link adaptation (PHY mode and TX power) header.
+ * @version 0.1.0
+ * @date 2026-10-19 (created)
+ * @date 2026-10-19 (updated)
+ *
+ * @copyright Copyright &copy; since 2024 <a href="https://agrotechlab.lages.ifsc.edu.br" target="_blank">AgroTechLab</a>.\n
+ * ![LICENSE license](../figs/license.png)<br>
+ * Licensed under the CC BY-SA (<i>Creative Commons Attribution-ShareAlike</i>) 4.0 International Unported License (the <em>"License"</em>). You may not
+ * use this file except in compliance with the License. You may obtain a copy of the License <a href="https://creativecommons.org/licenses/by-sa/4.0/legalcode" target="_blank">here</a>.
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an <em>"as is" basis,
+ * without warranties or conditions of any kind</em>, either express or implied. See the License for the specific language governing permissions
+ * and limitations under the License.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp_wifi_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum    atl_wifi_link_phy_e
+ * @brief   PHY mode selected to STA interface.
+ */
+typedef enum {
+    ATL_WIFI_LINK_PHY_HT40,     /**< 802.11b/g/n with 40 MHz channels (strong signal).*/
+    ATL_WIFI_LINK_PHY_HT20,     /**< 802.11b/g/n with 20 MHz channels.*/
+    ATL_WIFI_LINK_PHY_LR,       /**< Espressif 802.11 LR (weak signal, AP must support it).*/
+} atl_wifi_link_phy_e;
+
+/**
+ * @typedef atl_wifi_link_t
+ * @brief WiFi STA link quality metrics.
+ */
+typedef struct {
+    bool                connected;      /**< STA associated to AP.*/
+    int8_t              rssi;           /**< Last RSSI sample (dBm).*/
+    int8_t              rssi_avg;       /**< Average RSSI at current association (dBm).*/
+    int8_t              rssi_min;       /**< Min. RSSI at current association (dBm).*/
+    int8_t              rssi_max;       /**< Max. RSSI at current association (dBm).*/
+    int8_t              tx_power;       /**< Max. TX power in use (dBm).*/
+    uint8_t             channel;        /**< AP primary channel.*/
+    bool                ap_lr;          /**< AP supports 802.11 LR.*/
+    atl_wifi_link_phy_e phy;            /**< PHY mode selected.*/
+    wifi_phy_mode_t     phy_mode;       /**< PHY mode negotiated with AP.*/
+    uint32_t            link_losses;    /**< Disconnections not requested by link adaptation.*/
+    uint32_t            phy_switches;   /**< PHY mode switches.*/
+    uint32_t            tx_power_steps; /**< TX power changes.*/
+} atl_wifi_link_t;
+
+/**
+ * @fn atl_wifi_link_init(void)
+ * @brief Initialize link adaptation (must be called after STA mode is set and before WiFi start).
+ * @return esp_err_t - If ERR_OK success, otherwise fail.
+ */
+esp_err_t atl_wifi_link_init(void);
+
+/**
+ * @fn atl_wifi_link_sta_connected(const wifi_event_sta_connected_t *event)
+ * @brief Notify STA association (called from WiFi event handler).
+ * @param[in] event - Connected event data
+ */
+void atl_wifi_link_sta_connected(const wifi_event_sta_connected_t *event);
+
+/**
+ * @fn atl_wifi_link_sta_disconnected(const wifi_event_sta_disconnected_t *event)
+ * @brief Notify STA disconnection (called from WiFi event handler before reconnecting).
+ * @details Pending PHY mode is applied here, so it is used by the next connection attempt.
+ * @param[in] event - Disconnected event data
+ */
+void atl_wifi_link_sta_disconnected(const wifi_event_sta_disconnected_t *event);
+
+/**
+ * @fn atl_wifi_link_get(atl_wifi_link_t *link)
+ * @brief Get WiFi STA link quality metrics.
+ * @param[out] link - Link metrics
+ * @return esp_err_t - If ERR_OK success, ESP_ERR_INVALID_STATE if link adaptation is not initialized.
+ */
+esp_err_t atl_wifi_link_get(atl_wifi_link_t *link);
+
+/**
+ * @fn atl_wifi_link_get_phy_str(atl_wifi_link_phy_e phy)
+ * @brief Get PHY mode name.
+ * @param[in] phy - PHY mode
+ * @return const char* - PHY mode name.
+ */
+const char* atl_wifi_link_get_phy_str(atl_wifi_link_phy_e phy);
+
+#ifdef __cplusplus
+}
+#endif
@@ -56,4 +56,86 @@ function getConfJSONFile(){
         }
     };
     xhr.send();
-}
\ No newline at end of file
+}
+function getWifiScan(retry){
+    var xhr = new XMLHttpRequest();
+    xhr.open("GET", "/api/v1/wifi/scan", true);
+    xhr.responseType = 'json';
+    xhr.onreadystatechange = function() {
+        if (xhr.readyState === 4 && xhr.status === 200) {
+            var scan = xhr.response;
+            var list = document.getElementById('ssid_list');
+            if (list == null) {
+                return;
+            }
+            list.innerHTML = '';
+            scan.aps.forEach(function(ap) {
+                const option = document.createElement("option");
+                option.value = ap.ssid;
+                option.label = ap.rssi + ' dBm (ch ' + ap.channel + ')';
+                list.appendChild(option);
+            });
+            if (scan.scanning && (retry < 5)) {
+                setTimeout(function(){ getWifiScan(retry + 1); }, 2000);
+            }
+        }
+    };
+    xhr.send();
+}
+function getCellularStatus(){
+    var xhr = new XMLHttpRequest();
+    xhr.open("GET", "/api/v1/cellular/status", true);
+    xhr.responseType = 'json';
+    xhr.onreadystatechange = function() {
+        if (xhr.readyState === 4 && xhr.status === 200) {
+            var cell = xhr.response;
+            if (document.getElementById('cell_link') == null) {
+                return;
+            }
+            if (!cell.enabled) {
+                document.getElementById('cell_link').innerHTML = 'Disabled';
+                return;
+            }
+            document.getElementById('cell_link').innerHTML = (cell.ppp_up ? 'PPP up' : (cell.started ? 'PPP down' : 'Starting')) +
+                (cell.started ? (cell.cmux ? ' (CMUX)' : ' (data mode)') : '');
+            if (cell.age != null) {
+                document.getElementById('cell_reg').innerHTML = cell.registered ? (cell.reg_stat == 5 ? 'Roaming' : 'Home') : 'Not registered (' + cell.reg_stat + ')';
+                document.getElementById('cell_operator').innerHTML = cell.operator;
+                document.getElementById('cell_signal').innerHTML = (cell.rssi != 0) ? cell.rssi + ' dBm' : 'Unknown';
+                document.getElementById('cell_id').innerHTML = cell.tac.toString(16).toUpperCase() + ' / ' + cell.cell_id.toString(16).toUpperCase();
+            }
+            setTimeout(getCellularStatus, 10000);
+        }
+    };
+    xhr.send();
+}
+function getLoraStatus(){
+    var xhr = new XMLHttpRequest();
+    xhr.open("GET", "/api/v1/lora/status", true);
+    xhr.responseType = 'json';
+    xhr.onreadystatechange = function() {
+        if (xhr.readyState === 4 && xhr.status === 200) {
+            var lora = xhr.response;
+            if (document.getElementById('lora_net') == null) {
+                return;
+            }
+            if (!lora.enabled) {
+                document.getElementById('lora_net').innerHTML = 'Disabled';
+                return;
+            }
+            document.getElementById('lora_net').innerHTML = (lora.joined ? 'Joined' : 'Joining') + ' (' + lora.radio + ')';
+            document.getElementById('lora_dr').innerHTML = 'DR' + lora.dr;
+            if (lora.uplinks > 0) {
+                document.getElementById('lora_last').innerHTML = 'Port ' + lora.last_port + ', ' + lora.last_len + ' bytes, ' +
+                    lora.last_airtime + ' ms (' + lora.uplinks + ' sent, ' + lora.deferred + ' deferred)';
+            }
+            document.getElementById('lora_airtime').innerHTML = (lora.airtime_day / 1000).toFixed(1) + ' s' +
+                ((lora.airtime_budget > 0) ? ' of ' + (lora.airtime_budget / 1000) + ' s' : '');
+            if (lora.rssi != 0) {
+                document.getElementById('lora_signal').innerHTML = lora.rssi + ' dBm, SNR ' + lora.snr + ' dB';
+            }
+            setTimeout(getLoraStatus, 10000);
+        }
+    };
+    xhr.send();
+}
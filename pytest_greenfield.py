@@ -3,6 +3,7 @@
 
 import logging
 import os
+import re
 
 import pytest
 from pytest_embedded_idf.dut import IdfDut
@@ -15,3 +16,68 @@ def test_blink(dut: IdfDut) -> None:
     binary_file = os.path.join(dut.app.binary_path, 'greenfield_fw.bin')
     bin_size = os.path.getsize(binary_file)
     logging.info('greenfield_bin_size : {}KB'.format(bin_size // 1024))
+
+
+def webpage(dut: IdfDut, uri: str) -> tuple:
+    # request a page over loopback from the device console (status, length, SHA-256)
+    dut.write('webpage {}'.format(uri))
+    match = dut.expect(r'webpage (\S+): status (\d+), (\d+) bytes, sha256 ([0-9a-f]{64})', timeout=30)
+    assert match.group(1).decode() == uri
+    return int(match.group(2)), int(match.group(3)), match.group(4).decode()
+
+
+# webpage command is only built at test builds (profiles/sdkconfig.test)
+@pytest.mark.supported_targets
+@pytest.mark.generic
+@pytest.mark.parametrize('build_dir', ['build_test'], indirect=True)
+def test_page_cache(dut: IdfDut) -> None:
+    # two different cached pages in a row must each get their own body back from the cache
+    dut.expect('Serial console started', timeout=60)
+    wifi_rendered = webpage(dut, '/conf_wifi.html')
+    mqtt_rendered = webpage(dut, '/conf_mqtt.html')
+    wifi_cached = webpage(dut, '/conf_wifi.html')
+    mqtt_cached = webpage(dut, '/conf_mqtt.html')
+    assert wifi_rendered[0] == 200 and mqtt_rendered[0] == 200
+    assert wifi_rendered[2] != mqtt_rendered[2]
+    assert wifi_cached == wifi_rendered
+    assert mqtt_cached == mqtt_rendered
+
+
+# Pipelined status query answers (AT+CSQ;+CEREG?;+COPS?) captured from modems, with expected parse
+CELLULAR_CAPTURES = [
+    # complete answer (with command echo)
+    ('AT+CSQ;+CEREG?;+COPS?\r\r\n+CSQ: 20,99\r\n\r\n+CEREG: 2,1,"1A2B","01A2B3C4",7\r\n\r\n+COPS: 0,0,"Vivo",7\r\n\r\nOK\r\n',
+     {'found': 'csq,cereg,cops,ok,', 'rssi': '-73', 'ber': '99', 'reg': '1', 'registered': 'yes', 'tac': '1A2B', 'ci': '01A2B3C4', 'act': '7', 'operator': 'Vivo'}),
+    # +COPS? rejected (SIM busy), answers before the error are kept
+    ('\r\n+CSQ: 18,99\r\n\r\n+CEREG: 2,2\r\n\r\n+CME ERROR: 14\r\n',
+     {'found': 'csq,cereg,error,', 'rssi': '-77', 'reg': '2', 'registered': 'no', 'tac': '0000', 'ci': '00000000', 'operator': ''}),
+    # missing +COPS line
+    ('\r\n+CSQ: 31,0\r\n\r\n+CEREG: 2,5,"00C1","0A0B0C0D",7\r\n\r\nOK\r\n',
+     {'found': 'csq,cereg,ok,', 'rssi': '-51', 'ber': '0', 'reg': '5', 'registered': 'yes', 'tac': '00C1', 'ci': '0A0B0C0D', 'operator': ''}),
+    # unsolicited +CEREG and +CGEV in the middle of the answer
+    ('\r\n+CSQ: 99,99\r\n\r\n+CEREG: 1,"1A2C","01A2B3C5",7\r\n\r\n+CGEV: ME PDN ACT 1\r\n\r\n+CEREG: 2,1,"1A2B","01A2B3C4",7\r\n'
+     '\r\n+COPS: 0,0,"Claro BR",7\r\n\r\n+CEREG: 0\r\n\r\nOK\r\n',
+     {'found': 'csq,cereg,cops,ok,', 'rssi': '0', 'ber': '99', 'reg': '1', 'tac': '1A2B', 'ci': '01A2B3C4', 'operator': 'Claro BR'}),
+    # operator not selected (not registered)
+    ('\r\n+CSQ: 5,99\r\n\r\n+CEREG: 2,0\r\n\r\n+COPS: 0\r\n\r\nOK\r\n',
+     {'found': 'csq,cereg,cops,ok,', 'rssi': '-103', 'reg': '0', 'registered': 'no', 'operator': ''}),
+    # answer cut by timeout (last line incomplete)
+    ('\r\n+CSQ: 20,99\r\n\r\n+CEREG: 2,1,"1A',
+     {'found': 'csq,', 'rssi': '-73', 'reg': '0', 'tac': '0000'}),
+]
+
+
+@pytest.mark.supported_targets
+@pytest.mark.generic
+def test_cellular_parse(dut: IdfDut) -> None:
+    # captured modem answers go through the status query parser (no modem needed)
+    dut.expect('Serial console started', timeout=60)
+    for answer, expected in CELLULAR_CAPTURES:
+        arg = answer.replace('\r\n', '|').replace('\r', '|').replace('"', '\\"')
+        cmd = 'cellular parse "{}"'.format(arg)
+        assert len(cmd) < 256
+        dut.write(cmd)
+        match = dut.expect(r'cellular parse: (.*)\r?\n', timeout=5)
+        fields = dict(re.findall(r'(\w+)=("[^"]*"|\S*)', match.group(1).decode()))
+        for key, value in expected.items():
+            assert fields[key].strip('"') == value, '{}: {} (expected {})'.format(key, fields[key], value)